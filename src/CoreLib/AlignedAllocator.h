@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+namespace Core
+{
+  //std::allocator that aligns every block to Alignment bytes (e.g. 64 = a cache line / whole AVX-512 register), for
+  //arrays that SIMD code wants to load with aligned loads or that shouldn't share cache lines.
+  //  std::vector<float, Core::AlignedAllocator<float, 64>> xs;
+  template<typename T, std::size_t Alignment = 64>
+  class AlignedAllocator
+  {
+    static_assert((Alignment & (Alignment - 1)) == 0, "AlignedAllocator alignment must be a power of 2");
+    static_assert(Alignment >= alignof(T), "AlignedAllocator alignment must be at least alignof(T)");
+
+  public:
+    using value_type = T;
+    static constexpr std::size_t s_alignment = Alignment;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+      return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+      ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator == (const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template<typename U>
+    bool operator != (const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+  };
+}
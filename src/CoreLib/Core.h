@@ -3,4 +3,7 @@
 #include "CoreLib/PlatformDetect/PlatformDetect.h"
 #include "CoreLib/HelperMacros.h"
 #include "CoreLib/Logger.h"
-#include "CoreLib/SpgAssert.h"
\ No newline at end of file
+#include "CoreLib/SpgAssert.h"
+#include "CoreLib/Timer.h"
+#include "CoreLib/FunctionRef.h"
+#include "CoreLib/NodePool.h"
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <memory>
+
+namespace Core
+{
+  //Non-owning reference to a callable (like std::function but never allocates). Only valid while the callable 
+  //it was made from is alive, so use it for callback parameters, don't store it.
+  template<typename Fn>
+  class FunctionRef;
+
+  template<typename R, typename... Args>
+  class FunctionRef<R(Args...)>
+  {
+  public:
+    template<typename F>
+      requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+    FunctionRef(F&& f) :
+      m_obj{const_cast<void*>(static_cast<const void*>(std::addressof(f)))},
+      m_call{[](void* obj, Args... args) -> R {
+        return (*static_cast<std::remove_reference_t<F>*>(obj))(std::forward<Args>(args)...);
+      }}
+    {}
+
+    R operator()(Args... args) const { return m_call(m_obj, std::forward<Args>(args)...); }
+
+  private:
+    void* m_obj = nullptr;
+    R (*m_call)(void*, Args...) = nullptr;
+  };
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "CoreLib/SpgAssert.h"
+
+namespace Core
+{
+  //Slab allocator for fixed size nodes (tree nodes etc). Memory comes from slabs that double in size from 1 node up
+  //to s_max_slab_size nodes - nothing is allocated up front, and a pool holding a handful of nodes (a tree's
+  //sentinel, a small secondary tree) only holds about that many. Reserve() takes one slab sized for what's asked
+  //for, for bulk builds. Destroyed nodes go on a free list which is re-used first (LIFO, so recently freed => likely
+  //still in cache). Slabs are only released when the pool is destroyed or Release() is called, so steady state
+  //insert/erase churn does no heap allocation. Not thread safe - one pool per container.
+  template<typename TNode>
+  class NodePool
+  {
+  public:
+    static constexpr uint32_t s_min_slab_size = 1;
+    static constexpr uint32_t s_max_slab_size = 4096;
+
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    //Nodes stay where they are (slabs are separate heap blocks), so pointers into the moved-from pool stay valid
+    NodePool(NodePool&& other) noexcept { *this = std::move(other); }
+    NodePool& operator=(NodePool&& other) noexcept
+    {
+      if(this == &other)
+        return *this;
+      m_slabs = std::move(other.m_slabs);
+      m_free_list = std::exchange(other.m_free_list, nullptr);
+      m_slab_used = std::exchange(other.m_slab_used, 0);
+      m_slab_size = std::exchange(other.m_slab_size, 0);
+      m_num_live = std::exchange(other.m_num_live, 0);
+      m_num_reserved = std::exchange(other.m_num_reserved, 0);
+      other.m_slabs.clear();
+      return *this;
+    }
+
+    //Any nodes still live have their memory released without their destructors being run
+    ~NodePool() = default;
+
+    template<typename... Args>
+    TNode* Create(Args&&... args)
+    {
+      TNode* node = new (Allocate()) TNode(std::forward<Args>(args)...);
+      m_num_live++;
+      return node;
+    }
+
+    void Destroy(TNode* node)
+    {
+      SPG_ASSERT(node != nullptr);
+      SPG_ASSERT(m_num_live > 0);
+      node->~TNode();
+      Slot* slot = reinterpret_cast<Slot*>(node);
+      slot->next = m_free_list;
+      m_free_list = slot;
+      m_num_live--;
+    }
+
+    //Frees all the slabs. Only valid when there are no live nodes
+    void Release()
+    {
+      SPG_ASSERT(m_num_live == 0);
+      m_slabs.clear();
+      m_free_list = nullptr;
+      m_slab_used = m_slab_size = 0;
+      m_num_reserved = 0;
+    }
+
+    //Makes sure the next count Create()s allocate at most once - one slab for whatever the free list and the last
+    //slab can't cover
+    void Reserve(std::size_t count)
+    {
+      const std::size_t available = m_num_reserved - m_num_live;
+      if(count > available)
+        NewSlab((uint32_t)(count - available));
+    }
+
+    std::size_t NumLive() const { return m_num_live; }
+    std::size_t NumReserved() const { return m_num_reserved; } //nodes' worth of memory held, live or not
+
+  private:
+    union Slot
+    {
+      Slot* next;
+      alignas(TNode) std::byte storage[sizeof(TNode)];
+    };
+
+    void* Allocate()
+    {
+      if(m_free_list != nullptr) {
+        Slot* slot = m_free_list;
+        m_free_list = slot->next;
+        return slot->storage;
+      }
+      if(m_slab_used == m_slab_size)
+        NewSlab((m_slab_size == 0) ? s_min_slab_size : std::min(2*m_slab_size, s_max_slab_size));
+      return m_slabs.back()[m_slab_used++].storage;
+    }
+
+    void NewSlab(uint32_t size)
+    {
+      //Whatever's left of the last slab goes on the free list rather than being lost
+      for(uint32_t i = m_slab_used; i < m_slab_size; i++) {
+        Slot* slot = &m_slabs.back()[i];
+        slot->next = m_free_list;
+        m_free_list = slot;
+      }
+      m_slabs.push_back(std::make_unique<Slot[]>(size));
+      m_slab_size = size;
+      m_slab_used = 0;
+      m_num_reserved += size;
+    }
+
+  private:
+    std::vector<std::unique_ptr<Slot[]>> m_slabs;
+    Slot* m_free_list = nullptr;
+    uint32_t m_slab_used = 0; //bump index into the last slab
+    uint32_t m_slab_size = 0; //size of the last slab
+    std::size_t m_num_live = 0;
+    std::size_t m_num_reserved = 0;
+  };
+
+  //Same interface as NodePool, but every node is a separate new/delete. For comparison, or where nodes must
+  //outlive the container
+  template<typename TNode>
+  class HeapNodeAllocator
+  {
+  public:
+    template<typename... Args>
+    TNode* Create(Args&&... args) { return new TNode(std::forward<Args>(args)...); }
+    void Destroy(TNode* node) { delete node; }
+    void Reserve(std::size_t) {}
+  };
+}
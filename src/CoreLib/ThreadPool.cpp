@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <latch>
+#include <memory>
+
+namespace Core
+{
+  ThreadPool::ThreadPool(uint32_t num_threads)
+  {
+    if(num_threads == 0)
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    m_workers.reserve(num_threads);
+    for(uint32_t i = 0; i < num_threads; ++i)
+      m_workers.emplace_back([this]() { WorkerLoop(); });
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_task_available.notify_all();
+    for(auto& worker : m_workers)
+      worker.join();
+  }
+
+  void ThreadPool::Submit(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push(std::move(task));
+      m_tasks_pending++;
+    }
+    m_task_available.notify_one();
+  }
+
+  void ThreadPool::Wait()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_all_done.wait(lock, [this]() { return m_tasks_pending == 0; });
+  }
+
+  void ThreadPool::ParallelFor(uint32_t count, uint32_t min_chunk_size, const std::function<void(uint32_t,uint32_t)>& fn)
+  {
+    if(count == 0)
+      return;
+    min_chunk_size = std::max(1u, min_chunk_size);
+    //A few chunks per thread helps balance uneven work
+    const uint32_t max_chunks = (count + min_chunk_size - 1) / min_chunk_size;
+    const uint32_t target_chunks = std::min(max_chunks, NumThreads()*4);
+    const uint32_t chunk_size = (count + target_chunks - 1) / target_chunks;
+    const uint32_t num_chunks = (count + chunk_size - 1) / chunk_size; //rounding chunk_size up can leave fewer
+    if(num_chunks <= 1) {
+      fn(0, count);
+      return;
+    }
+
+    //Per call state: chunks are claimed from next_chunk by the helper tasks and by this thread. It's shared, as a
+    //helper that only gets to run after all the chunks are done still reads next_chunk. Every claimed chunk counts
+    //down, even if fn throws - the first exception is kept for this thread, and the chunks after it are skipped
+    struct ChunkState
+    {
+      std::atomic<uint32_t> next_chunk{0};
+      std::latch chunks_done;
+      std::atomic<bool> failed{false};
+      std::mutex error_mutex;
+      std::exception_ptr error;
+      explicit ChunkState(uint32_t num) : chunks_done(num) {}
+    };
+    auto state = std::make_shared<ChunkState>(num_chunks);
+    auto run_chunks = [state, &fn, count, chunk_size, num_chunks]() {
+      for(uint32_t chunk = state->next_chunk++; chunk < num_chunks; chunk = state->next_chunk++) {
+        if(!state->failed) {
+          try {
+            const uint32_t begin = chunk * chunk_size;
+            fn(begin, std::min(count, begin + chunk_size));
+          }
+          catch(...) {
+            std::lock_guard<std::mutex> lock(state->error_mutex);
+            if(!state->error)
+              state->error = std::current_exception();
+            state->failed = true;
+          }
+        }
+        state->chunks_done.count_down();
+      }
+    };
+    const uint32_t num_helpers = std::min(num_chunks - 1, NumThreads());
+    for(uint32_t i = 0; i < num_helpers; ++i)
+      Submit(run_chunks);
+    run_chunks();
+    //Any chunks left are already running on other threads
+    state->chunks_done.wait();
+    if(state->error)
+      std::rethrow_exception(state->error);
+  }
+
+  ThreadPool& ThreadPool::Default()
+  {
+    static ThreadPool s_pool;
+    return s_pool;
+  }
+
+  void ThreadPool::WorkerLoop()
+  {
+    while(true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_task_available.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+        if(m_stopping && m_tasks.empty())
+          return;
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks_pending--;
+        if(m_tasks_pending == 0)
+          m_all_done.notify_all();
+      }
+    }
+  }
+}
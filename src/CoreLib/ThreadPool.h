@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Core
+{
+  //Fixed size pool of worker threads. Used for the parallel / batched geometry queries.
+  //Note: Wait() blocks until all submitted tasks are done, so don't call it from inside a task. ParallelFor() only
+  //waits for its own chunks, and is fine to call from anywhere.
+  class ThreadPool
+  {
+  public:
+    explicit ThreadPool(uint32_t num_threads = 0); //0 => std::thread::hardware_concurrency()
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t NumThreads() const { return (uint32_t)m_workers.size(); }
+
+    void Submit(std::function<void()> task);
+    void Wait();
+
+    //Splits [0,count) into roughly equal chunks of at least min_chunk_size and runs fn(begin,end) on each 
+    //chunk across the pool. The calling thread runs chunks too, so it still finishes if every worker is busy
+    //(e.g. when called from a task). Blocks until all the chunks are done. If fn throws, the chunks not yet started
+    //are skipped and the first exception is rethrown here.
+    void ParallelFor(uint32_t count, uint32_t min_chunk_size, const std::function<void(uint32_t,uint32_t)>& fn);
+
+    //Shared pool, created on first use
+    static ThreadPool& Default();
+
+  private:
+    void WorkerLoop();
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_task_available;
+    std::condition_variable m_all_done;
+    uint32_t m_tasks_pending = 0; //queued + running
+    bool m_stopping = false;
+  };
+}
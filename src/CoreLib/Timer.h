@@ -0,0 +1,23 @@
+#pragma once
+#include <chrono>
+
+namespace Core
+{
+  //Simple wall clock timer for the Test() harnesses and benchmarks
+  class Timer
+  {
+  public:
+    Timer() { Reset(); }
+
+    void Reset() { m_start = Clock::now(); }
+
+    double ElapsedMillis() const 
+    { 
+      return std::chrono::duration<double, std::milli>(Clock::now() - m_start).count(); 
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point m_start;
+  };
+}
@@ -288,6 +288,27 @@ namespace Spg
     Geom::Test_RBTreeTr();
 #endif
 
+//-------------------------------------------------------------------------------
+//FlatSortedSet
+//-------------------------------------------------------------------------------
+#if 0
+    Geom::Test_FlatSortedSet();
+#endif
+
+//-------------------------------------------------------------------------------
+//ConvexHull
+//-------------------------------------------------------------------------------
+#if 0
+    Geom::Test_ConvexHull();
+#endif
+
+//-------------------------------------------------------------------------------
+//IncrementalHull2D
+//-------------------------------------------------------------------------------
+#if 0
+    Geom::IncrementalHull2D::Test();
+#endif
+
 //-------------------------------------------------------------------------------
 //RangeTree1D
 //-------------------------------------------------------------------------------
@@ -302,6 +323,13 @@ namespace Spg
   Geom::RangeTree2D::Test();
 #endif
 
+//-------------------------------------------------------------------------------
+//LayeredRangeTree2D
+//-------------------------------------------------------------------------------
+#if 0
+  Geom::LayeredRangeTree2D::Test();
+#endif
+
 
 //-------------------------------------------------------------------------------
 //Voronoi V4
@@ -310,18 +338,30 @@ namespace Spg
   Geom::Voronoi_V4::Voronoi::Test();
 #endif
 
+//-------------------------------------------------------------------------------
+//Constrained Delaunay triangulation
+//-------------------------------------------------------------------------------
+#if 0
+  Geom::DelaunayTriangulation2D::Test();
+#endif
+
 //-------------------------------------------------------------------------------
 //KDTree
 //-------------------------------------------------------------------------------
 #if 0
     Geom::KDTree2D::Test();
 #endif
+#if 0
+    Geom::KDTree<2>::Test();
+    Geom::KDTree3D::Test();
+#endif
 
 //-------------------------------------------------------------------------------
 //Intersection Set
 //-------------------------------------------------------------------------------
 #if 0
-    Geom::ItersectSet::IntersectionSet::Test();
+    Geom::ItersectSet::IntersectionSet<>::Test();
+    //Geom::ItersectSet::IntersectionSet<>::Test(true); //benchmark mode
 #endif
 
 //-------------------------------------------------------------------------------
@@ -329,6 +369,9 @@ namespace Spg
 //--------------------------------------------------------------------------------
 #if 0
     Geom::DCEL::Test();
+#endif
+#if 0
+    Geom::dcel_v3::DCEL::Test();
 #endif
   }
 }
\ No newline at end of file
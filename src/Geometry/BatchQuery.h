@@ -0,0 +1,71 @@
+#pragma once
+
+#include <span>
+#include "CoreLib/Core.h"
+#include "CoreLib/ThreadPool.h"
+#include "MathLib/Geom/Geom.h"
+
+namespace Geom
+{
+  //Results of a batched query in CSR form: the points for query i are points[offsets[i], offsets[i+1]). 
+  //Keep the same object around between batches - all its buffers are re-used, so steady state is allocation free.
+  struct BatchQueryResult
+  {
+    std::vector<SpgMth::Point2d> points;
+    std::vector<uint32_t> offsets;
+
+    size_t NumQueries() const { return offsets.empty() ? 0 : offsets.size()-1; }
+    std::span<const SpgMth::Point2d> operator[](size_t i) const 
+    {
+      return std::span<const SpgMth::Point2d>(points.data() + offsets[i], offsets[i+1] - offsets[i]);
+    }
+
+    //Scratch: one output buffer per chunk of queries
+    std::vector<std::vector<SpgMth::Point2d>> chunk_points;
+  };
+
+  //Runs query(ranges[i], out) for every range across the pool. query must append its hits to out and only read 
+  //from the structure being queried (it's called concurrently). 
+  template<typename TRange, typename TQuery>
+  void RunBatchQuery(std::span<const TRange> ranges, TQuery&& query, BatchQueryResult& result, Core::ThreadPool& pool)
+  {
+    const uint32_t num_queries = (uint32_t)ranges.size();
+    result.offsets.assign(num_queries+1, 0);
+    result.points.clear();
+    if(num_queries == 0)
+      return;
+
+    const uint32_t num_chunks = std::min(num_queries, pool.NumThreads()*4);
+    const uint32_t chunk_size = (num_queries + num_chunks - 1) / num_chunks;
+    if(result.chunk_points.size() < num_chunks)
+      result.chunk_points.resize(num_chunks);
+
+    //Pass 1: each chunk queries into its own buffer and records per query counts in offsets[i+1]
+    pool.ParallelFor(num_chunks, 1, [&](uint32_t chunk_begin, uint32_t chunk_end) {
+      for(uint32_t c = chunk_begin; c < chunk_end; ++c) {
+        auto& buffer = result.chunk_points[c];
+        buffer.clear();
+        const uint32_t end = std::min(num_queries, (c+1)*chunk_size);
+        for(uint32_t i = c*chunk_size; i < end; ++i) {
+          const size_t size_before = buffer.size();
+          query(ranges[i], buffer);
+          result.offsets[i+1] = (uint32_t)(buffer.size() - size_before);
+        }
+      }
+    });
+
+    //Prefix sum counts => offsets
+    for(uint32_t i = 0; i < num_queries; ++i)
+      result.offsets[i+1] += result.offsets[i];
+    result.points.resize(result.offsets[num_queries]);
+
+    //Pass 2: copy the chunk buffers into place. Queries in a chunk are consecutive so each is one block copy
+    pool.ParallelFor(num_chunks, 1, [&](uint32_t chunk_begin, uint32_t chunk_end) {
+      for(uint32_t c = chunk_begin; c < chunk_end; ++c) {
+        const uint32_t first_query = std::min(num_queries, c*chunk_size);
+        auto& buffer = result.chunk_points[c];
+        std::copy(buffer.begin(), buffer.end(), result.points.begin() + result.offsets[first_query]);
+      }
+    });
+  }
+}
@@ -1,81 +1,119 @@
 
 #include "Geometry/ConvexHull.h"
 
+#include <algorithm>
+#include <bit>
+#include <random>
 #include <vector>
 
 #include "Geometry/MeshPrimitives2D.h"
 #include "CoreLib/Core.h"
+#include "CoreLib/Timer.h"
 #include "MathLib/Geom/Geom.h"
+#include "MathLib/Geom/Predicates.h"
+#include "MathLib/Geom/BatchPredicates.h"
 
 namespace Geom
 {
+  namespace
+  {
+    inline bool LexLess(const SpgMth::Point2d& a, const SpgMth::Point2d& b)
+    {
+      return (a.x < b.x) || ((a.x == b.x) && (a.y < b.y));
+    }
+
+    inline double DistSq(const SpgMth::Point2d& a, const SpgMth::Point2d& b)
+    {
+      SpgMth::DVec2 d = SpgMth::DPoint2d(b) - SpgMth::DPoint2d(a);
+      return d.x * d.x + d.y * d.y;
+    }
+
+    //Gift wrapping from hull vertex p: is q a better next point than best? i.e. right of p->best, or on that line
+    //and further away (q can't be behind p - p would be between two input points, so not a hull vertex)
+    inline bool IsBetterWrapCandidate(const SpgMth::Point2d& p, const SpgMth::Point2d& best, const SpgMth::Point2d& q)
+    {
+      double det = SpgMth::Orient2d(p, best, q);
+      return (det < 0.0) || ((det == 0.0) && (DistSq(p, q) > DistSq(p, best)));
+    }
+  }
+
   std::vector<SpgMth::Point2d> ConvexHull2D_GiftWrap(const std::vector<SpgMth::Point2d>& points)
   {
     std::vector<SpgMth::Point2d> hull;
     if(points.size() < 3)
       return hull;
 
-    //Get the start point (bottom most)
-    float y_min = std::numeric_limits<float>::max();
+    //Get the start point (bottom most, left most of those)
     uint32_t start_idx = 0;
-    for(auto i=0; i< points.size(); ++i)  
+    for(uint32_t i=1; i< points.size(); ++i)  
     {
-      if(points[i].y < y_min)
-      {
-        y_min = points[i].y;
+      if((points[i].y < points[start_idx].y) || ((points[i].y == points[start_idx].y) && (points[i].x < points[start_idx].x)))
         start_idx = i;
-      }
     }
-    hull.push_back(points[start_idx]);
-    
-    //Get second point
-    SpgMth::Point2d ref_point{points[start_idx].x +100.0f, points[start_idx].y}; //horiz line seg to the right
-    SpgMth::LineSeg2D ref_seg{points[start_idx], ref_point};
-    float min_angle = std::numeric_limits<float>::max();
-    uint32_t second_idx = 0;
-    for(auto i=0; i< points.size(); ++i)  
-    {
-      if(i == start_idx) 
-        continue;
 
-      SpgMth::LineSeg2D test_seg{points[start_idx], points[i]};
-      float angle = SpgMth::ComputeAngleInDegrees(ref_seg,test_seg);
-      if(angle < min_angle)
+    //Each next point has every other point left of cur->next, or on it but nearer. Cross products only - no angles
+    uint32_t cur_idx = start_idx;
+    do
+    {
+      hull.push_back(points[cur_idx]);
+      const SpgMth::Point2d cur = points[cur_idx];
+      uint32_t next_idx = cur_idx;
+      for(uint32_t i=0; i<points.size(); ++i)
       {
-        min_angle = angle;
-        second_idx = i;  
+        if(points[i] == cur)
+          continue;
+        if((next_idx == cur_idx) || IsBetterWrapCandidate(cur, points[next_idx], points[i]))
+          next_idx = i;
       }
-    }
-    hull.push_back(points[second_idx]);
+      if(next_idx == cur_idx)
+        break; //all the points are the same
+      cur_idx = next_idx;
+    } while((points[cur_idx] != points[start_idx]) && (hull.size() <= points.size()));
+
+    return hull;
+  }
 
-    uint32_t prev_idx = start_idx;
-    uint32_t cur_idx = second_idx;
-    while(true)
+  namespace
+  {
+    //Upper then lower hull of points sorted left to right (bottom to top for equal x)
+    std::vector<SpgMth::Point2d> MonotoneChain(const std::vector<SpgMth::Point2d>& sorted_points)
     {
-      SpgMth::LineSeg2D ref_seg{points[prev_idx], points[cur_idx]};
-      float min_angle = std::numeric_limits<float>::max();
-      uint32_t next_idx = 0;
-      for(auto i=0; i<points.size(); ++i)
+      //generate upper hull
+      std::vector<SpgMth::Point2d> upper_hull;
+      for(auto itr = sorted_points.begin(); itr != sorted_points.end(); ++itr )
       {
-        SpgMth::LineSeg2D test_seg{points[cur_idx], points[i]};
-        float angle = SpgMth::ComputeAngleInDegrees(ref_seg,test_seg);
-        if(angle < min_angle)
-        {
-          min_angle = angle;
-          next_idx = i;  
-        }
+        while( (upper_hull.size() > 1) && SpgMth::Left({*(upper_hull.cend()-2), *(upper_hull.cend()-1)}, *itr))
+          upper_hull.pop_back();
+
+        upper_hull.push_back(*itr);
       }
-      if(next_idx != start_idx)
+
+      //generate lower hull
+      std::vector<SpgMth::Point2d> lower_hull;
+      for(auto itr = sorted_points.rbegin(); itr != sorted_points.rend(); ++itr )
       {
-        hull.push_back(points[next_idx]);
-        prev_idx = cur_idx;
-        cur_idx = next_idx;
+        while( (lower_hull.size() > 1) && SpgMth::Left({*(lower_hull.cend()-2), *(lower_hull.cend()-1)}, *itr))
+          lower_hull.pop_back();
+
+        lower_hull.push_back(*itr);
       }
-      else
-        break;
+
+      //merge lower into upper
+      upper_hull.insert(upper_hull.end(), lower_hull.begin()+1, lower_hull.end()-1);
+      return upper_hull;
     }
 
-    return hull;
+    //Float <=> uint32 preserving order (as unsigned ints): flip the sign bit of positives, all the bits of negatives
+    inline uint32_t OrderedBits(float f)
+    {
+      uint32_t u = std::bit_cast<uint32_t>(f);
+      return u ^ ((uint32_t)((int32_t)u >> 31) | 0x80000000u);
+    }
+
+    inline float FromOrderedBits(uint32_t u)
+    {
+      return std::bit_cast<float>(u ^ (((u >> 31) - 1) | 0x80000000u));
+    }
   }
 
   std::vector<SpgMth::Point2d> Convexhull2D_ModifiedGrahams(const std::vector<SpgMth::Point2d>& points)
@@ -83,36 +121,412 @@ namespace Geom
     if(points.size() < 3)
       return points;
       
-    //sort points left to right
+    //sort points left to right, bottom to top for equal x (sorting on x only leaves points with equal x in any
+    //order, which the chain needs to be consistent on vertical edges)
     std::vector<SpgMth::Point2d> sorted_points = points;
     std::sort(std::begin(sorted_points), std::end(sorted_points), [](const SpgMth::Point2d& lhs, const SpgMth::Point2d& rhs) {
-        return lhs.x < rhs.x;
+        return (lhs.x < rhs.x) || ((lhs.x == rhs.x) && (lhs.y < rhs.y));
     });
-    
-    //generate upper hull
-    std::vector<SpgMth::Point2d> upper_hull;
-    for(auto itr = sorted_points.begin(); itr != sorted_points.end(); ++itr )
+    return MonotoneChain(sorted_points);
+  }
+
+  std::vector<SpgMth::Point2d> Convexhull2D_ModifiedGrahams(PointSoAView2D points)
+  {
+    const std::size_t num_points = points.Size();
+    if(num_points < 3)
+      return points.ToPoints();
+
+    //key = x bits : y bits, so sorting the keys as integers sorts the points on x then y. Building and decoding
+    //the keys are plain loops over x[] and y[] which vectorise. (-0 sorts before +0, the only difference to the
+    //float comparison, and it doesn't affect the hull)
+    const float* xs = points.X();
+    const float* ys = points.Y();
+    std::vector<uint64_t> keys(num_points);
+    for(std::size_t i = 0; i < num_points; i++)
+      keys[i] = ((uint64_t)OrderedBits(xs[i]) << 32) | OrderedBits(ys[i]);
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<SpgMth::Point2d> sorted_points(num_points);
+    for(std::size_t i = 0; i < num_points; i++)
+      sorted_points[i] = {FromOrderedBits((uint32_t)(keys[i] >> 32)), FromOrderedBits((uint32_t)keys[i])};
+    return MonotoneChain(sorted_points);
+  }
+
+  namespace
+  {
+    //Andrew's monotone chain with the exact orientation test. hull_out = the strictly convex hull of points, CCW from
+    //the leftmost (lowest on ties) point. Sorts and de-duplicates points in place. Returns the index in hull_out of
+    //the rightmost (highest on ties) point - the lower chain is [0, that], lex ascending, the upper chain lex
+    //descending from there
+    uint32_t StrictHull(std::vector<SpgMth::Point2d>& points, std::vector<SpgMth::Point2d>& hull_out)
+    {
+      hull_out.clear();
+      std::sort(points.begin(), points.end(), LexLess);
+      points.erase(std::unique(points.begin(), points.end()), points.end());
+      const uint32_t num_points = (uint32_t)points.size();
+      if(num_points <= 2) {
+        hull_out.assign(points.begin(), points.end());
+        return (num_points == 0) ? 0 : num_points - 1;
+      }
+
+      for(auto& p : points) {
+        while((hull_out.size() >= 2) && (SpgMth::Orient2d(*(hull_out.end()-2), *(hull_out.end()-1), p) <= 0.0))
+          hull_out.pop_back();
+        hull_out.push_back(p);
+      }
+      const uint32_t max_idx = (uint32_t)hull_out.size() - 1;
+      const std::size_t lower_size = hull_out.size();
+      for(int32_t i = (int32_t)num_points - 2; i >= 0; i--) {
+        while((hull_out.size() > lower_size) && (SpgMth::Orient2d(*(hull_out.end()-2), *(hull_out.end()-1), points[i]) <= 0.0))
+          hull_out.pop_back();
+        hull_out.push_back(points[i]);
+      }
+      hull_out.pop_back(); //back at the start
+      return max_idx;
+    }
+
+    //A group's hull in Chan's algorithm, as made by StrictHull()
+    struct GroupHull
+    {
+      const SpgMth::Point2d* verts = nullptr;
+      uint32_t size = 0;
+      uint32_t max_idx = 0;
+
+      const SpgMth::Point2d& operator[](uint32_t i) const { return verts[i % size]; } //i <= size wraps to the start
+    };
+
+    constexpr uint32_t s_no_tangent = std::numeric_limits<uint32_t>::max();
+
+    //Index of the vertex equal to p, or s_no_tangent. Binary search on each chain
+    uint32_t FindVertex(const GroupHull& hull, const SpgMth::Point2d& p)
     {
-      while( (upper_hull.size() > 1) && SpgMth::Left({*(upper_hull.cend()-2), *(upper_hull.cend()-1)}, *itr))
-        upper_hull.pop_back();
+      const SpgMth::Point2d* lower_end = hull.verts + hull.max_idx + 1;
+      const SpgMth::Point2d* itr = std::lower_bound(hull.verts, lower_end, p, LexLess);
+      if((itr != lower_end) && (*itr == p))
+        return (uint32_t)(itr - hull.verts);
+      const SpgMth::Point2d* upper_end = hull.verts + hull.size;
+      itr = std::lower_bound(lower_end, upper_end, p, [](const SpgMth::Point2d& a, const SpgMth::Point2d& b) { return LexLess(b, a); });
+      if((itr != upper_end) && (*itr == p))
+        return (uint32_t)(itr - hull.verts);
+      return s_no_tangent;
+    }
 
-      upper_hull.push_back(*itr);
+    uint32_t TangentLinear(const GroupHull& hull, const SpgMth::Point2d& p)
+    {
+      uint32_t best = s_no_tangent;
+      for(uint32_t i = 0; i < hull.size; i++) {
+        if(hull[i] == p)
+          continue;
+        if((best == s_no_tangent) || IsBetterWrapCandidate(p, hull[best], hull[i]))
+          best = i;
+      }
+      return best;
     }
 
-    //generate lower hull
-    std::vector<SpgMth::Point2d> lower_hull;
-    for(auto itr = sorted_points.rbegin(); itr != sorted_points.rend(); ++itr )
+    //The next gift wrapping point from p among this group's vertices: the vertex with all the others left of p->it
+    //(the farthest one if two qualify). p is a vertex of the overall hull, so it's either one of this group's
+    //vertices - the answer is then just the next one - or strictly outside the group's hull, where a binary search
+    //finds the tangent (after Dan Sunday's tangent_PointPolyC()). s_no_tangent if every vertex is p
+    uint32_t Tangent(const GroupHull& hull, const SpgMth::Point2d& p)
     {
-      while( (lower_hull.size() > 1) && SpgMth::Left({*(lower_hull.cend()-2), *(lower_hull.cend()-1)}, *itr))
-        lower_hull.pop_back();
+      if(hull.size <= 3)
+        return TangentLinear(hull, p);
+      if(uint32_t idx = FindVertex(hull, p); idx != s_no_tangent)
+        return (idx + 1) % hull.size;
 
-      lower_hull.push_back(*itr);
+      //Vertices ordered by how good a next point they'd be (IsBetterWrapCandidate(), so on the line from p the
+      //further one is better). Going round the hull that rises to one maximum and falls to one minimum - the binary
+      //search follows the rising edges. With the distance tie break there are no flat spots, which would otherwise
+      //throw it when an edge is in line with p
+      auto better = [&p](const SpgMth::Point2d& a, const SpgMth::Point2d& b) { return IsBetterWrapCandidate(p, a, b); }; //b better than a
+      const uint32_t n = hull.size;
+      uint32_t result = s_no_tangent;
+      if(better(hull[1], hull[0]) && better(hull[n-1], hull[0]))
+        result = 0;
+      for(uint32_t a = 0, b = n; (result == s_no_tangent) && (b - a > 1);) {
+        uint32_t c = (a + b) / 2;
+        bool down_c = better(hull[c+1], hull[c]);
+        if(down_c && better(hull[c-1], hull[c])) {
+          result = c;
+          break;
+        }
+        bool up_a = better(hull[a], hull[a+1]);
+        if(up_a) {
+          if(down_c || better(hull[c], hull[a]))
+            b = c;
+          else
+            a = c;
+        }
+        else {
+          if(!down_c || !better(hull[a], hull[c]))
+            a = c;
+          else
+            b = c;
+        }
+      }
+      if(result == s_no_tangent)
+        return TangentLinear(hull, p); //shouldn't happen, but cheap insurance
+      return result;
     }
 
-    //merge lower into upper
-    upper_hull.insert(upper_hull.end(), lower_hull.begin()+1, lower_hull.end()-1);
-    return upper_hull;
+    //Extreme points in 8 directions, in CCW order round the hull: min y, max x-y, max x, max x+y, max y, max y-x,
+    //min x, min x+y. The first point found wins ties, so merging chunk results in order gives the serial answer
+    struct Extremes
+    {
+      SpgMth::Point2d points[8];
+      double keys[8]; //the value being maximised in each direction
+      bool empty = true;
+
+      void Add(const SpgMth::Point2d& p)
+      {
+        const double x = p.x, y = p.y;
+        const double p_keys[8] = {-y, x - y, x, x + y, y, y - x, -x, -x - y};
+        if(empty) {
+          for(int k = 0; k < 8; k++) {
+            points[k] = p;
+            keys[k] = p_keys[k];
+          }
+          empty = false;
+          return;
+        }
+        for(int k = 0; k < 8; k++) {
+          if(p_keys[k] > keys[k]) {
+            points[k] = p;
+            keys[k] = p_keys[k];
+          }
+        }
+      }
+
+      void Merge(const Extremes& other)
+      {
+        if(other.empty)
+          return;
+        if(empty) {
+          *this = other;
+          return;
+        }
+        for(int k = 0; k < 8; k++) {
+          if(other.keys[k] > keys[k]) {
+            points[k] = other.points[k];
+            keys[k] = other.keys[k];
+          }
+        }
+      }
+    };
+
+    Extremes FindExtremes(std::span<const SpgMth::Point2d> points)
+    {
+      Extremes extremes;
+      for(auto& p : points)
+        extremes.Add(p);
+      return extremes;
+    }
+
+    //Polygon through the extreme points, CCW, consecutive duplicates removed. x+y and x-y can round (in double),
+    //so the octagon is checked to be convex and if not (very unlikely) the quadrilateral of the x,y extremes is
+    //used, which is exact. Empty if there's nothing to cull against
+    std::vector<SpgMth::Point2d> ExtremePolygon(const Extremes& extremes)
+    {
+      auto make_polygon = [&extremes](std::initializer_list<int> directions) {
+        std::vector<SpgMth::Point2d> polygon;
+        for(int k : directions) {
+          if(polygon.empty() || (polygon.back() != extremes.points[k]))
+            polygon.push_back(extremes.points[k]);
+        }
+        while((polygon.size() > 1) && (polygon.back() == polygon.front()))
+          polygon.pop_back();
+        const std::size_t n = polygon.size();
+        for(std::size_t i = 0; i < n; i++) {
+          if(SpgMth::Orient2d(polygon[i], polygon[(i+1) % n], polygon[(i+2) % n]) < 0.0)
+            return std::vector<SpgMth::Point2d>();
+        }
+        return (n < 3) ? std::vector<SpgMth::Point2d>() : polygon;
+      };
+
+      if(extremes.empty)
+        return {};
+      auto polygon = make_polygon({0, 1, 2, 3, 4, 5, 6, 7});
+      if(polygon.empty())
+        polygon = make_polygon({0, 2, 4, 6});
+      return polygon;
+    }
+
+    //Appends the points that aren't strictly inside polygon (convex, CCW) to out: inside = left of every edge, which
+    //is one LeftBatch() bitmask per edge ANDed together
+    void CullInside(const std::vector<SpgMth::Point2d>& polygon, std::span<const SpgMth::Point2d> points, std::vector<SpgMth::Point2d>& out)
+    {
+      if(polygon.size() < 3) {
+        out.insert(out.end(), points.begin(), points.end());
+        return;
+      }
+      const std::size_t num_points = points.size();
+      const std::size_t num_words = SpgMth::BitmaskWords(num_points);
+      std::vector<uint64_t> inside(num_words, ~0ull);
+      std::vector<uint64_t> edge_mask(num_words);
+      for(std::size_t e = 0; e < polygon.size(); e++) {
+        SpgMth::LineSeg2D edge{polygon[e], polygon[(e+1) % polygon.size()]};
+        SpgMth::LeftBatch(edge, points, edge_mask);
+        for(std::size_t w = 0; w < num_words; w++)
+          inside[w] &= edge_mask[w];
+      }
+      for(std::size_t w = 0; w < num_words; w++) {
+        for(uint64_t keep = ~inside[w]; keep != 0; keep &= keep - 1) {
+          std::size_t i = w * 64 + std::countr_zero(keep);
+          if(i >= num_points)
+            break;
+          out.push_back(points[i]);
+        }
+      }
+    }
   }
 
+  std::vector<SpgMth::Point2d> AklToussaintCull(std::span<const SpgMth::Point2d> points)
+  {
+    std::vector<SpgMth::Point2d> survivors;
+    CullInside(ExtremePolygon(FindExtremes(points)), points, survivors);
+    return survivors;
+  }
 
-}
\ No newline at end of file
+  std::vector<SpgMth::Point2d> ConvexHull2D_Chan(std::span<const SpgMth::Point2d> points)
+  {
+    std::vector<SpgMth::Point2d> candidates = AklToussaintCull(points);
+    std::vector<SpgMth::Point2d> hull;
+    if(candidates.size() < 3) {
+      StrictHull(candidates, hull);
+      return hull;
+    }
+    const uint32_t num_points = (uint32_t)candidates.size();
+    const SpgMth::Point2d start = *std::min_element(candidates.begin(), candidates.end(), LexLess);
+
+    std::vector<SpgMth::Point2d> group_points, group_hull, all_group_verts;
+    std::vector<uint32_t> group_offsets, group_max_idx;
+    std::vector<GroupHull> groups;
+    for(uint32_t t = 1; ; t++) {
+      //m = 2^2^t, capped at n, which always finishes
+      const uint32_t group_size = (t >= 5) ? num_points : (uint32_t)std::min<uint64_t>(num_points, 1ull << (1u << t));
+
+      all_group_verts.clear();
+      group_offsets.assign(1, 0);
+      group_max_idx.clear();
+      for(uint32_t first = 0; first < num_points; first += group_size) {
+        group_points.assign(candidates.begin() + first, candidates.begin() + std::min(num_points, first + group_size));
+        group_max_idx.push_back(StrictHull(group_points, group_hull));
+        all_group_verts.insert(all_group_verts.end(), group_hull.begin(), group_hull.end());
+        group_offsets.push_back((uint32_t)all_group_verts.size());
+      }
+      groups.clear();
+      for(uint32_t g = 0; g < group_max_idx.size(); g++)
+        groups.push_back({all_group_verts.data() + group_offsets[g], group_offsets[g+1] - group_offsets[g], group_max_idx[g]});
+
+      //Gift wrap for up to m steps, each step taking the best of the groups' tangents
+      hull.assign(1, start);
+      SpgMth::Point2d p = start;
+      bool closed = false;
+      for(uint32_t step = 0; step < group_size; step++) {
+        bool found = false;
+        SpgMth::Point2d best;
+        for(auto& group : groups) {
+          uint32_t idx = Tangent(group, p);
+          if(idx == s_no_tangent)
+            continue;
+          const SpgMth::Point2d& q = group[idx];
+          if(!found || IsBetterWrapCandidate(p, best, q)) {
+            best = q;
+            found = true;
+          }
+        }
+        if(!found || (best == start)) {
+          closed = true;
+          break;
+        }
+        hull.push_back(best);
+        p = best;
+      }
+      if(closed)
+        return hull;
+    }
+  }
+
+  std::vector<SpgMth::Point2d> ConvexHull2D_Parallel(std::span<const SpgMth::Point2d> points, Core::ThreadPool& pool)
+  {
+    const uint32_t MIN_POINTS_PER_CHUNK = 1u << 16;
+    const uint32_t num_points = (uint32_t)points.size();
+    const uint32_t num_chunks = std::clamp(num_points / MIN_POINTS_PER_CHUNK, 1u, pool.NumThreads() * 4);
+    std::vector<SpgMth::Point2d> hull;
+    if(num_chunks <= 1) {
+      std::vector<SpgMth::Point2d> candidates = AklToussaintCull(points);
+      StrictHull(candidates, hull);
+      return hull;
+    }
+    const uint32_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+    auto chunk_points = [&](uint32_t c) {
+      const uint32_t first = std::min(num_points, c * chunk_size);
+      return points.subspan(first, std::min(num_points, first + chunk_size) - first);
+    };
+
+    //Pass 1: extremes of each chunk, merged into the culling polygon
+    std::vector<Extremes> chunk_extremes(num_chunks);
+    pool.ParallelFor(num_chunks, 1, [&](uint32_t chunk_begin, uint32_t chunk_end) {
+      for(uint32_t c = chunk_begin; c < chunk_end; ++c)
+        chunk_extremes[c] = FindExtremes(chunk_points(c));
+    });
+    Extremes extremes;
+    for(auto& e : chunk_extremes)
+      extremes.Merge(e);
+    const std::vector<SpgMth::Point2d> polygon = ExtremePolygon(extremes);
+
+    //Pass 2: cull and hull each chunk
+    std::vector<std::vector<SpgMth::Point2d>> chunk_hulls(num_chunks);
+    pool.ParallelFor(num_chunks, 1, [&](uint32_t chunk_begin, uint32_t chunk_end) {
+      std::vector<SpgMth::Point2d> candidates;
+      for(uint32_t c = chunk_begin; c < chunk_end; ++c) {
+        candidates.clear();
+        CullInside(polygon, chunk_points(c), candidates);
+        StrictHull(candidates, chunk_hulls[c]);
+      }
+    });
+
+    //Merge: the hull of the chunk hulls
+    std::vector<SpgMth::Point2d> hull_verts;
+    for(auto& chunk_hull : chunk_hulls)
+      hull_verts.insert(hull_verts.end(), chunk_hull.begin(), chunk_hull.end());
+    StrictHull(hull_verts, hull);
+    return hull;
+  }
+
+  void Test_ConvexHull()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("ConvexHull");
+    SPG_WARN("-------------------------------------------------------------------------");
+
+    //Scan sized inputs: uniform in a square (h ~ log n) and in a disc (h ~ n^1/3)
+    const uint32_t NUM_POINTS = 10000000;
+    std::mt19937 mt(19);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+    for(bool disc : {false, true}) {
+      std::vector<SpgMth::Point2d> points;
+      points.reserve(NUM_POINTS);
+      while(points.size() < NUM_POINTS) {
+        SpgMth::Point2d p{dist(mt), dist(mt)};
+        if(!disc || (p.x * p.x + p.y * p.y < 1000.0f * 1000.0f))
+          points.push_back(p);
+      }
+      SPG_WARN("{} points, uniform in a {}", NUM_POINTS, disc ? "disc" : "square");
+
+      Core::Timer timer;
+      auto cull = AklToussaintCull(points);
+      SPG_INFO("AklToussaintCull: {:.2f} ms, {} points left", timer.ElapsedMillis(), cull.size());
+      timer.Reset();
+      auto grahams = Convexhull2D_ModifiedGrahams(points);
+      SPG_INFO("Convexhull2D_ModifiedGrahams: {:.2f} ms, {} points", timer.ElapsedMillis(), grahams.size());
+      timer.Reset();
+      auto chan = ConvexHull2D_Chan(points);
+      SPG_INFO("ConvexHull2D_Chan: {:.2f} ms, {} points", timer.ElapsedMillis(), chan.size());
+      timer.Reset();
+      auto parallel = ConvexHull2D_Parallel(points);
+      SPG_INFO("ConvexHull2D_Parallel: {:.2f} ms, {} points, {} threads", timer.ElapsedMillis(), parallel.size(), Core::ThreadPool::Default().NumThreads());
+      SPG_ASSERT(chan == parallel);
+    }
+  }
+}
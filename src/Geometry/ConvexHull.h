@@ -1,12 +1,39 @@
 #pragma once
+#include <span>
 #include <vector>
 
+#include "CoreLib/ThreadPool.h"
 #include "MathLib/Geom/Geom.h"
+#include "Geometry/PointSoA2D.h"
 
 namespace Geom
 {
+  //O(nh). CCW, starting at the bottom most point. Exact orientation tests, no collinear points on the hull
   std::vector<SpgMth::Point2d> ConvexHull2D_GiftWrap(const std::vector<SpgMth::Point2d>& points);
 
   std::vector<SpgMth::Point2d> Convexhull2D_ModifiedGrahams(const std::vector<SpgMth::Point2d>& points);
-  
-}
\ No newline at end of file
+
+  //Same hull (same points, same order), but sorts one integer key per point built straight from the x and y
+  //arrays rather than sorting Point2d's through a comparator
+  std::vector<SpgMth::Point2d> Convexhull2D_ModifiedGrahams(PointSoAView2D points);
+
+  //The hulls below all use the exact orientation test (SpgMth::Orient2d), return the strictly convex hull (no
+  //collinear or duplicate points) CCW, starting at the leftmost point (lowest if there's a tie), so for the same
+  //input they give identical output. Both start with AklToussaintCull().
+
+  //Chan's algorithm, O(n log h): hulls of groups of m points, then gift wrapping over the groups with a binary
+  //search for each group's tangent, guessing m = 2^2^t for t = 1,2,.. until m >= h.
+  std::vector<SpgMth::Point2d> ConvexHull2D_Chan(std::span<const SpgMth::Point2d> points);
+
+  //Divide and conquer across the pool: the cull and a monotone chain hull of each chunk of points run in parallel,
+  //then the chunk hulls are merged (hull of their vertices, which is tiny). Small inputs just run serially
+  std::vector<SpgMth::Point2d> ConvexHull2D_Parallel(std::span<const SpgMth::Point2d> points, Core::ThreadPool& pool = Core::ThreadPool::Default());
+
+  //Akl-Toussaint heuristic: drops the points strictly inside the polygon through the extreme points in 8 directions
+  //(min/max of x, y, x+y, x-y), none of which can be on the hull. One linear pass to find the extremes, then the
+  //inside test is LeftBatch() against each polygon edge. For uniformly distributed input nearly everything goes.
+  //The survivors keep their input order
+  std::vector<SpgMth::Point2d> AklToussaintCull(std::span<const SpgMth::Point2d> points);
+
+  void Test_ConvexHull();
+}
@@ -1,5 +1,13 @@
 #include "DCEL.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+
 #include "CoreLib/Core.h"
+#include "CoreLib/Timer.h"
+#include "MathLib/Geom/Predicates.h"
 
 
 namespace Geom
@@ -935,4 +943,785 @@ namespace Geom
 
   }
 
+  namespace dcel_v3
+  {
+    using Vertex = DCEL::Vertex;
+    using HalfEdge = DCEL::HalfEdge;
+    using Face = DCEL::Face;
+    using Diagonal = DCEL::Diagonal;
+    using VertexId = DCEL::VertexId;
+    using HalfEdgeId = DCEL::HalfEdgeId;
+    using FaceId = DCEL::FaceId;
+    using HoleId = DCEL::HoleId;
+
+    DCEL::DCEL()
+    {
+      m_faces.push_back(Face{}); //unbounded
+    }
+
+    DCEL::DCEL(std::span<const SpgMth::Point2d> points) : DCEL()
+    {
+      Init(points);
+    }
+
+    void DCEL::Clear()
+    {
+      m_vertices.clear();
+      m_half_edges.clear();
+      m_faces.clear();
+      m_holes.clear();
+      m_faces.push_back(Face{});
+      m_edge_index.Clear();
+    }
+
+    void DCEL::BuildEdgeIndex()
+    {
+      SpgMth::BoundingBox bounds;
+      for(auto& v : m_vertices)
+        bounds.Update(v.point);
+      if(m_vertices.empty())
+        bounds.Update({0,0});
+      m_edge_index.Reset(bounds, NumHalfEdges() / 2);
+      for(HalfEdgeId h = 0; h < NumHalfEdges(); h += 2) {
+        if((Origin(h) != s_null) && (Origin(Twin(h)) != s_null))
+          m_edge_index.Insert(h / 2, GetOriginPoint(h), GetDestinationPoint(h));
+      }
+    }
+
+    void DCEL::Reserve(uint32_t num_vertices, uint32_t num_half_edges, uint32_t num_faces)
+    {
+      m_vertices.reserve(num_vertices);
+      m_half_edges.reserve(num_half_edges);
+      m_faces.reserve(num_faces);
+    }
+
+    //Assumes that points form a closed loop ordered CCW. Half edge 2i goes from vertex i to i+1 (interior face),
+    //2i+1 is its twin (unbounded face)
+    void DCEL::Init(std::span<const SpgMth::Point2d> points)
+    {
+      SPG_ASSERT(m_vertices.size() == 0);
+      SPG_ASSERT(m_half_edges.size() == 0);
+      SPG_ASSERT(m_faces.size() == 1);
+
+      if(points.size() < 3)
+        return;
+
+      const uint32_t n = (uint32_t)points.size();
+      Reserve(n, 2*n, 2);
+      FaceId face = MakeFace();
+      for(uint32_t i = 0; i < n; i++) {
+        VertexId v = MakeVertex(points[i]);
+        HalfEdgeId h = MakeHalfEdgePair();
+        m_vertices[v].incident_edge = h;
+      }
+      for(uint32_t i = 0; i < n; i++) {
+        uint32_t i_next = (i+1 < n) ? i+1 : 0;
+        uint32_t i_prev = (i > 0) ? i-1 : n-1;
+        HalfEdge& h_ccw = m_half_edges[2*i];
+        h_ccw.origin = i;
+        h_ccw.next = 2*i_next;
+        h_ccw.prev = 2*i_prev;
+        h_ccw.face = face;
+        HalfEdge& h_cw = m_half_edges[2*i + 1];
+        h_cw.origin = i_next;
+        h_cw.next = 2*i_prev + 1;
+        h_cw.prev = 2*i_next + 1;
+        h_cw.face = s_unbounded_face;
+      }
+      m_faces[face].outer = 0;
+      AddHole(s_unbounded_face, 1);
+    }
+
+    bool DCEL::Build(std::span<const SpgMth::Point2d> points, std::span<const FaceIndices> faces)
+    {
+      //Flatten, outer boundaries CCW and holes CW
+      std::vector<uint32_t> indices;
+      std::vector<uint32_t> loop_starts{0};
+      std::vector<FaceId> loop_faces;
+      auto add_loop = [&](const std::vector<uint32_t>& loop, FaceId f, bool ccw) {
+        double area = 0.0;
+        for(std::size_t i = 0, j = loop.size() - 1; i < loop.size(); j = i++) {
+          if((loop[i] < points.size()) && (loop[j] < points.size())) { //out of range is reported below
+            SpgMth::DPoint2d a(points[loop[j]]), b(points[loop[i]]);
+            area += a.x * b.y - b.x * a.y;
+          }
+        }
+        if((area > 0.0) == ccw)
+          indices.insert(indices.end(), loop.begin(), loop.end());
+        else
+          indices.insert(indices.end(), loop.rbegin(), loop.rend());
+        loop_starts.push_back((uint32_t)indices.size());
+        loop_faces.push_back(f);
+      };
+      for(uint32_t i = 0; i < (uint32_t)faces.size(); i++) {
+        add_loop(faces[i].outer, i+1, true);
+        for(auto& hole : faces[i].holes)
+          add_loop(hole, i+1, false);
+      }
+      return BuildFromLoops(points, indices, loop_starts, loop_faces, (uint32_t)faces.size());
+    }
+
+    bool DCEL::BuildFromTriangles(std::span<const SpgMth::Point2d> points, std::span<const uint32_t> triangles)
+    {
+      SPG_ASSERT(triangles.size() % 3 == 0);
+      const uint32_t num_triangles = (uint32_t)(triangles.size() / 3);
+      std::vector<uint32_t> indices(triangles.begin(), triangles.begin() + 3*num_triangles);
+      std::vector<uint32_t> loop_starts(num_triangles + 1);
+      std::vector<FaceId> loop_faces(num_triangles);
+      for(uint32_t t = 0; t < num_triangles; t++) {
+        uint32_t* tri = &indices[3*t];
+        if((tri[0] < points.size()) && (tri[1] < points.size()) && (tri[2] < points.size()) &&
+          (SpgMth::Orient2d(points[tri[0]], points[tri[1]], points[tri[2]]) < 0.0))
+          std::swap(tri[1], tri[2]);
+        loop_starts[t+1] = 3*(t+1);
+        loop_faces[t] = t+1;
+      }
+      return BuildFromLoops(points, indices, loop_starts, loop_faces, num_triangles);
+    }
+
+    bool DCEL::BuildFromLoops(std::span<const SpgMth::Point2d> points, std::span<const uint32_t> indices,
+      std::span<const uint32_t> loop_starts, std::span<const FaceId> loop_faces, uint32_t num_faces)
+    {
+      Clear();
+      const uint32_t num_loops = (uint32_t)loop_faces.size();
+      const uint32_t num_edges = (uint32_t)indices.size();
+      SPG_ASSERT(loop_starts.size() == num_loops + 1);
+      for(uint32_t i : indices) {
+        if(i >= points.size()) {
+          SPG_ERROR("DCEL::Build: vertex index {} out of range", i);
+          return false;
+        }
+      }
+
+      //Input edge e goes from indices[e] to indices[loop_next[e]]
+      std::vector<uint32_t> loop_next(num_edges);
+      for(uint32_t l = 0; l < num_loops; l++) {
+        //Checked before taking last - an empty loop would wrap it round
+        if((loop_starts[l+1] < loop_starts[l]) || (loop_starts[l+1] - loop_starts[l] < 3)) {
+          SPG_ERROR("DCEL::Build: loop {} has less than 3 vertices", l);
+          return false;
+        }
+        uint32_t first = loop_starts[l], last = loop_starts[l+1] - 1;
+        for(uint32_t e = first; e < last; e++)
+          loop_next[e] = e + 1;
+        loop_next[last] = first;
+      }
+
+      //Sort on the undirected edge. A run of 1 is a boundary edge, its twin goes in the unbounded face. A run of 2 in
+      //opposite directions is a pair of twins
+      struct EdgeKey
+      {
+        uint64_t key;
+        uint32_t edge;
+      };
+      std::vector<EdgeKey> keys(num_edges);
+      for(uint32_t e = 0; e < num_edges; e++) {
+        uint32_t a = indices[e], b = indices[loop_next[e]];
+        if(a == b) {
+          SPG_ERROR("DCEL::Build: repeated vertex {}", a);
+          return false;
+        }
+        keys[e] = {((uint64_t)std::min(a,b) << 32) | std::max(a,b), e};
+      }
+      std::sort(keys.begin(), keys.end(), [](const EdgeKey& k1, const EdgeKey& k2) { return k1.key < k2.key; });
+
+      std::vector<HalfEdgeId> edge_ids(num_edges);
+      std::vector<HalfEdgeId> boundary_twins;
+      uint32_t num_pairs = 0;
+      for(uint32_t i = 0; i < num_edges; ) {
+        uint32_t j = i + 1;
+        while((j < num_edges) && (keys[j].key == keys[i].key))
+          j++;
+        edge_ids[keys[i].edge] = 2*num_pairs;
+        if(j - i == 1)
+          boundary_twins.push_back(2*num_pairs + 1);
+        else if((j - i == 2) && (indices[keys[i].edge] != indices[keys[i+1].edge]))
+          edge_ids[keys[i+1].edge] = 2*num_pairs + 1;
+        else {
+          SPG_ERROR("DCEL::Build: edge {}-{} is in more than 2 faces, or 2 with the same orientation", keys[i].key >> 32, keys[i].key & 0xffffffff);
+          return false;
+        }
+        num_pairs++;
+        i = j;
+      }
+
+      m_vertices.reserve(points.size());
+      for(auto& p : points)
+        MakeVertex(p);
+      m_half_edges.resize(2*num_pairs);
+      m_faces.resize(num_faces + 1);
+
+      for(uint32_t e = 0; e < num_edges; e++) {
+        HalfEdgeId h = edge_ids[e];
+        HalfEdgeId h_next = edge_ids[loop_next[e]];
+        m_half_edges[h].origin = indices[e];
+        m_half_edges[h].next = h_next;
+        m_half_edges[h_next].prev = h;
+        m_vertices[indices[e]].incident_edge = h;
+      }
+      for(uint32_t l = 0; l < num_loops; l++) {
+        HalfEdgeId h = edge_ids[loop_starts[l]];
+        FaceId f = loop_faces[l];
+        SetLoopFace(h, f);
+        if(m_faces[f].outer == s_null)
+          m_faces[f].outer = h;
+        else
+          AddHole(f, h);
+      }
+
+      //Link the boundary twins. The one arriving at v is followed by the one leaving v - unless 2 or more leave v
+      //(faces touching at a corner), then it's followed by the next edge clockwise around v
+      const uint32_t num_vertices = NumVertices();
+      std::vector<HalfEdgeId> boundary_out(num_vertices, s_null);
+      std::vector<uint8_t> pinch(num_vertices, 0);
+      for(HalfEdgeId t : boundary_twins) {
+        VertexId v = Origin(Next(Twin(t))); //t's origin is its twin's destination
+        m_half_edges[t].origin = v;
+        m_half_edges[t].face = s_unbounded_face;
+        if(boundary_out[v] != s_null)
+          pinch[v] = 1;
+        boundary_out[v] = t;
+      }
+      std::vector<std::pair<VertexId,HalfEdgeId>> pinch_out; //(vertex, departing edge) sorted CCW around each vertex
+      for(HalfEdgeId h = 0; h < NumHalfEdges(); h++) {
+        if(pinch[Origin(h)])
+          pinch_out.push_back({Origin(h), h});
+      }
+      std::sort(pinch_out.begin(), pinch_out.end(), [this](const auto& o1, const auto& o2) {
+        if(o1.first != o2.first)
+          return o1.first < o2.first;
+        SpgMth::DVec2 d1 = SpgMth::DPoint2d(GetDestinationPoint(o1.second)) - SpgMth::DPoint2d(GetPoint(o1.first));
+        SpgMth::DVec2 d2 = SpgMth::DPoint2d(GetDestinationPoint(o2.second)) - SpgMth::DPoint2d(GetPoint(o2.first));
+        bool upper1 = (d1.y > 0.0) || ((d1.y == 0.0) && (d1.x > 0.0));
+        bool upper2 = (d2.y > 0.0) || ((d2.y == 0.0) && (d2.x > 0.0));
+        if(upper1 != upper2)
+          return upper1;
+        return SpgMth::Orient2d(GetPoint(o1.first), GetDestinationPoint(o1.second), GetDestinationPoint(o2.second)) > 0.0;
+      });
+      for(HalfEdgeId t : boundary_twins) {
+        VertexId v = Origin(Twin(t));
+        HalfEdgeId t_next = boundary_out[v];
+        if(pinch[v]) {
+          auto first = std::lower_bound(pinch_out.begin(), pinch_out.end(), v, [](const auto& o, VertexId v) { return o.first < v; });
+          auto last = std::upper_bound(first, pinch_out.end(), v, [](VertexId v, const auto& o) { return v < o.first; });
+          auto o = std::find_if(first, last, [t](const auto& o) { return o.second == Twin(t); });
+          t_next = std::prev((o == first) ? last : o)->second;
+        }
+        m_half_edges[t].next = t_next;
+        m_half_edges[t_next].prev = t;
+      }
+
+      //Each boundary loop is a hole in the unbounded face
+      std::vector<uint8_t> visited(NumHalfEdges(), 0);
+      for(HalfEdgeId t : boundary_twins) {
+        if(visited[t])
+          continue;
+        ForEachLoopEdge(t, [&](HalfEdgeId e) { visited[e] = 1; });
+        AddHole(s_unbounded_face, t);
+      }
+      return true;
+    }
+
+    VertexId DCEL::MakeVertex(const SpgMth::Point2d& point)
+    {
+      m_vertices.push_back(Vertex{point, s_null});
+      return (VertexId)m_vertices.size() - 1;
+    }
+
+    HalfEdgeId DCEL::MakeHalfEdgePair()
+    {
+      m_half_edges.push_back(HalfEdge{});
+      m_half_edges.push_back(HalfEdge{});
+      return (HalfEdgeId)m_half_edges.size() - 2;
+    }
+
+    FaceId DCEL::MakeFace()
+    {
+      m_faces.push_back(Face{});
+      return (FaceId)m_faces.size() - 1;
+    }
+
+    HoleId DCEL::AddHole(FaceId f, HalfEdgeId h)
+    {
+      m_holes.push_back(Hole{h, m_faces[f].first_hole});
+      m_faces[f].first_hole = (HoleId)m_holes.size() - 1;
+      return m_faces[f].first_hole;
+    }
+
+    void DCEL::RemoveHole(FaceId f, HoleId hole)
+    {
+      HoleId* link = &m_faces[f].first_hole;
+      while(*link != hole) {
+        SPG_ASSERT(*link != s_null);
+        link = &m_holes[*link].next;
+      }
+      *link = m_holes[hole].next;
+      m_holes[hole] = Hole{};
+    }
+
+    //The hole of f whose loop h is on, s_null if it's the outer boundary. Walks the hole loops rather than h's
+    //loop, which might be the (much bigger) outer boundary
+    HoleId DCEL::FindHoleOnLoop(FaceId f, HalfEdgeId h) const
+    {
+      for(HoleId hole = m_faces[f].first_hole; hole != s_null; hole = m_holes[hole].next) {
+        HalfEdgeId e = m_holes[hole].edge;
+        do {
+          if(e == h)
+            return hole;
+          e = m_half_edges[e].next;
+        } while(e != m_holes[hole].edge);
+      }
+      return s_null;
+    }
+
+    void DCEL::SetLoopFace(HalfEdgeId h, FaceId f)
+    {
+      HalfEdgeId e = h;
+      do {
+        m_half_edges[e].face = f;
+        e = m_half_edges[e].next;
+      } while(e != h);
+    }
+
+    double DCEL::LoopSignedArea(HalfEdgeId h) const
+    {
+      double area = 0.0;
+      ForEachLoopEdge(h, [&](HalfEdgeId e) {
+        SpgMth::DPoint2d a(GetOriginPoint(e)), b(GetDestinationPoint(e));
+        area += a.x * b.y - b.x * a.y;
+      });
+      return 0.5 * area;
+    }
+
+    //Crossing number, as PointInPolygon()
+    bool DCEL::LoopContains(HalfEdgeId h, const SpgMth::Point2d& p) const
+    {
+      bool inside = false;
+      ForEachLoopEdge(h, [&](HalfEdgeId e) {
+        SpgMth::DPoint2d a(GetOriginPoint(e)), b(GetDestinationPoint(e));
+        if((a.y > p.y) != (b.y > p.y)) {
+          double x_cross = (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x;
+          if(p.x < x_cross)
+            inside = !inside;
+        }
+      });
+      return inside;
+    }
+
+    VertexId DCEL::Split(const SpgMth::Point2d& point, HalfEdgeId h)
+    {
+      //h: a->b, t: b->a  becomes  h: a->p, n: p->b, nt: b->p, t: p->a
+      HalfEdgeId t = Twin(h);
+      VertexId b = Destination(h);
+      VertexId p = MakeVertex(point);
+      HalfEdgeId n = MakeHalfEdgePair();
+      HalfEdgeId nt = Twin(n);
+
+      HalfEdge& he_n = m_half_edges[n];
+      he_n.origin = p;
+      he_n.face = m_half_edges[h].face;
+      he_n.prev = h;
+      he_n.next = m_half_edges[h].next;
+      m_half_edges[he_n.next].prev = n;
+      m_half_edges[h].next = n;
+
+      HalfEdge& he_nt = m_half_edges[nt];
+      he_nt.origin = b;
+      he_nt.face = m_half_edges[t].face;
+      he_nt.next = t;
+      he_nt.prev = m_half_edges[t].prev;
+      m_half_edges[he_nt.prev].next = nt;
+      m_half_edges[t].prev = nt;
+      m_half_edges[t].origin = p;
+
+      if(m_vertices[b].incident_edge == t)
+        m_vertices[b].incident_edge = nt;
+      m_vertices[p].incident_edge = n;
+
+      //h shrinks so its grid cells can stay as they are
+      if(HasEdgeIndex()) {
+        if(m_edge_index.Contains(point))
+          m_edge_index.Insert(n / 2, point, GetPoint(b));
+        else
+          BuildEdgeIndex();
+      }
+      return p;
+    }
+
+    std::vector<HalfEdgeId> DCEL::GetEdgeLoop(HalfEdgeId h) const
+    {
+      std::vector<HalfEdgeId> edge_loop;
+      ForEachLoopEdge(h, [&](HalfEdgeId e) { edge_loop.push_back(e); });
+      return edge_loop;
+    }
+
+    std::vector<VertexId> DCEL::GetVertices(FaceId f) const
+    {
+      std::vector<VertexId> vertices;
+      if(m_faces[f].outer != s_null)
+        ForEachLoopEdge(m_faces[f].outer, [&](HalfEdgeId e) { vertices.push_back(Origin(e)); });
+      return vertices;
+    }
+
+    std::vector<HalfEdgeId> DCEL::GetDepartingEdges(VertexId v) const
+    {
+      std::vector<HalfEdgeId> half_edges;
+      ForEachDepartingEdge(v, [&](HalfEdgeId e) { half_edges.push_back(e); });
+      return half_edges;
+    }
+
+    HalfEdgeId DCEL::GetDepartingEdge(VertexId v, FaceId f) const
+    {
+      HalfEdgeId found = s_null;
+      ForEachDepartingEdge(v, [&](HalfEdgeId e) {
+        if((found == s_null) && (m_half_edges[e].face == f))
+          found = e;
+      });
+      return found;
+    }
+
+    //The common face must be bounded
+    std::pair<HalfEdgeId,HalfEdgeId> DCEL::FindDepartingEdgesWithCommonFace(VertexId v1, VertexId v2) const
+    {
+      HalfEdgeId first1 = m_vertices[v1].incident_edge;
+      HalfEdgeId first2 = m_vertices[v2].incident_edge;
+      if((first1 == s_null) || (first2 == s_null))
+        return {s_null, s_null};
+      HalfEdgeId e1 = first1;
+      do {
+        FaceId f = m_half_edges[e1].face;
+        if(m_faces[f].outer != s_null) {
+          HalfEdgeId e2 = first2;
+          do {
+            if(m_half_edges[e2].face == f)
+              return {e1, e2};
+            e2 = m_half_edges[Twin(e2)].next;
+          } while(e2 != first2);
+        }
+        e1 = m_half_edges[Twin(e1)].next;
+      } while(e1 != first1);
+      return {s_null, s_null};
+    }
+
+    //Every boundary edge of f not incident to v1 or v2 against the segment v1-v2 - or just those near it, with the
+    //edge index
+    bool DCEL::AnyIntersectionsExist(VertexId v1, VertexId v2, FaceId f) const
+    {
+      SpgMth::DPoint2d a(GetPoint(v1)), b(GetPoint(v2));
+      if(HasEdgeIndex()) {
+        return m_edge_index.ForEachCandidate(GetPoint(v1), GetPoint(v2), [&](uint32_t pair) {
+          HalfEdgeId e = 2 * pair;
+          if((m_half_edges[e].face != f) && (m_half_edges[e+1].face != f))
+            return false;
+          VertexId orig = Origin(e), dest = Destination(e);
+          return (orig != v1) && (orig != v2) && (dest != v1) && (dest != v2) &&
+            SpgMth::IntersectionExistsExact(a, b, SpgMth::DPoint2d(GetPoint(orig)), SpgMth::DPoint2d(GetPoint(dest)));
+        });
+      }
+
+      bool found = false;
+      ForEachBoundaryLoop(f, [&](HalfEdgeId loop) {
+        HalfEdgeId e = loop;
+        do {
+          VertexId orig = Origin(e), dest = Destination(e);
+          if((orig != v1) && (orig != v2) && (dest != v1) && (dest != v2) &&
+            SpgMth::IntersectionExistsExact(a, b, SpgMth::DPoint2d(GetPoint(orig)), SpgMth::DPoint2d(GetPoint(dest)))) {
+            found = true;
+            return;
+          }
+          e = m_half_edges[e].next;
+        } while(!found && (e != loop));
+      });
+      return found;
+    }
+
+    //Interior angle of the face at the origin of departing_edge <= 180
+    bool DCEL::IsConvex(HalfEdgeId departing_edge) const
+    {
+      return SpgMth::Orient2d(GetOriginPoint(Prev(departing_edge)), GetOriginPoint(departing_edge), GetDestinationPoint(departing_edge)) >= 0.0;
+    }
+
+    //Is the direction from the origin of orig_depart_edge to dest strictly inside the face's angle there
+    bool DCEL::MakesInteriorConnection(VertexId dest, HalfEdgeId orig_depart_edge) const
+    {
+      const SpgMth::Point2d& a = GetOriginPoint(orig_depart_edge);
+      const SpgMth::Point2d& b = GetPoint(dest);
+      const SpgMth::Point2d& a_next = GetDestinationPoint(orig_depart_edge);
+      const SpgMth::Point2d& a_prev = GetOriginPoint(Prev(orig_depart_edge));
+      if(IsConvex(orig_depart_edge)) //The 2 neighbours must be strictly on different sides
+        return (SpgMth::Orient2d(a, b, a_prev) > 0.0) && (SpgMth::Orient2d(b, a, a_next) > 0.0);
+      //reflex - interior unless it's in the (convex) exterior angle
+      return !((SpgMth::Orient2d(a, b, a_next) >= 0.0) && (SpgMth::Orient2d(b, a, a_prev) >= 0.0));
+    }
+
+    Diagonal DCEL::GetDiagonal(VertexId v1, VertexId v2) const
+    {
+      Diagonal d;
+      HalfEdgeId first1 = m_vertices[v1].incident_edge;
+      if((v1 == v2) || (first1 == s_null) || (m_vertices[v2].incident_edge == s_null))
+        return d;
+
+      //v1 and v2 can share more than one bounded face (e.g. both on a hole - the hole's inside and the face around
+      //it). Only one of them can have v1-v2 inside its angle at v1 and v2, so the cheap tests pick the face and the
+      //boundary scan is only done for that one
+      HalfEdgeId e1 = first1;
+      do {
+        FaceId f = m_half_edges[e1].face;
+        HalfEdgeId e2 = (m_faces[f].outer != s_null) ? GetDepartingEdge(v2, f) : s_null;
+        if(e2 != s_null) {
+          d.departing_edge_v1 = e1;
+          d.departing_edge_v2 = e2;
+          if((Destination(e1) == v2) || (Destination(e2) == v1)) //neighbours
+            return d;
+          if(MakesInteriorConnection(v2, e1) && MakesInteriorConnection(v1, e2)) {
+            d.is_valid = !AnyIntersectionsExist(v1, v2, f);
+            return d;
+          }
+        }
+        e1 = m_half_edges[Twin(e1)].next;
+      } while(e1 != first1);
+      return d;
+    }
+
+    HalfEdgeId DCEL::Join(VertexId v1, VertexId v2)
+    {
+      Diagonal d = GetDiagonal(v1, v2);
+      if(!d.is_valid)
+        return s_null;
+      HalfEdgeId e1 = d.departing_edge_v1;
+      HalfEdgeId e2 = d.departing_edge_v2;
+      FaceId f = m_half_edges[e1].face;
+
+      //Which loops e1 and e2 are on, before relinking. With no holes there's just the one
+      bool same_loop = true;
+      HoleId hole1 = s_null, hole2 = s_null;
+      if(m_faces[f].first_hole != s_null) {
+        hole1 = FindHoleOnLoop(f, e1);
+        hole2 = FindHoleOnLoop(f, e2);
+        same_loop = (hole1 == hole2);
+      }
+
+      //a: v1->v2 continues along e2's loop, b: v2->v1 along e1's
+      HalfEdgeId a = MakeHalfEdgePair();
+      HalfEdgeId b = Twin(a);
+      HalfEdgeId e1_prev = m_half_edges[e1].prev;
+      HalfEdgeId e2_prev = m_half_edges[e2].prev;
+      m_half_edges[a] = HalfEdge{v1, e2, e1_prev, f};
+      m_half_edges[b] = HalfEdge{v2, e1, e2_prev, f};
+      m_half_edges[e1_prev].next = a;
+      m_half_edges[e1].prev = b;
+      m_half_edges[e2_prev].next = b;
+      m_half_edges[e2].prev = a;
+      if(HasEdgeIndex())
+        m_edge_index.Insert(a / 2, GetPoint(v1), GetPoint(v2));
+
+      if(!same_loop) {
+        //Merged into one loop, which is the outer boundary if either was
+        RemoveHole(f, (hole2 != s_null) ? hole2 : hole1);
+        return a;
+      }
+
+      //Split. Off the outer boundary both loops are CCW - b's becomes the new face. Off a hole (CW), one loop is a
+      //CCW pocket between the hole and the diagonal - the new face - and the other is still the hole
+      FaceId g = MakeFace();
+      HalfEdgeId g_loop = b, f_loop = a;
+      if((hole1 != s_null) && (LoopSignedArea(b) < 0.0))
+        std::swap(g_loop, f_loop);
+      SetLoopFace(g_loop, g);
+      m_faces[g].outer = g_loop;
+      if(hole1 == s_null)
+        m_faces[f].outer = f_loop;
+      else
+        m_holes[hole1].edge = f_loop;
+
+      //Holes inside the new face move to it
+      HoleId* link = &m_faces[f].first_hole;
+      while(*link != s_null) {
+        HoleId hole = *link;
+        if((hole != hole1) && LoopContains(g_loop, GetOriginPoint(m_holes[hole].edge))) {
+          *link = m_holes[hole].next;
+          m_holes[hole].next = m_faces[g].first_hole;
+          m_faces[g].first_hole = hole;
+          SetLoopFace(m_holes[hole].edge, g);
+        }
+        else
+          link = &m_holes[hole].next;
+      }
+      return a;
+    }
+
+    bool DCEL::Validate() const
+    {
+      const uint32_t num_half_edges = NumHalfEdges();
+      for(VertexId v = 0; v < NumVertices(); v++) {
+        HalfEdgeId first = m_vertices[v].incident_edge;
+        if(first == s_null)
+          continue; //isolated
+        DCEL_VALIDATE(first < num_half_edges);
+        HalfEdgeId e = first;
+        uint32_t iters = 0;
+        do {
+          DCEL_VALIDATE(Origin(e) == v);
+          e = m_half_edges[Twin(e)].next;
+          DCEL_VALIDATE(++iters <= num_half_edges);
+        } while(e != first);
+      }
+
+      DCEL_VALIDATE(num_half_edges % 2 == 0);
+      for(HalfEdgeId h = 0; h < num_half_edges; h++) {
+        const HalfEdge& e = m_half_edges[h];
+        DCEL_VALIDATE(e.origin < NumVertices());
+        DCEL_VALIDATE(e.next < num_half_edges);
+        DCEL_VALIDATE(e.prev < num_half_edges);
+        DCEL_VALIDATE(e.face < NumFaces());
+        DCEL_VALIDATE(m_half_edges[e.next].prev == h);
+        DCEL_VALIDATE(m_half_edges[e.prev].next == h);
+        DCEL_VALIDATE(Origin(e.next) == Destination(h));
+        DCEL_VALIDATE(m_half_edges[e.next].face == e.face);
+      }
+
+      //Every half edge is on exactly one of the faces' boundary loops
+      DCEL_VALIDATE(m_faces[s_unbounded_face].outer == s_null);
+      std::vector<uint8_t> on_loop(num_half_edges, 0);
+      uint32_t num_on_loops = 0;
+      for(FaceId f = 0; f < NumFaces(); f++) {
+        DCEL_VALIDATE((f == s_unbounded_face) || (m_faces[f].outer != s_null));
+        bool ok = true;
+        ForEachBoundaryLoop(f, [&](HalfEdgeId loop) {
+          uint32_t iters = 0;
+          HalfEdgeId e = loop;
+          do {
+            ok = ok && (m_half_edges[e].face == f) && !on_loop[e] && (++iters <= num_half_edges);
+            if(!ok)
+              return;
+            on_loop[e] = 1;
+            num_on_loops++;
+            e = m_half_edges[e].next;
+          } while(e != loop);
+        });
+        DCEL_VALIDATE(ok);
+      }
+      DCEL_VALIDATE(num_on_loops == num_half_edges);
+      return true;
+    }
+
+    void DCEL::Test()
+    {
+      SPG_WARN("-------------------------------------------------------------------------");
+      SPG_WARN("DCEL (dcel_v3)");
+      SPG_WARN("-------------------------------------------------------------------------");
+
+      //Star shaped polygon (so simple) with lots of vertices: construction and walking the boundary vs dcel_v1
+      const uint32_t NUM_POINTS = 1000000;
+      std::mt19937 mt(31);
+      std::uniform_real_distribution<float> radius_dist(500.0f, 1000.0f);
+      std::vector<SpgMth::Point2d> points;
+      points.reserve(NUM_POINTS);
+      for(uint32_t i = 0; i < NUM_POINTS; i++) {
+        float angle = 2.0f * std::numbers::pi_v<float> * (float)i / (float)NUM_POINTS;
+        float r = radius_dist(mt);
+        points.push_back({r * std::cos(angle), r * std::sin(angle)});
+      }
+
+      Core::Timer timer;
+      dcel_v1::DCEL dcel1(points);
+      SPG_INFO("dcel_v1 construction: {:.2f} ms", timer.ElapsedMillis());
+      timer.Reset();
+      DCEL dcel3(points);
+      SPG_INFO("dcel_v3 construction: {:.2f} ms", timer.ElapsedMillis());
+
+      timer.Reset();
+      double sum1 = 0.0;
+      auto* start = dcel1.GetFaces()[0]->outer;
+      auto* e1 = start;
+      do {
+        sum1 += e1->origin->point.x;
+        e1 = e1->next;
+      } while(e1 != start);
+      SPG_INFO("dcel_v1 boundary walk: {:.2f} ms, sum of x {}", timer.ElapsedMillis(), sum1);
+      timer.Reset();
+      double sum3 = 0.0;
+      dcel3.ForEachLoopEdge(dcel3.GetFace(1).outer, [&](HalfEdgeId e) { sum3 += dcel3.GetOriginPoint(e).x; });
+      SPG_INFO("dcel_v3 boundary walk: {:.2f} ms, sum of x {}", timer.ElapsedMillis(), sum3);
+      SPG_ASSERT(sum1 == sum3);
+
+      timer.Reset();
+      DCEL clone = dcel3.Clone();
+      SPG_INFO("dcel_v3 Clone: {:.2f} ms, {} half edges", timer.ElapsedMillis(), clone.NumHalfEdges());
+      SPG_ASSERT(clone.Validate());
+
+      //Bulk build of a 1000 x 1000 grid of quads, and of the same grid as triangles
+      const uint32_t GRID_SIZE = 1000;
+      std::vector<SpgMth::Point2d> grid_points;
+      grid_points.reserve((GRID_SIZE+1) * (GRID_SIZE+1));
+      for(uint32_t j = 0; j <= GRID_SIZE; j++)
+        for(uint32_t i = 0; i <= GRID_SIZE; i++)
+          grid_points.push_back({(float)i, (float)j});
+      std::vector<FaceIndices> quads;
+      std::vector<uint32_t> triangles;
+      quads.reserve(GRID_SIZE * GRID_SIZE);
+      triangles.reserve(6 * GRID_SIZE * GRID_SIZE);
+      for(uint32_t j = 0; j < GRID_SIZE; j++) {
+        for(uint32_t i = 0; i < GRID_SIZE; i++) {
+          uint32_t v = j*(GRID_SIZE+1) + i;
+          quads.push_back({{v, v+1, v+GRID_SIZE+2, v+GRID_SIZE+1}, {}});
+          triangles.insert(triangles.end(), {v, v+1, v+GRID_SIZE+2, v, v+GRID_SIZE+2, v+GRID_SIZE+1});
+        }
+      }
+      timer.Reset();
+      DCEL grid;
+      grid.Build(grid_points, quads);
+      SPG_INFO("dcel_v3 Build: {:.2f} ms, {} faces, {} half edges", timer.ElapsedMillis(), grid.NumFaces(), grid.NumHalfEdges());
+      timer.Reset();
+      grid.BuildFromTriangles(grid_points, triangles);
+      SPG_INFO("dcel_v3 BuildFromTriangles: {:.2f} ms, {} faces, {} half edges", timer.ElapsedMillis(), grid.NumFaces(), grid.NumHalfEdges());
+      SPG_ASSERT(grid.Validate());
+
+      //Diagonal checks on a 100k vertex wavy, jittered (so about half the vertices are reflex) polygon, with and
+      //without the edge index: the ear diagonals i -> i+2, then cutting off every other ear with Join()
+      const uint32_t NUM_POLY_POINTS = 100000;
+      const uint32_t NUM_UNINDEXED = 1000; //each one scans the whole boundary
+      std::uniform_real_distribution<float> jitter_dist(0.0f, 0.02f);
+      std::vector<SpgMth::Point2d> poly_points;
+      poly_points.reserve(NUM_POLY_POINTS);
+      for(uint32_t i = 0; i < NUM_POLY_POINTS; i++) {
+        float angle = 2.0f * std::numbers::pi_v<float> * (float)i / (float)NUM_POLY_POINTS;
+        float r = 800.0f + 100.0f * std::sin(7.0f * angle) + jitter_dist(mt);
+        poly_points.push_back({r * std::cos(angle), r * std::sin(angle)});
+      }
+      DCEL poly(poly_points);
+      DCEL poly_indexed(poly_points);
+      timer.Reset();
+      poly_indexed.BuildEdgeIndex();
+      SPG_INFO("BuildEdgeIndex: {:.2f} ms", timer.ElapsedMillis());
+
+      timer.Reset();
+      uint32_t num_valid = 0;
+      for(uint32_t i = 0; i < NUM_UNINDEXED; i++)
+        num_valid += poly.GetDiagonal(i, i+2).is_valid;
+      double ms = timer.ElapsedMillis();
+      SPG_INFO("GetDiagonal, no index: {:.4f} ms each, {} of {} valid", ms / NUM_UNINDEXED, num_valid, NUM_UNINDEXED);
+      timer.Reset();
+      num_valid = 0;
+      for(uint32_t i = 0; i < NUM_POLY_POINTS - 2; i++)
+        num_valid += poly_indexed.GetDiagonal(i, i+2).is_valid;
+      ms = timer.ElapsedMillis();
+      SPG_INFO("GetDiagonal, edge index: {:.4f} ms each, {} of {} valid", ms / (NUM_POLY_POINTS - 2), num_valid, NUM_POLY_POINTS - 2);
+
+      timer.Reset();
+      uint32_t num_joined = 0;
+      for(uint32_t i = 0; i < 2 * NUM_UNINDEXED; i += 2)
+        num_joined += (poly.Join(i, i+2) != s_null);
+      ms = timer.ElapsedMillis();
+      SPG_INFO("Join, no index: {:.4f} ms each, {} joined", ms / NUM_UNINDEXED, num_joined);
+      timer.Reset();
+      num_joined = 0;
+      for(uint32_t i = 0; i < NUM_POLY_POINTS - 2; i += 2)
+        num_joined += (poly_indexed.Join(i, i+2) != s_null);
+      ms = timer.ElapsedMillis();
+      SPG_INFO("Join, edge index: {:.4f} ms each, {} joined", ms / (NUM_POLY_POINTS / 2 - 1), num_joined);
+      SPG_ASSERT(poly_indexed.Validate());
+    }
+  }
+
 } //namespace geom
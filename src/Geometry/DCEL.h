@@ -1,8 +1,13 @@
 #pragma once
 
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
 #include "CoreLib/Core.h"
 #include "MathLib/MathLib.h"
 #include "MathLib/Geom/Geom.h"
+#include "Geometry/SegmentGrid.h"
 
 
 namespace Geom
@@ -300,4 +305,214 @@ namespace Geom
     static_assert(std::is_move_constructible<DCEL>::value);
 
   }
+
+  //Index based DCEL: the records live in contiguous arrays and refer to each other by 32 bit indices (the index is
+  //the record's id, so no tags). The records are trivially copyable, so copying / moving a DCEL is a memcpy per
+  //array (Clone()) and nothing needs patching up when an array reallocates. Half edges are made in pairs, so the
+  //twin of h is always h^1 and isn't stored.
+  //
+  //Face 0 (s_unbounded_face) is the unbounded face. A face has (at most) one outer boundary loop (CCW) and any
+  //number of inner boundary loops (holes, CW), kept in a linked list through m_holes.
+  //
+  //Uses the exact predicates (Predicates.h), unlike dcel_v1.
+  namespace dcel_v3
+  {
+    class DCEL
+    {
+    public:
+      using VertexId = uint32_t;
+      using HalfEdgeId = uint32_t;
+      using FaceId = uint32_t;
+      using HoleId = uint32_t;
+
+      static constexpr uint32_t s_null = std::numeric_limits<uint32_t>::max();
+      static constexpr FaceId s_unbounded_face = 0;
+
+      struct Vertex
+      {
+        SpgMth::Point2d point;
+        HalfEdgeId incident_edge = s_null; //departs from this vertex
+      };
+
+      struct HalfEdge
+      {
+        VertexId origin = s_null;
+        HalfEdgeId next = s_null;
+        HalfEdgeId prev = s_null;
+        FaceId face = s_null; //to the left of this half edge
+      };
+
+      struct Face
+      {
+        HalfEdgeId outer = s_null; //s_null if unbounded
+        HoleId first_hole = s_null;
+      };
+
+      struct Hole
+      {
+        HalfEdgeId edge = s_null; //any half edge on the inner boundary
+        HoleId next = s_null; //next hole of the same face
+      };
+
+      struct Diagonal
+      {
+        HalfEdgeId departing_edge_v1 = s_null;
+        HalfEdgeId departing_edge_v2 = s_null;
+        bool is_valid = false;
+      };
+
+      //One face for Build(): the outer boundary, then any holes, as indices into the points
+      struct FaceIndices
+      {
+        std::vector<uint32_t> outer;
+        std::vector<std::vector<uint32_t>> holes;
+      };
+
+      DCEL();
+      //Assumes the input points form a simple polygon oriented CCW
+      explicit DCEL(std::span<const SpgMth::Point2d> points);
+
+      DCEL(const DCEL& other) = default;
+      DCEL& operator = (const DCEL& other) = default;
+      DCEL(DCEL&& other) noexcept = default;
+      DCEL& operator = (DCEL&& other) noexcept = default;
+
+      DCEL Clone() const { return *this; }
+
+      void Clear(); //leaves just the unbounded face
+      void Init(std::span<const SpgMth::Point2d> points);
+      void Reserve(uint32_t num_vertices, uint32_t num_half_edges, uint32_t num_faces);
+
+      //Bulk construction of a planar subdivision, replacing the contents. Vertex i is points[i] and input face i is
+      //face i+1. The unbounded face is everything not covered by an input face, including holes that aren't filled
+      //by another face. Either orientation is accepted - outer boundaries are made CCW and holes CW. Twins are
+      //paired by sorting the edges on their vertex indices, O(E log E), rather than linking them up edge by edge.
+      //Returns false (and leaves the DCEL empty) if an edge is in more than 2 faces, or in 2 with the same
+      //orientation (overlapping faces), or an index is out of range
+      bool Build(std::span<const SpgMth::Point2d> points, std::span<const FaceIndices> faces);
+      //3 indices per triangle
+      bool BuildFromTriangles(std::span<const SpgMth::Point2d> points, std::span<const uint32_t> triangles);
+
+      VertexId MakeVertex(const SpgMth::Point2d& point);
+      HalfEdgeId MakeHalfEdgePair(); //returns the first, the second is its Twin()
+      FaceId MakeFace();
+      HoleId AddHole(FaceId f, HalfEdgeId h);
+
+      //Inserts a new vertex at point on h (and its twin), splitting the edge in 2. h ends at the new vertex
+      VertexId Split(const SpgMth::Point2d& point, HalfEdgeId h);
+
+      //A diagonal is valid if v1 and v2 share a bounded face, aren't neighbours on it, and the segment v1-v2 is
+      //strictly inside the face: inside the angle of the face at each end and crossing or touching no other edge
+      //(of the outer boundary or any hole)
+      Diagonal GetDiagonal(VertexId v1, VertexId v2) const;
+      //Adds the diagonal v1-v2 if valid, returns the half edge v1->v2 (s_null if not valid). Between 2 vertices on
+      //the same boundary loop the face splits in 2 - one part keeps the face, the other (the part left of v2->v1,
+      //or for a hole the pocket between it and the diagonal) is a new face, and the holes inside it move to it.
+      //Between different loops (outer boundary and a hole, or 2 holes) the loops merge - one less hole
+      HalfEdgeId Join(VertexId v1, VertexId v2);
+      bool Validate() const;
+
+      //Optional index of the edges for GetDiagonal() / Join(). With it, the check that a diagonal doesn't cross the
+      //face's boundary only tests the edges near the diagonal rather than the whole boundary, so it no longer grows
+      //with the face. It's one grid for all the faces, candidates filtered by face, so a face splitting just means
+      //adding the diagonal. Join() and Split() keep it up to date; edges made any other way (MakeHalfEdgePair()) need
+      //another BuildEdgeIndex(). Clear(), Init() and Build() drop it
+      void BuildEdgeIndex();
+      void ClearEdgeIndex() { m_edge_index.Clear(); }
+      bool HasEdgeIndex() const { return !m_edge_index.Empty(); }
+
+      static HalfEdgeId Twin(HalfEdgeId h) { return h ^ 1u; }
+      HalfEdgeId Next(HalfEdgeId h) const { return m_half_edges[h].next; }
+      HalfEdgeId Prev(HalfEdgeId h) const { return m_half_edges[h].prev; }
+      VertexId Origin(HalfEdgeId h) const { return m_half_edges[h].origin; }
+      VertexId Destination(HalfEdgeId h) const { return m_half_edges[Twin(h)].origin; }
+      FaceId IncidentFace(HalfEdgeId h) const { return m_half_edges[h].face; }
+
+      const Vertex& GetVertex(VertexId v) const { return m_vertices[v]; }
+      const HalfEdge& GetHalfEdge(HalfEdgeId h) const { return m_half_edges[h]; }
+      const Face& GetFace(FaceId f) const { return m_faces[f]; }
+      std::span<const Vertex> GetVertices() const { return m_vertices; }
+      std::span<const HalfEdge> GetHalfEdges() const { return m_half_edges; }
+      std::span<const Face> GetFaces() const { return m_faces; }
+      uint32_t NumVertices() const { return (uint32_t)m_vertices.size(); }
+      uint32_t NumHalfEdges() const { return (uint32_t)m_half_edges.size(); }
+      uint32_t NumFaces() const { return (uint32_t)m_faces.size(); }
+
+      const SpgMth::Point2d& GetPoint(VertexId v) const { return m_vertices[v].point; }
+      const SpgMth::Point2d& GetOriginPoint(HalfEdgeId h) const { return GetPoint(Origin(h)); }
+      const SpgMth::Point2d& GetDestinationPoint(HalfEdgeId h) const { return GetPoint(Destination(h)); }
+      SpgMth::LineSeg2D GetLineSeg2d(HalfEdgeId h) const {
+        return SpgMth::LineSeg2D{GetOriginPoint(h), GetDestinationPoint(h)};
+      }
+
+      //fn(HalfEdgeId) for h, next(h), ... round the loop
+      template<typename TFunc>
+      void ForEachLoopEdge(HalfEdgeId h, TFunc fn) const
+      {
+        HalfEdgeId e = h;
+        do {
+          fn(e);
+          e = m_half_edges[e].next;
+        } while(e != h);
+      }
+
+      //fn(HalfEdgeId) for each half edge departing from v, clockwise around v (next of the twin)
+      template<typename TFunc>
+      void ForEachDepartingEdge(VertexId v, TFunc fn) const
+      {
+        HalfEdgeId first = m_vertices[v].incident_edge;
+        if(first == s_null)
+          return;
+        HalfEdgeId e = first;
+        do {
+          fn(e);
+          e = m_half_edges[Twin(e)].next;
+        } while(e != first);
+      }
+
+      //fn(HalfEdgeId) for a half edge on each boundary loop of f, the outer boundary first
+      template<typename TFunc>
+      void ForEachBoundaryLoop(FaceId f, TFunc fn) const
+      {
+        if(m_faces[f].outer != s_null)
+          fn(m_faces[f].outer);
+        for(HoleId hole = m_faces[f].first_hole; hole != s_null; hole = m_holes[hole].next)
+          fn(m_holes[hole].edge);
+      }
+
+      std::vector<HalfEdgeId> GetEdgeLoop(HalfEdgeId h) const;
+      std::vector<VertexId> GetVertices(FaceId f) const; //outer boundary
+      std::vector<HalfEdgeId> GetDepartingEdges(VertexId v) const;
+      HalfEdgeId GetDepartingEdge(VertexId v, FaceId f) const;
+      std::pair<HalfEdgeId,HalfEdgeId> FindDepartingEdgesWithCommonFace(VertexId v1, VertexId v2) const;
+      bool AnyIntersectionsExist(VertexId v1, VertexId v2, FaceId f) const;
+      bool IsConvex(HalfEdgeId departing_edge) const;
+      bool MakesInteriorConnection(VertexId dest, HalfEdgeId orig_depart_edge) const;
+
+      static void Test();
+
+    private:
+      //Loop l is indices[loop_starts[l]] .. indices[loop_starts[l+1] - 1], on face loop_faces[l] (already +1). The
+      //first loop of each face is its outer boundary, in order of face
+      bool BuildFromLoops(std::span<const SpgMth::Point2d> points, std::span<const uint32_t> indices,
+        std::span<const uint32_t> loop_starts, std::span<const FaceId> loop_faces, uint32_t num_faces);
+      void SetLoopFace(HalfEdgeId h, FaceId f);
+      void RemoveHole(FaceId f, HoleId hole);
+      HoleId FindHoleOnLoop(FaceId f, HalfEdgeId h) const;
+      double LoopSignedArea(HalfEdgeId h) const;
+      bool LoopContains(HalfEdgeId h, const SpgMth::Point2d& p) const;
+
+    private:
+      std::vector<Vertex> m_vertices;
+      std::vector<HalfEdge> m_half_edges;
+      std::vector<Face> m_faces;
+      std::vector<Hole> m_holes; //removed holes aren't reused
+      SegmentGrid2D m_edge_index; //id is the half edge pair, h/2
+    };
+
+    static_assert(std::is_trivially_copyable_v<DCEL::Vertex>);
+    static_assert(std::is_trivially_copyable_v<DCEL::HalfEdge>);
+    static_assert(std::is_trivially_copyable_v<DCEL::Face>);
+    static_assert(std::is_trivially_copyable_v<DCEL::Hole>);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,609 @@
+#include "Geometry/Delaunay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+#include <random>
+
+#include "Geometry/Voronoi.h"
+#include "CoreLib/Timer.h"
+#include "MathLib/Geom/Predicates.h"
+
+namespace Geom
+{
+  namespace
+  {
+    //Position along a Hilbert curve through a 2^16 x 2^16 grid
+    inline uint32_t HilbertIndex(uint32_t x, uint32_t y)
+    {
+      constexpr uint32_t n = 1u << 16;
+      uint32_t d = 0;
+      for(uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if(ry == 0) {
+          if(rx == 1) {
+            x = n - 1 - x;
+            y = n - 1 - y;
+          }
+          std::swap(x, y);
+        }
+      }
+      return d;
+    }
+
+    inline bool LexLess(const SpgMth::Point2d& a, const SpgMth::Point2d& b)
+    {
+      return (a.x < b.x) || ((a.x == b.x) && (a.y < b.y));
+    }
+
+    //c is on the line through a and b (and not at either) - is it between them?
+    inline bool CollinearBetween(const SpgMth::Point2d& a, const SpgMth::Point2d& b, const SpgMth::Point2d& c)
+    {
+      return LexLess(a, c) != LexLess(b, c);
+    }
+  }
+
+  bool DelaunayTriangulation2D::Triangulate(std::span<const SpgMth::Point2d> points,
+    std::span<const uint32_t> constraint_edges, InsertionOrder order)
+  {
+    Clear();
+    m_points.assign(points.begin(), points.end());
+    const uint32_t n = (uint32_t)m_points.size();
+    m_infinite = n;
+    m_vertex_map.resize(n);
+    std::iota(m_vertex_map.begin(), m_vertex_map.end(), 0u);
+    m_vertex_triangle.assign(n + 1, s_null);
+    m_new_by_start.assign(n + 1, s_null);
+    m_triangles.reserve(2 * n + 16); //about 2n real triangles, plus the ghosts round the hull
+    m_mark.reserve(2 * n + 16);
+
+    std::vector<uint32_t> insertion_order = ComputeInsertionOrder(order);
+    if(!MakeFirstTriangle(insertion_order)) {
+      SPG_ERROR("DelaunayTriangulation2D: fewer than 3 points that aren't collinear");
+      Clear();
+      return false;
+    }
+    for(uint32_t i = 3; i < n; i++)
+      InsertPoint(insertion_order[i]);
+
+    bool constraints_ok = (constraint_edges.size() % 2 == 0);
+    for(std::size_t i = 0; i + 1 < constraint_edges.size(); i += 2) {
+      uint32_t a = constraint_edges[i];
+      uint32_t b = constraint_edges[i + 1];
+      if((a >= n) || (b >= n)) {
+        SPG_ERROR("DelaunayTriangulation2D: constraint {} -> {} out of range", a, b);
+        constraints_ok = false;
+        continue;
+      }
+      if(!InsertConstraint(m_vertex_map[a], m_vertex_map[b])) {
+        SPG_ERROR("DelaunayTriangulation2D: constraint {} -> {} crosses another constraint", a, b);
+        constraints_ok = false;
+      }
+    }
+    return constraints_ok;
+  }
+
+  void DelaunayTriangulation2D::Clear()
+  {
+    m_points.clear();
+    m_vertex_map.clear();
+    m_triangles.clear();
+    m_free_triangles.clear();
+    m_vertex_triangle.clear();
+    m_infinite = 0;
+    m_last = s_null;
+    m_mark.clear();
+    m_mark_stamp = 0;
+    m_new_by_start.clear();
+  }
+
+  std::vector<uint32_t> DelaunayTriangulation2D::ComputeInsertionOrder(InsertionOrder order) const
+  {
+    const uint32_t n = (uint32_t)m_points.size();
+    std::vector<uint32_t> indices(n);
+    std::iota(indices.begin(), indices.end(), 0u);
+    if((order == InsertionOrder::Input) || (n == 0))
+      return indices;
+
+    SpgMth::BoundingBox bounds;
+    for(const auto& p : m_points)
+      bounds.Update(p);
+    const double scale = 65535.0 / std::max({(double)bounds.Width(), (double)bounds.Height(), 1e-30});
+    //Key in the top half, index in the bottom, so the rounds sort without looking anything up
+    std::vector<uint64_t> keyed(n);
+    for(uint32_t i = 0; i < n; i++) {
+      uint32_t x = (uint32_t)((m_points[i].x - bounds.left) * scale);
+      uint32_t y = (uint32_t)((m_points[i].y - bounds.bottom) * scale);
+      keyed[i] = ((uint64_t)HilbertIndex(std::min(x, 65535u), std::min(y, 65535u)) << 32) | i;
+    }
+
+    //Fixed seed, so the triangulation of cocircular points is repeatable
+    std::mt19937 mt(n);
+    std::shuffle(keyed.begin(), keyed.end(), mt);
+    //Rounds [.. n/4), [n/4, n/2), [n/2, n), each sorted by key - the first one (up to 64 points) too
+    uint32_t end = n;
+    while(end > 0) {
+      uint32_t begin = (end > 64) ? end / 2 : 0;
+      std::sort(keyed.begin() + begin, keyed.begin() + end);
+      end = begin;
+    }
+    for(uint32_t i = 0; i < n; i++)
+      indices[i] = (uint32_t)keyed[i];
+    return indices;
+  }
+
+  bool DelaunayTriangulation2D::MakeFirstTriangle(std::vector<uint32_t>& order)
+  {
+    //The first point, the next different one, and the next not collinear with them go first
+    const uint32_t n = (uint32_t)order.size();
+    if(n < 3)
+      return false;
+    uint32_t i1 = 1;
+    while((i1 < n) && (Point(order[i1]) == Point(order[0])))
+      i1++;
+    uint32_t i2 = i1 + 1;
+    while((i2 < n) && (SpgMth::Orient2d(Point(order[0]), Point(order[i1]), Point(order[i2])) == 0.0))
+      i2++;
+    if(i2 >= n)
+      return false;
+    std::swap(order[1], order[i1]);
+    std::swap(order[2], order[i2]);
+
+    uint32_t a = order[0], b = order[1], c = order[2];
+    if(SpgMth::Orient2d(Point(a), Point(b), Point(c)) < 0.0)
+      std::swap(b, c);
+    uint32_t t = MakeTriangle(a, b, c);
+    //Ghosts on the outside of each edge, linked in a ring round the infinite vertex
+    uint32_t g_ab = MakeTriangle(b, a, m_infinite);
+    uint32_t g_bc = MakeTriangle(c, b, m_infinite);
+    uint32_t g_ca = MakeTriangle(a, c, m_infinite);
+    m_triangles[t].adj = {g_ab, g_bc, g_ca};
+    m_triangles[g_ab].adj = {t, g_ca, g_bc};
+    m_triangles[g_bc].adj = {t, g_ab, g_ca};
+    m_triangles[g_ca].adj = {t, g_bc, g_ab};
+    m_last = t;
+    return true;
+  }
+
+  uint32_t DelaunayTriangulation2D::MakeTriangle(uint32_t v0, uint32_t v1, uint32_t v2)
+  {
+    //The infinite vertex goes last
+    if(v0 == m_infinite)
+      std::tie(v0, v1, v2) = std::make_tuple(v1, v2, v0);
+    else if(v1 == m_infinite)
+      std::tie(v0, v1, v2) = std::make_tuple(v2, v0, v1);
+
+    uint32_t t;
+    if(!m_free_triangles.empty()) {
+      t = m_free_triangles.back();
+      m_free_triangles.pop_back();
+    }
+    else {
+      t = (uint32_t)m_triangles.size();
+      m_triangles.emplace_back();
+      m_mark.push_back(0);
+    }
+    m_triangles[t] = Triangle{{v0, v1, v2}, {s_null, s_null, s_null}, 0};
+    m_vertex_triangle[v0] = m_vertex_triangle[v1] = m_vertex_triangle[v2] = t;
+    return t;
+  }
+
+  void DelaunayTriangulation2D::FreeTriangle(uint32_t t)
+  {
+    m_triangles[t].v[0] = s_null;
+    m_free_triangles.push_back(t);
+  }
+
+  uint32_t DelaunayTriangulation2D::Locate(uint32_t p, uint32_t& duplicate_of) const
+  {
+    //Visibility walk: cross any edge p is strictly beyond. Always ends in a Delaunay triangulation - in the
+    //triangle containing p, or a ghost if p is outside the hull
+    const SpgMth::Point2d& q = Point(p);
+    duplicate_of = s_null;
+    uint32_t t = IsGhost(m_last) ? m_triangles[m_last].adj[0] : m_last;
+    uint32_t prev = s_null;
+    while(!IsGhost(t)) {
+      const Triangle& tri = m_triangles[t];
+      uint32_t next = s_null;
+      for(uint32_t i = 0; i < 3; i++) {
+        if((tri.adj[i] != prev) && (SpgMth::Orient2d(Point(tri.v[i]), Point(tri.v[(i + 1) % 3]), q) < 0.0)) {
+          next = tri.adj[i];
+          break;
+        }
+      }
+      if(next == s_null) {
+        for(uint32_t v : tri.v) {
+          if(Point(v) == q)
+            duplicate_of = v;
+        }
+        return t;
+      }
+      prev = t;
+      t = next;
+    }
+    return t;
+  }
+
+  bool DelaunayTriangulation2D::InCircumcircle(uint32_t t, uint32_t p) const
+  {
+    const Triangle& tri = m_triangles[t];
+    if(!IsGhost(t))
+      return SpgMth::InCircle(Point(tri.v[0]), Point(tri.v[1]), Point(tri.v[2]), Point(p)) > 0.0;
+    //A ghost's 'circle' is the open half plane beyond its hull edge, plus the open edge itself
+    double orient = SpgMth::Orient2d(Point(tri.v[0]), Point(tri.v[1]), Point(p));
+    if(orient != 0.0)
+      return orient > 0.0;
+    return CollinearBetween(Point(tri.v[0]), Point(tri.v[1]), Point(p));
+  }
+
+  void DelaunayTriangulation2D::InsertPoint(uint32_t p)
+  {
+    uint32_t duplicate_of;
+    uint32_t t_start = Locate(p, duplicate_of);
+    if(duplicate_of != s_null) {
+      m_vertex_map[p] = duplicate_of;
+      return;
+    }
+
+    //The cavity - triangles whose circumcircle contains p. They're connected, so a search out from the one
+    //containing p finds them, and the edges where it stops are the cavity's boundary
+    if(m_mark_stamp >= std::numeric_limits<uint32_t>::max() - 2) {
+      std::fill(m_mark.begin(), m_mark.end(), 0);
+      m_mark_stamp = 0;
+    }
+    m_mark_stamp += 2;
+    const uint32_t in_cavity = m_mark_stamp, not_in_cavity = m_mark_stamp + 1;
+    m_cavity.clear();
+    m_cavity_boundary.clear();
+    m_cavity.push_back(t_start);
+    m_mark[t_start] = in_cavity;
+    for(std::size_t k = 0; k < m_cavity.size(); k++) {
+      const uint32_t t = m_cavity[k];
+      for(uint32_t i = 0; i < 3; i++) {
+        const uint32_t nb = m_triangles[t].adj[i];
+        if(m_mark[nb] == in_cavity)
+          continue;
+        if((m_mark[nb] != not_in_cavity) && InCircumcircle(nb, p)) {
+          m_mark[nb] = in_cavity;
+          m_cavity.push_back(nb);
+          continue;
+        }
+        m_mark[nb] = not_in_cavity;
+        const Triangle& tri = m_triangles[t];
+        m_cavity_boundary.push_back({tri.v[i], tri.v[(i + 1) % 3], nb, (uint8_t)((tri.constrained >> i) & 1)});
+      }
+    }
+
+    //Replace it with a fan of triangles round p, one per boundary edge
+    for(uint32_t t : m_cavity)
+      FreeTriangle(t);
+    for(const auto& edge : m_cavity_boundary) {
+      uint32_t t = MakeTriangle(edge.a, edge.b, p);
+      Triangle& tri = m_triangles[t];
+      uint32_t i = IndexOf(tri, edge.a);
+      tri.adj[i] = edge.outside;
+      tri.constrained = edge.constrained << i;
+      Triangle& outside = m_triangles[edge.outside];
+      outside.adj[IndexOf(outside, edge.b)] = t;
+      m_new_by_start[edge.a] = t;
+    }
+    for(const auto& edge : m_cavity_boundary) {
+      uint32_t t = m_new_by_start[edge.a];
+      uint32_t t_next = m_new_by_start[edge.b]; //across b -> p
+      m_triangles[t].adj[IndexOf(m_triangles[t], edge.b)] = t_next;
+      m_triangles[t_next].adj[IndexOf(m_triangles[t_next], p)] = t;
+    }
+    m_last = m_vertex_triangle[p];
+  }
+
+  DelaunayTriangulation2D::EdgeRef DelaunayTriangulation2D::FindEdge(uint32_t v1, uint32_t v2) const
+  {
+    const uint32_t start = m_vertex_triangle[v1];
+    if(start == s_null)
+      return {};
+    uint32_t t = start;
+    do {
+      const Triangle& tri = m_triangles[t];
+      uint32_t i = IndexOf(tri, v1);
+      if(tri.v[(i + 1) % 3] == v2)
+        return {t, i};
+      t = tri.adj[(i + 2) % 3];
+    } while(t != start);
+    return {};
+  }
+
+  void DelaunayTriangulation2D::SetConstrained(EdgeRef e)
+  {
+    Triangle& tri = m_triangles[e.t];
+    tri.constrained |= (1 << e.i);
+    Triangle& twin = m_triangles[tri.adj[e.i]];
+    twin.constrained |= (1 << IndexOf(twin, tri.v[(e.i + 1) % 3]));
+  }
+
+  void DelaunayTriangulation2D::Flip(EdgeRef e)
+  {
+    //Triangles (x,y,p1) and (y,x,p2) become (x,p2,p1) and (p2,y,p1)
+    const uint32_t t1 = e.t;
+    const uint32_t t2 = m_triangles[t1].adj[e.i];
+    const Triangle tri1 = m_triangles[t1];
+    const Triangle tri2 = m_triangles[t2];
+    const uint32_t i = e.i;
+    const uint32_t x = tri1.v[i], y = tri1.v[(i + 1) % 3], p1 = tri1.v[(i + 2) % 3];
+    const uint32_t j = IndexOf(tri2, y);
+    const uint32_t p2 = tri2.v[(j + 2) % 3];
+    auto bit = [](const Triangle& tri, uint32_t k) { return (uint8_t)((tri.constrained >> (k % 3)) & 1); };
+
+    m_triangles[t1] = Triangle{{x, p2, p1}, {tri2.adj[(j + 1) % 3], t2, tri1.adj[(i + 2) % 3]},
+      (uint8_t)(bit(tri2, j + 1) | (bit(tri1, i + 2) << 2))};
+    m_triangles[t2] = Triangle{{p2, y, p1}, {tri2.adj[(j + 2) % 3], tri1.adj[(i + 1) % 3], t1},
+      (uint8_t)(bit(tri2, j + 2) | (bit(tri1, i + 1) << 1))};
+
+    Triangle& nb_x_p2 = m_triangles[tri2.adj[(j + 1) % 3]];
+    nb_x_p2.adj[IndexOf(nb_x_p2, p2)] = t1;
+    Triangle& nb_y_p1 = m_triangles[tri1.adj[(i + 1) % 3]];
+    nb_y_p1.adj[IndexOf(nb_y_p1, p1)] = t2;
+    m_vertex_triangle[x] = m_vertex_triangle[p1] = m_vertex_triangle[p2] = t1;
+    m_vertex_triangle[y] = t2;
+  }
+
+  bool DelaunayTriangulation2D::InsertConstraint(uint32_t a, uint32_t b)
+  {
+    //A section at a time, a -> c, where c is b or the first vertex on the way to it
+    while(a != b) {
+      if(EdgeRef e = FindEdge(a, b); e.t != s_null) {
+        SetConstrained(e);
+        return true;
+      }
+      const SpgMth::Point2d& pa = Point(a);
+      const SpgMth::Point2d& pb = Point(b);
+      auto ahead_of_a = [&](uint32_t v) {
+        return (SpgMth::Orient2d(pa, pb, Point(v)) == 0.0) &&
+          (((double)Point(v).x - pa.x) * ((double)pb.x - pa.x) + ((double)Point(v).y - pa.y) * ((double)pb.y - pa.y) > 0.0);
+      };
+
+      //Round a to the triangle whose far edge x-y a->b crosses (x right of it, y left), or the edge to a vertex on it
+      uint32_t c = s_null;
+      uint32_t x = s_null, y = s_null;
+      uint32_t t = m_vertex_triangle[a];
+      do {
+        const Triangle& tri = m_triangles[t];
+        uint32_t i = IndexOf(tri, a);
+        uint32_t tx = tri.v[(i + 1) % 3], ty = tri.v[(i + 2) % 3];
+        if(!IsGhost(t)) {
+          if(ahead_of_a(tx) || ahead_of_a(ty)) {
+            c = ahead_of_a(tx) ? tx : ty;
+            break;
+          }
+          if((SpgMth::Orient2d(pa, pb, Point(tx)) < 0.0) && (SpgMth::Orient2d(pa, pb, Point(ty)) > 0.0)) {
+            x = tx;
+            y = ty;
+            break;
+          }
+        }
+        t = tri.adj[(i + 2) % 3];
+      } while(t != m_vertex_triangle[a]);
+
+      if(c != s_null) {
+        SetConstrained(FindEdge(a, c));
+        a = c;
+        continue;
+      }
+      SPG_ASSERT(x != s_null);
+      if(x == s_null)
+        return false;
+
+      //Walk on through the triangles a->b crosses, collecting the edges
+      m_crossing_edges.clear();
+      while(true) {
+        EdgeRef e = FindEdge(x, y);
+        if((m_triangles[e.t].constrained >> e.i) & 1)
+          return false;
+        m_crossing_edges.push_back({x, y});
+        uint32_t z = Opposite({m_triangles[e.t].adj[e.i], IndexOf(m_triangles[m_triangles[e.t].adj[e.i]], y)});
+        if((z == b) || (SpgMth::Orient2d(pa, pb, Point(z)) == 0.0)) {
+          c = z;
+          break;
+        }
+        if(SpgMth::Orient2d(pa, pb, Point(z)) < 0.0)
+          x = z;
+        else
+          y = z;
+      }
+
+      //Flip them out of the way. One that can't be flipped yet (its quad isn't convex) goes to the back of the queue
+      const SpgMth::Point2d& pc = Point(c);
+      auto crosses_ac = [&](uint32_t v1, uint32_t v2) {
+        if((v1 == a) || (v1 == c) || (v2 == a) || (v2 == c))
+          return false;
+        double o1 = SpgMth::Orient2d(pa, pc, Point(v1));
+        double o2 = SpgMth::Orient2d(pa, pc, Point(v2));
+        return ((o1 > 0.0) && (o2 < 0.0)) || ((o1 < 0.0) && (o2 > 0.0));
+      };
+      m_new_edges.clear();
+      while(!m_crossing_edges.empty()) {
+        auto [v1, v2] = m_crossing_edges.front();
+        m_crossing_edges.pop_front();
+        EdgeRef e = FindEdge(v1, v2);
+        uint32_t p1 = Opposite(e);
+        uint32_t t2 = m_triangles[e.t].adj[e.i];
+        uint32_t p2 = Opposite({t2, IndexOf(m_triangles[t2], v2)});
+        double o1 = SpgMth::Orient2d(Point(p1), Point(p2), Point(v1));
+        double o2 = SpgMth::Orient2d(Point(p1), Point(p2), Point(v2));
+        if(!(((o1 > 0.0) && (o2 < 0.0)) || ((o1 < 0.0) && (o2 > 0.0)))) {
+          m_crossing_edges.push_back({v1, v2});
+          continue;
+        }
+        Flip(e);
+        if(crosses_ac(p1, p2))
+          m_crossing_edges.push_back({p1, p2});
+        else
+          m_new_edges.push_back({p1, p2});
+      }
+      SetConstrained(FindEdge(a, c));
+
+      //Back towards Delaunay, flipping any new edge that isn't locally Delaunay until none are
+      bool flipped = true;
+      while(flipped) {
+        flipped = false;
+        for(auto& [v1, v2] : m_new_edges) {
+          EdgeRef e = FindEdge(v1, v2);
+          if((m_triangles[e.t].constrained >> e.i) & 1)
+            continue;
+          const Triangle& tri = m_triangles[e.t];
+          uint32_t t2 = tri.adj[e.i];
+          uint32_t p2 = Opposite({t2, IndexOf(m_triangles[t2], v2)});
+          if(SpgMth::InCircle(Point(tri.v[0]), Point(tri.v[1]), Point(tri.v[2]), Point(p2)) > 0.0) {
+            uint32_t p1 = Opposite(e);
+            Flip(e);
+            v1 = p1;
+            v2 = p2;
+            flipped = true;
+          }
+        }
+      }
+      a = c;
+    }
+    return true;
+  }
+
+  void DelaunayTriangulation2D::GetTriangles(std::vector<uint32_t>& triangles_out) const
+  {
+    triangles_out.clear();
+    triangles_out.reserve(3 * (m_triangles.size() - m_free_triangles.size()));
+    for(uint32_t t = 0; t < m_triangles.size(); t++) {
+      const Triangle& tri = m_triangles[t];
+      if((tri.v[0] != s_null) && !IsGhost(t))
+        triangles_out.insert(triangles_out.end(), tri.v.begin(), tri.v.end());
+    }
+  }
+
+  std::vector<uint32_t> DelaunayTriangulation2D::GetTriangles() const
+  {
+    std::vector<uint32_t> triangles;
+    GetTriangles(triangles);
+    return triangles;
+  }
+
+  bool DelaunayTriangulation2D::IsEdge(uint32_t v1, uint32_t v2) const
+  {
+    if((v1 >= m_vertex_map.size()) || (v2 >= m_vertex_map.size()))
+      return false;
+    return FindEdge(m_vertex_map[v1], m_vertex_map[v2]).t != s_null;
+  }
+
+  bool DelaunayTriangulation2D::IsConstrained(uint32_t v1, uint32_t v2) const
+  {
+    if((v1 >= m_vertex_map.size()) || (v2 >= m_vertex_map.size()))
+      return false;
+    EdgeRef e = FindEdge(m_vertex_map[v1], m_vertex_map[v2]);
+    return (e.t != s_null) && ((m_triangles[e.t].constrained >> e.i) & 1);
+  }
+
+  bool DelaunayTriangulation2D::BuildDCEL(dcel_v3::DCEL& dcel) const
+  {
+    std::vector<uint32_t> triangles;
+    GetTriangles(triangles);
+    return dcel.BuildFromTriangles(m_points, triangles);
+  }
+
+  void DelaunayTriangulation2D::Test()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("DelaunayTriangulation2D");
+    SPG_WARN("-------------------------------------------------------------------------");
+
+    std::mt19937 mt(29);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+    auto random_points = [&](uint32_t num_points) {
+      std::vector<SpgMth::Point2d> points;
+      points.reserve(num_points);
+      for(uint32_t i = 0; i < num_points; i++)
+        points.push_back({dist(mt), dist(mt)});
+      return points;
+    };
+
+    //Insertion order. In input order each walk starts from the last point's triangle, wherever the next point is -
+    //about sqrt(n) steps for random points, and right across the triangulation for points sorted along x
+    {
+      auto points = random_points(1000000);
+      DelaunayTriangulation2D dt;
+      Core::Timer timer;
+      dt.Triangulate(points);
+      SPG_INFO("Delaunay, 1M random points, BRIO order: {:.2f} ms, {} triangles", timer.ElapsedMillis(), dt.GetTriangles().size() / 3);
+      dcel_v3::DCEL dcel;
+      timer.Reset();
+      dt.BuildDCEL(dcel);
+      SPG_INFO("BuildDCEL: {:.2f} ms, {} faces", timer.ElapsedMillis(), dcel.NumFaces());
+
+      points.resize(100000);
+      timer.Reset();
+      dt.Triangulate(points, {}, InsertionOrder::Input);
+      SPG_INFO("Delaunay, 100k random points, input order: {:.2f} ms", timer.ElapsedMillis());
+      timer.Reset();
+      dt.Triangulate(points);
+      SPG_INFO("Delaunay, 100k random points, BRIO order: {:.2f} ms", timer.ElapsedMillis());
+      std::sort(points.begin(), points.end(), LexLess);
+      timer.Reset();
+      dt.Triangulate(points, {}, InsertionOrder::Input);
+      SPG_INFO("Delaunay, 100k points sorted by x, input order: {:.2f} ms", timer.ElapsedMillis());
+      timer.Reset();
+      dt.Triangulate(points);
+      SPG_INFO("Delaunay, 100k points sorted by x, BRIO order: {:.2f} ms", timer.ElapsedMillis());
+    }
+
+    //Against the Voronoi diagram (the dual) of the same sites. Voronoi_V4 loses track of its beach line on larger
+    //random site sets, so this is 300 sites, repeated. It logs every event - logging is turned down while it runs
+    {
+      const uint32_t NUM_RUNS = 50;
+      std::mt19937 site_mt(1);
+      std::uniform_real_distribution<float> site_dist(-100.0f, 100.0f);
+      std::vector<SpgMth::Point2d> sites;
+      for(uint32_t i = 0; i < 300; i++)
+        sites.push_back({site_dist(site_mt), site_dist(site_mt)});
+
+      Core::Timer timer;
+      DelaunayTriangulation2D dt;
+      for(uint32_t run = 0; run < NUM_RUNS; run++)
+        dt.Triangulate(sites);
+      double delaunay_ms = timer.ElapsedMillis() / NUM_RUNS;
+
+      auto level = Core::Logger::GetDefault()->level();
+      Core::Logger::GetDefault()->set_level(spdlog::level::err);
+      std::size_t num_voronoi_vertices = 0;
+      timer.Reset();
+      for(uint32_t run = 0; run < NUM_RUNS; run++) {
+        Voronoi_V4::Voronoi voronoi(sites);
+        voronoi.Construct();
+        num_voronoi_vertices = voronoi.GetVertexPoints().size();
+      }
+      double voronoi_ms = timer.ElapsedMillis() / NUM_RUNS;
+      Core::Logger::GetDefault()->set_level(level);
+      SPG_INFO("{} sites: Delaunay {:.3f} ms, {} triangles. Voronoi_V4 {:.3f} ms, {} vertices", sites.size(), delaunay_ms, dt.GetTriangles().size() / 3, voronoi_ms, num_voronoi_vertices);
+    }
+
+    //Constraints: 100k random points and 50 concentric rings of constraint edges, each edge crossing several triangles
+    {
+      auto points = random_points(100000);
+      std::vector<uint32_t> constraints;
+      for(uint32_t ring = 1; ring <= 50; ring++) {
+        const uint32_t first = (uint32_t)points.size();
+        const uint32_t num_ring_points = 10 + 4 * ring;
+        for(uint32_t k = 0; k < num_ring_points; k++) {
+          float angle = 2.0f * std::numbers::pi_v<float> * (float)k / (float)num_ring_points;
+          points.push_back({19.0f * ring * std::cos(angle), 19.0f * ring * std::sin(angle)});
+          constraints.insert(constraints.end(), {first + k, first + (k + 1) % num_ring_points});
+        }
+      }
+      DelaunayTriangulation2D dt;
+      Core::Timer timer;
+      dt.Triangulate(points);
+      SPG_INFO("Delaunay, {} points: {:.2f} ms", points.size(), timer.ElapsedMillis());
+      timer.Reset();
+      bool ok = dt.Triangulate(points, constraints);
+      SPG_INFO("Constrained Delaunay, {} points, {} constraints: {:.2f} ms, all added: {}", points.size(), constraints.size() / 2, timer.ElapsedMillis(), ok);
+    }
+  }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include "CoreLib/Core.h"
+#include "MathLib/Geom/Geom.h"
+#include "Geometry/DCEL.h"
+
+namespace Geom
+{
+  //Constrained Delaunay triangulation of a point set. Incremental (Bowyer-Watson): each point is located by walking
+  //from the last triangle made, then the triangles whose circumcircle contains it are replaced by a fan round it.
+  //The outside of the hull is covered by 'ghost' triangles that share a vertex at infinity, so a point outside the
+  //hull so far is just another insertion - no enclosing super triangle, and the result is always the full hull.
+  //
+  //Points go in in BRIO order: random rounds, each twice the size of the one before, each sorted along a Hilbert
+  //curve. Consecutive points are close, so walks are short and the triangles touched are still in cache, while the
+  //randomisation keeps the expected cost O(n log n) whatever order the points come in.
+  //
+  //Constraint edges are added after the points (Sloan's method): the edges crossing one are flipped until it's an
+  //edge itself, then the new edges are flipped back towards Delaunay as far as the constraints allow. A constraint
+  //passing through another point is split there. Constraints mustn't cross each other.
+  //
+  //Exact predicates (SpgMth::Orient2d(), InCircle()) throughout. Triangles are CCW, vertex i is points[i]. Repeated
+  //points are triangulated once, as the first of them - the others are left out (constraints to them are moved to it)
+  class DelaunayTriangulation2D
+  {
+  public:
+    enum class InsertionOrder { BRIO, Input }; //Input is for comparison
+
+    DelaunayTriangulation2D() = default;
+
+    //constraint_edges is 2 indices into points per edge. False if the points are all collinear (or fewer than 3),
+    //or if a constraint is out of range or crosses another (the others are still added)
+    bool Triangulate(std::span<const SpgMth::Point2d> points, std::span<const uint32_t> constraint_edges = {},
+      InsertionOrder order = InsertionOrder::BRIO);
+    void Clear();
+
+    //3 indices per triangle
+    std::vector<uint32_t> GetTriangles() const;
+    void GetTriangles(std::vector<uint32_t>& triangles_out) const;
+    bool IsEdge(uint32_t v1, uint32_t v2) const;
+    bool IsConstrained(uint32_t v1, uint32_t v2) const;
+
+    //The triangulation as a planar subdivision - one face per triangle, the unbounded face outside the hull
+    bool BuildDCEL(dcel_v3::DCEL& dcel) const;
+
+    static void Test();
+
+  private:
+    static constexpr uint32_t s_null = std::numeric_limits<uint32_t>::max();
+
+    struct Triangle
+    {
+      std::array<uint32_t, 3> v; //CCW. v[2] of a ghost triangle is the vertex at infinity, v[0] of a free one s_null
+      std::array<uint32_t, 3> adj; //adj[i] is across edge v[i] -> v[i+1]
+      uint8_t constrained = 0; //bit i for edge i
+    };
+
+    struct EdgeRef
+    {
+      uint32_t t = s_null;
+      uint32_t i = 0; //edge i of triangle t
+    };
+
+    std::vector<uint32_t> ComputeInsertionOrder(InsertionOrder order) const;
+    bool MakeFirstTriangle(std::vector<uint32_t>& order);
+    void InsertPoint(uint32_t p);
+    uint32_t Locate(uint32_t p, uint32_t& duplicate_of) const;
+    bool InCircumcircle(uint32_t t, uint32_t p) const;
+    bool InsertConstraint(uint32_t a, uint32_t b);
+
+    uint32_t MakeTriangle(uint32_t v0, uint32_t v1, uint32_t v2);
+    void FreeTriangle(uint32_t t);
+    void Flip(EdgeRef e);
+    EdgeRef FindEdge(uint32_t v1, uint32_t v2) const;
+    void SetConstrained(EdgeRef e);
+    uint32_t Opposite(EdgeRef e) const { return m_triangles[e.t].v[(e.i + 2) % 3]; }
+    bool IsGhost(uint32_t t) const { return m_triangles[t].v[2] == m_infinite; }
+    static uint32_t IndexOf(const Triangle& tri, uint32_t v) { return (tri.v[0] == v) ? 0 : ((tri.v[1] == v) ? 1 : 2); }
+    const SpgMth::Point2d& Point(uint32_t v) const { return m_points[v]; }
+
+  private:
+    std::vector<SpgMth::Point2d> m_points;
+    std::vector<uint32_t> m_vertex_map; //repeated points to the first of them, others to themselves
+    std::vector<Triangle> m_triangles;
+    std::vector<uint32_t> m_free_triangles;
+    std::vector<uint32_t> m_vertex_triangle; //a triangle round each vertex (s_null if not inserted)
+    uint32_t m_infinite = 0; //m_points.size()
+    uint32_t m_last = s_null; //where the next walk starts
+
+    //Scratch space, kept to save reallocating
+    struct CavityEdge
+    {
+      uint32_t a, b; //a -> b, the cavity on its left
+      uint32_t outside;
+      uint8_t constrained;
+    };
+    std::vector<uint32_t> m_cavity;
+    std::vector<CavityEdge> m_cavity_boundary;
+    std::vector<uint32_t> m_mark; //per triangle, m_mark_stamp (in the cavity) or m_mark_stamp + 1 (not)
+    uint32_t m_mark_stamp = 0;
+    std::vector<uint32_t> m_new_by_start; //per vertex, the new triangle on the cavity edge starting there
+    std::deque<std::pair<uint32_t, uint32_t>> m_crossing_edges;
+    std::vector<std::pair<uint32_t, uint32_t>> m_new_edges;
+  };
+}
@@ -0,0 +1,159 @@
+#include "Geometry/FlatSortedSet.h"
+#include "Geometry/RBTree.h"
+#include "Geometry/IntersectionSet.h"
+#include "CoreLib/Timer.h"
+#include <random>
+#include <set>
+
+namespace Geom
+{
+  void Test_FlatSortedSet()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("FlatSortedSet");
+    SPG_WARN("-------------------------------------------------------------------------");
+    {
+      FlatSortedSet<int, std::less<int>, 4> set(std::vector<int>{2,11,4,125,15,3,9,32,71,43,27,1});
+      set.Validate();
+      SPG_TRACE("Size: {}, Blocks: {}", set.Size(), set.NumBlocks());
+      for(auto v : set)
+        SPG_TRACE(v);
+      SPG_TRACE("LowerBound(10): {}, UpperBound(11): {}", *set.LowerBound(10), *set.UpperBound(11));
+      SPG_TRACE("Duplicate insert returns end(): {}", set.Insert(15) == set.end());
+      for(auto v : {125, 2, 15, 9})
+        set.Erase(v);
+      set.Validate();
+      for(auto itr = --set.end(); itr != set.end(); --itr)
+        SPG_TRACE(*itr);
+    }
+
+    {
+      SPG_WARN("INSERT/ERASE CHURN + NEIGHBOUR LOOKUPS VS RBTree_V2, std::set ")
+      //Status structure usage: insert, look at the neighbours either side, later erase. Run at a typical
+      //status structure size and at a large one
+      for(int num_vals : {1000, 200000}) {
+        const int NUM_ROUNDS = 5;
+        std::vector<int> vals(num_vals);
+        for(int i=0; i<num_vals; i++)
+          vals[i] = i;
+        std::mt19937 mt(1);
+        std::shuffle(vals.begin(), vals.end(), mt);
+        const int num_reps = 1000000 / num_vals;
+
+        auto churn = [&](auto& container) {
+          Core::Timer timer;
+          long long sum = 0;
+          for(int rep = 0; rep < num_reps; rep++) {
+            for(auto v : vals)
+              container.Insert(v);
+            for(int r=0; r<NUM_ROUNDS; r++) {
+              for(int i=0; i<num_vals; i+=2)
+                container.Erase(vals[i]);
+              for(int i=0; i<num_vals; i+=2) {
+                auto itr = container.Insert(vals[i]);
+                auto next = itr; ++next;
+                if(next != container.end()) sum += *next;
+                if(itr != container.begin()) sum += *(--itr);
+              }
+            }
+            container.Clear();
+          }
+          SPG_ASSERT(sum != 0);
+          return timer.ElapsedMillis();
+        };
+
+        //std::set wrapped so the same lambda drives it
+        struct StdSet
+        {
+          std::set<int> s;
+          auto Insert(int v) { return s.insert(v).first; }
+          void Erase(int v) { s.erase(v); }
+          void Clear() { s.clear(); }
+          auto begin() { return s.begin(); }
+          auto end() { return s.end(); }
+        };
+
+        FlatSortedSet<int> flat_set;
+        RBTree_V2::RBTree<int> rb_tree;
+        StdSet std_set;
+        SPG_INFO("{} values:", num_vals);
+        SPG_INFO("  FlatSortedSet: {:.2f} ms", churn(flat_set));
+        SPG_INFO("  RBTree_V2: {:.2f} ms", churn(rb_tree));
+        SPG_INFO("  std::set: {:.2f} ms", churn(std_set));
+      }
+    }
+
+    {
+      SPG_WARN("SWEEP LINE STATUS STRUCTURE (SweepLineComparator) VS RBTree_V2, std::set ")
+      //Near vertical segments each in their own x slot so none intersect, with overlapping y ranges. The sweep
+      //goes down through the endpoints: insert at the upper endpoint, find the left/right neighbours (as
+      //IntersectionSet does), erase at the lower endpoint
+      const int NUM_SEGS = 20000;
+      std::mt19937 mt(3);
+      std::uniform_real_distribution<double> y_dist(0.0, 10000.0);
+      std::uniform_real_distribution<double> len_dist(10.0, 2000.0);
+      std::uniform_real_distribution<double> dx_dist(-4.0, 4.0);
+      std::vector<ItersectSet::Segment> segs;
+      for(int i=0; i<NUM_SEGS; i++) {
+        double x = 10.0 * i + 5.0;
+        double y_top = y_dist(mt);
+        segs.push_back({{x, y_top}, {x + dx_dist(mt), y_top - len_dist(mt)}});
+      }
+      struct SweepEvent { double y; ItersectSet::SegIndex seg; bool is_start; };
+      std::vector<SweepEvent> events;
+      for(ItersectSet::SegIndex i=0; i<NUM_SEGS; i++) {
+        events.push_back({segs[i].upper.y, i, true});
+        events.push_back({segs[i].lower.y, i, false});
+      }
+      std::sort(events.begin(), events.end(), [](auto& a, auto& b) { return a.y > b.y; });
+
+      ItersectSet::SweepLine<> sweep_line;
+      sweep_line.segs = segs.data();
+      sweep_line.tolerance = 1e-9;
+      auto sweep = [&](auto& status) {
+        Core::Timer timer;
+        uint32_t num_neighbours = 0;
+        std::size_t max_size = 0;
+        for(auto& e : events) {
+          auto& seg = segs[e.seg];
+          sweep_line.event_point = e.is_start ? seg.upper : seg.lower;
+          if(e.is_start) {
+            auto itr = status.Insert(e.seg);
+            auto right = itr; ++right;
+            num_neighbours += (right != status.end()) + (itr != status.begin());
+            max_size = std::max(max_size, (std::size_t)status.Size());
+          }
+          else {
+            auto itr = status.Find(e.seg);
+            SPG_ASSERT(itr != status.end());
+            status.Erase(itr);
+          }
+        }
+        SPG_ASSERT(status.Empty());
+        SPG_INFO("  neighbours found: {}, max status size: {}", num_neighbours, max_size);
+        return timer.ElapsedMillis();
+      };
+
+      struct StdSet
+      {
+        std::set<ItersectSet::SegIndex, ItersectSet::SweepLineComparator<>> s;
+        StdSet(ItersectSet::SweepLineComparator<> comp) : s(comp) {}
+        auto Insert(ItersectSet::SegIndex seg) { return s.insert(seg).first; }
+        auto Find(ItersectSet::SegIndex seg) { return s.find(seg); }
+        void Erase(std::set<ItersectSet::SegIndex, ItersectSet::SweepLineComparator<>>::iterator itr) { s.erase(itr); }
+        std::size_t Size() const { return s.size(); }
+        bool Empty() const { return s.empty(); }
+        auto begin() { return s.begin(); }
+        auto end() { return s.end(); }
+      };
+
+      ItersectSet::SweepLineComparator<> comp(sweep_line);
+      FlatSortedSet<ItersectSet::SegIndex, ItersectSet::SweepLineComparator<>> flat_set(comp);
+      RBTree_V2::RBTree<ItersectSet::SegIndex, ItersectSet::SweepLineComparator<>> rb_tree(comp);
+      StdSet std_set(comp);
+      SPG_INFO("FlatSortedSet: {:.2f} ms", sweep(flat_set));
+      SPG_INFO("RBTree_V2: {:.2f} ms", sweep(rb_tree));
+      SPG_INFO("std::set: {:.2f} ms", sweep(std_set));
+    }
+  }
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include "CoreLib/SpgAssert.h"
+
+namespace Geom
+{
+  //Ordered set with the same Insert/Erase/Find/LowerBound/UpperBound/Iterator surface as RBTree_V2::RBTree, but
+  //stored as a list of sorted blocks (a 2 level B+ tree with the index level being the block list itself). Each
+  //block is its own heap allocated vector of up to s_block_size elements, and the block list is a vector of those.
+  //A search is a binary search over the block maxima followed by a binary search inside one block (O(log n)), and
+  //in order iteration / neighbour lookups walk a block's contiguous elements, only hopping to another allocation
+  //at a block boundary, instead of chasing a pointer per element.
+  //Insert/Erase shift up to s_block_size elements within a block. When that splits a full block or merges a small
+  //one, the block list itself is shifted too: O(n / s_block_size) block headers (moved, not their elements).
+  //
+  //Unlike a textbook B+ tree there are no separator key copies - the block index compares against each block's
+  //live back() element. That matters for sweep line status structures where the comparator depends on the sweep
+  //position (SweepLineComparator): a stale separator for an already erased segment could compare inconsistently
+  //once the sweep line has moved past it, whereas live elements are ordered consistently as long as the
+  //comparator is consistent for the elements actually in the set (the same requirement as std::set / RBTree).
+  //
+  //Iterators are invalidated by Insert and Erase (as for std::vector), whereas RBTree iterators stay valid. Emptied
+  //blocks are kept on a spare list and re-used, so insert/erase churn at a steady size does no heap allocation.
+  template<
+    typename TValue,
+    typename TComp = std::less<TValue>,
+    uint32_t BlockSize = 64
+  >
+  class FlatSortedSet
+  {
+    static_assert(BlockSize >= 4, "FlatSortedSet block size must be at least 4");
+
+  public:
+    using key_type = TValue;
+    using value_type = TValue;
+    using reference = const value_type&; //elements are the keys, so not modifiable in place
+    using pointer = const value_type*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = TComp;
+    using value_compare = TComp;
+
+    static constexpr uint32_t s_block_size = BlockSize;
+
+  private:
+    using Block = std::vector<value_type>;
+
+  public:
+    class Iterator
+    {
+    private:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using difference_type   = std::ptrdiff_t;
+
+    public:
+      Iterator() = default;
+
+      Iterator& operator++() {
+        if(m_block == m_blocks->size())
+          return *this;
+        if(++m_idx == (*m_blocks)[m_block].size()) {
+          m_block++;
+          m_idx = 0;
+        }
+        return *this;
+      }
+
+      Iterator& operator--() {
+        //Decrementing begin() gives end(), same as RBTree_V2
+        if(m_idx > 0) {
+          m_idx--;
+          return *this;
+        }
+        if(m_block == 0) {
+          m_block = (uint32_t)m_blocks->size();
+          return *this;
+        }
+        m_block--;
+        m_idx = (uint32_t)(*m_blocks)[m_block].size() - 1;
+        return *this;
+      }
+
+      Iterator operator++(int) {
+        auto tmp = *this;
+        ++(*this);
+        return tmp;
+      }
+
+      Iterator operator--(int) {
+        auto tmp = *this;
+        --(*this);
+        return tmp;
+      }
+
+      bool operator == (const Iterator& other) const {
+        return (m_blocks == other.m_blocks) && (m_block == other.m_block) && (m_idx == other.m_idx);
+      }
+
+      bool operator != (const Iterator& other) const {
+        return !(*this == other);
+      }
+
+      reference operator* () const {
+        SPG_ASSERT(m_block < m_blocks->size());
+        return (*m_blocks)[m_block][m_idx];
+      }
+
+      pointer operator->() const {
+        return &(operator*());
+      }
+
+    private:
+      friend class FlatSortedSet;
+      Iterator(const std::vector<Block>* blocks, uint32_t block, uint32_t idx) :
+        m_blocks{blocks}, m_block{block}, m_idx{idx} {}
+      const std::vector<Block>* m_blocks = nullptr;
+      uint32_t m_block = 0; //== m_blocks->size() for end()
+      uint32_t m_idx = 0;
+    };
+
+  public:
+    FlatSortedSet(TComp comp = TComp()) : m_comp{comp} {}
+
+    FlatSortedSet(const std::vector<value_type>& elements, TComp comp = TComp()) : FlatSortedSet{comp} {
+      for(auto& e : elements)
+        Insert(e);
+    }
+
+    Iterator Insert(const value_type& element) {
+      //Returns end() if an equivalent element is already in the set (same as RBTree_V2)
+      if(m_blocks.empty()) {
+        m_blocks.push_back(NewBlock());
+        m_blocks[0].push_back(element);
+        m_size++;
+        return Iterator(&m_blocks, 0, 0);
+      }
+      uint32_t b = FindBlock(element);
+      if(b == m_blocks.size())
+        b--; //goes after everything - append to the last block
+      Block& block = m_blocks[b];
+      auto pos = std::lower_bound(block.begin(), block.end(), element, m_comp);
+      if((pos != block.end()) && !m_comp(element, *pos))
+        return end();
+      uint32_t idx = (uint32_t)(pos - block.begin());
+      block.insert(pos, element);
+      m_size++;
+      if(block.size() > s_block_size) {
+        //Split in half, the upper half goes in a new block after this one
+        uint32_t half = (uint32_t)block.size() / 2;
+        Block upper = NewBlock();
+        upper.assign(block.begin() + half, block.end());
+        m_blocks[b].resize(half);
+        m_blocks.insert(m_blocks.begin() + b + 1, std::move(upper));
+        if(idx >= half)
+          return Iterator(&m_blocks, b + 1, idx - half);
+      }
+      return Iterator(&m_blocks, b, idx);
+    }
+
+    bool Erase(const key_type& key) {
+      auto itr = Find(key);
+      if(itr == end())
+        return false;
+      Erase(itr);
+      return true;
+    }
+
+    void Erase(Iterator itr) {
+      SPG_ASSERT(itr.m_blocks == &m_blocks);
+      SPG_ASSERT(itr.m_block < m_blocks.size());
+      uint32_t b = itr.m_block;
+      Block& block = m_blocks[b];
+      block.erase(block.begin() + itr.m_idx);
+      m_size--;
+      if(block.empty()) {
+        RemoveBlock(b);
+        return;
+      }
+      //Merge under-full neighbours so the block list doesn't fill up with tiny blocks
+      if((block.size() < s_block_size / 4) && (b + 1 < m_blocks.size()) && (block.size() + m_blocks[b+1].size() <= s_block_size / 2)) {
+        block.insert(block.end(), m_blocks[b+1].begin(), m_blocks[b+1].end());
+        RemoveBlock(b + 1);
+      }
+      else if((block.size() < s_block_size / 4) && (b > 0) && (block.size() + m_blocks[b-1].size() <= s_block_size / 2)) {
+        Block& prev = m_blocks[b-1];
+        prev.insert(prev.end(), block.begin(), block.end());
+        RemoveBlock(b);
+      }
+    }
+
+    void Clear() {
+      while(!m_blocks.empty())
+        RemoveBlock((uint32_t)m_blocks.size() - 1);
+      m_size = 0;
+    }
+
+    bool Contains(const key_type& key) const {
+      return Find(key) != end();
+    }
+
+    std::size_t Size() const {
+      return m_size;
+    }
+
+    bool Empty() const {
+      return (m_size == 0);
+    }
+
+    void InOrderTraverse(std::vector<value_type>& values_out) const {
+      for(auto& block : m_blocks)
+        values_out.insert(values_out.end(), block.begin(), block.end());
+    }
+
+    Iterator begin() const {
+      return Iterator(&m_blocks, 0, 0); //== end() if empty
+    }
+
+    Iterator end() const {
+      return Iterator(&m_blocks, (uint32_t)m_blocks.size(), 0);
+    }
+
+    Iterator Find(const key_type& key) const {
+      auto itr = LowerBound(key);
+      if((itr != end()) && m_comp(key, *itr))
+        return end();
+      return itr;
+    }
+
+    Iterator LowerBound(const key_type& key) const {
+      //First element which does not go before key, i.e. comp(element, key) = false
+      uint32_t b = FindBlock(key);
+      if(b == m_blocks.size())
+        return end();
+      const Block& block = m_blocks[b];
+      auto pos = std::lower_bound(block.begin(), block.end(), key, m_comp);
+      return Iterator(&m_blocks, b, (uint32_t)(pos - block.begin()));
+    }
+
+    Iterator UpperBound(const key_type& key) const {
+      //First element that goes after key, i.e. comp(key, element) = true
+      auto block_itr = std::partition_point(m_blocks.begin(), m_blocks.end(),
+        [this, &key](const Block& block) { return !m_comp(key, block.back()); });
+      if(block_itr == m_blocks.end())
+        return end();
+      auto pos = std::upper_bound(block_itr->begin(), block_itr->end(), key, m_comp);
+      return Iterator(&m_blocks, (uint32_t)(block_itr - m_blocks.begin()), (uint32_t)(pos - block_itr->begin()));
+    }
+
+    template<typename TPred>
+    Iterator PartitionPoint(TPred pred) const {
+      //First element for which pred is false. The set must be partitioned by pred (all the elements it's true for
+      //come first) - for searching on something other than a key, e.g. a sweep line position
+      auto block_itr = std::partition_point(m_blocks.begin(), m_blocks.end(),
+        [&pred](const Block& block) { return pred(block.back()); });
+      if(block_itr == m_blocks.end())
+        return end();
+      auto pos = std::partition_point(block_itr->begin(), block_itr->end(), pred);
+      return Iterator(&m_blocks, (uint32_t)(block_itr - m_blocks.begin()), (uint32_t)(pos - block_itr->begin()));
+    }
+
+    uint32_t NumBlocks() const {
+      return (uint32_t)m_blocks.size();
+    }
+
+    void Validate() const {
+      std::size_t count = 0;
+      for(uint32_t b = 0; b < m_blocks.size(); b++) {
+        const Block& block = m_blocks[b];
+        SPG_ASSERT(!block.empty());
+        SPG_ASSERT(block.size() <= s_block_size);
+        for(uint32_t i = 1; i < block.size(); i++)
+          SPG_ASSERT(m_comp(block[i-1], block[i]));
+        if(b > 0)
+          SPG_ASSERT(m_comp(m_blocks[b-1].back(), block.front()));
+        count += block.size();
+      }
+      SPG_ASSERT(count == m_size);
+    }
+
+  private:
+    uint32_t FindBlock(const key_type& key) const {
+      //First block whose max doesn't go before key - the only block that can hold LowerBound(key)
+      auto block_itr = std::partition_point(m_blocks.begin(), m_blocks.end(),
+        [this, &key](const Block& block) { return m_comp(block.back(), key); });
+      return (uint32_t)(block_itr - m_blocks.begin());
+    }
+
+    Block NewBlock() {
+      if(m_spare_blocks.empty()) {
+        Block block;
+        block.reserve(s_block_size + 1);
+        return block;
+      }
+      Block block = std::move(m_spare_blocks.back());
+      m_spare_blocks.pop_back();
+      return block;
+    }
+
+    void RemoveBlock(uint32_t b) {
+      m_blocks[b].clear();
+      m_spare_blocks.push_back(std::move(m_blocks[b]));
+      m_blocks.erase(m_blocks.begin() + b);
+    }
+
+  private:
+    std::vector<Block> m_blocks;
+    std::vector<Block> m_spare_blocks; //emptied blocks, capacity kept
+    std::size_t m_size = 0;
+    TComp m_comp;
+  };
+
+  void Test_FlatSortedSet();
+}
@@ -4,14 +4,21 @@
 
 #include "Geometry/MeshPrimitives2D.h"
 #include "Geometry/DCEL.h"
+#include "Geometry/SegmentGrid.h"
+#include "Geometry/Delaunay.h"
 #include "Geometry/ConvexHull.h"
+#include "Geometry/IncrementalHull.h"
 #include "Geometry/Polygon.h"
 #include "Geometry/Triangulate.h"
 #include "Geometry/BSTree.h"
 #include "Geometry/RBTree.h"
 #include "Geometry/RBTreeTraversable.h"
+#include "Geometry/FlatSortedSet.h"
 #include "Geometry/KDTree.h"
+#include "Geometry/KDTreeND.h"
 #include "Geometry/RangeTree.h"
+#include "Geometry/BatchQuery.h"
+#include "Geometry/PointSoA2D.h"
 #include "Geometry/IntersectionSet.h"
 #include "Geometry/MonotonePartition.h"
 #include "Geometry/Voronoi.h"
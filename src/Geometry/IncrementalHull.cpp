@@ -0,0 +1,176 @@
+#include "Geometry/IncrementalHull.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Geometry/ConvexHull.h"
+#include "CoreLib/Timer.h"
+#include "MathLib/Geom/Predicates.h"
+
+namespace Geom
+{
+  void IncrementalHull2D::Insert(std::span<const SpgMth::Point2d> points)
+  {
+    for(const auto& p : points)
+      Insert(p);
+  }
+
+  bool IncrementalHull2D::Insert(const SpgMth::Point2d& point)
+  {
+    bool lower_changed = InsertIntoChain(m_lower, point, 1.0);
+    bool upper_changed = InsertIntoChain(m_upper, point, -1.0);
+    return lower_changed || upper_changed;
+  }
+
+  bool IncrementalHull2D::InsertIntoChain(Chain& chain, const SpgMth::Point2d& point, double sign)
+  {
+    //Reject if p is already a vertex, or between two neighbouring vertices and on the inside of (or on) the edge.
+    //If next is end(), p is the new lex max, so it's always a vertex - as is a new lex min
+    auto next = chain.LowerBound(point);
+    if(next != chain.end()) {
+      if(*next == point)
+        return false;
+      if(next != chain.begin()) {
+        auto prev = next;
+        --prev;
+        if(sign * SpgMth::Orient2d(*prev, *next, point) >= 0.0)
+          return false;
+      }
+    }
+
+    auto itr = chain.Insert(point);
+    SPG_ASSERT(itr != chain.end());
+
+    //Neighbours that p has made reflex (or collinear). Erasing relinks nodes, so itr stays valid
+    while(true) {
+      auto nxt = itr;
+      ++nxt;
+      if(nxt == chain.end())
+        break;
+      auto nxt_nxt = nxt;
+      ++nxt_nxt;
+      if((nxt_nxt == chain.end()) || (sign * SpgMth::Orient2d(point, *nxt, *nxt_nxt) > 0.0))
+        break;
+      chain.Erase(nxt);
+    }
+    while(true) {
+      auto prv = itr;
+      --prv;
+      if(prv == chain.end())
+        break;
+      auto prv_prv = prv;
+      --prv_prv;
+      if((prv_prv == chain.end()) || (sign * SpgMth::Orient2d(*prv_prv, *prv, point) > 0.0))
+        break;
+      chain.Erase(prv);
+    }
+    return true;
+  }
+
+  bool IncrementalHull2D::ChainContains(const Chain& chain, const SpgMth::Point2d& point, double sign)
+  {
+    auto next = chain.LowerBound(point);
+    if(next == chain.end())
+      return false; //right of the hull
+    if(*next == point)
+      return true;
+    if(next == chain.begin())
+      return false; //left of the hull
+    auto prev = next;
+    --prev;
+    return sign * SpgMth::Orient2d(*prev, *next, point) >= 0.0;
+  }
+
+  bool IncrementalHull2D::Contains(const SpgMth::Point2d& point) const
+  {
+    return ChainContains(m_lower, point, 1.0) && ChainContains(m_upper, point, -1.0);
+  }
+
+  std::vector<SpgMth::Point2d> IncrementalHull2D::Hull() const
+  {
+    std::vector<SpgMth::Point2d> hull;
+    Hull(hull);
+    return hull;
+  }
+
+  void IncrementalHull2D::Hull(std::vector<SpgMth::Point2d>& hull_out) const
+  {
+    //Lower chain left to right, then the upper chain right to left without its end points (shared with the lower)
+    hull_out.clear();
+    hull_out.reserve(NumVertices());
+    for(const auto& p : m_lower)
+      hull_out.push_back(p);
+    std::size_t upper_start = hull_out.size();
+    for(const auto& p : m_upper)
+      hull_out.push_back(p);
+    if(hull_out.size() - upper_start <= 2) {
+      hull_out.resize(upper_start);
+      return;
+    }
+    hull_out.pop_back();
+    hull_out.erase(hull_out.begin() + upper_start);
+    std::reverse(hull_out.begin() + upper_start, hull_out.end());
+  }
+
+  uint32_t IncrementalHull2D::NumVertices() const
+  {
+    if(m_upper.Size() <= 2)
+      return m_lower.Size();
+    return m_lower.Size() + m_upper.Size() - 2;
+  }
+
+  void IncrementalHull2D::Clear()
+  {
+    m_lower.Clear();
+    m_upper.Clear();
+  }
+
+  void IncrementalHull2D::Test()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("IncrementalHull2D");
+    SPG_WARN("-------------------------------------------------------------------------");
+
+    //A stream of points arriving in batches, hull wanted after each one: incremental inserts vs re-running a
+    //batch hull over everything seen so far
+    const uint32_t NUM_POINTS = 100000;
+    const uint32_t BATCH_SIZE = 1000;
+    std::mt19937 mt(23);
+    std::normal_distribution<float> dist(0.0f, 100.0f);
+    std::vector<SpgMth::Point2d> points;
+    points.reserve(NUM_POINTS);
+    for(uint32_t i = 0; i < NUM_POINTS; i++)
+      points.push_back({dist(mt), dist(mt)});
+
+    Core::Timer timer;
+    IncrementalHull2D inc_hull;
+    std::vector<SpgMth::Point2d> hull;
+    for(uint32_t first = 0; first < NUM_POINTS; first += BATCH_SIZE) {
+      inc_hull.Insert(std::span(points).subspan(first, BATCH_SIZE));
+      inc_hull.Hull(hull);
+    }
+    SPG_INFO("IncrementalHull2D: {:.2f} ms, {} batches of {}, {} vertices", timer.ElapsedMillis(), NUM_POINTS / BATCH_SIZE, BATCH_SIZE, hull.size());
+
+    timer.Reset();
+    std::vector<SpgMth::Point2d> seen;
+    std::vector<SpgMth::Point2d> grahams;
+    for(uint32_t first = 0; first < NUM_POINTS; first += BATCH_SIZE) {
+      seen.insert(seen.end(), points.begin() + first, points.begin() + first + BATCH_SIZE);
+      grahams = Convexhull2D_ModifiedGrahams(seen);
+    }
+    SPG_INFO("Convexhull2D_ModifiedGrahams per batch: {:.2f} ms, {} points", timer.ElapsedMillis(), grahams.size());
+
+    timer.Reset();
+    std::vector<SpgMth::Point2d> chan;
+    for(uint32_t first = 0; first < NUM_POINTS; first += BATCH_SIZE)
+      chan = ConvexHull2D_Chan(std::span(points).first(first + BATCH_SIZE));
+    SPG_INFO("ConvexHull2D_Chan per batch: {:.2f} ms, {} points", timer.ElapsedMillis(), chan.size());
+    SPG_ASSERT(chan == hull);
+
+    timer.Reset();
+    uint32_t num_inside = 0;
+    for(const auto& p : points)
+      num_inside += inc_hull.Contains(p) ? 1 : 0;
+    SPG_INFO("Contains: {:.2f} ms for {} queries, {} inside", timer.ElapsedMillis(), NUM_POINTS, num_inside);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include "CoreLib/Core.h"
+#include "MathLib/Geom/Geom.h"
+#include "Geometry/RBTree.h"
+
+namespace Geom
+{
+  //Convex hull of a growing point set, for point streams where the hull is wanted after every batch. Keeps the
+  //lower and upper monotone chains (as in Andrew's algorithm) in two RBTree_V2::RBTree's ordered by x, then y.
+  //A point inside the hull is rejected after one O(log h) search per chain. One outside is inserted into the
+  //chain(s) it's outside of and the neighbours it makes non-convex are erased - each vertex is erased at most
+  //once, so that's amortised O(1). A batch of k points costs O(k log h), independent of how many came before.
+  //
+  //Exact orientation tests (SpgMth::Orient2d) throughout. The hull is strictly convex - collinear points on an
+  //edge aren't vertices.
+  class IncrementalHull2D
+  {
+  private:
+    struct LexLess
+    {
+      bool operator()(const SpgMth::Point2d& a, const SpgMth::Point2d& b) const
+      {
+        return (a.x < b.x) || ((a.x == b.x) && (a.y < b.y));
+      }
+    };
+
+    using Chain = RBTree_V2::RBTree<SpgMth::Point2d, LexLess>;
+
+  public:
+    IncrementalHull2D() = default;
+
+    void Insert(std::span<const SpgMth::Point2d> points);
+    bool Insert(const SpgMth::Point2d& point); //true if the hull changed
+
+    //Inside or on the boundary, O(log h)
+    bool Contains(const SpgMth::Point2d& point) const;
+
+    //CCW from the leftmost (lowest on ties) vertex - the same as ConvexHull2D_Chan() for all the points inserted
+    std::vector<SpgMth::Point2d> Hull() const;
+    void Hull(std::vector<SpgMth::Point2d>& hull_out) const;
+
+    uint32_t NumVertices() const;
+    bool Empty() const { return m_lower.Empty(); }
+    void Clear();
+
+    static void Test();
+
+  private:
+    //sign = 1 for the lower chain (the hull is left of it, going left to right), -1 for the upper
+    static bool InsertIntoChain(Chain& chain, const SpgMth::Point2d& point, double sign);
+    static bool ChainContains(const Chain& chain, const SpgMth::Point2d& point, double sign);
+
+  private:
+    Chain m_lower;
+    Chain m_upper;
+  };
+}
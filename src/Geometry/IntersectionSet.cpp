@@ -2,95 +2,54 @@
 
 #include <string>
 #include <algorithm>
+#include <random>
+#include <set>
 
 #include "CoreLib/Core.h"
+#include "CoreLib/Timer.h"
 #include "MathLib/Geom/Geom.h"
+#include "MathLib/Geom/Predicates.h"
 
 namespace Geom
 {
   namespace ItersectSet
   {
-    #define LOG_COMP_VERS 0
-    #define ENABLE_PRINTING
+    //#define ENABLE_PRINTING
     //#define ENABLE_PRINT_COMPARATOR_LOGGING
 
-    static void PrintComparatorResult1(const SpgMth::LineSeg2D& seg1, const SpgMth::LineSeg2D& seg2, const SpgMth::Point2d& event_point, bool result, int idx)
-    {
-      const char* res_str = result ? "True" : "False" ;
-      SPG_INFO("  {}.SLC Comparing ({},{})->({},{}) with ({},{})->({},{}) at ({},{}) => {}",idx, seg1.start.x,seg1.start.y,seg1.end.x,seg1.end.y, seg2.start.x,seg2.start.y,seg2.end.x,seg2.end.y, event_point.x,event_point.y, res_str);
-    }
-
-    static void PrintComparatorResult2(const SpgMth::LineSeg2D& seg1, const SpgMth::LineSeg2D& seg2, const SpgMth::Point2d& event_point, bool result, int idx)
-    {
-      std::cout << idx << ".SLC Comp: " ;
-      std::cout << "(" << seg1.start.x << "," << seg1.start.y << ")->(" << seg1.end.x << "," << seg2.end.y << ") with";
-      std::cout << "(" << seg2.start.x << "," << seg2.start.y << ")->(" << seg2.end.x << "," << seg2.end.y << ")  at ";
-      std::cout << "(" << event_point.x << "," << event_point.y << ") => " << std::boolalpha << result;
-      std::cout << std::endl; 
-    }
-
-    #if(LOG_COMP_VERS == 1)
-      #define PRINT_COMPARATOR_RESULT(seg1,seg2,event_point,result,idx) PrintComparatorResult1(seg1,seg2,event_point,result,idx)
-    #elif(LOG_COMP_VERS == 2) 
-       #define PRINT_COMPARATOR_RESULT(seg1,seg2,event_point,result,idx) PrintComparatorResult2(seg1,seg2,event_point,result,idx)
-    #else
-       #define PRINT_COMPARATOR_RESULT(seg1,seg2,event_point,result,tag)   
-    #endif
-   
+    //Compiles to just 'return result' unless TLogger::s_enabled
     #define LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point,result,tag) \
       { \
-        if(m_logger != nullptr) { \
-          ComparatorLogger::ComparisonRecord record{seg1,seg2,event_point,result,tag}; \
-          m_logger->Log(record); \
+        if constexpr(TLogger::s_enabled) { \
+          if(sweep_line.logger != nullptr) { \
+            ComparatorLogger::ComparisonRecord record{seg1,seg2,event_point,result,tag}; \
+            sweep_line.logger->Log(record); \
+          } \
         } \
         return result; \
       } \
-    
-    static void PrintInsertion(SpgMth::LineSeg2D& seg)
-    {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_WARN("Inserting ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-      SPG_LOG_FLUSH;
-    }
 
-    static void PrintDeletion(SpgMth::LineSeg2D& seg)
+    static double Cross(const SpgMth::DVec2& v1, const SpgMth::DVec2& v2)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_WARN("Deleting ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-      SPG_LOG_FLUSH;
+      return v1.x * v2.y - v1.y * v2.x;
     }
 
-    static void PrintInsertionResult(SpgMth::LineSeg2D& seg, int diff)
+    static bool Near(const SpgMth::DPoint2d& p1, const SpgMth::DPoint2d& p2, double tolerance)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-        if(diff == 1) {
-           SPG_INFO("Insertion Success ({},{})->({},{}), {}", seg.start.x,seg.start.y,seg.end.x,seg.end.y, diff);
-        } else {
-           SPG_ERROR("Insertion Fail ({},{})->({},{}), {}", seg.start.x,seg.start.y,seg.end.x,seg.end.y, diff);
-        }
-        SPG_LOG_FLUSH;
+      return (std::abs(p1.x - p2.x) <= tolerance) && (std::abs(p1.y - p2.y) <= tolerance);
     }
 
-    static void PrintDeletionResult(SpgMth::LineSeg2D& seg, int diff)
+    static void PrintSeg(const Segment& seg)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-        if(diff == -1) {
-           SPG_INFO("Deletion Success ({},{})->({},{}), {}", seg.start.x,seg.start.y,seg.end.x,seg.end.y, diff);
-        } else {
-           SPG_ERROR("Deletion Fail ({},{})->({},{}), {}", seg.start.x,seg.start.y,seg.end.x,seg.end.y, diff);
-        }
-        SPG_LOG_FLUSH;
+      if(seg.IsHorizontal()) {
+        SPG_TRACE("  ({},{})->({},{}) - HOR", seg.upper.x,seg.upper.y,seg.lower.x,seg.lower.y);
+      }
+      else {
+        SPG_TRACE("  ({},{})->({},{})", seg.upper.x,seg.upper.y,seg.lower.x,seg.lower.y);
+      }
     }
 
-    void ComparatorLogger::Print()
+    void ComparatorLogger::Print(std::span<const Segment> segs)
     {
       #ifndef ENABLE_PRINT_COMPARATOR_LOGGING
         return;
@@ -99,141 +58,160 @@ namespace Geom
         if(std::holds_alternative<ComparatorLogger::ComparisonRecord>(record)){
           auto r = std::get<ComparatorLogger::ComparisonRecord>(record);
           const char* res_str = r.result ? "True" : "False" ;
-          SPG_TRACE("{}.SLC COMPARING ({},{})->({},{}) with ({},{})->({},{}) at ({},{}) => {}",r.tag, r.seg1.start.x, r.seg1.start.y, r.seg1.end.x, r.seg1.end.y, r.seg2.start.x, r.seg2.start.y, r.seg2.end.x, r.seg2.end.y, r.event_point.x, r.event_point.y, res_str);
+          auto& s1 = segs[r.seg1];
+          auto& s2 = segs[r.seg2];
+          SPG_TRACE("{}.SLC COMPARING {}:({},{})->({},{}) with {}:({},{})->({},{}) at ({},{}) => {}",r.tag, r.seg1, s1.upper.x, s1.upper.y, s1.lower.x, s1.lower.y, r.seg2, s2.upper.x, s2.upper.y, s2.lower.x, s2.lower.y, r.event_point.x, r.event_point.y, res_str);
         }
         else if (std::holds_alternative<ComparatorLogger::PreInsertionRecord>(record)) {
           auto r = std::get<ComparatorLogger::PreInsertionRecord>(record);
-          SPG_WARN("Inserting: ({},{})->({},{})", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y );
+          SPG_WARN("Inserting: {}", r.seg);
         }
         else if (std::holds_alternative<ComparatorLogger::PreDeletionRecord>(record)) {
           auto r = std::get<ComparatorLogger::PreDeletionRecord>(record);
-          SPG_WARN("Deleting: ({},{})->({},{})", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y );
+          SPG_WARN("Deleting: {}", r.seg);
         }
         else if (std::holds_alternative<ComparatorLogger::PostInsertionRecord>(record)) {
           auto r = std::get<ComparatorLogger::PostInsertionRecord>(record);
-          if(r.success) 
-            SPG_INFO("Insertion Successful: ({},{})->({},{})", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y)
+          if(r.success)
+            SPG_INFO("Insertion Successful: {}", r.seg)
           else
-             SPG_ERROR("Insertion Failed: ({},{})->({},{}). Delta size: {}", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y, r.size_change)
+             SPG_ERROR("Insertion Failed: {}. Delta size: {}", r.seg, r.size_change)
         }
         else if (std::holds_alternative<ComparatorLogger::PostDeletionRecord>(record)) {
           auto r = std::get<ComparatorLogger::PostDeletionRecord>(record);
-          if(r.success) 
-            SPG_INFO("Deletion Successful: ({},{})->({},{})", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y)
+          if(r.success)
+            SPG_INFO("Deletion Successful: {}", r.seg)
           else
-             SPG_ERROR("Deletion Failed: ({},{})->({},{}). Delta size: {}", r.seg.start.x, r.seg.start.y, r.seg.end.x, r.seg.end.y, r.size_change)
+             SPG_ERROR("Deletion Failed: {}. Delta size: {}", r.seg, r.size_change)
         }
       }
     }
 
-    void Event::Print()
+    std::size_t ComparatorLogger::NumComparisons() const
+    {
+      return std::count_if(m_data.begin(), m_data.end(), [](const Record& record) {
+        return std::holds_alternative<ComparisonRecord>(record); });
+    }
+
+    void Queue::Print()
     {
       #ifndef ENABLE_PRINTING
         return;
       #endif
-      SPG_WARN("Next Event: ({},{}) ----------------",  point.x, point.y);
-      for(auto seg : seg_list) {
-        SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-      }
+      SPG_TRACE("Queue: {} upper, {} lower, {} intersection events pending", m_upper_order.size() - m_next_upper,
+        m_lower_order.size() - m_next_lower, m_intersections.size());
     }
 
-    void Queue::Print()  
+    template<typename TLogger>
+    void StatusStructure<TLogger>::PrintStatusStructure()
     {
       #ifndef ENABLE_PRINTING
         return;
       #endif
-      for(auto itr = m_data.cbegin(); itr != m_data.end(); itr++) {
-        Event e = *itr;
-        e.Print();
-      }
+      SPG_TRACE("Status structure: y sweep {}: ------------------- ",m_sweep_line.event_point.y);
+      for(auto seg : m_T)
+        PrintSeg(m_segs[seg]);
     }
-    
-    void StatusStructure::PrintStatusStructure()
+
+    template<typename TLogger>
+    void StatusStructure<TLogger>::PrintSegsContainingPoint()
     {
       #ifndef ENABLE_PRINTING
         return;
       #endif
-      SPG_TRACE("Status structure: y sweep {}: ------------------- ",m_cur_event_point.y);
-      for(auto& seg : m_T) {
-        if(IsHorizontal(seg)) {
-          SPG_TRACE("  ({},{})->({},{}) - HOR", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
-        else {
-          SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
+      auto& p = m_sweep_line.event_point;
+      SPG_WARN("L(P) for ({},{}) ----------------------------------------", p.x,p.y);
+      for(auto seg : m_L)
+        PrintSeg(m_segs[seg]);
+      SPG_WARN("C(P) for ({},{}) ----------------------------------------", p.x,p.y);
+      for(auto seg : m_C)
+        PrintSeg(m_segs[seg]);
+    }
+
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::PrintIntersections()
+    {
+      SPG_WARN("Intersections Found----------------------------------");
+      for(auto& intersection : m_intersections) {
+        SPG_TRACE("({},{})",  intersection.point.x, intersection.point.y);
+        for(auto seg : GetSegs(intersection))
+          PrintSeg(m_segs[seg]);
       }
     }
 
-    void StatusStructure::PrintStatusStructureSubset(std::set<SpgMth::LineSeg2D, SweepLineComparator>::iterator first,
-         std::set<SpgMth::LineSeg2D, SweepLineComparator>::iterator last, const SpgMth::Point2d& p)
+    //Pairs of input segs that intersect (touching included) - O(n^2) reference for testing the sweep
+    static std::set<std::pair<SegIndex,SegIndex>> BruteForceIntersectingPairs(std::span<const SpgMth::LineSeg2D> segs)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_WARN("Status structure - Subset of segs containing ({},{}) ----------------------", p.x,p.y);
-      SPG_ASSERT((first != m_T.end()) && (last != m_T.end()));
-      for(auto itr = first; itr != std::next(last); ++itr) {
-        SpgMth::LineSeg2D seg = *itr;
-        if(IsHorizontal(seg)) {
-          SPG_TRACE("  ({},{})->({},{}) - HOR", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
-        else {
-          SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
+      std::set<std::pair<SegIndex,SegIndex>> pairs;
+      for(SegIndex i = 0; i < segs.size(); i++) {
+        for(SegIndex j = i+1; j < segs.size(); j++) {
+          if(SpgMth::IntersectionExistsExact(segs[i], segs[j]))
+            pairs.insert({i,j});
         }
       }
+      return pairs;
     }
 
-    void StatusStructure::PrintActiveSegList()
+    template<typename TLogger>
+    static std::set<std::pair<SegIndex,SegIndex>> IntersectingPairs(const IntersectionSet<TLogger>& intersection_set)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_TRACE("Segs in m_active_segs !!! ------------------- ");
-      for(auto& seg : m_active_segs) {
-        if(IsHorizontal(seg)) {
-          SPG_TRACE("  ({},{})->({},{}) - HOR", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
-        else {
-          SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
+      std::set<std::pair<SegIndex,SegIndex>> pairs;
+      for(auto& intersection : intersection_set.GetIntersections()) {
+        auto segs = intersection_set.GetSegs(intersection);
+        for(std::size_t i = 0; i < segs.size(); i++)
+          for(std::size_t j = i+1; j < segs.size(); j++)
+            pairs.insert({std::min(segs[i],segs[j]), std::max(segs[i],segs[j])});
       }
+      return pairs;
     }
 
-    void StatusStructure::PrintUnionUC(const SpgMth::Point2d& p)
+    //Random segs with lengths up to max_length, in a square of side 'extent'
+    static SegList RandomSegs(uint32_t num_segs, float extent, float max_length, uint32_t seed)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_WARN("U(P) Union C(P) for ({},{}) ----------------------------------------", p.x,p.y);
-      for(auto& seg : m_union_UC) {
-        if(IsHorizontal(seg)) {
-          SPG_TRACE("  ({},{})->({},{}) - HOR", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
-        else {
-          SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
+      std::mt19937 mt(seed);
+      std::uniform_real_distribution<float> pos_dist(0.0f, extent);
+      std::uniform_real_distribution<float> len_dist(-max_length, max_length);
+      SegList segs;
+      segs.reserve(num_segs);
+      while(segs.size() < num_segs) {
+        SpgMth::Point2d start{pos_dist(mt), pos_dist(mt)};
+        SpgMth::Point2d end{start.x + len_dist(mt), start.y + len_dist(mt)};
+        if(start != end)
+          segs.emplace_back(start, end);
       }
+      return segs;
     }
 
-    void IntersectionSet::PrintIntersections()
+    //Same intersections in the same order, with the same segs
+    template<typename TLogger>
+    static bool SameIntersections(const IntersectionSet<TLogger>& set1, const IntersectionSet<TLogger>& set2)
     {
-      #ifndef ENABLE_PRINTING
-        return;
-      #endif
-      SPG_WARN("Intersections Found----------------------------------");
-      for(auto& intersection : m_intersections) {
-        SPG_TRACE("({},{})",  intersection.point.x, intersection.point.y);
-        for(auto& seg : intersection.segs) {
-          SPG_TRACE("  ({},{})->({},{})", seg.start.x,seg.start.y,seg.end.x,seg.end.y);
-        }
+      auto& intersections1 = set1.GetIntersections();
+      auto& intersections2 = set2.GetIntersections();
+      if(intersections1.size() != intersections2.size())
+        return false;
+      for(std::size_t i = 0; i < intersections1.size(); i++) {
+        auto segs1 = set1.GetSegs(intersections1[i]);
+        auto segs2 = set2.GetSegs(intersections2[i]);
+        if((intersections1[i].point != intersections2[i].point) || !std::equal(segs1.begin(), segs1.end(), segs2.begin(), segs2.end()))
+          return false;
       }
+      return true;
     }
 
-    void IntersectionSet::Test()
+    static void Benchmark();
+
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::Test(bool benchmark_mode)
     {
-       SPG_WARN("-----------------------------------");  
-        SPG_TRACE("iNTERSECTION TESTING");  
-        std::vector<SpgMth::LineSeg2D> segs 
+      if(benchmark_mode) {
+        Benchmark();
+        return;
+      }
+
+       SPG_WARN("-----------------------------------");
+        SPG_TRACE("iNTERSECTION TESTING");
+        std::vector<SpgMth::LineSeg2D> segs
         {
           {{-1,4},{-2,1}}, //f
           {{-2,12},{2,-2}}, //g
@@ -242,382 +220,581 @@ namespace Geom
           {{6,4},{2,10}}, //j
           {{4,4},{2,10}}, //k
           {{2,10},{4,14}}, //l
-          {{8,10},{-4,10}}, //m horizontal line - 
-          {{8,9},{-4,10}}, //m near horizontal line - 
+          {{8,10},{-4,10}}, //m horizontal line -
+          {{8,9},{-4,10}}, //m near horizontal line -
+
 
-        
-          {{-4,6},{-4,10}}, 
+          {{-4,6},{-4,10}},
           {{4,4},{6,4}}, //p horizontal line
-          
+
           {{-8,8},{-4,8}}, //r horizontal line
           {{-6,12},{-6,4}}, //q vertical line
           {{6,14},{6,10}}, //q vertical line
           //{{6,14},{6,9.1666667}}, //q vertical line
 
       };
-    
-      // seg1 = {{-4,10},{8,10}};
-      // seg2 = {{-4,10},{8,10}};
-      // eq = Geom::Equal(seg1.start, seg2.start) && Geom::Equal(seg1.end, seg2.end);
 
-      Geom::ItersectSet::IntersectionSet intersection_set{segs};
-      intersection_set.Process();
+      {
+        IntersectionSet intersection_set{segs};
+        intersection_set.Process();
+        intersection_set.PrintIntersections();
+        auto pairs = IntersectingPairs(intersection_set);
+        auto expected_pairs = BruteForceIntersectingPairs(segs);
+        SPG_INFO("Intersecting pairs: {}, brute force: {}, match: {}", pairs.size(), expected_pairs.size(), pairs == expected_pairs);
+        SPG_ASSERT(pairs == expected_pairs);
+      }
+
+      {
+        SPG_WARN("RANDOM SEGMENTS VS BRUTE FORCE ");
+        //Sparse, then dense - lots of intersections within the tolerance of each other in y
+        for(uint32_t seed = 1; seed <= 10; seed++) {
+          auto random_segs = (seed <= 5) ? RandomSegs(2000, 1000.0f, 60.0f, seed) : RandomSegs(4000, 200.0f, 40.0f, seed);
+          IntersectionSet intersection_set{random_segs};
+          intersection_set.Process();
+          auto pairs = IntersectingPairs(intersection_set);
+          auto expected_pairs = BruteForceIntersectingPairs(random_segs);
+          SPG_INFO("Seed {}: intersecting pairs: {}, brute force: {}, match: {}", seed, pairs.size(), expected_pairs.size(), pairs == expected_pairs);
+          SPG_ASSERT(pairs == expected_pairs);
+        }
+      }
+
+      {
+        SPG_WARN("PARALLEL (STRIPS) VS SERIAL ");
+        for(uint32_t seed = 1; seed <= 3; seed++) {
+          auto random_segs = RandomSegs(50000, 2000.0f, 40.0f, seed);
+          IntersectionSet serial_set{random_segs};
+          serial_set.Process();
+          for(uint32_t num_strips : {2u, 7u, 0u}) {
+            IntersectionSet parallel_set{random_segs};
+            parallel_set.ProcessParallel(Core::ThreadPool::Default(), num_strips);
+            bool match = SameIntersections(parallel_set, serial_set);
+            SPG_INFO("Seed {}, strips {}: intersections: {}, serial: {}, match: {}", seed, num_strips,
+              parallel_set.GetIntersections().size(), serial_set.GetIntersections().size(), match);
+            SPG_ASSERT(match);
+          }
+        }
+      }
+    }
+
+    static void Benchmark()
+    {
+      {
+        SPG_WARN("COMPARATOR LOGGING OVERHEAD ");
+        //Same input and same (deterministic) comparison sequence for both, so the comparison count from the
+        //logging run applies to the non-logging one too
+        auto segs = RandomSegs(50000, 5000.0f, 20.0f, 8);
+        Core::Timer timer;
+        IntersectionSet<ComparatorLogger> logged_set{segs};
+        logged_set.Process();
+        double logged_ms = timer.ElapsedMillis();
+        timer.Reset();
+        IntersectionSet<NullComparatorLogger> unlogged_set{segs};
+        unlogged_set.Process();
+        double unlogged_ms = timer.ElapsedMillis();
+        auto& log = logged_set.GetComparatorLogger();
+        double num_comparisons = (double)log.NumComparisons();
+        SPG_INFO("{} segs, {} intersections, {} comparisons, {} log records ({:.1f} MB)", segs.size(),
+          unlogged_set.GetIntersections().size(), num_comparisons, log.m_data.size(),
+          (double)(log.m_data.capacity() * sizeof(ComparatorLogger::Record)) / (1024.0 * 1024.0));
+        SPG_INFO("Logger enabled: {:.1f} ms, {:.1f}M comparisons/s", logged_ms, num_comparisons / (logged_ms * 1000.0));
+        SPG_INFO("Logger disabled: {:.1f} ms, {:.1f}M comparisons/s", unlogged_ms, num_comparisons / (unlogged_ms * 1000.0));
+      }
+
+      {
+        SPG_WARN("1M SEGMENTS ");
+        auto big_segs = RandomSegs(1000000, 10000.0f, 5.0f, 7);
+        Core::Timer timer;
+        IntersectionSet<> intersection_set{big_segs};
+        double init_ms = timer.ElapsedMillis();
+        timer.Reset();
+        intersection_set.Process();
+        double process_ms = timer.ElapsedMillis();
+        SPG_INFO("Initialise: {:.1f} ms, Process: {:.1f} ms, intersections: {}", init_ms, process_ms, intersection_set.GetIntersections().size());
+
+        IntersectionSet<> parallel_set{big_segs};
+        timer.Reset();
+        parallel_set.ProcessParallel();
+        double parallel_ms = timer.ElapsedMillis();
+        bool match = SameIntersections(parallel_set, intersection_set);
+        SPG_INFO("ProcessParallel ({} threads): {:.1f} ms ({:.1f}x), intersections: {}, match: {}", Core::ThreadPool::Default().NumThreads(),
+          parallel_ms, process_ms / parallel_ms, parallel_set.GetIntersections().size(), match);
+        SPG_ASSERT(match);
+      }
     }
+
 /*****************************************************************************************************
     HERE'S THE START OF THE CODE THAT ACTUALLY DOES STUFF!!
  ***************************************************************************************************/
 
-    void Queue::Insert(const SegList& seg_list)
+    void Queue::Initialise(std::span<const Segment> segs, double tolerance)
     {
-      for(const auto& seg : seg_list) {
-        SPG_ASSERT(!SpgMth::Equal(seg.start,seg.end));
-        auto upper = seg.start;
-        auto lower = seg.end;
-        if(!SpgMth::Equal(seg.start.y, seg.end.y)) {
-          if((upper.y < lower.y)) {
-            upper = seg.end;
-            lower = seg.start;    
-          }
-        }
-        else if(upper.x > lower.x) { //horizontal line.  Left point is considered the upper endpoint
-          upper = seg.end;
-          lower = seg.start;
-        }
-        SpgMth::LineSeg2D new_seg{upper,lower}; //Ensure start point is segments upper point
-
-        // Insert an event for the upper endpoint.
-        {
-          auto [itr,success] = m_data.emplace(upper, new_seg); 
-          if(!success)
-          { //upper point already in queue - add this seg to the existing event point
-            auto event = *itr;
-            m_data.erase(itr); //erase, update, re-insert since std::set elements are immutable
-            event.Insert(new_seg);
-            m_data.insert(event);  
-          }
-        }
-        // Insert an event for the lower endpoint.
-        {
-          auto [itr,success] = m_data.emplace(lower); 
-          auto event = *itr;
-          if(success) { // lower endpoint should normally be unique.
-            if(itr != m_data.begin()) {
-              auto prev_itr = std::prev(itr);
-              // Check if the y difference between consecutive events is less than s_sweep_delta.
-              if((*prev_itr).point.y - event.point.y < StatusStructure::s_sweep_delta) {
-                // If the difference is too small, align the event’s y to keep ordering consistent.
-                event.point.y = (*prev_itr).point.y;
-                m_data.erase(itr);
-                m_data.insert(event);  
-              }
-            }
-          }
-        }
-        
+      m_segs = segs;
+      m_tolerance = tolerance;
+      m_upper_order.clear();
+      m_lower_order.clear();
+      m_intersections.clear();
+      m_next_upper = m_next_lower = 0;
+      for(SegIndex i = 0; i < segs.size(); i++) {
+        //Degenerate (zero length to within the tolerance) segs would be inserted and removed at the same event - 
+        //they're valid input, just left out
+        if(!Near(segs[i].upper, segs[i].lower))
+          m_upper_order.push_back(i);
       }
+      m_lower_order = m_upper_order;
+      EventComparator comp;
+      //Ties broken on index so U(p) always comes out in the same order (IntersectionSet::ProcessParallel() relies
+      //on this to match Process())
+      std::sort(m_upper_order.begin(), m_upper_order.end(), [&](SegIndex s1, SegIndex s2) {
+        return comp(segs[s1].upper, segs[s2].upper) || (!comp(segs[s2].upper, segs[s1].upper) && (s1 < s2)); });
+      std::sort(m_lower_order.begin(), m_lower_order.end(), [&](SegIndex s1, SegIndex s2) {
+        return comp(segs[s1].lower, segs[s2].lower) || (!comp(segs[s2].lower, segs[s1].lower) && (s1 < s2)); });
     }
 
-    void Queue::Insert(Event e)
+    static bool EventAfter(const SpgMth::DPoint2d& p1, const SpgMth::DPoint2d& p2)
     {
-      m_data.insert(e); 
+      return EventComparator()(p2, p1);
     }
 
-    Event Queue::Next() 
+    void Queue::Insert(const SpgMth::DPoint2d& point)
     {
-      auto itr = m_data.cbegin();
-      Event e = *itr;
-      m_data.erase(itr);
-      return e;
+      //The same intersection can be found more than once - duplicates get merged when they come off the heap
+      m_intersections.push_back(point);
+      std::push_heap(m_intersections.begin(), m_intersections.end(), EventAfter);
     }
 
-    float SweepLineComparator::ComputeSweepLineXIntercept(const SpgMth::LineSeg2D& seg) const noexcept
+    Event Queue::Next()
     {
-      float y_sweep = event_point.y;
-      if(SpgMth::Equal(seg.start.y, y_sweep))
-        return seg.start.x;
-      if(SpgMth::Equal(seg.end.y, y_sweep))
-        return seg.end.x;
-      if(SpgMth::IsVertical(seg))
-        return seg.start.x;  
-      if(IsHorizontal(seg)) { 
-        if(SegIncludesPoint(seg,event_point))
-          return event_point.x;
-        else  
-          return seg.start.x;  
+      SPG_ASSERT(!IsEmpty());
+      EventComparator comp;
+      SpgMth::DPoint2d p{DBL_MAX, -DBL_MAX}; //after everything
+      if(m_next_upper < m_upper_order.size())
+        p = m_segs[m_upper_order[m_next_upper]].upper;
+      if((m_next_lower < m_lower_order.size()) && comp(m_segs[m_lower_order[m_next_lower]].lower, p))
+        p = m_segs[m_lower_order[m_next_lower]].lower;
+      if(!m_intersections.empty() && comp(m_intersections.front(), p))
+        p = m_intersections.front();
+
+      Event e{p, m_next_upper, m_next_upper};
+      while((m_next_upper < m_upper_order.size()) && Near(m_segs[m_upper_order[m_next_upper]].upper, p))
+        m_next_upper++;
+      e.upper_end = m_next_upper;
+      //Lower endpoints don't need recording - those segs are found in the status structure
+      while((m_next_lower < m_lower_order.size()) && Near(m_segs[m_lower_order[m_next_lower]].lower, p))
+        m_next_lower++;
+      while(!m_intersections.empty() && Near(m_intersections.front(), p)) {
+        std::pop_heap(m_intersections.begin(), m_intersections.end(), EventAfter);
+        m_intersections.pop_back();
       }
-      
-      y_sweep = event_point.y - 0.01f;  
-      
-      float x = (seg.start.x - seg.end.x) / (seg.start.y - seg.end.y) *(y_sweep - seg.end.y) + seg.end.x;
+      return e;
+    }
 
-      auto seg_min_x = std::min(seg.start.x,seg.end.x);
-      auto seg_max_x = std::max(seg.start.x,seg.end.x);  
-      SPG_ASSERT((x >= seg_min_x) && (x <= seg_max_x));
+    template<typename TLogger>
+    double SweepLineComparator<TLogger>::ComputeSweepLineXIntercept(SegIndex seg_idx) const noexcept
+    {
+      const Segment& seg = sweep_line.segs[seg_idx];
+      const SpgMth::DPoint2d& p = sweep_line.event_point;
+      if(seg.IsHorizontal())
+        return std::clamp(p.x, seg.upper.x, seg.lower.x);
+      if(p.y >= seg.upper.y)
+        return seg.upper.x;
+      if(p.y <= seg.lower.y)
+        return seg.lower.x;
+      double t = (seg.upper.y - p.y) / (seg.upper.y - seg.lower.y);
+      return seg.upper.x + t * (seg.lower.x - seg.upper.x);
+    }
 
+    template<typename TLogger>
+    double SweepLineComparator<TLogger>::SweepLineKey(SegIndex seg) const noexcept
+    {
+      //Segs passing through the tolerance box around the event point (the box event points get merged within) all
+      //get the event x as their key, so they're found in L(p)/C(p). In x the box is wider for a shallow seg
+      const SpgMth::DPoint2d& p = sweep_line.event_point;
+      const double tol = sweep_line.tolerance;
+      double x = ComputeSweepLineXIntercept(seg);
+      double dist = std::abs(x - p.x);
+      if(dist <= tol)
+        return p.x;
+      const Segment& s = sweep_line.segs[seg];
+      if(s.IsHorizontal())
+        return x;
+      double dx_dy = (s.lower.x - s.upper.x) / (s.upper.y - s.lower.y);
+      if(dist > tol * (1.0 + std::abs(dx_dy)))
+        return x;
+      //Close enough to need the exact test: clip the seg to the box's y range, and check its x range against the box
+      double y_top = std::min(s.upper.y, p.y + tol);
+      double y_bottom = std::max(s.lower.y, p.y - tol);
+      if(y_top < y_bottom)
+        return x;
+      double x_top = s.upper.x + (s.upper.y - y_top) * dx_dy;
+      double x_bottom = s.upper.x + (s.upper.y - y_bottom) * dx_dy;
+      if((std::max(x_top, x_bottom) >= p.x - tol) && (std::min(x_top, x_bottom) <= p.x + tol))
+        return p.x;
       return x;
     }
 
-    bool SweepLineComparator::operator ()(const SpgMth::LineSeg2D& seg1,  const SpgMth::LineSeg2D& seg2) const noexcept
+    template<typename TLogger>
+    bool SweepLineComparator<TLogger>::operator ()(SegIndex seg1, SegIndex seg2) const noexcept
     {
-      if(SpgMth::Equal(seg1.start, seg2.start) && SpgMth::Equal(seg1.end, seg2.end)) {
-        LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point,false,1); //segs equivalent
+      if(seg1 == seg2) {
+        LOG_COMP_RES_THEN_RETURN(seg1,seg2,sweep_line.event_point,false,1);
       }
-        
-      bool s1_includes_p = SpgMth::SegIncludesPoint(seg1,event_point);
-      bool s2_includes_p = SpgMth::SegIncludesPoint(seg2,event_point);
-      bool s1_horiz = SpgMth::IsHorizontal(seg1);
-      bool s2_horiz = SpgMth::IsHorizontal(seg2);
-#if 0
-      if(s1_includes_p && s2_includes_p) {
-        if(s2_horiz && !s1_horiz) {
-          LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point, true, 2); //seg1 (non horizontal) comes before seg2 (horizontal)
-        }
-        if(s1_horiz && !s2_horiz) {
-          LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point, false,3); 
-        }
-        if(s1_horiz && s2_horiz) {
-          bool res = std::tie(seg1.start.x, seg1.end.x) < std::tie(seg2.start.x, seg2.end.x);
-          LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point,res,4);
+
+      double x1 = SweepLineKey(seg1);
+      double x2 = SweepLineKey(seg2);
+      if(x1 != x2) {
+        LOG_COMP_RES_THEN_RETURN(seg1,seg2,sweep_line.event_point,x1<x2,5); //seg1 before seg2 if true
+      }
+
+      //Both through the event point. Order just below it - by dx/-dy, with horizontal segs last
+      const Segment& s1 = sweep_line.segs[seg1];
+      const Segment& s2 = sweep_line.segs[seg2];
+      bool s1_horiz = s1.IsHorizontal();
+      bool s2_horiz = s2.IsHorizontal();
+      if(s1_horiz != s2_horiz) {
+        LOG_COMP_RES_THEN_RETURN(seg1,seg2,sweep_line.event_point,s2_horiz,2);
+      }
+      if(!s1_horiz) {
+        SpgMth::DVec2 d1 = s1.lower - s1.upper;
+        SpgMth::DVec2 d2 = s2.lower - s2.upper;
+        double lhs = d1.x * -d2.y;
+        double rhs = d2.x * -d1.y;
+        if(lhs != rhs) {
+          LOG_COMP_RES_THEN_RETURN(seg1,seg2,sweep_line.event_point,lhs<rhs,3);
         }
       }
-#endif        
+      //Overlapping
+      LOG_COMP_RES_THEN_RETURN(seg1,seg2,sweep_line.event_point,seg1<seg2,6);
+    }
+
+    template<typename TLogger>
+    void StatusStructure<TLogger>::Initialise(std::span<const Segment> segs, double tolerance)
+    {
+      m_segs = segs;
+      m_sweep_line.segs = segs.data();
+      m_sweep_line.tolerance = tolerance;
+      m_sweep_line.event_point = SpgMth::DPoint2d{DBL_MAX,DBL_MAX};
+      m_T.Clear();
+      m_comparator_log = TLogger{};
+    }
 
-      //One or both of seg1, seg2 both don't coincide with the event point.  Or, both do coincide with event point but both are non-horizontal.
+    template<typename TLogger>
+    typename StatusStructure<TLogger>::Status::Iterator StatusStructure<TLogger>::FirstAtEventPoint() const
+    {
+      SweepLineComparator<TLogger> comp(m_sweep_line);
+      double x = m_sweep_line.event_point.x;
+      return m_T.PartitionPoint([&](SegIndex seg) { return comp.SweepLineKey(seg) < x; });
+    }
 
-      float x1 = ComputeSweepLineXIntercept(seg1);
-      float x2 = ComputeSweepLineXIntercept(seg2);
-      
-      //Todo - if sweep line is lowered slightly, then x-intercepts should not usually not be equal.  Just need to account for (near) vertical, horiz segs
-      // if(!Equal(x1,x2)) 
-      //   return x1 < x2; //if true, seg1 will come before seg 2
+    template<typename TLogger>
+    typename StatusStructure<TLogger>::Status::Iterator StatusStructure<TLogger>::FirstAfterEventPoint() const
+    {
+      SweepLineComparator<TLogger> comp(m_sweep_line);
+      double x = m_sweep_line.event_point.x;
+      return m_T.PartitionPoint([&](SegIndex seg) { return comp.SweepLineKey(seg) <= x; });
+    }
 
-      if (std::fabs(x1 - x2) > SpgMth::Epsilon()) {
-        LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point,x1<x2,5); //seg1 before seg2 if true
+    template<typename TLogger>
+    void StatusStructure<TLogger>::FindSegsContainingPoint(const Event& e)
+    {
+      //SweepLineComparator holds a ref to the sweep line, updated according to event e
+      m_sweep_line.event_point = e.point;
+      m_L.clear();
+      m_C.clear();
+
+      //The segs containing p are consecutive in T - the ones with sweep line key p.x
+      SweepLineComparator<TLogger> comp(m_sweep_line);
+      for(auto itr = FirstAtEventPoint(); (itr != m_T.end()) && (comp.SweepLineKey(*itr) == e.point.x); ++itr) {
+        if(Near(m_segs[*itr].lower, e.point, m_sweep_line.tolerance))
+          m_L.push_back(*itr);
+        else
+          m_C.push_back(*itr);
       }
-        
-      bool res = std::tie(seg1.start.x, seg1.start.y, seg1.end.x, seg1.end.y) <
-          std::tie(seg2.start.x, seg2.start.y, seg2.end.x, seg2.end.y);
-
-      LOG_COMP_RES_THEN_RETURN(seg1,seg2,event_point,res,6);
     }
 
-    //Todo - consider a trailing return type as per Copilot info
-    //The Segs containing point p in T (status struct) should be consecutive
-    auto StatusStructure::FindSegsInTContainingPoint(const SpgMth::Point2d& p)
+    template<typename TLogger>
+    void StatusStructure<TLogger>::UpdateActiveSegs(std::span<const SegIndex> upper_segs)
     {
-      auto ret_val = std::make_pair(m_T.begin(),m_T.end());
-      while( (ret_val.first != m_T.end()) && !SpgMth::SegIncludesPoint(*(ret_val.first),p) ) {
-        ret_val.first++;
+      //L(p),C(p) are a consecutive run in T - delete from the front of it. Their order above the sweep line doesn't
+      //match the order just below, so they aren't looked up with the comparator
+      auto num_to_delete = m_L.size() + m_C.size();
+      for(std::size_t i = 0; i < num_to_delete; i++) {
+        auto itr = FirstAtEventPoint();
+        SPG_ASSERT(itr != m_T.end());
+        if constexpr(TLogger::s_enabled) {
+          m_comparator_log.Log(ComparatorLogger::PreDeletionRecord{*itr});
+          m_comparator_log.Log(ComparatorLogger::PostDeletionRecord{*itr, true, -1});
+        }
+        m_T.Erase(itr);
       }
 
-      if(ret_val.first == m_T.end()) 
-        return ret_val;
-      
-      ret_val.second = ret_val.first;
-      while( (std::next(ret_val.second) != m_T.end()) ) {
-        auto seg = *(std::next(ret_val.second));
-        if(SpgMth::SegIncludesPoint(seg,p))
-          ret_val.second++;
-        else
-          break; 
-      }
-      return ret_val;
-    }
-
-    const float StatusStructure::s_sweep_delta = 0.01f;
-
-    void StatusStructure::UpdateActiveSegs(const Event& e)
-    {
-      m_T.clear();
-      for(auto& seg : m_active_segs) {
-         m_T.insert(seg);
-      }
-      SPG_ASSERT(m_T.size() == m_active_segs.size());
-      return;
-
-      for(auto seg : m_union_LC) {
-        int size1 = m_T.size();
-        ComparatorLogger::PreDeletionRecord deletion{seg};
-        m_comparator_log.Log(deletion);
-        PrintDeletion(seg);
-        m_T.erase(seg);
-        int size2 = m_T.size();
-        PrintDeletionResult(seg, size2-size1);
-        ComparatorLogger::PostDeletionRecord post_deletion{seg, (size2 - size1 == -1),  (size2 - size1)};
-        m_comparator_log.Log(post_deletion);
-      }
-      //e.point.y -= s_sweep_delta;
-      for(auto seg : m_union_UC) {
-          int size1 = m_T.size();
-          ComparatorLogger::PreInsertionRecord insertion{seg};
-          m_comparator_log.Log(insertion);
-          PrintInsertion(seg);
-          m_T.insert(seg);
-          int size2 = m_T.size();
-          PrintInsertionResult(seg, size2-size1);
-          ComparatorLogger::PostInsertionRecord post_insertion{seg, (size2 - size1 == 1),  (size2 - size1)};
-          m_comparator_log.Log(post_insertion);
-      }
-      //e.point.y += s_sweep_delta;
-    }
-
-    void StatusStructure::FindNewActiveSegCandidates(const Event& e)
-    {
-      //SweepLineComparator holds refs to the next to variable updated according to event e
-      this->m_cur_event_point = e.point; 
-
-      m_union_LUC.clear();
-      m_union_LC.clear();
-      m_union_UC.clear();
-
-      SegList u, l, c; //upper, lower, central (i.e. interior) segs
-      u = e.seg_list;
-      for(auto& seg : m_T) {
-        if(SpgMth::Equal(e.point, seg.end)) 
-           l.insert(l.end(), seg);  
-        else if(SegContainsPoint(seg, e.point)) 
-          c.insert(c.end(), seg);
-      }
-
-      //Using SweepLineComparator as sorting predicate with sweep line adjusted down.  Should give same order as in the status structure m_T after m_union_LC deleted and m_union_UC added!
-      SpgMth::Point2d event_point = e.point;
-      SweepLineComparator comp = SweepLineComparator(event_point);
-      std::sort(l.begin(), l.end(),comp);
-      std::sort(u.begin(), u.end(),comp);
-      std::sort(c.begin(), c.end(),comp);
-
-      std::set_union(l.cbegin(), l.cend(), c.cbegin(), c.cend(), std::back_inserter(m_union_LC),comp);
-      std::set_union(u.cbegin(), u.cend(), c.cbegin(), c.cend(), std::back_inserter(m_union_UC),comp);
-      std::sort(m_union_LC.begin(), m_union_LC.end(),comp);
-      std::set_union(u.cbegin(), u.cend(), m_union_LC.cbegin(), m_union_LC.cend(), std::back_inserter(m_union_LUC),comp);
-
-      //m_active_segs.insert(m_active_segs.end(), u.begin(), u.end());
-      //m_active_segs.insert(m_active_segs.end(), c.begin(), c.end());
-      for(auto& seg : m_union_LC) {
-        auto itr = std::find_if(m_active_segs.begin(), m_active_segs.end(), SegEqualityChecker(seg));
-        if(itr != m_active_segs.end())
-          m_active_segs.erase(itr);
-      }
-      m_active_segs.insert(m_active_segs.end(), m_union_UC.begin(), m_union_UC.end());
-
-      
-#ifdef SPG_DEBUG
-      //Pretty sure theres no way that l,c,u can every overlap - check..
-      SPG_ASSERT(m_union_LUC.size() == l.size() + u.size() + c.size());
-      SegList LC_i, UC_i, LUC_i;
-      std::set_intersection(l.cbegin(), l.cend(), c.cbegin(), c.cend(), std::back_inserter(LC_i),comp);
-      std::set_intersection(u.cbegin(), u.cend(), c.cbegin(), c.cend(), std::back_inserter(UC_i),comp);
-       std::sort(LC_i.begin(), LC_i.end(),comp);
-      std::set_intersection(u.cbegin(), u.cend(), LC_i.cbegin(), LC_i.cend(), std::back_inserter(LUC_i),comp);
-      SPG_ASSERT(LUC_i.size() == 0);
-#endif
+      auto insert = [&](SegIndex seg) {
+        if constexpr(TLogger::s_enabled)
+          m_comparator_log.Log(ComparatorLogger::PreInsertionRecord{seg});
+        auto itr = m_T.Insert(seg);
+        [[maybe_unused]] bool success = (itr != m_T.end());
+        SPG_ASSERT(success);
+        if constexpr(TLogger::s_enabled)
+          m_comparator_log.Log(ComparatorLogger::PostInsertionRecord{seg, success, success ? 1 : 0});
+      };
+      for(auto seg : upper_segs)
+        insert(seg);
+      for(auto seg : m_C)
+        insert(seg);
     }
 
-    auto StatusStructure::LeftAndRightNeighbour(const Event& e)
+    template<typename TLogger>
+    std::pair<SegIndex,SegIndex> StatusStructure<TLogger>::LeftAndRightNeighbour() const
     {
       //step 9 in Comp Geom pg 26
-      SpgMth::LineSeg2D dummy_seg{{e.point.x,  e.point.y},{e.point.x,  e.point.y + 0.1f}};
-      //Returns iterator to first element in m_T that is  greater or equal to dummy_seg
-      //use m_T.lower_bound(dummy_seg); if need to find the first that is strictly greater than dummy_seg
-      auto itr = m_T.lower_bound(dummy_seg); 
-      if( (itr != m_T.end()) && (itr != m_T.begin()) )
-        return std::make_pair(std::prev(itr), itr); //left and right neighbours pf p
-      return std::make_pair(m_T.end(), m_T.end());
+      auto itr = FirstAtEventPoint();
+      if( (itr != m_T.end()) && (itr != m_T.begin()) ) {
+        auto right = *itr;
+        return std::make_pair(*(--itr), right); //left and right neighbours pf p
+      }
+      return std::make_pair(s_none, s_none);
     }
 
-    auto StatusStructure::LeftMost_UC_In_T(const Event& e)
+    template<typename TLogger>
+    std::pair<SegIndex,SegIndex> StatusStructure<TLogger>::LeftMost_UC_In_T() const
     {
-      SpgMth::Point2d event_point = e.point;
-      SweepLineComparator comp = SweepLineComparator(event_point);
-      //get iterator to the left most element in m_union_UC
-      auto uc_itr = std::min_element(m_union_UC.cbegin(), m_union_UC.cend(),comp);
-      auto left_most_element = *uc_itr;
-      auto itr = m_T.find(left_most_element);
-      if(itr != m_T.end() && itr != m_T.begin()) 
-        return std::make_pair(std::prev(itr),itr);
-      
-      return std::make_pair(m_T.end(), m_T.end());
+      auto itr = FirstAtEventPoint();
+      SPG_ASSERT(itr != m_T.end());
+      if(itr != m_T.begin()) {
+        auto left_most = *itr;
+        return std::make_pair(*(--itr), left_most);
+      }
+      return std::make_pair(s_none, s_none);
     }
 
-    auto StatusStructure::RightMost_UC_In_T(const Event& e)
+    template<typename TLogger>
+    std::pair<SegIndex,SegIndex> StatusStructure<TLogger>::RightMost_UC_In_T() const
     {
-      SpgMth::Point2d event_point = e.point;
-      SweepLineComparator comp = SweepLineComparator(event_point);
-      //get iterator to the left most element in m_union_UC 
-      auto uc_itr = std::max_element(m_union_UC.cbegin(), m_union_UC.cend(),comp);
-      auto element = *uc_itr;
-      auto itr = m_T.find(element);
-      if(itr != m_T.end() && std::next(itr) != m_T.end()) 
-        return std::make_pair(itr, std::next(itr));
-        
-      return std::make_pair(m_T.end(), m_T.end());
+      auto itr = FirstAfterEventPoint();
+      SPG_ASSERT(itr != m_T.begin());
+      if(itr != m_T.end()) {
+        auto right = *itr;
+        return std::make_pair(*(--itr), right);
+      }
+      return std::make_pair(s_none, s_none);
     }
- 
-    IntersectionSet::IntersectionSet(const SegList& seg_list)
+
+    template<typename TLogger>
+    IntersectionSet<TLogger>::IntersectionSet(std::span<const SpgMth::LineSeg2D> seg_list)
     {
-      m_queue.Insert(seg_list);
+      m_segs.reserve(seg_list.size());
+      SpgMth::DPoint2d min{DBL_MAX,DBL_MAX}, max{-DBL_MAX,-DBL_MAX};
+      for(const auto& seg : seg_list) {
+        SpgMth::DPoint2d upper{seg.start};
+        SpgMth::DPoint2d lower{seg.end};
+        if(EventComparator()(lower, upper)) //Horizontal seg: Left point is considered the upper endpoint
+          std::swap(upper, lower);
+        m_segs.push_back({upper, lower});
+        min = glm::min(min, glm::min(upper, lower));
+        max = glm::max(max, glm::max(upper, lower));
+      }
+      double extent = seg_list.empty() ? 1.0 : std::max({1.0, max.x - min.x, max.y - min.y});
+      Initialise(s_relative_tolerance * extent);
     }
 
-    void IntersectionSet::Process()
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::Initialise(double tolerance)
     {
+      //Tolerance passed in rather than worked out from m_segs, so a strip in ProcessParallel() merges events
+      //exactly as the full set would
+      m_tolerance = tolerance;
+      m_queue.Initialise(m_segs, m_tolerance);
+      m_status.Initialise(m_segs, m_tolerance);
+    }
+
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::Process()
+    {
+      m_intersections.clear();
+      m_intersection_segs.clear();
+      m_event_points.clear();
       while(!m_queue.IsEmpty()) {
         Event e = m_queue.Next();
-        e.Print();
         HandleEvent(e);
+#ifdef ENABLE_PRINTING
+        SPG_WARN("Event: ({},{}) ----------------",  e.point.x, e.point.y);
+        m_status.PrintSegsContainingPoint();
         m_status.PrintStatusStructure();
-        m_status.PrintActiveSegList();
-        m_status.PrintUnionUC(e.point);
-        auto [first_itr, second_itr] = m_status.FindSegsInTContainingPoint(e.point);
-        if((first_itr != m_status.end()) && (second_itr != m_status.end()))
-           m_status.PrintStatusStructureSubset(first_itr,second_itr,e.point);
-        PrintIntersections();
+        m_queue.Print();
+#endif
       }
       m_status.PrintComparatorLog();
     }
 
-    void IntersectionSet::FindNewEvent(const SpgMth::LineSeg2D& seg1, const SpgMth::LineSeg2D& seg2, SpgMth::Point2d p)
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::ProcessParallel(Core::ThreadPool& pool, uint32_t num_strips)
     {
-      if(!StrictIntersectionExists(seg1, seg2)) 
+      //Below this a strip is mostly segs copied in from its neighbours, and the serial sweep is just as quick
+      const uint32_t MIN_SEGS_PER_STRIP = 2000;
+      if(num_strips == 0)
+        num_strips = 4 * pool.NumThreads();
+      num_strips = std::min(num_strips, (uint32_t)(m_segs.size() / MIN_SEGS_PER_STRIP));
+      if(num_strips <= 1) {
+        Process();
         return;
-  
-      SpgMth::Point2d intersection_point;
-      bool success = ComputeIntersection(seg1, seg2, intersection_point);
-      if(success) { //StrictIntersectionExists should guarantee this, but check anyway.
-        //x coord check is to avoid adding events that are to the left of an already processed point
-        if(intersection_point.y < m_status.SweepLineY() || (intersection_point.x > p.x)) {
-          Event e{intersection_point};
-          m_queue.Insert(e); 
+      }
+      m_intersections.clear();
+      m_intersection_segs.clear();
+
+      //Strip boundaries at the quantiles of the seg mid points, so each strip gets about the same number of segs
+      std::vector<double> boundaries(num_strips + 1);
+      {
+        std::vector<double> mid_x(m_segs.size());
+        for(std::size_t i = 0; i < m_segs.size(); i++)
+          mid_x[i] = 0.5 * (m_segs[i].upper.x + m_segs[i].lower.x);
+        boundaries.front() = -DBL_MAX;
+        boundaries.back() = DBL_MAX;
+        auto first = mid_x.begin();
+        for(uint32_t k = 1; k < num_strips; k++) {
+          auto nth = mid_x.begin() + (k * mid_x.size()) / num_strips;
+          std::nth_element(first, nth, mid_x.end());
+          boundaries[k] = *nth;
+          first = nth;
         }
       }
+
+      //An event point can be up to the tolerance away from where the segs actually cross, so segs go in every strip
+      //they come within a couple of tolerances of. Whichever strip ends up owning the point then has all its segs
+      std::vector<std::vector<SegIndex>> strip_segs(num_strips);
+      for(SegIndex i = 0; i < m_segs.size(); i++) {
+        double x_min = std::min(m_segs[i].upper.x, m_segs[i].lower.x) - 2.0 * m_tolerance;
+        double x_max = std::max(m_segs[i].upper.x, m_segs[i].lower.x) + 2.0 * m_tolerance;
+        //Strip k is [boundaries[k], boundaries[k+1]]
+        uint32_t k_first = (uint32_t)(std::lower_bound(boundaries.begin() + 1, boundaries.end(), x_min) - (boundaries.begin() + 1));
+        uint32_t k_last = (uint32_t)(std::upper_bound(boundaries.begin(), boundaries.end() - 1, x_max) - boundaries.begin()) - 1;
+        for(uint32_t k = k_first; k <= k_last; k++)
+          strip_segs[k].push_back(i);
+      }
+
+      struct StripResult
+      {
+        std::vector<Intersection> intersections;
+        std::vector<SpgMth::DPoint2d> event_points;
+        std::vector<SegIndex> segs; //global seg indices
+      };
+      std::vector<StripResult> results(num_strips);
+      pool.ParallelFor(num_strips, 1, [&](uint32_t begin, uint32_t end) {
+        for(uint32_t k = begin; k < end; k++) {
+          const auto& local_to_global = strip_segs[k];
+          IntersectionSet strip_set;
+          strip_set.m_segs.reserve(local_to_global.size());
+          for(SegIndex i : local_to_global)
+            strip_set.m_segs.push_back(m_segs[i]);
+          strip_set.Initialise(m_tolerance);
+          strip_set.m_record_event_points = true;
+          strip_set.Process();
+
+          auto& result = results[k];
+          for(std::size_t i = 0; i < strip_set.m_intersections.size(); i++) {
+            const Intersection& intersection = strip_set.m_intersections[i];
+            const SpgMth::DPoint2d& event_point = strip_set.m_event_points[i];
+            if((event_point.x < boundaries[k]) || (event_point.x >= boundaries[k+1]))
+              continue; //owned by a neighbouring strip
+            result.intersections.push_back({intersection.point, (uint32_t)result.segs.size(), intersection.count});
+            result.event_points.push_back(event_point);
+            for(SegIndex local : strip_set.GetSegs(intersection))
+              result.segs.push_back(local_to_global[local]);
+          }
+        }
+      });
+
+      //Put the intersections back in the event order Process() gives them in
+      std::vector<std::pair<uint32_t,uint32_t>> order; //(strip, intersection)
+      for(uint32_t k = 0; k < num_strips; k++)
+        for(uint32_t i = 0; i < results[k].intersections.size(); i++)
+          order.push_back({k, i});
+      EventComparator comp;
+      std::sort(order.begin(), order.end(), [&](const auto& a, const auto& b) {
+        return comp(results[a.first].event_points[a.second], results[b.first].event_points[b.second]);
+      });
+      m_intersections.reserve(order.size());
+      for(auto [k, i] : order) {
+        const Intersection& intersection = results[k].intersections[i];
+        m_intersections.push_back({intersection.point, (uint32_t)m_intersection_segs.size(), intersection.count});
+        auto first = results[k].segs.begin() + intersection.first;
+        m_intersection_segs.insert(m_intersection_segs.end(), first, first + intersection.count);
+      }
     }
 
-    void IntersectionSet::HandleEvent(const Event& e)
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::FindNewEvent(SegIndex seg1, SegIndex seg2)
     {
-      m_status.FindNewActiveSegCandidates(e);
+      const Segment& s1 = m_segs[seg1];
+      const Segment& s2 = m_segs[seg2];
+      //Whether they meet at all is decided exactly. The rounded t below can land just outside [0,1] for a T junction
+      //or a crossing right by an endpoint, which would otherwise lose the intersection
+      if(!SpgMth::IntersectionExistsExact(s1.upper, s1.lower, s2.upper, s2.lower))
+        return;
+      SpgMth::DVec2 d1 = s1.lower - s1.upper;
+      SpgMth::DVec2 d2 = s2.lower - s2.upper;
+      double denominator = Cross(d1, d2);
+      if(denominator == 0)
+        return; //parallel. Collinear overlaps are found at the endpoint events
+      SpgMth::DVec2 w = s2.upper - s1.upper;
+      double t = std::clamp(Cross(w, d2) / denominator, 0.0, 1.0);
+      SpgMth::DPoint2d q = s1.upper + t * d1;
+
+      //Only intersections below the sweep line, or on it and to the right of the event point, are new. One computed
+      //just above the sweep line (e.g. along a horizontal seg) is put back on it. Not the other way though - moving
+      //one from just below up onto the sweep line puts it off a shallow seg by more than the tolerance, so the seg
+      //isn't found in C(p) at the event and the crossing is missed
+      const SpgMth::DPoint2d& p = m_status.EventPoint();
+      if((q.y > p.y) && (q.y - p.y <= m_tolerance))
+        q.y = p.y;
+      if(EventComparator()(p, q) && !Near(p, q, m_tolerance))
+        m_queue.Insert(q);
+    }
 
-      if(m_status.Get_LUC().size() >= 2)
-         m_intersections.emplace_back(e.point, m_status.Get_LUC());
+    template<typename TLogger>
+    void IntersectionSet<TLogger>::HandleEvent(const Event& e)
+    {
+      m_status.FindSegsContainingPoint(e);
+      auto upper_segs = m_queue.UpperSegs(e);
+      auto& lower_segs = m_status.Get_L();
+      auto& interior_segs = m_status.Get_C();
+
+      uint32_t count = (uint32_t)(upper_segs.size() + lower_segs.size() + interior_segs.size());
+      if(count >= 2) {
+        Intersection intersection{SpgMth::Point2d(e.point), (uint32_t)m_intersection_segs.size(), count};
+        m_intersection_segs.insert(m_intersection_segs.end(), upper_segs.begin(), upper_segs.end());
+        m_intersection_segs.insert(m_intersection_segs.end(), lower_segs.begin(), lower_segs.end());
+        m_intersection_segs.insert(m_intersection_segs.end(), interior_segs.begin(), interior_segs.end());
+        m_intersections.push_back(intersection);
+        if(m_record_event_points)
+          m_event_points.push_back(e.point);
+      }
 
-      m_status.UpdateActiveSegs(e);
+      bool uc_empty = upper_segs.empty() && interior_segs.empty();
+      m_status.UpdateActiveSegs(upper_segs);
 
-      if(m_status.Get_UC().empty()) {
-        auto [left_itr, right_itr] = m_status.LeftAndRightNeighbour(e.point); 
-        if(left_itr !=  m_status.end() && right_itr !=  m_status.end())
-          FindNewEvent(*left_itr, *right_itr,e.point);    
+      if(uc_empty) {
+        auto [left, right] = m_status.LeftAndRightNeighbour();
+        if(left != StatusStructure<TLogger>::s_none)
+          FindNewEvent(left, right);
       }
       else {
         {
-          auto [left_itr, right_itr] = m_status.LeftMost_UC_In_T(e.point); 
-          if(left_itr !=  m_status.end() && right_itr !=  m_status.end())
-            FindNewEvent(*left_itr, *right_itr, e.point);   
+          auto [left, left_most] = m_status.LeftMost_UC_In_T();
+          if(left != StatusStructure<TLogger>::s_none)
+            FindNewEvent(left, left_most);
         }
         {
-          auto [left_itr, right_itr] = m_status.RightMost_UC_In_T(e.point); 
-          if(left_itr !=  m_status.end() && right_itr !=  m_status.end())
-            FindNewEvent(*left_itr, *right_itr, e.point);     
+          auto [right_most, right] = m_status.RightMost_UC_In_T();
+          if(right != StatusStructure<TLogger>::s_none)
+            FindNewEvent(right_most, right);
         }
       }
     }
 
+    template struct SweepLineComparator<NullComparatorLogger>;
+    template struct SweepLineComparator<ComparatorLogger>;
+    template class StatusStructure<NullComparatorLogger>;
+    template class StatusStructure<ComparatorLogger>;
+    template class IntersectionSet<NullComparatorLogger>;
+    template class IntersectionSet<ComparatorLogger>;
   }
-}
\ No newline at end of file
+}
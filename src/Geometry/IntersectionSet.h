@@ -1,13 +1,14 @@
 #pragma once
 
 #include <vector>
-#include <set>
-#include <map>
+#include <span>
 #include <variant>
 #include <iostream>
 
 #include "CoreLib/Core.h"
 #include "MathLib/Geom/Geom.h"
+#include "CoreLib/ThreadPool.h"
+#include "Geometry/FlatSortedSet.h"
 
  /*
   Comparators must have 'Strict week ordering'
@@ -37,91 +38,117 @@ namespace Geom
   {
     /*
       Bentley-Ottmann - Line intersection algorithm. Comp Geom book, sec 2.1
+
+      Works on segment indices into the input - nothing in the event queue or status structure holds a LineSeg2D.
+      Upper and lower endpoint events are two index arrays sorted once up front, and intersection events go in a
+      binary heap, so the queue never copies events or segment lists around. U(p) is a contiguous run of the
+      sorted upper endpoint array, and L(p), C(p) are collected into scratch buffers that keep their capacity
+      between events. Once the buffers have grown, the only per-event allocations are for the reported
+      intersections themselves.
     */
     
     using SegList = std::vector<SpgMth::LineSeg2D>;
-    
-    struct Event
-    {
-      Event() = default;
-      Event(SpgMth::Point2d point) : point{point} {}
-      Event(SpgMth::Point2d point, SpgMth::LineSeg2D seg) : point{point}  {
-        seg_list.push_back(seg);
-      }
-      Event(SpgMth::Point2d point, const SegList& segs) : point{point}, seg_list(segs) {}
+    using SegIndex = uint32_t;
 
-      void Insert(SpgMth::LineSeg2D seg) {
-        seg_list.push_back(seg);
-      }
-      void Print();
+    //Input segment in double precision, with upper = the endpoint processed first (higher y, or lower x for
+    //horizontal segments)
+    struct Segment
+    {
+      SpgMth::DPoint2d upper;
+      SpgMth::DPoint2d lower;
 
-      SpgMth::Point2d point;
-      SegList seg_list;
+      bool IsHorizontal() const { return upper.y == lower.y; }
     };
 
     struct EventComparator
     {
-      bool operator ()(const Event& e1,  const Event& e2) const noexcept
+      //true if p1 is processed before p2 - top to bottom, then left to right
+      bool operator ()(const SpgMth::DPoint2d& p1, const SpgMth::DPoint2d& p2) const noexcept
       {
-        if( !SpgMth::Equal(e1.point.y,e2.point.y))
-          return e1.point.y > e2.point.y;  
-        else
-          return e1.point.x < e2.point.x;  
+        if(p1.y != p2.y)
+          return p1.y > p2.y;
+        return p1.x < p2.x;
       }
     };
 
+    struct Event
+    {
+      SpgMth::DPoint2d point;
+      uint32_t upper_begin = 0; //U(p) = segs upper_order[upper_begin, upper_end)
+      uint32_t upper_end = 0;
+    };
+
     class Queue
     {
       public:
         Queue() = default;
         ~Queue() = default;
 
-        void Insert(const SegList& seg_list);
-        void Insert(Event e);
+        void Initialise(std::span<const Segment> segs, double tolerance);
+        void Insert(const SpgMth::DPoint2d& point); //intersection event
         bool IsEmpty() const {
-          return m_data.empty();
+          return (m_next_upper == m_upper_order.size()) && (m_next_lower == m_lower_order.size()) && m_intersections.empty();
+        }
+        Event Next(); //merges all the queued events within the tolerance of the next event point
+        std::span<const SegIndex> UpperSegs(const Event& e) const {
+          return std::span<const SegIndex>(m_upper_order.data() + e.upper_begin, e.upper_end - e.upper_begin);
         }
-        Event Next();
         void Print();
 
-      private:  
-        std::set<Event, EventComparator> m_data;
+      private:
+        bool Near(const SpgMth::DPoint2d& p1, const SpgMth::DPoint2d& p2) const {
+          return (std::abs(p1.x - p2.x) <= m_tolerance) && (std::abs(p1.y - p2.y) <= m_tolerance);
+        }
+
+      private:
+        std::span<const Segment> m_segs;
+        std::vector<SegIndex> m_upper_order; //seg indices sorted by upper endpoint
+        std::vector<SegIndex> m_lower_order; //seg indices sorted by lower endpoint
+        uint32_t m_next_upper = 0;
+        uint32_t m_next_lower = 0;
+        std::vector<SpgMth::DPoint2d> m_intersections; //heap, next event on top
+        double m_tolerance = 0;
     };
 
+    //Comparator logging policy. ComparatorLogger records every status structure comparison, insertion and deletion
+    //for debugging. NullComparatorLogger is the default - its Log() calls compile away, so production builds pay
+    //nothing for the logging hooks in the hot loop
     struct ComparatorLogger
     {
+      static constexpr bool s_enabled = true;
+
       struct ComparisonRecord
       {
-        SpgMth::LineSeg2D seg1;
-        SpgMth::LineSeg2D seg2;
-        SpgMth::Point2d event_point;
+        SegIndex seg1;
+        SegIndex seg2;
+        SpgMth::DPoint2d event_point;
         bool result;
         int tag;
       };
       struct PreInsertionRecord
       {
-        SpgMth::LineSeg2D seg;
+        SegIndex seg;
       };
        struct PostInsertionRecord
       {
-        SpgMth::LineSeg2D seg;
+        SegIndex seg;
         bool success;
         int32_t size_change=0;
       };
       struct PreDeletionRecord
       {
-        SpgMth::LineSeg2D seg;
+        SegIndex seg;
       };
       struct PostDeletionRecord
       {
-        SpgMth::LineSeg2D seg;
+        SegIndex seg;
         bool success;
         int32_t size_change=0;
       };
 
       using Record = std::variant<ComparisonRecord,PreInsertionRecord,PostInsertionRecord,PreDeletionRecord,PostDeletionRecord>;
 
-      void Log(const SpgMth::LineSeg2D& seg1, const SpgMth::LineSeg2D& seg2, const SpgMth::Point2d& event_point, bool result, int tag) {
+      void Log(SegIndex seg1, SegIndex seg2, const SpgMth::DPoint2d& event_point, bool result, int tag) {
         ComparisonRecord record{seg1,seg2,event_point,result,tag};
         m_data.push_back(record);
       }
@@ -129,134 +156,156 @@ namespace Geom
       void Log(Record record) {
         m_data.push_back(record);
       }
-      void Print();
+      void Print(std::span<const Segment> segs);
+      std::size_t NumComparisons() const;
 
       std::vector<Record> m_data;
     };  
 
-    struct SegComparator
+    struct NullComparatorLogger
     {
-      bool operator ()(const SpgMth::LineSeg2D& seg1,  const SpgMth::LineSeg2D& seg2) const noexcept
-      {
-        if(!SpgMth::Equal(seg1.start.x,seg2.start.x))
-          return seg1.start.x < seg2.start.x;
-        else if(!SpgMth::Equal(seg1.start.y,seg2.start.y))  
-          return seg1.start.y > seg2.start.y;
-        else if(!SpgMth::Equal(seg1.end.x,seg2.end.x))
-          return seg1.end.x < seg2.end.x;  
-        else
-          return seg1.end.y > seg2.end.y;     
-      }
+      static constexpr bool s_enabled = false;
+
+      template<typename TRecord>
+      void Log(const TRecord&) {}
+      void Print(std::span<const Segment>) {}
     };
 
-    struct SegEqualityChecker
+    //Current sweep line state, shared by reference with the comparator
+    template<typename TLogger = NullComparatorLogger>
+    struct SweepLine
     {
-      SpgMth::LineSeg2D target;
-      explicit SegEqualityChecker(SpgMth::LineSeg2D& target) : target{target} {}
-      bool operator ()(const SpgMth::LineSeg2D& seg) const
-      {
-        if(!SpgMth::Equal(seg.start.x,target.start.x))
-          return false;
-        else if(!SpgMth::Equal(seg.start.y,target.start.y))  
-          return false;
-        else if(!SpgMth::Equal(seg.end.x,target.end.x))
-          return false;
-        else if(!SpgMth::Equal(seg.end.y,target.end.y))
-          return false;
-        return true;  
-      }
+      const Segment* segs = nullptr;
+      SpgMth::DPoint2d event_point{DBL_MAX,DBL_MAX};
+      double tolerance = 0; //x intercepts this close to event_point.x are snapped to it
+      TLogger* logger = nullptr; //every comparison is logged if set (and TLogger::s_enabled)
     };
 
+    template<typename TLogger = NullComparatorLogger>
     struct SweepLineComparator
     {
-      SpgMth::Point2d& event_point;
-      SweepLineComparator(SpgMth::Point2d& event_point_) : event_point{event_point_} {}
-      SweepLineComparator(SpgMth::Point2d& event_point_, ComparatorLogger* logger) : 
-        event_point{event_point_}, m_logger{logger} {}
-
-      float ComputeSweepLineXIntercept(const SpgMth::LineSeg2D& seg) const noexcept;
-      bool operator ()(const SpgMth::LineSeg2D& seg1,  const SpgMth::LineSeg2D& seg2) const noexcept;
-
-      ComparatorLogger* m_logger = nullptr;
-      void SetComparatorLogger(ComparatorLogger* logger) {m_logger = logger;}
+      const SweepLine<TLogger>& sweep_line;
+      SweepLineComparator(const SweepLine<TLogger>& sweep_line_) : sweep_line{sweep_line_} {}
+
+      //x coord where seg crosses the sweep line. Horizontal segs are at the event point (clamped to the seg)
+      double ComputeSweepLineXIntercept(SegIndex seg) const noexcept;
+      //As above, but snapped to the event point x if the seg passes within the tolerance box around it - segs through the
+      //event point compare equal on this
+      double SweepLineKey(SegIndex seg) const noexcept;
+      //Order just below the sweep line. Segs through the event point are ordered by slope (horizontal last), then index
+      bool operator ()(SegIndex seg1, SegIndex seg2) const noexcept;
     };
 
+    template<typename TLogger = NullComparatorLogger>
     class StatusStructure
     {
       public:
 
-        StatusStructure() : m_T(SweepLineComparator(m_cur_event_point, &m_comparator_log)) {}
-
-        void FindNewActiveSegCandidates(const Event& e);
-        auto FindSegsInTContainingPoint(const SpgMth::Point2d& p);
-      
-        auto LeftAndRightNeighbour(const Event& e);
-        auto LeftMost_UC_In_T(const Event& e);
-        auto RightMost_UC_In_T(const Event& e);
-
-        void UpdateActiveSegs(const Event& e);
-
-        SegList& Get_LUC() {return m_union_LUC;}
-        SegList& Get_LC() {return m_union_LC;}
-        SegList& Get_UC() {return m_union_UC;}
+        StatusStructure() : m_T(SweepLineComparator<TLogger>(m_sweep_line)) {
+          if constexpr(TLogger::s_enabled)
+            m_sweep_line.logger = &m_comparator_log;
+        }
+        StatusStructure(const StatusStructure&) = delete; //m_T's comparator refers to m_sweep_line
+        StatusStructure& operator=(const StatusStructure&) = delete;
+
+        void Initialise(std::span<const Segment> segs, double tolerance);
+        //Sets the sweep line to the event point, and collects L(p) and C(p) from the segs in T through it
+        void FindSegsContainingPoint(const Event& e);
+        //Deletes L(p),C(p) then inserts U(p),C(p) in their order just below the event point
+        void UpdateActiveSegs(std::span<const SegIndex> upper_segs);
+
+        //Left and right neighbours of the event point (when U(p),C(p) is empty)
+        std::pair<SegIndex,SegIndex> LeftAndRightNeighbour() const;
+        //Leftmost seg of U(p),C(p) in T and its left neighbour
+        std::pair<SegIndex,SegIndex> LeftMost_UC_In_T() const;
+        //Rightmost seg of U(p),C(p) in T and its right neighbour
+        std::pair<SegIndex,SegIndex> RightMost_UC_In_T() const;
+
+        const std::vector<SegIndex>& Get_L() const {return m_L;}
+        const std::vector<SegIndex>& Get_C() const {return m_C;}
         auto& GetStatusStructure() {return m_T;}
         auto begin() {return m_T.begin();}
         auto end() {return m_T.end();}
-        auto rbegin() {return m_T.rbegin();}
-        auto rend() {return m_T.rend();}
 
+        const SpgMth::DPoint2d& EventPoint() const {
+          return m_sweep_line.event_point;
+        }
         float SweepLineY() const {
-          return m_cur_event_point.y;
+          return (float)m_sweep_line.event_point.y;
         }
-        ComparatorLogger& GetComparatorLogger() {
+        TLogger& GetComparatorLogger() {
           return m_comparator_log;
         }
         void PrintComparatorLog() {
-          m_comparator_log.Print();
+          m_comparator_log.Print(m_segs);
         }
 
         void PrintStatusStructure();
-        void PrintUnionUC(const SpgMth::Point2d& p);
-        void PrintStatusStructureSubset(std::set<SpgMth::LineSeg2D, SweepLineComparator>::iterator first,
-         std::set<SpgMth::LineSeg2D, SweepLineComparator>::iterator last, const SpgMth::Point2d& p);
+        void PrintSegsContainingPoint();
+
+        static constexpr SegIndex s_none = UINT32_MAX;
 
-        void PrintActiveSegList(); 
+      private:
+        using Status = FlatSortedSet<SegIndex, SweepLineComparator<TLogger>>;
 
-       static const float s_sweep_delta; //Amount to lower sweep line to force order swap for intersecting segs  
+        Status::Iterator FirstAtEventPoint() const; //first seg in T with key >= event point x
+        Status::Iterator FirstAfterEventPoint() const; //first seg in T with key > event point x
 
       private:
-        SpgMth::Point2d m_cur_event_point{FLT_MAX,FLT_MAX};
-        std::set<SpgMth::LineSeg2D, SweepLineComparator> m_T; //ordered set of active segs. i.e. 'Status Structure'
-        SegList m_union_LUC, m_union_LC, m_union_UC;
-        ComparatorLogger m_comparator_log;
-        SegList m_active_segs;
+        std::span<const Segment> m_segs;
+        SweepLine<TLogger> m_sweep_line;
+        Status m_T; //ordered set of active segs. i.e. 'Status Structure'
+        std::vector<SegIndex> m_L, m_C; //scratch: segs in T with lower endpoint at / interior through the event point
+        TLogger m_comparator_log;
     };
     
     struct Intersection
     {
       SpgMth::Point2d point;
-      SegList segs;
+      uint32_t first = 0; //segs are IntersectionSet::m_intersection_segs[first, first + count)
+      uint32_t count = 0;
     };
 
+    //TLogger = ComparatorLogger to record the status structure comparisons (see GetComparatorLogger())
+    template<typename TLogger = NullComparatorLogger>
     class IntersectionSet 
     {
       public:
         IntersectionSet() = default;
-        IntersectionSet(const SegList& seg_list);
+        IntersectionSet(std::span<const SpgMth::LineSeg2D> seg_list);
         void Process();  
+        //Same result as Process(), but the plane is cut into vertical strips holding roughly equal numbers of segs
+        //and each strip is swept independently on the pool. A seg is copied into every strip its x range overlaps,
+        //and an intersection is only kept by the strip whose [x_min, x_max) contains it, so those on the strip
+        //boundaries aren't reported twice. num_strips = 0 => 4 per pool thread. Small inputs just use Process()
+        void ProcessParallel(Core::ThreadPool& pool = Core::ThreadPool::Default(), uint32_t num_strips = 0);
+
+        const std::vector<Intersection>& GetIntersections() const { return m_intersections; }
+        std::span<const SegIndex> GetSegs(const Intersection& intersection) const {
+          return std::span<const SegIndex>(m_intersection_segs.data() + intersection.first, intersection.count);
+        }
         void PrintIntersections();
+        TLogger& GetComparatorLogger() { return m_status.GetComparatorLogger(); }
 
-        static void Test();
+        //Points closer than this (times the input extent) are treated as the same event point
+        static constexpr double s_relative_tolerance = 1e-9;
+
+        static void Test(bool benchmark_mode = false); //benchmark mode: timings and comparator logging overhead
       private:
+        void Initialise(double tolerance);
         void HandleEvent(const Event& e);
-        void FindNewEvent(const SpgMth::LineSeg2D& seg1, const SpgMth::LineSeg2D& seg2, SpgMth::Point2d p);
+        void FindNewEvent(SegIndex seg1, SegIndex seg2);
 
-        
       private:
+        std::vector<Segment> m_segs;
+        double m_tolerance = 0;
         Queue m_queue;
-        StatusStructure m_status;
+        StatusStructure<TLogger> m_status;
         std::vector<Intersection> m_intersections;
+        std::vector<SegIndex> m_intersection_segs;
+        bool m_record_event_points = false; //ProcessParallel() strips: keep the exact point of each intersection too
+        std::vector<SpgMth::DPoint2d> m_event_points;
     };
 
   }
-}
\ No newline at end of file
+}
@@ -7,6 +7,7 @@ namespace Geom
   {
     if(points.empty())
       return;
+    m_num_points = points.size();
     m_root = BuildTree(0,points);  
   }
 
@@ -14,20 +15,81 @@ namespace Geom
   {
     if(points.empty())
       return;
+    m_num_points = points.size();
     m_root = BuildTree(0,std::move(points));
   }
 
+  KDTree2D::KDTree2D(const std::vector<SpgMth::Point2d>& points, Layout layout, uint32_t leaf_size) :
+    m_layout{layout}
+  {
+    if(points.empty())
+      return;
+    m_num_points = points.size();
+    if(m_layout == Layout::Linked) {
+      m_root = BuildTree(0,points);
+      return;
+    }
+    m_flat_tree = KDTree<2>(points, leaf_size);
+  }
+
+  KDTree2D::KDTree2D(std::vector<SpgMth::Point2d>&& points, Layout layout, uint32_t leaf_size) :
+    m_layout{layout}
+  {
+    if(points.empty())
+      return;
+    m_num_points = points.size();
+    if(m_layout == Layout::Linked) {
+      m_root = BuildTree(0,std::move(points));
+      return;
+    }
+    m_flat_tree = KDTree<2>(std::move(points), leaf_size);
+  }
+
+  KDTree2D::KDTree2D(PointSoAView2D points, Layout layout, uint32_t leaf_size) :
+    KDTree2D(points.ToPoints(), layout, leaf_size)
+  {
+  }
+
+  KDTree2D::~KDTree2D()
+  {
+    DestroySubtree(m_root);
+  }
+
+  KDTree2D::KDTree2D(KDTree2D&& other) noexcept
+  {
+    *this = std::move(other);
+  }
+
+  KDTree2D& KDTree2D::operator=(KDTree2D&& other) noexcept
+  {
+    if(this == &other)
+      return *this;
+    DestroySubtree(m_root);
+    m_root = std::exchange(other.m_root, nullptr);
+    m_layout = other.m_layout;
+    m_num_points = std::exchange(other.m_num_points, 0);
+    m_num_tombstones = std::exchange(other.m_num_tombstones, 0);
+    m_flat_tree = std::move(other.m_flat_tree);
+    return *this;
+  }
+
+  void KDTree2D::Rebuild(const std::vector<SpgMth::Point2d>& points)
+  {
+    //Re-uses the existing buffers, so no allocation once they've grown to size (e.g. per frame rebuilds)
+    if(m_layout != Layout::Flat) {
+      SPG_ERROR("KDTree2D::Rebuild(): only supported for Layout::Flat");
+      return;
+    }
+    m_flat_tree.Rebuild(points);
+    m_num_points = m_flat_tree.Size();
+  }
+
   KDTree2D::KDNode2D* KDTree2D::BuildTree(uint32_t depth, std::vector<SpgMth::Point2d> points)
   {
     //Could store multiple points in a leaf node, so use vector
     uint32_t num_points = points.size();
-    if(num_points == 1) {
-      KDNode2D* node = new KDNode2D();
-      node->is_leaf = true;
-      node->depth = depth;
-      node->points.push_back(points[0]);
-      return node;
-    }
+    if(num_points == 1) 
+      return MakeLeaf(depth, points[0]);
  
     if(depth%2 == 0) //split on vertical axis => sort by x coord
       std::sort(points.begin(), points.end(), [](SpgMth::Point2d a, SpgMth::Point2d b) {return a.x < b.x;});
@@ -44,15 +106,179 @@ namespace Geom
     node->is_leaf = false;
     node->split_value = split_value;
     node->depth = depth;
+    node->num_points = num_points;
+    node->num_leaves = num_points;
     node->left = BuildTree(depth+1, std::move(first_half));
     node->right = BuildTree(depth+1, std::move(second_half));
     return node;
   }
 
+  KDTree2D::KDNode2D* KDTree2D::MakeLeaf(uint32_t depth, SpgMth::Point2d point)
+  {
+    KDNode2D* node = new KDNode2D();
+    node->is_leaf = true;
+    node->depth = depth;
+    node->points.push_back(point);
+    node->num_points = 1;
+    node->num_leaves = 1;
+    return node;
+  }
+
+  void KDTree2D::DestroySubtree(KDNode2D* node)
+  {
+    if(node == nullptr)
+      return;
+    DestroySubtree(node->left);
+    DestroySubtree(node->right);
+    delete node;
+  }
+
+  uint32_t KDTree2D::MaxBalancedDepth() const
+  {
+    //No leaf in an alpha weight balanced tree is deeper than log_(1/alpha)(num leaves)
+    const float num_leaves = (m_root == nullptr) ? 1.0f : (float)std::max(m_root->num_leaves, 1u);
+    return (uint32_t)(std::log(num_leaves) / std::log(1.0f/s_balance_alpha));
+  }
+
+  bool KDTree2D::Insert(SpgMth::Point2d point)
+  {
+    if(m_layout != Layout::Linked) {
+      SPG_ERROR("KDTree2D::Insert(): only supported for Layout::Linked");
+      return false;
+    }
+    m_num_points++;
+    if(m_root == nullptr) {
+      m_root = MakeLeaf(0, point);
+      return true;
+    }
+
+    //Descend to the leaf whose region contains the point (points <= split value go left, same as BuildTree())
+    m_insert_path.clear();
+    KDNode2D* node = m_root;
+    while(!node->is_leaf) {
+      m_insert_path.push_back(node);
+      const float c = (node->depth % 2 == 0) ? point.x : point.y;
+      node = (c <= node->split_value) ? node->left : node->right;
+    }
+
+    if(node->is_deleted) {
+      //Re-use the tombstone - the point is inside its region, so no change to the structure
+      node->points[0] = point;
+      node->is_deleted = false;
+      node->num_points = 1;
+      m_num_tombstones--;
+      for(auto n : m_insert_path)
+        n->num_points++;
+      return true;
+    }
+
+    //Split the leaf into an internal node with the 2 points as leaves. If they're equal on this axis, splitting 
+    //on that value still puts one on each side (left <= split <= right)
+    const uint32_t depth = node->depth;
+    const SpgMth::Point2d existing = node->points[0];
+    const float c_new = (depth % 2 == 0) ? point.x : point.y;
+    const float c_existing = (depth % 2 == 0) ? existing.x : existing.y;
+    const bool new_is_left = c_new < c_existing;
+    node->is_leaf = false;
+    node->points.clear();
+    node->split_value = new_is_left ? c_new : c_existing;
+    node->left = MakeLeaf(depth+1, new_is_left ? point : existing);
+    node->right = MakeLeaf(depth+1, new_is_left ? existing : point);
+    node->num_points = 2;
+    node->num_leaves = 2;
+    for(auto n : m_insert_path) {
+      n->num_points++;
+      n->num_leaves++;
+    }
+
+    if(depth + 1 <= MaxBalancedDepth())
+      return true;
+
+    //Too deep, so some ancestor is out of balance. Rebuild the subtree at the deepest one (the scapegoat)
+    m_insert_path.push_back(node);
+    for(int32_t i = (int32_t)m_insert_path.size() - 1; i >= 0; --i) {
+      KDNode2D* n = m_insert_path[i];
+      const uint32_t max_child = std::max(n->left->num_leaves, n->right->num_leaves);
+      if((float)max_child > s_balance_alpha * (float)n->num_leaves) {
+        KDNode2D* parent = (i > 0) ? m_insert_path[i-1] : nullptr;
+        const uint32_t removed = RebuildSubtree(n, parent);
+        for(int32_t j = 0; j < i; ++j)
+          m_insert_path[j]->num_leaves -= removed;
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool KDTree2D::Erase(SpgMth::Point2d point)
+  {
+    if(m_layout != Layout::Linked) {
+      SPG_ERROR("KDTree2D::Erase(): only supported for Layout::Linked");
+      return false;
+    }
+    if(m_root == nullptr || !EraseFromNode(m_root, point))
+      return false;
+    m_num_points--;
+    m_num_tombstones++;
+    if(m_num_tombstones > m_num_points)
+      RebuildAll();
+    return true;
+  }
+
+  bool KDTree2D::EraseFromNode(KDNode2D* node, SpgMth::Point2d point)
+  {
+    if(node->num_points == 0)
+      return false;
+    if(node->is_leaf) {
+      if(node->points[0] != point)
+        return false;
+      node->is_deleted = true;
+      node->num_points = 0;
+      return true;
+    }
+    //Points equal to the split value can be on either side
+    const float c = (node->depth % 2 == 0) ? point.x : point.y;
+    bool erased = false;
+    if(c <= node->split_value)
+      erased = EraseFromNode(node->left, point);
+    if(!erased && c >= node->split_value)
+      erased = EraseFromNode(node->right, point);
+    if(erased)
+      node->num_points--;
+    return erased;
+  }
+
+  uint32_t KDTree2D::RebuildSubtree(KDNode2D* node, KDNode2D* parent)
+  {
+    std::vector<SpgMth::Point2d> points;
+    points.reserve(node->num_points);
+    AccumulateSubtreePoints(node, points);
+    const uint32_t removed = node->num_leaves - node->num_points;
+    m_num_tombstones -= removed;
+
+    SPG_ASSERT(!points.empty()); //only called on subtrees containing the new point
+    KDNode2D* new_node = BuildTree(node->depth, std::move(points));
+    if(parent == nullptr)
+      m_root = new_node;
+    else if(parent->left == node)
+      parent->left = new_node;
+    else
+      parent->right = new_node;
+    DestroySubtree(node);
+    return removed;
+  }
+
+  void KDTree2D::RebuildAll()
+  {
+    std::vector<SpgMth::Point2d> points = CollectAllPoints();
+    DestroySubtree(m_root);
+    m_root = points.empty() ? nullptr : BuildTree(0, std::move(points));
+    m_num_tombstones = 0;
+  }
+
   std::vector<SpgMth::Point2d> KDTree2D::BruteForceRangeSearch(const Range& input_range)
   {
-    std::vector<SpgMth::Point2d> all_points;
-    AccumulateSubtreePoints(m_root, all_points);
+    std::vector<SpgMth::Point2d> all_points = CollectAllPoints();
     std::vector<SpgMth::Point2d> points_in_range;
     for(auto& p : all_points) {
       if(RangeContainsPoint(p,input_range))
@@ -61,32 +287,27 @@ namespace Geom
     return points_in_range;
   }
 
-  std::vector<SpgMth::Point2d> KDTree2D::RangeSearch(const Range& input_range)
+  std::vector<SpgMth::Point2d> KDTree2D::RangeSearch(const Range& input_range) const
   {
     std::vector<SpgMth::Point2d> points_found;
-    Range node_range;
-    SearchNode(m_root, node_range, input_range, points_found);
+    RangeSearch(input_range, points_found);
     return points_found;
   }
 
-  std::vector<SpgMth::Point2d> KDTree2D::CollectAllPoints()
-  {
-    std::vector<SpgMth::Point2d> points;
-    AccumulateSubtreePoints(m_root,points);
-    return points;
-  }
-
-  
-
-  void KDTree2D::SearchNode(KDNode2D* node, Range node_range, const Range& input_range,std::vector<SpgMth::Point2d>& points_found)
+  //The range search walks are shared by RangeSearch(), RangeCount() and the visitor version. on_point(p) is called for 
+  //points tested individually, on_subtree(node) for subtrees whose region is fully inside the input range.
+  template<typename TPointFn, typename TSubtreeFn>
+  void KDTree2D::SearchNode(KDNode2D* node, Range node_range, const Range& input_range, TPointFn& on_point, TSubtreeFn& on_subtree) const
   {
     SPG_ASSERT(node != nullptr);
+    if(node->num_points == 0) //all tombstones
+      return;
 
     if(node->is_leaf) {
       SPG_ASSERT(node->points.size() == 1);
       auto p = node->points[0];
       if(RangeContainsPoint(p, input_range)) {
-        points_found.push_back(p);
+        on_point(p);
       }
       return;
     }
@@ -94,35 +315,96 @@ namespace Geom
     //update node range
     Range r_left = node_range;
     Range r_right = node_range;
+    //Range can be degenerate (split on the range edge) when there are duplicate coords
     if(node->depth % 2 == 0) { //vertical split
-      SPG_ASSERT((node_range.x_max > node->split_value)&&(node_range.x_min < node->split_value));
+      SPG_ASSERT((node_range.x_max >= node->split_value)&&(node_range.x_min <= node->split_value));
       r_left.x_max = node->split_value;
       r_right.x_min = node->split_value;
     }
     else { //horizontal splt
-      SPG_ASSERT((node_range.y_max > node->split_value)&&(node_range.y_min < node->split_value));
+      SPG_ASSERT((node_range.y_max >= node->split_value)&&(node_range.y_min <= node->split_value));
       r_left.y_max = node->split_value;
       r_right.y_min = node->split_value;
     }
 
     if(RangeContainsRange(input_range, r_left)) {
-      AccumulateSubtreePoints(node->left, points_found);
+      on_subtree(node->left);
     }
     else if(RangesIntersect(input_range, r_left)) {
-      SearchNode(node->left, r_left, input_range, points_found);
+      SearchNode(node->left, r_left, input_range, on_point, on_subtree);
     }
 
     if(RangeContainsRange(input_range, r_right)) {
-      AccumulateSubtreePoints(node->right, points_found);
+      on_subtree(node->right);
     }
     else if(RangesIntersect(input_range, r_right)) {
-      SearchNode(node->right, r_right, input_range, points_found);
+      SearchNode(node->right, r_right, input_range, on_point, on_subtree);
+    }
+  }
+
+  void KDTree2D::RangeSearch(const Range& input_range, std::vector<SpgMth::Point2d>& points_found) const
+  {
+    auto on_point = [&points_found](SpgMth::Point2d p) { points_found.push_back(p); };
+    Range node_range;
+    if(m_layout == Layout::Flat) {
+      m_flat_tree.RangeSearch(ToBox(input_range), points_found);
+      return;
+    }
+    if(m_root != nullptr) {
+      auto on_subtree = [&](KDNode2D* node) { AccumulateSubtreePoints(node, points_found); };
+      SearchNode(m_root, node_range, input_range, on_point, on_subtree);
+    }
+  }
+
+  void KDTree2D::RangeSearch(const Range& input_range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const
+  {
+    auto on_point = [&visitor](SpgMth::Point2d p) { visitor(p); };
+    Range node_range;
+    if(m_layout == Layout::Flat) {
+      m_flat_tree.RangeSearch(ToBox(input_range), visitor);
+      return;
     }
+    if(m_root != nullptr) {
+      auto on_subtree = [&](KDNode2D* node) { VisitSubtreePoints(node, visitor); };
+      SearchNode(m_root, node_range, input_range, on_point, on_subtree);
+    }
+  }
+
+  uint32_t KDTree2D::RangeCount(const Range& input_range) const
+  {
+    //Fully contained subtrees are counted from their size without visiting them 
+    uint32_t count = 0;
+    auto on_point = [&count](SpgMth::Point2d) { count++; };
+    Range node_range;
+    if(m_layout == Layout::Flat)
+      return m_flat_tree.RangeCount(ToBox(input_range));
+    if(m_root != nullptr) {
+      auto on_subtree = [&count](KDNode2D* node) { count += node->num_points; };
+      SearchNode(m_root, node_range, input_range, on_point, on_subtree);
+    }
+    return count;
+  }
+
+  void KDTree2D::RangeSearchBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool) const
+  {
+    RunBatchQuery(ranges, [this](const Range& range, std::vector<SpgMth::Point2d>& out) { RangeSearch(range, out); }, result, pool);
+  }
+
+  std::vector<SpgMth::Point2d> KDTree2D::CollectAllPoints() const
+  {
+    if(m_layout == Layout::Flat)
+      return m_flat_tree.Points();
+    std::vector<SpgMth::Point2d> points;
+    if(m_root != nullptr)
+      AccumulateSubtreePoints(m_root,points);
+    return points;
   }
 
-  void KDTree2D::AccumulateSubtreePoints(KDNode2D* node,std::vector<SpgMth::Point2d>& cur_points)
+  void KDTree2D::AccumulateSubtreePoints(KDNode2D* node,std::vector<SpgMth::Point2d>& cur_points) const
   {
     SPG_ASSERT(node != nullptr);
+    if(node->num_points == 0)
+      return;
     if(node->is_leaf) {
       SPG_ASSERT(node->points.size() == 1);
       cur_points.push_back(node->points[0]);
@@ -132,7 +414,150 @@ namespace Geom
     AccumulateSubtreePoints(node->right,cur_points);
   }
 
-  bool KDTree2D::RangeContainsPoint(SpgMth::Point2d p, const Range& range)
+  void KDTree2D::VisitSubtreePoints(KDNode2D* node, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const
+  {
+    SPG_ASSERT(node != nullptr);
+    if(node->num_points == 0)
+      return;
+    if(node->is_leaf) {
+      for(auto& p : node->points)
+        visitor(p);
+      return;
+    }
+    VisitSubtreePoints(node->left, visitor);
+    VisitSubtreePoints(node->right, visitor);
+  }
+
+  std::optional<SpgMth::Point2d> KDTree2D::Nearest(SpgMth::Point2d query) const
+  {
+    std::vector<Neighbour> heap;
+    KNearestQuery(query, 1, heap);
+    if(heap.empty())
+      return std::nullopt;
+    return heap[0].point;
+  }
+
+  std::vector<SpgMth::Point2d> KDTree2D::KNearest(SpgMth::Point2d query, uint32_t k) const
+  {
+    std::vector<Neighbour> heap;
+    KNearestQuery(query, k, heap);
+    std::sort_heap(heap.begin(), heap.end(), [](const Neighbour& a, const Neighbour& b) {return a.dist_sq < b.dist_sq;});
+    std::vector<SpgMth::Point2d> points;
+    points.reserve(heap.size());
+    for(auto& n : heap)
+      points.push_back(n.point);
+    return points;
+  }
+
+  uint32_t KDTree2D::KNearestBatch(const std::vector<SpgMth::Point2d>& queries, uint32_t k, std::vector<SpgMth::Point2d>& results) const
+  {
+    const uint32_t k_out = std::min(k, Size());
+    results.resize(queries.size() * k_out);
+    if(k_out == 0)
+      return 0;
+
+    std::vector<Neighbour> heap;
+    heap.reserve(k_out);
+    for(uint32_t i = 0; i < queries.size(); ++i) {
+      KNearestQuery(queries[i], k_out, heap);
+      SPG_ASSERT(heap.size() == k_out);
+      std::sort_heap(heap.begin(), heap.end(), [](const Neighbour& a, const Neighbour& b) {return a.dist_sq < b.dist_sq;});
+      for(uint32_t j = 0; j < k_out; ++j)
+        results[i*k_out + j] = heap[j].point;
+    }
+    return k_out;
+  }
+
+  std::vector<SpgMth::Point2d> KDTree2D::RadiusSearch(SpgMth::Point2d query, float radius) const
+  {
+    std::vector<SpgMth::Point2d> points_found;
+    if(radius < 0)
+      return points_found;
+    if(m_layout == Layout::Flat) {
+      m_flat_tree.RadiusSearch(query, radius, points_found);
+    }
+    else if(m_root != nullptr) {
+      RadiusSearchNode(m_root, query, radius*radius, points_found);
+    }
+    return points_found;
+  }
+
+  std::vector<SpgMth::Point2d> KDTree2D::BruteForceKNearest(SpgMth::Point2d query, uint32_t k) const
+  {
+    auto points = CollectAllPoints();
+    k = std::min<uint32_t>(k, points.size());
+    auto dist_less = [query](SpgMth::Point2d a, SpgMth::Point2d b) {
+      return glm::length2(a - query) < glm::length2(b - query);
+    };
+    std::partial_sort(points.begin(), points.begin() + k, points.end(), dist_less);
+    points.resize(k);
+    return points;
+  }
+
+  void KDTree2D::KNearestQuery(SpgMth::Point2d query, uint32_t k, std::vector<Neighbour>& heap) const
+  {
+    //heap is a bounded max-heap on dist_sq - the root is the current k'th nearest, which sets the pruning distance
+    heap.clear();
+    if(k == 0)
+      return;
+    if(m_layout == Layout::Flat) {
+      m_flat_tree.KNearestQuery(query, k, heap);
+    }
+    else if(m_root != nullptr) {
+      KNearestNode(m_root, query, k, heap);
+    }
+  }
+
+  void KDTree2D::KNearestNode(KDNode2D* node, SpgMth::Point2d query, uint32_t k, std::vector<Neighbour>& heap) const
+  {
+    SPG_ASSERT(node != nullptr);
+    if(node->num_points == 0)
+      return;
+    if(node->is_leaf) {
+      for(auto& p : node->points)
+        KDTree<2>::PushNeighbour(heap, k, p, glm::length2(p - query));
+      return;
+    }
+
+    //Search the side of the split containing the query first. The far side only needs visiting if the split 
+    //line is closer than the current k'th nearest (left points are <= split value, right points >= split value)
+    const float q = (node->depth % 2 == 0) ? query.x : query.y;
+    const float plane_dist = q - node->split_value;
+    KDNode2D* near_node = (plane_dist <= 0) ? node->left : node->right;
+    KDNode2D* far_node = (plane_dist <= 0) ? node->right : node->left;
+
+    KNearestNode(near_node, query, k, heap);
+    if(heap.size() < k || plane_dist*plane_dist < heap.front().dist_sq)
+      KNearestNode(far_node, query, k, heap);
+  }
+
+  void KDTree2D::RadiusSearchNode(KDNode2D* node, SpgMth::Point2d query, float radius_sq, std::vector<SpgMth::Point2d>& points_found) const
+  {
+    SPG_ASSERT(node != nullptr);
+    if(node->num_points == 0)
+      return;
+    if(node->is_leaf) {
+      for(auto& p : node->points) {
+        if(glm::length2(p - query) <= radius_sq)
+          points_found.push_back(p);
+      }
+      return;
+    }
+
+    const float q = (node->depth % 2 == 0) ? query.x : query.y;
+    const float plane_dist = q - node->split_value;
+    if(plane_dist <= 0 || plane_dist*plane_dist <= radius_sq)
+      RadiusSearchNode(node->left, query, radius_sq, points_found);
+    if(plane_dist >= 0 || plane_dist*plane_dist <= radius_sq)
+      RadiusSearchNode(node->right, query, radius_sq, points_found);
+  }
+
+  KDTree<2>::Box KDTree2D::ToBox(const Range& range)
+  {
+    return KDTree<2>::Box{SpgMth::Point2d(range.x_min, range.y_min), SpgMth::Point2d(range.x_max, range.y_max)};
+  }
+
+  bool KDTree2D::RangeContainsPoint(SpgMth::Point2d p, const Range& range) const
   {
     if(!(p.x < range.x_max))
       return false;
@@ -146,7 +571,7 @@ namespace Geom
     return true;   
   }
 
-  bool KDTree2D::RangeContainsRange(const Range& range, const Range& test_range)
+  bool KDTree2D::RangeContainsRange(const Range& range, const Range& test_range) const
   {
     if(!(test_range.x_max < range.x_max))
       return false;
@@ -160,7 +585,7 @@ namespace Geom
     return true;   
   }
 
-  bool KDTree2D::RangesIntersect(const Range& range1, const Range& range2)
+  bool KDTree2D::RangesIntersect(const Range& range1, const Range& range2) const
   {
     bool no_intersection = (range1.x_min > range2.x_max) || (range1.x_max < range2.x_min) || 
       (range1.y_min > range2.y_max) || (range1.y_max < range2.y_min);
@@ -206,6 +631,7 @@ void KDTree2D::ValidateSearch(const Range& input_range)
     }
 
     Geom::KDTree2D kdtree(kd_values);
+    Geom::KDTree2D kdtree_flat(kd_values, Layout::Flat);
     Geom::KDTree2D kdtree2(std::move(kd_values));
 
     auto points1 = kdtree.CollectAllPoints();
@@ -214,8 +640,154 @@ void KDTree2D::ValidateSearch(const Range& input_range)
     Geom::KDTree2D::Range range{20,80,20,80};
     auto points3 = kdtree.RangeSearch(range);
     auto points4 = kdtree2.RangeSearch(range);
+    auto points5 = kdtree_flat.RangeSearch(range);
 
     kdtree.ValidateSearch(range);
+    kdtree_flat.ValidateSearch(range);
+    SPG_ASSERT(points3.size() == points5.size());
+    SPG_TRACE("KDTree2D range search: linked {} points, flat {} points", points3.size(), points5.size());
+
+    //Nearest neighbour queries vs brute force
+    {
+      std::vector<SpgMth::Point2d> queries;
+      for(int i=0; i<100; i++)
+        queries.push_back(SpgMth::Point2d(fdist(mt),fdist(mt)));
+
+      const uint32_t K = 5;
+      std::vector<SpgMth::Point2d> batch_results;
+      const uint32_t k_out = kdtree_flat.KNearestBatch(queries, K, batch_results);
+      SPG_ASSERT(k_out == K);
+      for(uint32_t i=0; i<queries.size(); i++) {
+        auto q = queries[i];
+        auto expected = kdtree.BruteForceKNearest(q, K);
+        auto linked_result = kdtree.KNearest(q, K);
+        auto flat_result = kdtree_flat.KNearest(q, K);
+        for(uint32_t j=0; j<K; j++) {
+          SPG_ASSERT(glm::length2(linked_result[j]-q) == glm::length2(expected[j]-q));
+          SPG_ASSERT(glm::length2(flat_result[j]-q) == glm::length2(expected[j]-q));
+          SPG_ASSERT(glm::length2(batch_results[i*K+j]-q) == glm::length2(expected[j]-q));
+        }
+        SPG_ASSERT(kdtree.RadiusSearch(q, 10.0f).size() == kdtree_flat.RadiusSearch(q, 10.0f).size());
+      }
+      auto nearest = kdtree_flat.Nearest(queries[0]);
+      SPG_TRACE("KDTree2D nearest to {} is {}", queries[0], nearest.value());
+    }
+
+    //Batched range queries
+    {
+      std::vector<Range> ranges;
+      for(int i=0; i<10000; i++) {
+        float x = fdist(mt), y = fdist(mt);
+        ranges.push_back(Range{x, x+10, y, y+10});
+      }
+      
+      Core::Timer timer;
+      size_t serial_count = 0;
+      for(auto& r : ranges)
+        serial_count += kdtree_flat.RangeSearch(r).size();
+      SPG_INFO("KDTree2D {} range queries, serial: {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+
+      BatchQueryResult result;
+      timer.Reset();
+      kdtree_flat.RangeSearchBatch(ranges, result);
+      SPG_INFO("KDTree2D {} range queries, batched: {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+
+      SPG_ASSERT(result.NumQueries() == ranges.size());
+      SPG_ASSERT(result.points.size() == serial_count);
+      for(size_t i=0; i<ranges.size(); i+=100)
+        SPG_ASSERT(result[i].size() == kdtree.RangeSearch(ranges[i]).size());
+    }
+
+    //Count only and visitor queries
+    {
+      std::vector<Range> ranges;
+      for(int i=0; i<1000; i++) {
+        float x = fdist(mt), y = fdist(mt);
+        ranges.push_back(Range{x, x+50, y, y+50});
+      }
+      Core::Timer timer;
+      size_t total = 0;
+      for(auto& r : ranges)
+        total += kdtree_flat.RangeSearch(r).size();
+      SPG_INFO("KDTree2D {} RangeSearch(): {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+      timer.Reset();
+      size_t total_count = 0;
+      for(auto& r : ranges)
+        total_count += kdtree_flat.RangeCount(r);
+      SPG_INFO("KDTree2D {} RangeCount(): {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+      size_t total_visited = 0;
+      for(auto& r : ranges)
+        kdtree.RangeSearch(r, [&total_visited](const SpgMth::Point2d&) { total_visited++; });
+      SPG_ASSERT(total == total_count);
+      SPG_ASSERT(total == total_visited);
+      for(auto& r : ranges) 
+        SPG_ASSERT(kdtree.RangeCount(r) == kdtree_flat.RangeCount(r));
+    }
+
+    //Dynamic insert / erase vs brute force
+    {
+      std::vector<SpgMth::Point2d> live;
+      Geom::KDTree2D dynamic_tree;
+      Core::Timer timer;
+      for(int i=0; i<20000; i++) {
+        if(live.empty() || fdist(mt) < 130) {
+          SpgMth::Point2d p(fdist(mt),fdist(mt));
+          dynamic_tree.Insert(p);
+          live.push_back(p);
+        }
+        else {
+          const size_t idx = mt() % live.size();
+          bool erased = dynamic_tree.Erase(live[idx]);
+          SPG_ASSERT(erased);
+          live[idx] = live.back();
+          live.pop_back();
+        }
+      }
+      SPG_INFO("KDTree2D 20000 inserts/erases: {:.2f} ms, {} points", timer.ElapsedMillis(), dynamic_tree.Size());
+      SPG_ASSERT(dynamic_tree.Size() == live.size());
+      SPG_ASSERT(dynamic_tree.CollectAllPoints().size() == live.size());
+      SPG_ASSERT(!dynamic_tree.Erase(SpgMth::Point2d(-1.0f,-1.0f)));
+      for(int i=0; i<100; i++) {
+        float x = fdist(mt), y = fdist(mt);
+        Range r{x, x+30, y, y+30};
+        size_t expected = 0;
+        for(auto& p : live)
+          expected += dynamic_tree.RangeContainsPoint(p, r) ? 1 : 0;
+        SPG_ASSERT(dynamic_tree.RangeSearch(r).size() == expected);
+        SPG_ASSERT(dynamic_tree.RangeCount(r) == expected);
+      }
+    }
+
+    //Build timing
+    {
+      const uint32_t KD_NUM_TIMING_VALS = 1000000;
+      std::vector<SpgMth::Point2d> timing_values;
+      timing_values.reserve(KD_NUM_TIMING_VALS);
+      for(uint32_t i=0; i< KD_NUM_TIMING_VALS; i++) 
+        timing_values.push_back(SpgMth::Point2d(fdist(mt),fdist(mt)));
+
+      SPG_WARN("-------------------------------------------------------------------------");
+      SPG_WARN("KDTree2D build timing, {} points", KD_NUM_TIMING_VALS);
+      SPG_WARN("-------------------------------------------------------------------------");
+      Core::Timer timer;
+      Geom::KDTree2D linked_tree(timing_values);
+      SPG_INFO("Linked (sort per level):      {:.2f} ms", timer.ElapsedMillis());
+
+      timer.Reset();
+      Geom::KDTree2D flat_tree(timing_values, Layout::Flat, 1);
+      SPG_INFO("Flat, leaf size 1 (nth_element): {:.2f} ms", timer.ElapsedMillis());
+
+      timer.Reset();
+      Geom::KDTree2D flat_tree_bucketed(timing_values, Layout::Flat);
+      SPG_INFO("Flat, leaf size {} (nth_element): {:.2f} ms", s_default_leaf_size, timer.ElapsedMillis());
+
+      timer.Reset();
+      flat_tree_bucketed.Rebuild(timing_values);
+      SPG_INFO("Flat, rebuild into existing buffers: {:.2f} ms", timer.ElapsedMillis());
+
+      SPG_ASSERT(linked_tree.RangeSearch(range).size() == flat_tree.RangeSearch(range).size());
+      SPG_ASSERT(linked_tree.RangeSearch(range).size() == flat_tree_bucketed.RangeSearch(range).size());
+    }
   }
 
 }
\ No newline at end of file
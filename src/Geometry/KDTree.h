@@ -1,7 +1,11 @@
 #pragma once
 
+#include <optional>
 #include "CoreLib/Core.h"
 #include "MathLib/Geom/Geom.h"
+#include "Geometry/BatchQuery.h"
+#include "Geometry/KDTreeND.h"
+#include "Geometry/PointSoA2D.h"
 
 namespace Geom
 {
@@ -15,6 +19,9 @@ namespace Geom
       bool is_leaf = false;
       float split_value = 0;
       uint32_t depth=0;
+      uint32_t num_points = 0; //live points in this subtree
+      uint32_t num_leaves = 0; //including tombstoned leaves - used for the balance check
+      bool is_deleted = false; //tombstoned leaf
       KDNode2D* left = nullptr;
       KDNode2D* right = nullptr;
       //Only storing 1 point in a leaf for now - could maybe store multiple so use vector
@@ -31,40 +38,101 @@ namespace Geom
       float y_max = std::numeric_limits<float>::max();
     };
 
+    enum class Layout
+    {
+      Linked, //One heap allocated node per point (original version)
+      Flat    //Index based nodes in a single array, points permuted into one buffer, multiple points per leaf (KDTree<2>)
+    };
+
+    using Neighbour = KDTree<2>::Neighbour;
+
+    static constexpr uint32_t s_default_leaf_size = 8;
+    static constexpr float s_balance_alpha = 0.7f; //scapegoat: neither child may have more than this fraction of a node's leaves
+
+    KDTree2D() = default; //empty, Layout::Linked - fill with Insert()
     KDTree2D(std::vector<SpgMth::Point2d>&& points);
     KDTree2D(const std::vector<SpgMth::Point2d>& points);
-    std::vector<SpgMth::Point2d> RangeSearch(const Range& input_range);
+    KDTree2D(std::vector<SpgMth::Point2d>&& points, Layout layout, uint32_t leaf_size = s_default_leaf_size);
+    KDTree2D(const std::vector<SpgMth::Point2d>& points, Layout layout, uint32_t leaf_size = s_default_leaf_size);
+    //The tree keeps its own copy of the points in tree order, so this interleaves them into that once
+    KDTree2D(PointSoAView2D points, Layout layout, uint32_t leaf_size = s_default_leaf_size);
+    ~KDTree2D();
+    KDTree2D(const KDTree2D&) = delete;
+    KDTree2D& operator=(const KDTree2D&) = delete;
+    KDTree2D(KDTree2D&& other) noexcept;
+    KDTree2D& operator=(KDTree2D&& other) noexcept;
+
+    //Dynamic updates, Layout::Linked only - on a Flat tree they log an error and return false, leaving it as is.
+    //Erase() tombstones the leaf and the whole tree is rebuilt once tombstones outnumber live points. Insert() 
+    //splits a leaf, and if that makes the tree too deep the scapegoat subtree (deepest ancestor that's out of 
+    //balance) is rebuilt.
+    bool Insert(SpgMth::Point2d point);
+    bool Erase(SpgMth::Point2d point); //removes one point exactly equal to point, false if not found
+    std::vector<SpgMth::Point2d> RangeSearch(const Range& input_range) const;
+    void RangeSearch(const Range& input_range, std::vector<SpgMth::Point2d>& points_found) const; //appends to points_found
+    void RangeSearch(const Range& input_range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const; //no allocation
+    uint32_t RangeCount(const Range& input_range) const;
+    //Runs all the queries across the pool, results in CSR form (see BatchQueryResult)
+    void RangeSearchBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool = Core::ThreadPool::Default()) const;
     std::vector<SpgMth::Point2d> BruteForceRangeSearch(const Range& input_range); //For testing
-    std::vector<SpgMth::Point2d> CollectAllPoints();
+    std::vector<SpgMth::Point2d> CollectAllPoints() const;
     void ValidateSearch(const Range& input_range);
+    void Rebuild(const std::vector<SpgMth::Point2d>& points); //Flat layout only (logs an error otherwise)
+
+    //Nearest neighbour queries. KNearest() results are ordered nearest first. 
+    std::optional<SpgMth::Point2d> Nearest(SpgMth::Point2d query) const;
+    std::vector<SpgMth::Point2d> KNearest(SpgMth::Point2d query, uint32_t k) const;
+    std::vector<SpgMth::Point2d> RadiusSearch(SpgMth::Point2d query, float radius) const; //points with distance <= radius
+    //Batched k-nearest: results for queries[i] are at [i*k_out, (i+1)*k_out) in results, nearest first, where 
+    //k_out = min(k, num points) is returned. Scratch buffers are shared across all the queries.
+    uint32_t KNearestBatch(const std::vector<SpgMth::Point2d>& queries, uint32_t k, std::vector<SpgMth::Point2d>& results) const;
+    std::vector<SpgMth::Point2d> BruteForceKNearest(SpgMth::Point2d query, uint32_t k) const; //For testing
+    Layout GetLayout() const { return m_layout; }
+    uint32_t Size() const { return m_num_points; }
 
     static void Test();
 
     /*
       Additional:
 
-      Nearest neighbour search (collision detection, spacial search)
-      Point Insertion
-      Point Deletion
       Balanced KD-construction - depth limit, use AABBs to better partition sparse regions, multiple points per leaf
       Serialization / Export
       Visualization/debug helpers - walk and print tree.  Export to .dot file (for Graphviz), show bounding boxes and splits
       Batch construction from file
       Thread safe parallel search
-      3D version
       Use in conjunction with other spacial structures - BVH, quadtrees etc
     */
 
   private:
     KDNode2D* BuildTree(uint32_t depth, std::vector<SpgMth::Point2d> points);
-    void AccumulateSubtreePoints(KDNode2D* node,std::vector<SpgMth::Point2d>& cur_points);
-    void SearchNode(KDNode2D* node, Range node_range, const Range& input_range, std::vector<SpgMth::Point2d>& points_found);
-    bool RangeContainsPoint(SpgMth::Point2d, const Range& range);
-    bool RangeContainsRange(const Range& range, const Range& test_range);  //Is test_range fully contained in range?
-    bool RangesIntersect(const Range& range1, const Range& range2);
+    KDNode2D* MakeLeaf(uint32_t depth, SpgMth::Point2d point);
+    void DestroySubtree(KDNode2D* node);
+    bool EraseFromNode(KDNode2D* node, SpgMth::Point2d point);
+    uint32_t RebuildSubtree(KDNode2D* node, KDNode2D* parent); //returns number of tombstones removed
+    void RebuildAll();
+    uint32_t MaxBalancedDepth() const;
+    void AccumulateSubtreePoints(KDNode2D* node,std::vector<SpgMth::Point2d>& cur_points) const;
+    void VisitSubtreePoints(KDNode2D* node, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const;
+    template<typename TPointFn, typename TSubtreeFn>
+    void SearchNode(KDNode2D* node, Range node_range, const Range& input_range, TPointFn& on_point, TSubtreeFn& on_subtree) const;
+    bool RangeContainsPoint(SpgMth::Point2d, const Range& range) const;
+    bool RangeContainsRange(const Range& range, const Range& test_range) const;  //Is test_range fully contained in range?
+    bool RangesIntersect(const Range& range1, const Range& range2) const;
+
+    static KDTree<2>::Box ToBox(const Range& range);
+
+    void KNearestQuery(SpgMth::Point2d query, uint32_t k, std::vector<Neighbour>& heap) const;
+    void KNearestNode(KDNode2D* node, SpgMth::Point2d query, uint32_t k, std::vector<Neighbour>& heap) const;
+    void RadiusSearchNode(KDNode2D* node, SpgMth::Point2d query, float radius_sq, std::vector<SpgMth::Point2d>& points_found) const;
 
   private:
     KDNode2D* m_root = nullptr;
+
+    Layout m_layout = Layout::Linked;
+    uint32_t m_num_points = 0;
+    uint32_t m_num_tombstones = 0;
+    std::vector<KDNode2D*> m_insert_path; //scratch for Insert()
+    KDTree<2> m_flat_tree;
   };
 
 
@@ -0,0 +1,351 @@
+#include "Geometry/KDTreeND.h"
+#include "CoreLib/Timer.h"
+#include "MathLib/Geom/Geom.h"
+
+namespace Geom
+{
+  template<uint32_t Dim>
+  KDTree<Dim>::KDTree(const std::vector<Point>& points, uint32_t leaf_size) :
+    m_leaf_size{std::max(leaf_size, 1u)}, m_points{points}
+  {
+    Build();
+  }
+
+  template<uint32_t Dim>
+  KDTree<Dim>::KDTree(std::vector<Point>&& points, uint32_t leaf_size) :
+    m_leaf_size{std::max(leaf_size, 1u)}, m_points{std::move(points)}
+  {
+    Build();
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::Rebuild(const std::vector<Point>& points)
+  {
+    m_points.assign(points.begin(), points.end());
+    Build();
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::Build()
+  {
+    m_nodes.clear();
+    if(m_points.empty())
+      return;
+    //Each split leaves at least ceil(leaf_size/2) points per leaf, so this is an upper bound on node count
+    const uint32_t num_points = m_points.size();
+    const uint32_t min_leaf_points = std::max(1u, (m_leaf_size+1)/2);
+    m_nodes.reserve(2*(num_points/min_leaf_points) + 1);
+    BuildTree<0>(0, num_points);
+  }
+
+  template<uint32_t Dim>
+  template<uint32_t Axis>
+  uint32_t KDTree<Dim>::BuildTree(uint32_t begin, uint32_t end)
+  {
+    //Same split rule as KDTree2D - left half gets the extra point, points <= split value go left
+    const uint32_t node_idx = m_nodes.size();
+    m_nodes.emplace_back();
+    m_nodes[node_idx].begin = begin;
+    m_nodes[node_idx].end = end;
+
+    const uint32_t num_points = end - begin;
+    if(num_points <= m_leaf_size) {
+      m_nodes[node_idx].is_leaf = true;
+      return node_idx;
+    }
+
+    const uint32_t median_pos = (num_points%2 == 0) ? num_points/2 : num_points/2 + 1;
+    const uint32_t mid = begin + median_pos;
+    std::nth_element(m_points.begin() + begin, m_points.begin() + (mid-1), m_points.begin() + end,
+      [](const Point& a, const Point& b) {return a[Axis] < b[Axis];});
+    m_nodes[node_idx].split_value = m_points[mid-1][Axis];
+
+    BuildTree<NextAxis(Axis)>(begin, mid); //left child is always node_idx+1
+    const uint32_t right_idx = BuildTree<NextAxis(Axis)>(mid, end);
+    m_nodes[node_idx].right = right_idx;
+    return node_idx;
+  }
+
+  template<uint32_t Dim>
+  template<uint32_t Axis, typename TPointFn, typename TSubtreeFn>
+  void KDTree<Dim>::SearchNode(uint32_t node_idx, Box node_box, const Box& box, TPointFn& on_point, TSubtreeFn& on_subtree) const
+  {
+    const Node& node = m_nodes[node_idx];
+    if(node.is_leaf) {
+      for(uint32_t i = node.begin; i < node.end; ++i) {
+        if(BoxContainsPoint(box, m_points[i]))
+          on_point(m_points[i]);
+      }
+      return;
+    }
+
+    Box b_left = node_box;
+    Box b_right = node_box;
+    b_left.max[Axis] = node.split_value;
+    b_right.min[Axis] = node.split_value;
+
+    const uint32_t left_idx = node_idx + 1;
+    if(BoxContainsBox(box, b_left))
+      on_subtree(left_idx);
+    else if(BoxesIntersect(box, b_left))
+      SearchNode<NextAxis(Axis)>(left_idx, b_left, box, on_point, on_subtree);
+
+    if(BoxContainsBox(box, b_right))
+      on_subtree(node.right);
+    else if(BoxesIntersect(box, b_right))
+      SearchNode<NextAxis(Axis)>(node.right, b_right, box, on_point, on_subtree);
+  }
+
+  template<uint32_t Dim>
+  template<typename TPointFn, typename TSubtreeFn>
+  void KDTree<Dim>::Search(const Box& box, TPointFn& on_point, TSubtreeFn& on_subtree) const
+  {
+    if(m_nodes.empty())
+      return;
+    SearchNode<0>(0, Box{}, box, on_point, on_subtree);
+  }
+
+  template<uint32_t Dim>
+  std::vector<typename KDTree<Dim>::Point> KDTree<Dim>::RangeSearch(const Box& box) const
+  {
+    std::vector<Point> points_found;
+    RangeSearch(box, points_found);
+    return points_found;
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::RangeSearch(const Box& box, std::vector<Point>& points_found) const
+  {
+    //Subtree points are contiguous in m_points, so a fully contained subtree is a single block copy
+    auto on_point = [&points_found](const Point& p) { points_found.push_back(p); };
+    auto on_subtree = [&](uint32_t idx) {
+      points_found.insert(points_found.end(), m_points.begin() + m_nodes[idx].begin, m_points.begin() + m_nodes[idx].end);
+    };
+    Search(box, on_point, on_subtree);
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::RangeSearch(const Box& box, Core::FunctionRef<void(const Point&)> visitor) const
+  {
+    auto on_point = [&visitor](const Point& p) { visitor(p); };
+    auto on_subtree = [&](uint32_t idx) {
+      for(uint32_t i = m_nodes[idx].begin; i < m_nodes[idx].end; ++i)
+        visitor(m_points[i]);
+    };
+    Search(box, on_point, on_subtree);
+  }
+
+  template<uint32_t Dim>
+  uint32_t KDTree<Dim>::RangeCount(const Box& box) const
+  {
+    uint32_t count = 0;
+    auto on_point = [&count](const Point&) { count++; };
+    auto on_subtree = [&](uint32_t idx) { count += m_nodes[idx].end - m_nodes[idx].begin; };
+    Search(box, on_point, on_subtree);
+    return count;
+  }
+
+  template<uint32_t Dim>
+  std::optional<typename KDTree<Dim>::Point> KDTree<Dim>::Nearest(Point query) const
+  {
+    std::vector<Neighbour> heap;
+    KNearestQuery(query, 1, heap);
+    if(heap.empty())
+      return std::nullopt;
+    return heap[0].point;
+  }
+
+  template<uint32_t Dim>
+  std::vector<typename KDTree<Dim>::Point> KDTree<Dim>::KNearest(Point query, uint32_t k) const
+  {
+    std::vector<Neighbour> heap;
+    KNearestQuery(query, k, heap);
+    std::sort_heap(heap.begin(), heap.end(), [](const Neighbour& a, const Neighbour& b) {return a.dist_sq < b.dist_sq;});
+    std::vector<Point> points;
+    points.reserve(heap.size());
+    for(auto& n : heap)
+      points.push_back(n.point);
+    return points;
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::KNearestQuery(Point query, uint32_t k, std::vector<Neighbour>& heap) const
+  {
+    heap.clear();
+    if(k == 0 || m_nodes.empty())
+      return;
+    KNearestNode<0>(0, query, k, heap);
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::PushNeighbour(std::vector<Neighbour>& heap, uint32_t k, Point point, float dist_sq)
+  {
+    auto comp = [](const Neighbour& a, const Neighbour& b) {return a.dist_sq < b.dist_sq;};
+    if(heap.size() < k) {
+      heap.push_back({point, dist_sq});
+      std::push_heap(heap.begin(), heap.end(), comp);
+    }
+    else if(dist_sq < heap.front().dist_sq) {
+      std::pop_heap(heap.begin(), heap.end(), comp);
+      heap.back() = {point, dist_sq};
+      std::push_heap(heap.begin(), heap.end(), comp);
+    }
+  }
+
+  template<uint32_t Dim>
+  template<uint32_t Axis>
+  void KDTree<Dim>::KNearestNode(uint32_t node_idx, Point query, uint32_t k, std::vector<Neighbour>& heap) const
+  {
+    const Node& node = m_nodes[node_idx];
+    if(node.is_leaf) {
+      for(uint32_t i = node.begin; i < node.end; ++i)
+        PushNeighbour(heap, k, m_points[i], glm::length2(m_points[i] - query));
+      return;
+    }
+
+    //Near side first, far side only if the split plane is closer than the current k'th nearest
+    const float plane_dist = query[Axis] - node.split_value;
+    const uint32_t near_idx = (plane_dist <= 0) ? node_idx + 1 : node.right;
+    const uint32_t far_idx = (plane_dist <= 0) ? node.right : node_idx + 1;
+
+    KNearestNode<NextAxis(Axis)>(near_idx, query, k, heap);
+    if(heap.size() < k || plane_dist*plane_dist < heap.front().dist_sq)
+      KNearestNode<NextAxis(Axis)>(far_idx, query, k, heap);
+  }
+
+  template<uint32_t Dim>
+  std::vector<typename KDTree<Dim>::Point> KDTree<Dim>::RadiusSearch(Point query, float radius) const
+  {
+    std::vector<Point> points_found;
+    RadiusSearch(query, radius, points_found);
+    return points_found;
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::RadiusSearch(Point query, float radius, std::vector<Point>& points_found) const
+  {
+    if(radius < 0 || m_nodes.empty())
+      return;
+    RadiusSearchNode<0>(0, query, radius*radius, points_found);
+  }
+
+  template<uint32_t Dim>
+  template<uint32_t Axis>
+  void KDTree<Dim>::RadiusSearchNode(uint32_t node_idx, Point query, float radius_sq, std::vector<Point>& points_found) const
+  {
+    const Node& node = m_nodes[node_idx];
+    if(node.is_leaf) {
+      for(uint32_t i = node.begin; i < node.end; ++i) {
+        if(glm::length2(m_points[i] - query) <= radius_sq)
+          points_found.push_back(m_points[i]);
+      }
+      return;
+    }
+
+    const float plane_dist = query[Axis] - node.split_value;
+    if(plane_dist <= 0 || plane_dist*plane_dist <= radius_sq)
+      RadiusSearchNode<NextAxis(Axis)>(node_idx + 1, query, radius_sq, points_found);
+    if(plane_dist >= 0 || plane_dist*plane_dist <= radius_sq)
+      RadiusSearchNode<NextAxis(Axis)>(node.right, query, radius_sq, points_found);
+  }
+
+  //The loops below have a compile time trip count of Dim, so they're fully unrolled
+
+  template<uint32_t Dim>
+  bool KDTree<Dim>::BoxContainsPoint(const Box& box, const Point& p)
+  {
+    for(uint32_t a = 0; a < Dim; ++a) {
+      if(p[a] < box.min[a] || !(p[a] < box.max[a]))
+        return false;
+    }
+    return true;
+  }
+
+  template<uint32_t Dim>
+  bool KDTree<Dim>::BoxContainsBox(const Box& box, const Box& test_box)
+  {
+    for(uint32_t a = 0; a < Dim; ++a) {
+      if(test_box.min[a] < box.min[a] || !(test_box.max[a] < box.max[a]))
+        return false;
+    }
+    return true;
+  }
+
+  template<uint32_t Dim>
+  bool KDTree<Dim>::BoxesIntersect(const Box& box1, const Box& box2)
+  {
+    for(uint32_t a = 0; a < Dim; ++a) {
+      if(box1.min[a] > box2.max[a] || box1.max[a] < box2.min[a])
+        return false;
+    }
+    return true;
+  }
+
+  template<uint32_t Dim>
+  void KDTree<Dim>::Test()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("KDTree<{}>", Dim);
+    SPG_WARN("-------------------------------------------------------------------------");
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f);
+    auto random_point = [&]() {
+      Point p;
+      for(uint32_t a = 0; a < Dim; ++a)
+        p[a] = fdist(mt);
+      return p;
+    };
+
+    std::vector<Point> points;
+    for(int i=0; i<100000; i++)
+      points.push_back(random_point());
+
+    Core::Timer timer;
+    KDTree tree(points);
+    SPG_INFO("Build, {} points: {:.2f} ms", points.size(), timer.ElapsedMillis());
+
+    //Range queries vs brute force
+    uint32_t total = 0;
+    for(int i=0; i<100; i++) {
+      Box box;
+      box.min = random_point();
+      box.max = box.min + Point(30.0f);
+      uint32_t expected = 0;
+      for(auto& p : points)
+        expected += BoxContainsPoint(box, p) ? 1 : 0;
+      SPG_ASSERT(tree.RangeSearch(box).size() == expected);
+      SPG_ASSERT(tree.RangeCount(box) == expected);
+      total += expected;
+    }
+    SPG_TRACE("100 range queries, {} points found", total);
+
+    //Nearest neighbours vs brute force
+    for(int i=0; i<100; i++) {
+      Point q = random_point();
+      float nearest_sq = std::numeric_limits<float>::max();
+      uint32_t in_radius = 0;
+      for(auto& p : points) {
+        nearest_sq = std::min(nearest_sq, glm::length2(p - q));
+        in_radius += (glm::length2(p - q) <= 10.0f*10.0f) ? 1 : 0;
+      }
+      auto nearest = tree.KNearest(q, 3);
+      SPG_ASSERT(nearest.size() == 3);
+      SPG_ASSERT(glm::length2(nearest[0] - q) == nearest_sq);
+      SPG_ASSERT(tree.RadiusSearch(q, 10.0f).size() == in_radius);
+    }
+
+    std::vector<Point> queries;
+    for(int i=0; i<10000; i++)
+      queries.push_back(random_point());
+    std::vector<Neighbour> heap;
+    timer.Reset();
+    for(auto& q : queries)
+      tree.KNearestQuery(q, 8, heap);
+    SPG_INFO("{} 8-nearest queries: {:.2f} ms", queries.size(), timer.ElapsedMillis());
+  }
+
+  template class KDTree<2>;
+  template class KDTree<3>;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <optional>
+#include "CoreLib/Core.h"
+#include "CoreLib/FunctionRef.h"
+#include "MathLib/MathLib.h"
+
+namespace Geom
+{
+  //Dimension templated KD tree over glm::vec<Dim,float>, flat layout only (same layout as KDTree2D::Layout::Flat,
+  //which is built on top of KDTree<2>). The split axis cycles with depth, and it's a template parameter of the
+  //build/search functions so each level is compiled with a constant axis - p[Axis] is a plain member access and
+  //there's no depth % Dim at run time. Instantiated for Dim = 2 and 3 in KDTreeND.cpp.
+  template<uint32_t Dim>
+  class KDTree
+  {
+    static_assert((Dim == 2) || (Dim == 3), "KDTree dimension must be 2 or 3");
+
+  public:
+    using Point = glm::vec<Dim, float>;
+
+    //Same convention as KDTree2D::Range - min inclusive, max exclusive
+    struct Box
+    {
+      Point min = Point(std::numeric_limits<float>::lowest());
+      Point max = Point(std::numeric_limits<float>::max());
+    };
+
+    struct Neighbour
+    {
+      Point point;
+      float dist_sq = 0; //squared distance to the query point
+    };
+
+    static constexpr uint32_t s_default_leaf_size = 8;
+
+    KDTree() = default;
+    KDTree(const std::vector<Point>& points, uint32_t leaf_size = s_default_leaf_size);
+    KDTree(std::vector<Point>&& points, uint32_t leaf_size = s_default_leaf_size);
+
+    void Rebuild(const std::vector<Point>& points); //re-uses the existing buffers
+
+    std::vector<Point> RangeSearch(const Box& box) const;
+    void RangeSearch(const Box& box, std::vector<Point>& points_found) const; //appends to points_found
+    void RangeSearch(const Box& box, Core::FunctionRef<void(const Point&)> visitor) const;
+    uint32_t RangeCount(const Box& box) const;
+
+    std::optional<Point> Nearest(Point query) const;
+    std::vector<Point> KNearest(Point query, uint32_t k) const; //nearest first
+    //heap is left as a bounded max-heap on dist_sq (unsorted), so callers can re-use it across queries
+    void KNearestQuery(Point query, uint32_t k, std::vector<Neighbour>& heap) const;
+    std::vector<Point> RadiusSearch(Point query, float radius) const; //points with distance <= radius
+    void RadiusSearch(Point query, float radius, std::vector<Point>& points_found) const; //appends to points_found
+
+    const std::vector<Point>& Points() const { return m_points; } //in tree order
+    uint32_t Size() const { return (uint32_t)m_points.size(); }
+    bool Empty() const { return m_points.empty(); }
+
+    static void PushNeighbour(std::vector<Neighbour>& heap, uint32_t k, Point point, float dist_sq);
+    static void Test();
+
+  private:
+    //Pre-order, left child is always node_idx+1. Subtree points are m_points[begin,end)
+    struct Node
+    {
+      float split_value = 0;
+      uint32_t begin = 0;
+      uint32_t end = 0;
+      uint32_t right = 0;
+      bool is_leaf = false;
+    };
+
+    static constexpr uint32_t NextAxis(uint32_t axis) { return (axis + 1) % Dim; }
+
+    void Build();
+    template<uint32_t Axis>
+    uint32_t BuildTree(uint32_t begin, uint32_t end);
+    template<uint32_t Axis, typename TPointFn, typename TSubtreeFn>
+    void SearchNode(uint32_t node_idx, Box node_box, const Box& box, TPointFn& on_point, TSubtreeFn& on_subtree) const;
+    template<typename TPointFn, typename TSubtreeFn>
+    void Search(const Box& box, TPointFn& on_point, TSubtreeFn& on_subtree) const;
+    template<uint32_t Axis>
+    void KNearestNode(uint32_t node_idx, Point query, uint32_t k, std::vector<Neighbour>& heap) const;
+    template<uint32_t Axis>
+    void RadiusSearchNode(uint32_t node_idx, Point query, float radius_sq, std::vector<Point>& points_found) const;
+
+    static bool BoxContainsPoint(const Box& box, const Point& p);
+    static bool BoxContainsBox(const Box& box, const Box& test_box); //Is test_box fully contained in box?
+    static bool BoxesIntersect(const Box& box1, const Box& box2);
+
+  private:
+    uint32_t m_leaf_size = s_default_leaf_size;
+    std::vector<Node> m_nodes;
+    std::vector<Point> m_points;
+  };
+
+  using KDTree3D = KDTree<3>;
+}
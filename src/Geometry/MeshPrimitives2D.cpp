@@ -97,6 +97,22 @@ namespace Geom
     return points;
   }
 
+  void GenerateRandomPoints_XY(float radius, uint32_t num_points, PointSoA2D& points)
+  {
+    std::random_device rand_device;
+    std::mt19937 gen(rand_device());
+    std::uniform_real_distribution<float> dist(-radius,radius);
+
+    points.Resize(num_points);
+    float* xs = points.X();
+    float* ys = points.Y();
+    for(uint32_t i = 0; i < num_points; ++i )
+    {
+      xs[i] = dist(gen);
+      ys[i] = dist(gen);
+    }
+  }
+
   std::vector<SpgMth::Point2d> GenerateCircle_XY(float radius, uint32_t num_vertices)
   {
     std::vector<SpgMth::Point2d> points;
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "Geometry/Polygon.h"
+#include "Geometry/PointSoA2D.h"
 #include "Mathlib/Geom/Line.h"
 #include "MathLib/MathLib.h"
 
@@ -24,6 +25,9 @@ namespace Geom
 
   std::vector<SpgMth::Point2d> GenerateRandomPoints_XY(float radius, uint32_t num_points);
 
+  //Same distribution, written straight into the x and y arrays (points is resized to num_points)
+  void GenerateRandomPoints_XY(float radius, uint32_t num_points, PointSoA2D& points);
+
   std::vector<SpgMth::Point2d> GenerateCircle_XY(float radius, uint32_t num_vertices);
 
   std::vector<SpgMth::Point2d> GenerateRandomPolygon_XY(uint32_t num_vertices, float perturb_factor);
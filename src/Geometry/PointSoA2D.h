@@ -0,0 +1,126 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include "CoreLib/Core.h"
+#include "CoreLib/AlignedAllocator.h"
+#include "MathLib/Geom/Geom.h"
+
+namespace Geom
+{
+  //Non owning view of points stored as separate x and y arrays (structure of arrays). Cheap to copy - pass by value.
+  //The algorithms that take one (Convexhull2D_ModifiedGrahams(), KDTree2D etc) take a view rather than a
+  //PointSoA2D, so a sub range of a bigger set can be passed without copying (Subview()).
+  class PointSoAView2D
+  {
+  public:
+    PointSoAView2D() = default;
+    PointSoAView2D(const float* x, const float* y, std::size_t size) : m_x{x}, m_y{y}, m_size{size} {}
+
+    std::size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+    const float* X() const { return m_x; }
+    const float* Y() const { return m_y; }
+    std::span<const float> Xs() const { return {m_x, m_size}; }
+    std::span<const float> Ys() const { return {m_y, m_size}; }
+
+    SpgMth::Point2d operator[](std::size_t i) const
+    {
+      SPG_ASSERT(i < m_size);
+      return {m_x[i], m_y[i]};
+    }
+
+    PointSoAView2D Subview(std::size_t first, std::size_t count) const
+    {
+      SPG_ASSERT(first + count <= m_size);
+      return {m_x + first, m_y + first, count};
+    }
+
+    //Interleave into out, which must hold Size() points
+    void CopyTo(std::span<SpgMth::Point2d> out) const
+    {
+      SPG_ASSERT(out.size() >= m_size);
+      for(std::size_t i = 0; i < m_size; i++)
+        out[i] = {m_x[i], m_y[i]};
+    }
+
+    std::vector<SpgMth::Point2d> ToPoints() const
+    {
+      std::vector<SpgMth::Point2d> points(m_size);
+      CopyTo(points);
+      return points;
+    }
+
+  private:
+    const float* m_x = nullptr;
+    const float* m_y = nullptr;
+    std::size_t m_size = 0;
+  };
+
+  //Owning structure of arrays point container: x[] and y[] in separate cache line (s_alignment) aligned arrays,
+  //so a loop over just the x's, or over x and y doing the same thing to each point, is a straight run of
+  //contiguous floats the compiler can vectorise - unlike std::vector<Point2d> where x and y interleave.
+  //Converts to a PointSoAView2D implicitly.
+  class PointSoA2D
+  {
+  public:
+    static constexpr std::size_t s_alignment = 64;
+    using FloatArray = std::vector<float, Core::AlignedAllocator<float, s_alignment>>;
+
+    PointSoA2D() = default;
+    explicit PointSoA2D(std::size_t size) : m_x(size), m_y(size) {}
+    explicit PointSoA2D(std::span<const SpgMth::Point2d> points) { Assign(points); }
+
+    void Assign(std::span<const SpgMth::Point2d> points)
+    {
+      Resize(points.size());
+      for(std::size_t i = 0; i < points.size(); i++) {
+        m_x[i] = points[i].x;
+        m_y[i] = points[i].y;
+      }
+    }
+
+    void PushBack(SpgMth::Point2d point)
+    {
+      m_x.push_back(point.x);
+      m_y.push_back(point.y);
+    }
+
+    void Set(std::size_t i, SpgMth::Point2d point)
+    {
+      SPG_ASSERT(i < Size());
+      m_x[i] = point.x;
+      m_y[i] = point.y;
+    }
+
+    SpgMth::Point2d operator[](std::size_t i) const
+    {
+      SPG_ASSERT(i < Size());
+      return {m_x[i], m_y[i]};
+    }
+
+    void Resize(std::size_t size) { m_x.resize(size); m_y.resize(size); }
+    void Reserve(std::size_t size) { m_x.reserve(size); m_y.reserve(size); }
+    void Clear() { m_x.clear(); m_y.clear(); }
+    std::size_t Size() const { return m_x.size(); }
+    bool Empty() const { return m_x.empty(); }
+
+    float* X() { return m_x.data(); }
+    float* Y() { return m_y.data(); }
+    const float* X() const { return m_x.data(); }
+    const float* Y() const { return m_y.data(); }
+    std::span<float> Xs() { return m_x; }
+    std::span<float> Ys() { return m_y; }
+    std::span<const float> Xs() const { return m_x; }
+    std::span<const float> Ys() const { return m_y; }
+
+    PointSoAView2D View() const { return {m_x.data(), m_y.data(), m_x.size()}; }
+    operator PointSoAView2D() const { return View(); }
+    PointSoAView2D Subview(std::size_t first, std::size_t count) const { return View().Subview(first, count); }
+    std::vector<SpgMth::Point2d> ToPoints() const { return View().ToPoints(); }
+
+  private:
+    FloatArray m_x;
+    FloatArray m_y;
+  };
+}
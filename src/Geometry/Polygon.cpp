@@ -12,8 +12,10 @@ namespace Geom
       const auto size = points.size();
       SPG_ASSERT(size >= 3);
 
-      for(auto& p : points)
+      for(auto& p : points) {
         vertices.push_back(new Vertex{p});
+        vertices.back()->index = (uint32_t)vertices.size() - 1;
+      }
 
       vertices[0]->prev = vertices[size-1];
       for (auto i = 0; i < size; ++i)
@@ -15,6 +15,7 @@ namespace Geom
       SpgMth::Point2d point;
       Vertex* next = nullptr;
       Vertex* prev = nullptr;
+      uint32_t index = 0; //in Polygon::vertices
 
       //For ear clipping algo
       bool is_ear = false;
@@ -1,9 +1,11 @@
 #include "Geometry/RBTree.h"
+#include "CoreLib/Timer.h"
+#include <set>
 
 namespace Geom
 {
   
-  void Test_RB_Tree() 
+  void Test_RBTree() 
   {
    
     SPG_WARN("-------------------------------------------------------------------------");
@@ -256,6 +258,26 @@ namespace Geom
          tree.Erase(3.0f);
          tree.Validate(); 
       }
+      {
+        SPG_WARN("BULK BUILD FROM SORTED INPUT ")
+        const int NUM_VALS = 1000000;
+        std::vector<float> vals(NUM_VALS);
+        for(int i=0; i<NUM_VALS; i++)
+          vals[i] = (float)i;
+        Core::Timer timer;
+        RBTree<float,void> inserted_tree;
+        for(auto v : vals)
+          inserted_tree.Insert(v);
+        SPG_INFO("{} repeated inserts: {:.2f} ms", NUM_VALS, timer.ElapsedMillis());
+        timer.Reset();
+        RBTree<float,void> bulk_tree(sorted_input, vals);
+        SPG_INFO("{} bulk build: {:.2f} ms", NUM_VALS, timer.ElapsedMillis());
+        SPG_ASSERT(bulk_tree.Size() == inserted_tree.Size());
+        bulk_tree.Validate();
+        for(int i=0; i<NUM_VALS; i+=2)
+          bulk_tree.Erase(vals[i]);
+        bulk_tree.Validate();
+      }
     }
  }
 
@@ -528,6 +550,97 @@ namespace Geom
           tree.Validate(); 
         }
 #endif
+
+        {
+          SPG_WARN("NODE ALLOCATOR: INSERT/ERASE CHURN VS std::set ")
+          const int NUM_VALS = 200000;
+          const int NUM_ROUNDS = 5;
+          std::vector<int> vals(NUM_VALS);
+          for(int i=0; i<NUM_VALS; i++) 
+            vals[i] = i;
+          std::mt19937 mt(1);
+          std::shuffle(vals.begin(), vals.end(), mt);
+
+          //Fill, then repeatedly erase half and re-insert it (sweep line status / beach line usage pattern)
+          auto churn = [&](auto& container, auto&& insert, auto&& erase) {
+            Core::Timer timer;
+            for(auto v : vals) 
+              insert(container, v);
+            for(int r=0; r<NUM_ROUNDS; r++) {
+              for(int i=0; i<NUM_VALS; i+=2) 
+                erase(container, vals[i]);
+              for(int i=0; i<NUM_VALS; i+=2) 
+                insert(container, vals[i]);
+            }
+            return timer.ElapsedMillis();
+          };
+          auto rb_insert = [](auto& c, int v) { c.Insert(v); };
+          auto rb_erase = [](auto& c, int v) { c.Erase(v); };
+          auto set_insert = [](auto& c, int v) { c.insert(v); };
+          auto set_erase = [](auto& c, int v) { c.erase(v); };
+
+          RBTree<int> pooled_tree;
+          RBTree<int,std::less<int>,void,Core::HeapNodeAllocator> heap_tree;
+          Geom::RBTree<int,void> pooled_tree_v1;
+          Geom::RBTree<int,void,std::less<int>,DefaultValueTraits<int,void>,Core::HeapNodeAllocator> heap_tree_v1;
+          std::set<int> std_set;
+          SPG_INFO("RBTree_V2, pooled: {:.2f} ms", churn(pooled_tree, rb_insert, rb_erase));
+          SPG_INFO("RBTree_V2, new/delete: {:.2f} ms", churn(heap_tree, rb_insert, rb_erase));
+          SPG_INFO("RBTree (V1), pooled: {:.2f} ms", churn(pooled_tree_v1, rb_insert, rb_erase));
+          SPG_INFO("RBTree (V1), new/delete: {:.2f} ms", churn(heap_tree_v1, rb_insert, rb_erase));
+          SPG_INFO("std::set: {:.2f} ms", churn(std_set, set_insert, set_erase));
+          SPG_ASSERT(pooled_tree.Size() == std_set.size());
+          SPG_ASSERT(pooled_tree_v1.Size() == std_set.size());
+        }
+
+        {
+          SPG_WARN("ORDER STATISTICS: RANK, SELECT, COUNTRANGE ")
+          OrderStatisticRBTree<int> os_tree;
+          std::set<int> expected;
+          std::mt19937 mt(2);
+          std::uniform_int_distribution<int> dist(0, 100000);
+          for(int i=0; i<50000; i++) {
+            int v = dist(mt);
+            if(expected.erase(v))
+              os_tree.Erase(v);
+            else {
+              expected.insert(v);
+              os_tree.Insert(v);
+            }
+          }
+          os_tree.Validate();
+          std::vector<int> sorted(expected.begin(), expected.end());
+          for(int i=0; i<1000; i++) {
+            int lo = dist(mt), hi = dist(mt);
+            auto rank = std::lower_bound(sorted.begin(), sorted.end(), lo) - sorted.begin();
+            SPG_ASSERT(os_tree.Rank(lo) == (std::size_t)rank);
+            auto count = (lo <= hi) ? std::upper_bound(sorted.begin(), sorted.end(), hi) - sorted.begin() - rank : 0;
+            SPG_ASSERT(os_tree.CountRange(lo, hi) == (std::size_t)count);
+          }
+          for(std::size_t k=0; k<sorted.size(); k+=97)
+            SPG_ASSERT(*os_tree.Select(k) == sorted[k]);
+          SPG_INFO("Median of {} elements: {}", os_tree.Size(), *os_tree.Select(os_tree.Size()/2));
+
+          //Cost of maintaining the subtree sizes
+          std::vector<int> vals(200000);
+          for(int i=0; i<(int)vals.size(); i++) 
+            vals[i] = i;
+          std::shuffle(vals.begin(), vals.end(), mt);
+          Core::Timer timer;
+          {
+            RBTree<int> tree;
+            for(auto v : vals) tree.Insert(v);
+            for(auto v : vals) tree.Erase(v);
+          }
+          SPG_INFO("RBTree_V2 {} inserts + erases: {:.2f} ms", vals.size(), timer.ElapsedMillis());
+          timer.Reset();
+          {
+            OrderStatisticRBTree<int> tree;
+            for(auto v : vals) tree.Insert(v);
+            for(auto v : vals) tree.Erase(v);
+          }
+          SPG_INFO("OrderStatisticRBTree {} inserts + erases: {:.2f} ms", vals.size(), timer.ElapsedMillis());
+        }
       }
 
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include "CoreLib/Core.h"
+#include "CoreLib/NodePool.h"
 #include <random>
 #include <functional> //std::less
 
@@ -34,8 +35,8 @@ namespace Geom
 #if (RBTREE_VERS==1)
   
   //#define RBTREE_BASE_TRAVERSABLE
-  #define RBT_TEMPLATE template<typename TKey,typename TValue,typename TComp,typename Traits>
-  #define RBT_TYPE RBTree<TKey,TValue,TComp,Traits>
+  #define RBT_TEMPLATE template<typename TKey,typename TValue,typename TComp,typename Traits,template<typename> class TAlloc>
+  #define RBT_TYPE RBTree<TKey,TValue,TComp,Traits,TAlloc>
 
   // forward declaration — definition comes below Enables DefaultValueTraits<int>; instead of DefaultValueTraits<int,void>. 
   //todo: Except that is doesn't seem to work!
@@ -68,11 +69,16 @@ namespace Geom
     static const key_type&  Key(const value_type& value) {return value;}
   };
 
+  //Tag for the constructors that take input already sorted by key (see BuildFromSorted())
+  struct SortedInputTag {};
+  inline constexpr SortedInputTag sorted_input{};
+
   template<
     typename TKey,
     typename TValue,
     typename TComp = std::less<TKey>,
-    typename Traits = DefaultValueTraits<TKey,TValue>
+    typename Traits = DefaultValueTraits<TKey,TValue>,
+    template<typename> class TAlloc = Core::NodePool //node allocator: Core::NodePool or Core::HeapNodeAllocator
   >
   class RBTree
   {
@@ -184,7 +190,7 @@ namespace Geom
     
     private:
       friend class RBTree;
-      template<typename,typename,typename,typename> friend class RBTreeTraversable;
+      template<typename,typename,typename,typename,template<typename> class> friend class RBTreeTraversable;
       Iterator(RBNode* node, RBNode* nil) : m_node{node}, m_nil{nil} {}
       RBNode* m_node = nullptr;
       RBNode* m_nil = nullptr;
@@ -193,6 +199,7 @@ namespace Geom
   public:
     RBTree(TComp comp = TComp());
     explicit RBTree(const std::vector<value_type>& elements, TComp comp = TComp());
+    RBTree(SortedInputTag, const std::vector<value_type>& sorted_elements, TComp comp = TComp());
     
     RBTree(const RBTree& other);
     RBTree(RBTree&& other) noexcept;
@@ -209,6 +216,9 @@ namespace Geom
     // Iterator Erase(Iterator pos);
 
     void Clear();
+    //Replaces the contents in O(n) from elements sorted by key. Builds a balanced tree directly (no rotations). 
+    //Equivalent keys are dropped after the first, as with repeated Insert()
+    void BuildFromSorted(const std::vector<value_type>& sorted_elements);
     bool Contains(const key_type& key) const;
     uint32_t Size() const;
     bool Empty() const;
@@ -238,6 +248,7 @@ namespace Geom
   protected:
     void InitSentinal();
     RBNode* CreateNode(const value_type& element, RBNode* parent);
+    RBNode* BuildBalanced(const value_type* elements, int32_t lo, int32_t hi, RBNode* parent, uint32_t depth, uint32_t red_depth);
     void DestroyNode(RBNode* node);
     bool IsLeaf(RBNode* n) const;
     bool IsLeftChild(RBNode* node) const;
@@ -286,6 +297,7 @@ namespace Geom
     RBNode* m_nil = nullptr;
     uint32_t m_node_count = 0;
     comparator_type m_comp;
+    TAlloc<RBNode> m_node_alloc;
   };
 
   RBT_TEMPLATE
@@ -302,6 +314,13 @@ namespace Geom
       Insert(e);
   }
 
+  RBT_TEMPLATE
+  RBT_TYPE::RBTree(SortedInputTag, const std::vector<value_type>& sorted_elements, TComp comp) : m_comp(comp)
+  {
+    InitSentinal();
+    BuildFromSorted(sorted_elements);
+  }
+
   RBT_TEMPLATE
   RBT_TYPE::RBTree(const RBTree& other)
   {
@@ -320,6 +339,7 @@ namespace Geom
     m_root = other.m_root;
     m_nil = other.m_nil;
     m_node_count = other.m_node_count;
+    m_node_alloc = std::move(other.m_node_alloc); //nodes don't move, so m_root/m_nil are still valid
     other.InitSentinal();  //keep the sentinal node in other
   }
 
@@ -338,9 +358,12 @@ namespace Geom
   RBT_TYPE& RBT_TYPE::operator = (RBTree&& other) noexcept 
   {
     if(&other != this) {
+      Clear();
+      m_node_alloc.Destroy(m_nil);
       m_root = other.m_root;
       m_nil = other.m_nil;
       m_node_count = other.m_node_count;
+      m_node_alloc = std::move(other.m_node_alloc);
       other.InitSentinal();  //keep the sentinal node in other
     }
     return *this;
@@ -350,7 +373,7 @@ namespace Geom
   RBT_TYPE::~RBTree()
   {
     Clear();
-    delete m_nil;
+    m_node_alloc.Destroy(m_nil);
     m_nil = m_root = nullptr;
   }
 
@@ -387,18 +410,20 @@ namespace Geom
 
       if(Less(Key(element),Key(cur->value))) {
         if(cur->left == m_nil) {
-          cur->left = CreateNode(element, cur);
-          InsertFixup(cur->left);
-          return Iterator(cur->left,m_nil);
+          RBNode* node = CreateNode(element, cur);
+          cur->left = node;
+          InsertFixup(node); //can rotate cur, so cur->left isn't necessarily node after this
+          return Iterator(node,m_nil);
         } else {
           cur = cur->left;
         }
       }
       else {
         if(cur->right ==  m_nil) {
-          cur->right = CreateNode(element, cur);
-          InsertFixup(cur->right);
-          return Iterator(cur->right,m_nil);
+          RBNode* node = CreateNode(element, cur);
+          cur->right = node;
+          InsertFixup(node); //can rotate cur, so cur->right isn't necessarily node after this
+          return Iterator(node,m_nil);
         } else {
           cur = cur->right;
         }
@@ -427,6 +452,53 @@ namespace Geom
     m_root = m_nil;  
   }
 
+  RBT_TEMPLATE
+  void RBT_TYPE::BuildFromSorted(const std::vector<value_type>& sorted_elements)
+  {
+    Clear();
+    if(sorted_elements.empty())
+      return;
+
+    const value_type* elements = sorted_elements.data();
+    std::vector<value_type> unique_elements;
+    for(size_t i = 1; i < sorted_elements.size(); ++i) {
+      SPG_ASSERT(!Less(Key(sorted_elements[i]), Key(sorted_elements[i-1])));
+      if(Equal(Key(sorted_elements[i]), Key(sorted_elements[i-1]))) {
+        //Only copy when there are duplicates to remove
+        unique_elements.reserve(sorted_elements.size());
+        unique_elements.push_back(sorted_elements[0]);
+        for(size_t j = 1; j < sorted_elements.size(); ++j) {
+          if(!Equal(Key(sorted_elements[j]), Key(unique_elements.back())))
+            unique_elements.push_back(sorted_elements[j]);
+        }
+        elements = unique_elements.data();
+        break;
+      }
+    }
+    const int32_t n = (elements == sorted_elements.data()) ? (int32_t)sorted_elements.size() : (int32_t)unique_elements.size();
+    m_node_alloc.Reserve(n);
+
+    //Splitting at the middle fills every level except maybe the deepest. All nodes above it are black and the 
+    //nodes on it are red, so every path has the same black height and no red node has a red child
+    uint32_t red_depth = 0;
+    while((2u << red_depth) <= (uint32_t)n)
+      red_depth++;
+    m_root = BuildBalanced(elements, 0, n-1, m_nil, 0, red_depth);
+  }
+
+  RBT_TEMPLATE
+  RBT_TYPE::RBNode* RBT_TYPE::BuildBalanced(const value_type* elements, int32_t lo, int32_t hi, RBNode* parent, uint32_t depth, uint32_t red_depth)
+  {
+    if(lo > hi)
+      return m_nil;
+    const int32_t mid = lo + (hi - lo)/2;
+    RBNode* node = CreateNode(elements[mid], parent);
+    node->colour = (depth == red_depth && depth > 0) ? Colour::Red : Colour::Black;
+    node->left = BuildBalanced(elements, lo, mid-1, node, depth+1, red_depth);
+    node->right = BuildBalanced(elements, mid+1, hi, node, depth+1, red_depth);
+    return node;
+  }
+
   RBT_TEMPLATE
   bool RBT_TYPE::Contains(const key_type& key) const
   {
@@ -635,7 +707,7 @@ namespace Geom
   {
     m_nil = m_root = nullptr;
     m_node_count = 0;
-    m_nil = new RBNode();
+    m_nil = m_node_alloc.Create();
     m_nil->parent = m_nil->left=m_nil->right = m_nil;
     m_nil->colour = RBTree::Colour::Black;
     m_root = m_nil;  
@@ -644,7 +716,7 @@ namespace Geom
   RBT_TEMPLATE
   RBT_TYPE::RBNode* RBT_TYPE::CreateNode(const value_type& element, RBNode* parent)
   {
-    RBNode* node = new RBNode(element);
+    RBNode* node = m_node_alloc.Create(element);
     node->parent = parent;
     node->left = node->right = m_nil;
     m_node_count++;
@@ -657,8 +729,7 @@ namespace Geom
     SPG_ASSERT(node != nullptr);
     SPG_ASSERT(node != m_nil);
     m_node_count--;
-    delete node;
-    node = nullptr;
+    m_node_alloc.Destroy(node);
   }
 
   RBT_TEMPLATE
@@ -862,8 +933,8 @@ namespace Geom
         if(cur->left == m_nil) {
           node->parent = cur;
           cur->left = node;
-          InsertFixup(cur->left);
-          return Iterator(cur->left,m_nil);
+          InsertFixup(node);
+          return Iterator(node,m_nil);
         } else {
           cur = cur->left;
         }
@@ -872,8 +943,8 @@ namespace Geom
         if(cur->right ==  m_nil) {
           node->parent = cur;
           cur->right = node;
-          InsertFixup(cur->right);
-          return Iterator(cur->right,m_nil);
+          InsertFixup(node);
+          return Iterator(node,m_nil);
         } else {
           cur = cur->right;
         }
@@ -1258,10 +1329,24 @@ auto GetPointer(Iterator itr)
       using Base::Base;
     };
 
+    //Order statistic augmentation: any node type with a subtree_size member gets it maintained through inserts, 
+    //erases and rotations, and enables Rank(), Select() and CountRange() in O(log n)
+    template<typename TNode>
+    concept OrderStatisticNode = requires(TNode node) { { node.subtree_size } -> std::convertible_to<std::size_t>; };
+
+    template<typename TValue>
+    struct OrderStatisticRBNode : RBNodeBase<OrderStatisticRBNode<TValue>,TValue>
+    {
+      using Base = RBNodeBase<OrderStatisticRBNode<TValue>, TValue>;
+      using Base::Base;
+      std::size_t subtree_size = 0; //0 for the nil sentinal
+    };
+
     template<
       typename TValue, 
       typename TComp = std::less<TValue>,
-      typename TNode = void
+      typename TNode = void,
+      template<typename> class TAlloc = Core::NodePool //node allocator: Core::NodePool or Core::HeapNodeAllocator
     >
     class RBTree
     {
@@ -1412,6 +1497,7 @@ auto GetPointer(Iterator itr)
         m_root = other.m_root;
         m_nil = other.m_nil;
         m_node_count = other.m_node_count;
+        m_node_alloc = std::move(other.m_node_alloc); //nodes don't move, so m_root/m_nil are still valid
         other.Initialise(); //Destructor crashes withouth this!
       }
 
@@ -1426,9 +1512,12 @@ auto GetPointer(Iterator itr)
 
       RBTree& operator = (RBTree&& other) noexcept {
         if(&other != this) {
+          Clear();
+          DeallocateNode(m_nil);
           m_root = other.m_root;
           m_nil = other.m_nil;
           m_node_count = other.m_node_count;
+          m_node_alloc = std::move(other.m_node_alloc);
           other.Initialise(); //Destructor crashes withouth this!
         }
         return *this;
@@ -1436,13 +1525,14 @@ auto GetPointer(Iterator itr)
 
       ~RBTree() {
         Clear();
-        delete m_nil;
+        DeallocateNode(m_nil);
         m_nil = m_root = nullptr;
       }
 
       Iterator Insert(const value_type& element) {
         if(m_root == m_nil) {
           m_root = MakeNode(element, m_nil);
+          IncrementSizesToRoot(m_root);
           InsertFixup(m_root); 
           m_node_count++;
           return Iterator(m_root,m_nil);
@@ -1456,20 +1546,24 @@ auto GetPointer(Iterator itr)
 
           if(Less(Key(element),Key(cur->value))) {
             if(cur->left == m_nil) {
-              cur->left = MakeNode(element, cur);
-              InsertFixup(cur->left);
+              node_type* node = MakeNode(element, cur);
+              cur->left = node;
+              IncrementSizesToRoot(node);
+              InsertFixup(node); //can rotate cur, so cur->left isn't necessarily node after this
               m_node_count++;
-              return Iterator(cur->left,m_nil);
+              return Iterator(node,m_nil);
             } else {
               cur = cur->left;
             }
           }
           else {
             if(cur->right ==  m_nil) {
-              cur->right = MakeNode(element, cur);
-              InsertFixup(cur->right);
+              node_type* node = MakeNode(element, cur);
+              cur->right = node;
+              IncrementSizesToRoot(node);
+              InsertFixup(node); //can rotate cur, so cur->right isn't necessarily node after this
               m_node_count++;
-              return Iterator(cur->right,m_nil);
+              return Iterator(node,m_nil);
             } else {
               cur = cur->right;
             }
@@ -1482,6 +1576,7 @@ auto GetPointer(Iterator itr)
         if(m_root == m_nil) {
           m_root = node;
           m_root->parent = m_nil;
+          IncrementSizesToRoot(m_root);
 
           InsertFixup(m_root); 
           m_node_count++;
@@ -1498,10 +1593,11 @@ auto GetPointer(Iterator itr)
             if(cur->left == m_nil) {
               cur->left = node;
               node->parent = cur;
+              IncrementSizesToRoot(node);
 
-              InsertFixup(cur->left);
+              InsertFixup(node);
               m_node_count++;
-              return Iterator(cur->left,m_nil);
+              return Iterator(node,m_nil);
             } else {
               cur = cur->left;
             }
@@ -1510,10 +1606,11 @@ auto GetPointer(Iterator itr)
             if(cur->right ==  m_nil) {
               cur->right = node;
               node->parent = cur;
+              IncrementSizesToRoot(node);
 
-              InsertFixup(cur->right);
+              InsertFixup(node);
               m_node_count++;
-              return Iterator(cur->right,m_nil);
+              return Iterator(node,m_nil);
             } else {
               cur = cur->right;
             }
@@ -1618,6 +1715,57 @@ auto GetPointer(Iterator itr)
         return Iterator(candidate_node, m_nil);
       }
 
+      //Order statistics (node_type must have subtree_size, e.g. OrderStatisticRBNode)
+      std::size_t Rank(const key_type& key) const requires OrderStatisticNode<node_type> {
+        //Number of elements strictly less than key
+        std::size_t rank = 0;
+        node_type* node = m_root;
+        while(node != m_nil) {
+          if(Less(Key(node->value), key)) {
+            rank += node->left->subtree_size + 1;
+            node = node->right;
+          }
+          else
+            node = node->left;
+        }
+        return rank;
+      }
+
+      Iterator Select(std::size_t k) const requires OrderStatisticNode<node_type> {
+        //k'th smallest element (k = 0 is the min), end() if k >= Size()
+        if(k >= m_node_count)
+          return end();
+        node_type* node = m_root;
+        while(true) {
+          const std::size_t left_size = node->left->subtree_size;
+          if(k < left_size)
+            node = node->left;
+          else if(k == left_size)
+            return Iterator(node, m_nil);
+          else {
+            k -= left_size + 1;
+            node = node->right;
+          }
+        }
+      }
+
+      std::size_t CountRange(const key_type& key_low, const key_type& key_high) const requires OrderStatisticNode<node_type> {
+        //Number of elements in [key_low, key_high]
+        if(Less(key_high, key_low))
+          return 0;
+        std::size_t count_less_equal = 0; //elements <= key_high
+        node_type* node = m_root;
+        while(node != m_nil) {
+          if(!Less(key_high, Key(node->value))) {
+            count_less_equal += node->left->subtree_size + 1;
+            node = node->right;
+          }
+          else
+            node = node->left;
+        }
+        return count_less_equal - Rank(key_low);
+      }
+
 #endif
       
 // *Protected data
@@ -1627,6 +1775,7 @@ auto GetPointer(Iterator itr)
       node_type* m_nil = nullptr;
       std::size_t m_node_count = 0;
       TComp m_comp;  
+      TAlloc<node_type> m_node_alloc;
 #endif
       
 // *Protected functions
@@ -1642,20 +1791,19 @@ auto GetPointer(Iterator itr)
       }
 
       node_type* AllocateNode() {
-        node_type* node = new node_type();
+        node_type* node = m_node_alloc.Create();
         SPG_ASSERT(node != nullptr);
         return node;
       }
 
       node_type* AllocateNode(value_type const& v) {
-        node_type* node = new node_type(v);
+        node_type* node = m_node_alloc.Create(v);
         SPG_ASSERT(node != nullptr);
         return node;
       }
 
       void DeallocateNode(node_type* node) {
-        delete node;
-        node = nullptr;
+        m_node_alloc.Destroy(node);
       }
 
       node_type* MakeNode(value_type const& v, node_type* parent) {
@@ -1666,6 +1814,27 @@ auto GetPointer(Iterator itr)
         return node;
       }
 
+      //Order statistic maintenance - these compile to nothing unless node_type has subtree_size
+      void IncrementSizesToRoot(node_type* node) {
+        if constexpr (OrderStatisticNode<node_type>) {
+          node->subtree_size = 1;
+          for(node_type* p = node->parent; p != m_nil; p = p->parent)
+            p->subtree_size++;
+        }
+      }
+
+      void DecrementSizesToRoot(node_type* node) {
+        if constexpr (OrderStatisticNode<node_type>) {
+          for(node_type* p = node->parent; p != m_nil; p = p->parent)
+            p->subtree_size--;
+        }
+      }
+
+      void UpdateSize(node_type* node) {
+        if constexpr (OrderStatisticNode<node_type>)
+          node->subtree_size = node->left->subtree_size + node->right->subtree_size + 1;
+      }
+
       bool Equal(const key_type& k1, const key_type& k2) const { 
         return !m_comp(k1,k2) && !m_comp(k2,k1);
       }
@@ -1794,6 +1963,8 @@ auto GetPointer(Iterator itr)
 
         y->left = node; 
         node->parent = y;
+        UpdateSize(node);
+        UpdateSize(y);
       }
 
       void RotateRight(node_type* node) {
@@ -1815,6 +1986,8 @@ auto GetPointer(Iterator itr)
 
         y->right = node;
         node->parent = y;
+        UpdateSize(node);
+        UpdateSize(y);
       }
 
       void InOrderTraverse(node_type* node, std::vector<value_type>& values_out) const {
@@ -1829,12 +2002,17 @@ auto GetPointer(Iterator itr)
         SPG_ASSERT(node != nullptr);
         if(node == m_nil)
           return;
-        if(NumChildren(node) < 2) 
+        if(NumChildren(node) < 2) {
+          DecrementSizesToRoot(node);
           SpliceOut(node);
+        }
         else {  
           node_type* successor = Min(node->right);
+          DecrementSizesToRoot(successor);
           SpliceOut(successor);
           Replace(node,successor);
+          if constexpr (OrderStatisticNode<node_type>)
+            successor->subtree_size = node->subtree_size;
         } 
         DeallocateNode(node);
         m_node_count--;
@@ -1864,10 +2042,17 @@ auto GetPointer(Iterator itr)
             m_nil->parent = r; //temporatily set parent of m_nil to r so that its correct parent can be accessed
         }  
 
+        //r is moved up into node's place, so the subtree sizes drop along the path from r's old position
+        DecrementSizesToRoot((r != m_nil) ? r : node);
+
         if(r != m_nil)
           SpliceOut(r); 
 
         Replace(node,r); 
+        if constexpr (OrderStatisticNode<node_type>) {
+          if(r != m_nil)
+            r->subtree_size = node->subtree_size;
+        }
 
         if( (node->colour == Colour::Red) && ((r == m_nil) || (r->colour == Colour::Red)) ) {
           //nothing to do!
@@ -2119,6 +2304,8 @@ auto GetPointer(Iterator itr)
         if(node->right != m_nil) {
           SPG_ASSERT(Less(Key(node->value),Key(node->right->value)));  
         }
+        if constexpr (OrderStatisticNode<node_type>)
+          SPG_ASSERT(node->subtree_size == node->left->subtree_size + node->right->subtree_size + 1);
   
         node_count++;  
         black_depth += (node->colour == RBTree::Colour::Black) ? 1 : 0;
@@ -2162,6 +2349,9 @@ auto GetPointer(Iterator itr)
 // *Free functions for Iterator
 #if 1
 
+    template<typename TValue, typename TComp = std::less<TValue>, template<typename> class TAlloc = Core::NodePool>
+    using OrderStatisticRBTree = RBTree<TValue, TComp, OrderStatisticRBNode<TValue>, TAlloc>;
+
     template <typename T_Itr>
     T_Itr Next(T_Itr itr, std::ptrdiff_t n = 1 ) {
       while (n-- >0) ++itr;
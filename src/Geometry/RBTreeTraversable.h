@@ -9,11 +9,12 @@ namespace Geom
     typename TKey,
     typename TVal,
     typename TComp = std::less<TKey>,
-    typename Traits = DefaultValueTraits<TKey,TVal>
+    typename Traits = DefaultValueTraits<TKey,TVal>,
+    template<typename> class TAlloc = Core::NodePool
   >
-  class RBTreeTraversable : public RBTree<TKey,TVal,TComp,Traits>
+  class RBTreeTraversable : public RBTree<TKey,TVal,TComp,Traits,TAlloc>
   {
-    using Base = RBTree<TKey,TVal,TComp,Traits>;
+    using Base = RBTree<TKey,TVal,TComp,Traits,TAlloc>;
     using RBNode = typename Base::RBNode;
     using key_type =  typename Base::key_type;
     using value_type = typename Base::value_type;
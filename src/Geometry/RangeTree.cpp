@@ -1,5 +1,6 @@
 #include "Geometry/RangeTree.h"
 #include "Geometry/RBTree.h"
+#include "Geometry/KDTree.h"
 
 #include "MathLib/Geom/Geom.h"
 
@@ -10,6 +11,19 @@ namespace Geom
 // RangeTree1D
 //-------------------------------------------------------------------------------
 
+  RangeTree1D::RangeTree1D(const std::vector<float>& points)
+  {
+    auto sorted_points = points;
+    std::sort(sorted_points.begin(), sorted_points.end());
+    m_tree.BuildFromSorted(sorted_points);
+  }
+
+  RangeTree1D::RangeTree1D(std::vector<float>&& points) noexcept
+  {
+    std::sort(points.begin(), points.end());
+    m_tree.BuildFromSorted(points);
+  }
+
   std::vector<float> RangeTree1D::RangeSearch(const Range& range)
   {
     std::vector<float> vals_out;
@@ -96,13 +110,14 @@ namespace Geom
 
   RangeTree2D::Node* RangeTree2D::BuildTree(std::vector<SpgMth::Point2d> points)
   {
+    //Each node's y_sorted is merged from its children's in linear time => O(n log n) overall
     uint32_t num_points = points.size();
     SPG_ASSERT(num_points > 0);
     if(num_points == 1) {
       Node* node = new Node();
       node->is_leaf = true;
       node->point = points[0];
-      node->secondary_tree = SecondaryTree(points);
+      node->y_sorted = std::move(points);
       return node;
     }
 
@@ -121,13 +136,16 @@ namespace Geom
     Node* node = new Node();
     node->is_leaf = false;
     node->x_val = split_value;
-    node->secondary_tree = SecondaryTree(points);
     node->left = BuildTree(std::move(first_half));
     node->right = BuildTree(std::move(second_half));
+    const auto& left_y_sorted = node->left->y_sorted;
+    const auto& right_y_sorted = node->right->y_sorted;
+    node->y_sorted.resize(num_points);
+    std::merge(left_y_sorted.begin(), left_y_sorted.end(), right_y_sorted.begin(), right_y_sorted.end(), node->y_sorted.begin(), CompY{});
     return node;
   }
 
-  RangeTree2D::Node* RangeTree2D::FindSplitNode(float x_low, float x_high)
+  RangeTree2D::Node* RangeTree2D::FindSplitNode(float x_low, float x_high) const
   {
     //Todo either return nullptr if low < high or swap the value
     SPG_ASSERT(x_low < x_high);
@@ -142,75 +160,104 @@ namespace Geom
     return node;
   }
 
-  std::vector<SpgMth::Point2d> RangeTree2D::RangeQueryY(SecondaryTree& tree, const Range& range)
+  template<typename TPointFn>
+  void RangeTree2D::RangeQueryY(const Node* node, const Range& range, TPointFn& on_point) const
   {
-    //Only the y-coord in Point2d is used (secondary tree ordered on y coord), but key needs to be Point2d
-    auto itr_split = tree.FindSplitPos(SpgMth::Point2d{range.x_min,range.y_min}, SpgMth::Point2d{range.x_max,range.y_max} );
-    std::vector<SpgMth::Point2d> points_out;
-    if(itr_split == tree.end())
-      return points_out;
-    SeachSubTreeSecondary(tree, itr_split, range, points_out);
-    return points_out;
+    //Only called for canonical subtrees, so x is already in range
+    const auto& y_sorted = node->y_sorted;
+    auto itr = std::lower_bound(y_sorted.begin(), y_sorted.end(), SpgMth::Point2d{0, range.y_min}, CompY{});
+    for(; (itr != y_sorted.end()) && (itr->y < range.y_max); ++itr)
+      on_point(*itr);
   }
 
-  void RangeTree2D::SeachSubTreeSecondary(SecondaryTree& tree,Iterator itr , const Range& range,std::vector<SpgMth::Point2d>& points_out)
+  //Walks the paths to the x-range ends. on_point(p) is called for the leaves at the path ends that are in range, 
+  //on_canonical(node) for the canonical subtrees (those with x fully inside the range) - still need y checking.
+  template<typename TPointFn, typename TCanonicalFn>
+  void RangeTree2D::QueryCanonical(const Range& range, TPointFn& on_point, TCanonicalFn& on_canonical) const
   {
-    if(itr == tree.end())
+    //Range is half open, so nothing can be in it if x_min >= x_max (and FindSplitNode(),FindSplitPos() assert on it)
+    if(m_root == nullptr || !(range.x_min < range.x_max) || !(range.y_min < range.y_max))
       return;
-    const auto& point = *itr;  
-    if((point.y > range.y_min) && (tree.LeftChild(itr) != tree.end()))
-      SeachSubTreeSecondary(tree, tree.LeftChild(itr), range, points_out);
-    if(PointInRange(point, range))
-      points_out.push_back(point);
-    if((point.y < range.y_max) && (tree.RightChild(itr) != tree.end()) )
-      SeachSubTreeSecondary(tree, tree.RightChild(itr), range, points_out);
-  }
-  
-  std::vector<SpgMth::Point2d> RangeTree2D::RangeQuery(const Range& range)
-  {
-    std::vector<SpgMth::Point2d> points;
     Node* split_node = FindSplitNode(range.x_min, range.x_max);
     if(split_node == nullptr)
-      return points;
+      return;
     
     if(split_node->is_leaf) {
       if(PointInRange(split_node->point, range))
-        points.push_back(split_node->point);
-      return points;  
+        on_point(split_node->point);
+      return;  
     }
 
     Node* node = split_node->left;
     while (!node->is_leaf) {
       if(range.x_min <= node->x_val) {
         SPG_ASSERT(node->right != nullptr);
-        auto points_in_range = RangeQueryY(node->right->secondary_tree,range);
-        points.insert(points.end(), points_in_range.begin(), points_in_range.end());
+        on_canonical(node->right);
         node=node->left;
       }
       else
         node = node->right;
     }
     if(PointInRange(node->point, range))
-      points.push_back(node->point);
+      on_point(node->point);
 
     node = split_node->right;
     while (!node->is_leaf) {
       if(range.x_max > node->x_val) {
         SPG_ASSERT(node->left != nullptr);
-        auto points_in_range = RangeQueryY(node->left->secondary_tree,range);
-        points.insert(points.end(), points_in_range.begin(), points_in_range.end());
+        on_canonical(node->left);
         node=node->right;
       }
       else
         node = node->left;
     }
     if(PointInRange(node->point, range))
-      points.push_back(node->point);
-    
+      on_point(node->point);
+  }
+
+  std::vector<SpgMth::Point2d> RangeTree2D::RangeQuery(const Range& range) const
+  {
+    std::vector<SpgMth::Point2d> points;
+    RangeQuery(range, points);
     return points;
   }
 
-  bool RangeTree2D::PointInRange(SpgMth::Point2d p, const Range& range)
+  void RangeTree2D::RangeQuery(const Range& range, std::vector<SpgMth::Point2d>& points) const
+  {
+    auto on_point = [&points](const SpgMth::Point2d& p) { points.push_back(p); };
+    auto on_canonical = [&](Node* node) { RangeQueryY(node, range, on_point); };
+    QueryCanonical(range, on_point, on_canonical);
+  }
+
+  void RangeTree2D::RangeQuery(const Range& range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const
+  {
+    auto on_point = [&visitor](const SpgMth::Point2d& p) { visitor(p); };
+    auto on_canonical = [&](Node* node) { RangeQueryY(node, range, on_point); };
+    QueryCanonical(range, on_point, on_canonical);
+  }
+
+  uint32_t RangeTree2D::RangeCount(const Range& range) const
+  {
+    //Canonical subtrees have x fully inside the range, so their count is the number of y values in [y_min, y_max) -
+    //two binary searches. O(log n) canonical subtrees => O(log^2 n) whatever the number of points in range
+    uint32_t count = 0;
+    auto on_point = [&count](const SpgMth::Point2d&) { count++; };
+    auto on_canonical = [&](Node* node) { 
+      const auto& y_sorted = node->y_sorted;
+      auto lower = std::lower_bound(y_sorted.begin(), y_sorted.end(), SpgMth::Point2d{0, range.y_min}, CompY{});
+      auto upper = std::lower_bound(lower, y_sorted.end(), SpgMth::Point2d{0, range.y_max}, CompY{});
+      count += (uint32_t)(upper - lower);
+    };
+    QueryCanonical(range, on_point, on_canonical);
+    return count;
+  }
+
+  void RangeTree2D::RangeQueryBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool) const
+  {
+    RunBatchQuery(ranges, [this](const Range& range, std::vector<SpgMth::Point2d>& out) { RangeQuery(range, out); }, result, pool);
+  }
+
+  bool RangeTree2D::PointInRange(SpgMth::Point2d p, const Range& range) const
   {
     //Todo - make sure the inequalities match intended semantics (inclusive ve exclusive bounds).  x<x_max (exclusive upper bound) x >= x_min (inclusive upper bound)
     if(!(p.x < range.x_max))
@@ -305,13 +352,13 @@ namespace Geom
     ReportSubTreeMain(node, points_primary);  
 
     SPG_INFO("Subtree at split-x={},  Subtree vals={}, 2nd Tree Vals={}", 
-      node->x_val, points_primary.size(), node->secondary_tree.Size());
-    for(auto& e : node->secondary_tree) 
-      points_secondary.push_back(e);
+      node->x_val, points_primary.size(), node->y_sorted.size());
+    SPG_ASSERT(std::is_sorted(node->y_sorted.begin(), node->y_sorted.end(), CompY()));
+    points_secondary = node->y_sorted;
 
     SPG_ASSERT(points_primary.size() == points_secondary.size());
-    std::sort(points_primary.begin(), points_primary.end(), CompX()); //already sorted by x-coord anyway!
-    std::sort(points_secondary.begin(), points_secondary.end(), CompX()); //initialliy sorted by y-coord 
+    std::sort(points_primary.begin(), points_primary.end(), Comp()); //already sorted by x-coord anyway!
+    std::sort(points_secondary.begin(), points_secondary.end(), Comp()); //initialliy sorted by y-coord 
     for(auto i=0; i<points_primary.size(); ++i ){
       SPG_TRACE("{}: P:{} S:{}",i+1, points_primary[i], points_secondary[i]);
       SPG_ASSERT(SpgMth::Equal(points_primary[i], points_secondary[i]));
@@ -368,5 +415,303 @@ namespace Geom
     for(auto i=0; i< points_bf.size(); ++i) 
       SPG_ASSERT(SpgMth::Equal(points_bf[i], points_in_range[i]));
     SPG_WARN("Comparison check out!");
+
+    //Batched queries
+    {
+      std::vector<Range> ranges;
+      for(int i=0; i<10000; i++) {
+        float x = fdist(mt), y = fdist(mt);
+        ranges.push_back(Range{x, x+50, y, y+50});
+      }
+
+      Core::Timer timer;
+      size_t serial_count = 0;
+      for(auto& r : ranges)
+        serial_count += tree.RangeQuery(r).size();
+      SPG_INFO("RangeTree2D {} queries, serial: {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+
+      BatchQueryResult result;
+      timer.Reset();
+      tree.RangeQueryBatch(ranges, result);
+      SPG_INFO("RangeTree2D {} queries, batched: {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+
+      SPG_ASSERT(result.NumQueries() == ranges.size());
+      SPG_ASSERT(result.points.size() == serial_count);
+      for(size_t i=0; i<ranges.size(); i+=100)
+        SPG_ASSERT(result[i].size() == tree.RangeQuery(ranges[i]).size());
+    }
+
+    //Count only and visitor queries
+    {
+      std::vector<Range> ranges;
+      for(int i=0; i<1000; i++) {
+        float x = fdist(mt), y = fdist(mt);
+        ranges.push_back(Range{x, x+200, y, y+200});
+      }
+      Core::Timer timer;
+      size_t total = 0;
+      for(auto& r : ranges)
+        total += tree.RangeQuery(r).size();
+      SPG_INFO("RangeTree2D {} RangeQuery(): {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+      timer.Reset();
+      size_t total_count = 0;
+      for(auto& r : ranges)
+        total_count += tree.RangeCount(r);
+      SPG_INFO("RangeTree2D {} RangeCount(): {:.2f} ms", ranges.size(), timer.ElapsedMillis());
+      size_t total_visited = 0;
+      for(auto& r : ranges)
+        tree.RangeQuery(r, [&total_visited](const SpgMth::Point2d&) { total_visited++; });
+      SPG_ASSERT(total == total_count);
+      SPG_ASSERT(total == total_visited);
+    }
+  }
+
+//-------------------------------------------------------------------------------
+// LayeredRangeTree2D
+//-------------------------------------------------------------------------------
+
+  LayeredRangeTree2D::LayeredRangeTree2D(const std::vector<SpgMth::Point2d>& points) : m_x_points(points)
+  {
+    if(m_x_points.empty())
+      return;
+    //x ties broken on y, but queries work on positions in m_x_points (not x values) so duplicates are fine anyway
+    std::sort(m_x_points.begin(), m_x_points.end(), [](SpgMth::Point2d a, SpgMth::Point2d b) {
+      return (a.x < b.x) || ((a.x == b.x) && (a.y < b.y));
+    });
+
+    //Every level of the tree holds all n points in its y-arrays
+    const uint32_t num_points = m_x_points.size();
+    uint32_t num_levels = 1;
+    for(uint32_t m = num_points; m > 1; m = (m+1)/2)
+      num_levels++;
+    m_nodes.reserve(2*num_points - 1);
+    m_y_points.reserve(num_points * num_levels);
+    m_bridge_left.reserve((num_points+1) * num_levels);
+    m_bridge_right.reserve((num_points+1) * num_levels);
+    BuildTree(0, num_points);
+  }
+
+  uint32_t LayeredRangeTree2D::BuildTree(uint32_t lo, uint32_t hi)
+  {
+    const uint32_t node_idx = m_nodes.size();
+    m_nodes.push_back(Node{lo, hi});
+    if(hi - lo == 1) {
+      m_nodes[node_idx].y_offset = m_y_points.size();
+      m_y_points.push_back(m_x_points[lo]);
+      return node_idx;
+    }
+
+    const uint32_t mid = lo + (hi - lo + 1)/2; //left gets the extra point, as in RangeTree2D
+    BuildTree(lo, mid);
+    const uint32_t right_idx = BuildTree(mid, hi);
+    const Node left = m_nodes[node_idx+1];
+    const Node right = m_nodes[right_idx];
+
+    const uint32_t size = hi - lo;
+    const uint32_t y_offset = m_y_points.size();
+    const uint32_t bridge_offset = m_bridge_left.size();
+    m_y_points.resize(y_offset + size);
+    m_bridge_left.resize(bridge_offset + size + 1);
+    m_bridge_right.resize(bridge_offset + size + 1);
+
+    //Merge the children's y-arrays. The bridge for element i is the lower bound of its y in each child array, which 
+    //is just how many of that child's elements are already merged - except for equal y, where it's the same as 
+    //for the first element with that y.
+    uint32_t il = left.y_offset, il_end = left.y_offset + (mid - lo);
+    uint32_t ir = right.y_offset, ir_end = right.y_offset + (hi - mid);
+    for(uint32_t i = 0; i < size; ++i) {
+      const bool take_left = (ir == ir_end) || ((il < il_end) && !(m_y_points[ir].y < m_y_points[il].y));
+      const SpgMth::Point2d p = take_left ? m_y_points[il] : m_y_points[ir];
+      if(i > 0 && m_y_points[y_offset + i - 1].y == p.y) {
+        m_bridge_left[bridge_offset + i] = m_bridge_left[bridge_offset + i - 1];
+        m_bridge_right[bridge_offset + i] = m_bridge_right[bridge_offset + i - 1];
+      }
+      else {
+        m_bridge_left[bridge_offset + i] = il - left.y_offset;
+        m_bridge_right[bridge_offset + i] = ir - right.y_offset;
+      }
+      m_y_points[y_offset + i] = p;
+      if(take_left) il++; else ir++;
+    }
+    m_bridge_left[bridge_offset + size] = mid - lo;
+    m_bridge_right[bridge_offset + size] = hi - mid;
+
+    m_nodes[node_idx].y_offset = y_offset;
+    m_nodes[node_idx].bridge_offset = bridge_offset;
+    m_nodes[node_idx].right = right_idx;
+    return node_idx;
+  }
+
+  //on_span(first, last) is called with the in-range points of each canonical node, [first,last) in its y-array
+  template<typename TSpanFn>
+  void LayeredRangeTree2D::Query(const Range& range, TSpanFn& on_span) const
+  {
+    if(m_nodes.empty() || !(range.x_min < range.x_max) || !(range.y_min < range.y_max))
+      return;
+
+    //x range => span [r_lo,r_hi) of m_x_points
+    auto x_less = [](const SpgMth::Point2d& p, float x) { return p.x < x; };
+    const uint32_t r_lo = std::lower_bound(m_x_points.begin(), m_x_points.end(), range.x_min, x_less) - m_x_points.begin();
+    const uint32_t r_hi = std::lower_bound(m_x_points.begin(), m_x_points.end(), range.x_max, x_less) - m_x_points.begin();
+    if(r_lo >= r_hi)
+      return;
+
+    //The only binary searches on y - everything below the root follows the bridges
+    auto y_less = [](const SpgMth::Point2d& p, float y) { return p.y < y; };
+    auto root_first = m_y_points.begin() + m_nodes[0].y_offset;
+    auto root_last = root_first + m_x_points.size();
+    const uint32_t pos_lo = std::lower_bound(root_first, root_last, range.y_min, y_less) - root_first;
+    const uint32_t pos_hi = std::lower_bound(root_first, root_last, range.y_max, y_less) - root_first;
+    QueryNode(0, r_lo, r_hi, pos_lo, pos_hi, on_span);
+  }
+
+  template<typename TSpanFn>
+  void LayeredRangeTree2D::QueryNode(uint32_t node_idx, uint32_t r_lo, uint32_t r_hi, uint32_t pos_lo, uint32_t pos_hi, TSpanFn& on_span) const
+  {
+    if(pos_lo >= pos_hi)
+      return;
+    const Node& node = m_nodes[node_idx];
+    if(node.hi <= r_lo || node.lo >= r_hi)
+      return;
+    if(r_lo <= node.lo && node.hi <= r_hi) {
+      const SpgMth::Point2d* first = m_y_points.data() + node.y_offset;
+      on_span(first + pos_lo, first + pos_hi);
+      return;
+    }
+    //Partial overlap, so can't be a leaf
+    const uint32_t b = node.bridge_offset;
+    QueryNode(node_idx+1, r_lo, r_hi, m_bridge_left[b + pos_lo], m_bridge_left[b + pos_hi], on_span);
+    QueryNode(node.right, r_lo, r_hi, m_bridge_right[b + pos_lo], m_bridge_right[b + pos_hi], on_span);
+  }
+
+  std::vector<SpgMth::Point2d> LayeredRangeTree2D::RangeQuery(const Range& range) const
+  {
+    std::vector<SpgMth::Point2d> points;
+    RangeQuery(range, points);
+    return points;
+  }
+
+  void LayeredRangeTree2D::RangeQuery(const Range& range, std::vector<SpgMth::Point2d>& points_out) const
+  {
+    auto on_span = [&points_out](const SpgMth::Point2d* first, const SpgMth::Point2d* last) { 
+      points_out.insert(points_out.end(), first, last); 
+    };
+    Query(range, on_span);
+  }
+
+  void LayeredRangeTree2D::RangeQuery(const Range& range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const
+  {
+    auto on_span = [&visitor](const SpgMth::Point2d* first, const SpgMth::Point2d* last) { 
+      for(auto p = first; p != last; ++p)
+        visitor(*p);
+    };
+    Query(range, on_span);
+  }
+
+  uint32_t LayeredRangeTree2D::RangeCount(const Range& range) const
+  {
+    uint32_t count = 0;
+    auto on_span = [&count](const SpgMth::Point2d* first, const SpgMth::Point2d* last) { count += (uint32_t)(last - first); };
+    Query(range, on_span);
+    return count;
+  }
+
+  void LayeredRangeTree2D::RangeQueryBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool) const
+  {
+    RunBatchQuery(ranges, [this](const Range& range, std::vector<SpgMth::Point2d>& out) { RangeQuery(range, out); }, result, pool);
+  }
+
+  void LayeredRangeTree2D::Test()
+  {
+    SPG_WARN("-------------------------------------------------------------------------");
+    SPG_WARN("LayeredRangeTree2D - Test");
+    SPG_WARN("-------------------------------------------------------------------------");
+
+    const uint32_t NUM_POINTS = 100000;
+    const uint32_t NUM_QUERIES = 10000;
+    const float MIN_VAL = 0;
+    const float MAX_VAL = 1000;
+    
+    std::random_device rd;                         
+    std::mt19937 mt(rd()); 
+    std::uniform_real_distribution<float> fdist(MIN_VAL, MAX_VAL); 
+
+    //Repeated y values (every 10th point) and repeated points (every 50th) - all three have to report every copy
+    std::vector<SpgMth::Point2d> points;
+    for(uint32_t i=0; i<NUM_POINTS; i++) {
+      SpgMth::Point2d p(fdist(mt),fdist(mt));
+      if((i % 50 == 49))
+        p = points[mt() % i];
+      else if(i % 10 == 9)
+        p.y = points[mt() % i].y;
+      points.push_back(p);
+    }
+
+    std::vector<Range> ranges;
+    std::vector<KDTree2D::Range> kd_ranges;
+    for(uint32_t i=0; i<NUM_QUERIES; i++) {
+      float x = fdist(mt), y = fdist(mt);
+      ranges.push_back(Range{x, x+100, y, y+100});
+      kd_ranges.push_back(KDTree2D::Range{x, x+100, y, y+100});
+    }
+
+    Core::Timer timer;
+    RangeTree2D range_tree(points);
+    const double rt_build = timer.ElapsedMillis();
+    timer.Reset();
+    LayeredRangeTree2D layered_tree(points);
+    const double lrt_build = timer.ElapsedMillis();
+    timer.Reset();
+    KDTree2D kd_tree(points, KDTree2D::Layout::Flat);
+    const double kd_build = timer.ElapsedMillis();
+
+    SPG_INFO("Build, {} points:  RangeTree2D {:.2f} ms, LayeredRangeTree2D {:.2f} ms, KDTree2D(flat) {:.2f} ms", 
+      NUM_POINTS, rt_build, lrt_build, kd_build);
+
+    std::vector<SpgMth::Point2d> out;
+    size_t rt_total = 0, lrt_total = 0, kd_total = 0;
+    timer.Reset();
+    for(auto& r : ranges) {
+      out.clear();
+      range_tree.RangeQuery(r, out);
+      rt_total += out.size();
+    }
+    const double rt_query = timer.ElapsedMillis();
+    timer.Reset();
+    for(auto& r : ranges) {
+      out.clear();
+      layered_tree.RangeQuery(r, out);
+      lrt_total += out.size();
+    }
+    const double lrt_query = timer.ElapsedMillis();
+    timer.Reset();
+    for(auto& r : kd_ranges) {
+      out.clear();
+      kd_tree.RangeSearch(r, out);
+      kd_total += out.size();
+    }
+    const double kd_query = timer.ElapsedMillis();
+    SPG_INFO("{} queries, {} points reported:  RangeTree2D {:.2f} ms, LayeredRangeTree2D {:.2f} ms, KDTree2D(flat) {:.2f} ms", 
+      NUM_QUERIES, lrt_total, rt_query, lrt_query, kd_query);
+    SPG_ASSERT(rt_total == lrt_total);
+    SPG_ASSERT(kd_total == lrt_total);
+
+    size_t rt_count = 0, lrt_count = 0, kd_count = 0;
+    timer.Reset();
+    for(auto& r : ranges)
+      rt_count += range_tree.RangeCount(r);
+    const double rt_count_time = timer.ElapsedMillis();
+    timer.Reset();
+    for(auto& r : ranges)
+      lrt_count += layered_tree.RangeCount(r);
+    const double lrt_count_time = timer.ElapsedMillis();
+    timer.Reset();
+    for(auto& r : kd_ranges)
+      kd_count += kd_tree.RangeCount(r);
+    const double kd_count_time = timer.ElapsedMillis();
+    SPG_INFO("{} counts:  RangeTree2D {:.2f} ms, LayeredRangeTree2D {:.2f} ms, KDTree2D(flat) {:.2f} ms", 
+      NUM_QUERIES, rt_count_time, lrt_count_time, kd_count_time);
+    SPG_ASSERT(rt_count == lrt_count);
+    SPG_ASSERT(kd_count == lrt_count);
   }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "CoreLib/Core.h"
 #include "MathLib/Geom/Geom.h"
+#include "Geometry/BatchQuery.h"
 
 namespace Geom
 {
@@ -26,8 +27,8 @@ namespace Geom
     };
 
     RangeTree1D() = default;
-    RangeTree1D(const std::vector<float>& points) :m_tree(points) {}
-    RangeTree1D(std::vector<float>&& points) noexcept :m_tree(std::move(points)) {}
+    RangeTree1D(const std::vector<float>& points);
+    RangeTree1D(std::vector<float>&& points) noexcept;
     std::vector<float> RangeSearch(const Range& range);
     auto begin() {return m_tree.begin();}
     auto end() {return m_tree.end();}
@@ -68,17 +69,11 @@ namespace Geom
       bool operator () (const SpgMth::Point2d& p1, const SpgMth::Point2d& p2) const {return p1.y < p2.y;}
     };
 
-  #ifdef RBTREE_BASE_TRAVERSABLE
-    using SecondaryTree = Geom::RBTree<Geom::Point2d,void,CompY>;
-  #else
-   using SecondaryTree = Geom::RBTreeTraversable<SpgMth::Point2d,void,CompY>;
-  #endif
-
-    using Iterator = typename SecondaryTree::Iterator;
-
+    //The secondary structure is the subtree's points sorted on y (repeats kept), in an array - reporting is a binary
+    //search then a scan, counting is 2 binary searches
     struct Node
     {
-      SecondaryTree secondary_tree;
+      std::vector<SpgMth::Point2d> y_sorted;
       float x_val = 0;
       Node* left = nullptr;
       Node* right = nullptr;
@@ -99,16 +94,23 @@ namespace Geom
       RangeTree2D() = default;
       RangeTree2D( std::vector<SpgMth::Point2d>& points);
       RangeTree2D(std::vector<SpgMth::Point2d>&& points) noexcept;
-      std::vector<SpgMth::Point2d> RangeQuery(const Range& range);
+      std::vector<SpgMth::Point2d> RangeQuery(const Range& range) const;
+      void RangeQuery(const Range& range, std::vector<SpgMth::Point2d>& points_out) const; //appends to points_out
+      void RangeQuery(const Range& range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const; //no allocation
+      uint32_t RangeCount(const Range& range) const;
+      //Runs all the queries across the pool, results in CSR form (see BatchQueryResult)
+      void RangeQueryBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool = Core::ThreadPool::Default()) const;
      
       static void Test();
 
     private:
       Node* BuildTree(std::vector<SpgMth::Point2d> points);
-      Node* FindSplitNode(float x_low, float x_high);
-      bool PointInRange(SpgMth::Point2d, const Range& range);
-      std::vector<SpgMth::Point2d> RangeQueryY(SecondaryTree& tree, const Range& range);
-      void SeachSubTreeSecondary(SecondaryTree& tree, Iterator itr, const Range& range,std::vector<SpgMth::Point2d>& points_out);
+      Node* FindSplitNode(float x_low, float x_high) const;
+      bool PointInRange(SpgMth::Point2d, const Range& range) const;
+      template<typename TPointFn, typename TCanonicalFn>
+      void QueryCanonical(const Range& range, TPointFn& on_point, TCanonicalFn& on_canonical) const;
+      template<typename TPointFn>
+      void RangeQueryY(const Node* node, const Range& range, TPointFn& on_point) const;
 
       // The following for validation only
       void ReportSubTreeMain(Node* node, std::vector<SpgMth::Point2d>& out_points); 
@@ -117,7 +119,51 @@ namespace Geom
       void ValidateTree(Node* node);
     
     private:
-      Node* m_root;
+      Node* m_root = nullptr;
+  };
+
+  //Static layered range tree with fractional cascading. Same queries as RangeTree2D, but array based: each primary 
+  //node has its points in a y-sorted array, plus bridge indices into its children's arrays so the y-search 
+  //is only done once at the root and then followed down in O(1) per level => O(log n + k) queries.
+  class LayeredRangeTree2D
+  {
+    struct Node
+    {
+      uint32_t lo = 0;            //span [lo,hi) of x-sorted points in this subtree
+      uint32_t hi = 0;
+      uint32_t y_offset = 0;      //start of this node's y-sorted array in m_y_points (size hi-lo)
+      uint32_t bridge_offset = 0; //start of this node's bridges in m_bridge_left/m_bridge_right (size hi-lo+1)
+      uint32_t right = 0;         //left child is node_idx+1 (pre-order)
+    };
+
+  public:
+    using Range = RangeTree2D::Range; //half open, same as RangeTree2D
+
+    LayeredRangeTree2D() = default;
+    LayeredRangeTree2D(const std::vector<SpgMth::Point2d>& points);
+
+    std::vector<SpgMth::Point2d> RangeQuery(const Range& range) const;
+    void RangeQuery(const Range& range, std::vector<SpgMth::Point2d>& points_out) const; //appends to points_out
+    void RangeQuery(const Range& range, Core::FunctionRef<void(const SpgMth::Point2d&)> visitor) const; //no allocation
+    uint32_t RangeCount(const Range& range) const;
+    void RangeQueryBatch(std::span<const Range> ranges, BatchQueryResult& result, Core::ThreadPool& pool = Core::ThreadPool::Default()) const;
+    uint32_t Size() const { return (uint32_t)m_x_points.size(); }
+
+    static void Test();
+
+  private:
+    uint32_t BuildTree(uint32_t lo, uint32_t hi);
+    template<typename TSpanFn>
+    void Query(const Range& range, TSpanFn& on_span) const;
+    template<typename TSpanFn>
+    void QueryNode(uint32_t node_idx, uint32_t r_lo, uint32_t r_hi, uint32_t pos_lo, uint32_t pos_hi, TSpanFn& on_span) const;
+
+  private:
+    std::vector<SpgMth::Point2d> m_x_points;  //sorted on x
+    std::vector<SpgMth::Point2d> m_y_points;  //y-sorted arrays of all the nodes
+    std::vector<uint32_t> m_bridge_left;
+    std::vector<uint32_t> m_bridge_right;
+    std::vector<Node> m_nodes;
   };
 
 }
\ No newline at end of file
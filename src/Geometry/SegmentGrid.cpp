@@ -0,0 +1,47 @@
+#include "Geometry/SegmentGrid.h"
+
+namespace Geom
+{
+  void SegmentGrid2D::Reset(SpgMth::BoundingBox bounds, uint32_t expected_segments)
+  {
+    SPG_ASSERT(bounds.left <= bounds.right && bounds.bottom <= bounds.top);
+    constexpr uint32_t MAX_CELLS_PER_SIDE = 4096;
+    double width = std::max((double)bounds.Width(), 1e-9);
+    double height = std::max((double)bounds.Height(), 1e-9);
+    double cell_size = std::sqrt(width * height / std::max(expected_segments, 1u));
+    cell_size = std::max({cell_size, width / MAX_CELLS_PER_SIDE, height / MAX_CELLS_PER_SIDE});
+
+    m_min_x = bounds.left;
+    m_min_y = bounds.bottom;
+    m_inv_cell_size = 1.0 / cell_size;
+    m_num_x = std::clamp((uint32_t)std::ceil(width / cell_size), 1u, MAX_CELLS_PER_SIDE);
+    m_num_y = std::clamp((uint32_t)std::ceil(height / cell_size), 1u, MAX_CELLS_PER_SIDE);
+    m_cell_first.assign(NumCells(), s_null);
+    m_entries.clear();
+    m_entries.reserve(2 * expected_segments);
+  }
+
+  void SegmentGrid2D::Clear()
+  {
+    m_num_x = m_num_y = 0;
+    m_cell_first.clear();
+    m_entries.clear();
+  }
+
+  bool SegmentGrid2D::Contains(const SpgMth::Point2d& p) const
+  {
+    double x = (p.x - m_min_x) * m_inv_cell_size;
+    double y = (p.y - m_min_y) * m_inv_cell_size;
+    return !Empty() && (x >= 0.0) && (y >= 0.0) && (x <= m_num_x) && (y <= m_num_y);
+  }
+
+  void SegmentGrid2D::Insert(uint32_t id, const SpgMth::Point2d& a, const SpgMth::Point2d& b)
+  {
+    SPG_ASSERT(Contains(a) && Contains(b));
+    ForEachCell(a, b, [&](uint32_t cell) {
+      m_entries.push_back({id, m_cell_first[cell]});
+      m_cell_first[cell] = (uint32_t)m_entries.size() - 1;
+      return false;
+    });
+  }
+}
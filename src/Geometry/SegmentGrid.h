@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "CoreLib/Core.h"
+#include "MathLib/Geom/Geom.h"
+
+namespace Geom
+{
+  //Uniform grid of line segments, for "does anything cross this segment" checks that would otherwise scan every
+  //edge of a polygon. Each segment goes in every cell it passes through (slightly padded, so one passing exactly
+  //through a cell corner isn't missed). A query visits the ids in the cells along the query segment - for a short
+  //segment that's a handful, whatever the total. The grid only stores ids: the caller does the exact test, so it
+  //can filter, and a segment whose geometry has since shrunk (e.g. an edge split or an ear clipped) can be left
+  //where it is - it just costs a wasted test. Insert the new geometry again if it's grown.
+  //
+  //Cells are sized for around 1 segment each on average. That suits segments that are short relative to the extent
+  //(typical polygons and meshes); long ones spread over many cells, crowding them. Everything inserted or queried
+  //must be inside the bounds given to Reset() - check with Contains() and Reset() again if not.
+  class SegmentGrid2D
+  {
+  public:
+    SegmentGrid2D() = default;
+    SegmentGrid2D(SpgMth::BoundingBox bounds, uint32_t expected_segments) { Reset(bounds, expected_segments); }
+
+    void Reset(SpgMth::BoundingBox bounds, uint32_t expected_segments);
+    void Clear();
+    void Insert(uint32_t id, const SpgMth::Point2d& a, const SpgMth::Point2d& b);
+
+    bool Empty() const { return m_cell_first.empty(); }
+    bool Contains(const SpgMth::Point2d& p) const;
+    uint32_t NumCells() const { return m_num_x * m_num_y; }
+    uint32_t NumEntries() const { return (uint32_t)m_entries.size(); }
+
+    //fn(id) for the ids in the cells along a-b, until it returns true. Returns true if it did. An id can come up
+    //more than once (in more than one cell)
+    template<typename TFunc>
+    bool ForEachCandidate(const SpgMth::Point2d& a, const SpgMth::Point2d& b, TFunc fn) const
+    {
+      return ForEachCell(a, b, [&](uint32_t cell) {
+        for(uint32_t entry = m_cell_first[cell]; entry != s_null; entry = m_entries[entry].next) {
+          if(fn(m_entries[entry].id))
+            return true;
+        }
+        return false;
+      });
+    }
+
+  private:
+    static constexpr uint32_t s_null = std::numeric_limits<uint32_t>::max();
+
+    //fn(cell) for each cell a-b passes through, row by row, until it returns true
+    template<typename TFunc>
+    bool ForEachCell(const SpgMth::Point2d& a, const SpgMth::Point2d& b, TFunc fn) const
+    {
+      constexpr double pad = 1e-3; //fraction of a cell
+      double ax = (a.x - m_min_x) * m_inv_cell_size, ay = (a.y - m_min_y) * m_inv_cell_size;
+      double bx = (b.x - m_min_x) * m_inv_cell_size, by = (b.y - m_min_y) * m_inv_cell_size;
+      if(ay > by) {
+        std::swap(ax, bx);
+        std::swap(ay, by);
+      }
+      const double dx_dy = (by - ay > 1e-12) ? (bx - ax) / (by - ay) : 0.0;
+      const uint32_t row_first = ClampCell(ay - pad, m_num_y), row_last = ClampCell(by + pad, m_num_y);
+      for(uint32_t row = row_first; row <= row_last; row++) {
+        //The part of the segment in this row
+        double y_lo = std::clamp((double)row, ay, by);
+        double y_hi = std::clamp((double)row + 1.0, ay, by);
+        double x_lo = ax + (y_lo - ay) * dx_dy;
+        double x_hi = (dx_dy == 0.0) ? bx : ax + (y_hi - ay) * dx_dy;
+        if(x_lo > x_hi)
+          std::swap(x_lo, x_hi);
+        const uint32_t col_first = ClampCell(x_lo - pad, m_num_x), col_last = ClampCell(x_hi + pad, m_num_x);
+        for(uint32_t col = col_first; col <= col_last; col++) {
+          if(fn(row * m_num_x + col))
+            return true;
+        }
+      }
+      return false;
+    }
+
+    static uint32_t ClampCell(double coord, uint32_t num_cells)
+    {
+      return (uint32_t)std::clamp(std::floor(coord), 0.0, (double)(num_cells - 1));
+    }
+
+    struct Entry
+    {
+      uint32_t id;
+      uint32_t next; //next entry in the same cell
+    };
+
+    double m_min_x = 0.0;
+    double m_min_y = 0.0;
+    double m_inv_cell_size = 1.0;
+    uint32_t m_num_x = 0;
+    uint32_t m_num_y = 0;
+    std::vector<uint32_t> m_cell_first; //first entry of each cell
+    std::vector<Entry> m_entries;
+  };
+}
@@ -1,7 +1,13 @@
 #include "Geometry/Triangulate.h"
 //#include "GeomUtils.h"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <set>
+
 #include "MathLib/Geom/Geom.h"
+#include "MathLib/Geom/Predicates.h"
 
 namespace Geom
 {
@@ -70,17 +76,28 @@ namespace Geom
     return prospect && InteriorCheck(v1,v2) && InteriorCheck(v2,v1);
   }
 
-  static void InitialiseEarStatus(const PolygonSimple* polygon)
+  bool IsDiagonal(const SP::Vertex* v1, const SP::Vertex* v2, const PolygonSimple& polygon, const SegmentGrid2D& edge_grid)
+  {
+    bool intersects = edge_grid.ForEachCandidate(v1->point, v2->point, [&](uint32_t index) {
+      const SP::Vertex* current = polygon.vertices[index];
+      const SP::Vertex* next = current->next;
+      return !current->is_processed && current != v1 && next != v1 && current != v2 && next != v2 && 
+        SpgMth::IntersectionExists({v1->point, v2->point},{current->point, next->point});
+    });
+    return !intersects && InteriorCheck(v1,v2) && InteriorCheck(v2,v1);
+  }
+
+  static void InitialiseEarStatus(const PolygonSimple* polygon, const SegmentGrid2D& edge_grid)
   {
     SP::Vertex *v0, *v1, *v2;
-    auto vertices = polygon->vertices;
+    auto& vertices = polygon->vertices;
     v1 = vertices[0];
 
     do {
       v0 = v1->prev;
       v2 = v1->next;
       if(SpgMth::IsConvex(v0->point,v1->point,v2->point))
-        v1->is_ear = IsDiagonal(v0,v2);
+        v1->is_ear = IsDiagonal(v0,v2,*polygon,edge_grid);
       v1 = v1->next;  
     } while (v1 != vertices[0]);
   }
@@ -90,7 +107,16 @@ namespace Geom
   //edge_list is an output param and is actually the list of diagonals used to triangulate the poly
   void Triangulate_EarClipping(PolygonSimple* polygon, std::vector<SP::Edge>& edge_list)
   {
-    InitialiseEarStatus(polygon);
+    //Polygon edges by start vertex, so the diagonal checks don't scan the whole polygon. When an ear is clipped the
+    //diagonal goes in under its start vertex (v1->v3 replaces v1->v2)
+    SpgMth::BoundingBox bounds;
+    for(auto v : polygon->vertices)
+      bounds.Update(v->point);
+    SegmentGrid2D edge_grid(bounds, (uint32_t)polygon->vertices.size());
+    for(auto v : polygon->vertices)
+      edge_grid.Insert(v->index, v->point, v->next->point);
+
+    InitialiseEarStatus(polygon, edge_grid);
     //return;
 
     auto vertex_list = polygon->vertices;
@@ -114,13 +140,14 @@ namespace Geom
           //clip v2
           v1->next = v3;
           v3->prev = v1;
+          edge_grid.Insert(v1->index, v1->point, v3->point);
 
           //update ear status of v1 and v3
           if(SpgMth::IsConvex(v1->prev->point,v1->point,v2->next->point))
-            v1->is_ear = IsDiagonal(v0,v3);
+            v1->is_ear = IsDiagonal(v0,v3,*polygon,edge_grid);
 
           if(SpgMth::IsConvex(v3->prev->point,v3->point,v3->next->point))
-            v3->is_ear = IsDiagonal(v1,v4);  
+            v3->is_ear = IsDiagonal(v1,v4,*polygon,edge_grid);  
 
           vertices_to_process--;
           if(vertices_to_process <= 3)
@@ -131,4 +158,380 @@ namespace Geom
     }
 
   }
-}
\ No newline at end of file
+
+  //----------------------------------------------------------------------------------------------------------------
+  //TriangulatePolygon() - monotone partition, then triangulate the pieces, all on vertex indices
+
+  namespace
+  {
+    constexpr uint32_t s_null = std::numeric_limits<uint32_t>::max();
+
+    //Sweep order, top to bottom then left to right - as MonotonePartitionAlgo, but without the epsilon
+    inline bool Above(const SpgMth::Point2d& p1, const SpgMth::Point2d& p2)
+    {
+      return (p1.y > p2.y) || ((p1.y == p2.y) && (p1.x < p2.x));
+    }
+
+    //All the boundary loops as links between vertex indices, oriented so the interior is left of each edge (outer
+    //boundary CCW, holes CW). Edge v is v -> next[v]
+    struct PolygonLoops
+    {
+      std::vector<SpgMth::Point2d> points;
+      std::vector<uint32_t> next;
+      std::vector<uint32_t> prev;
+
+      void AddLoop(std::span<const SpgMth::Point2d> loop, bool make_ccw)
+      {
+        const uint32_t first = (uint32_t)points.size();
+        const uint32_t count = (uint32_t)loop.size();
+        double area = 0.0;
+        for(uint32_t i = 0; i < count; i++) {
+          const auto& p = loop[i];
+          const auto& q = loop[(i + 1) % count];
+          area += (double)p.x * q.y - (double)q.x * p.y;
+        }
+        const bool reverse = (area > 0.0) != make_ccw;
+        for(uint32_t i = 0; i < count; i++) {
+          uint32_t after = first + (i + 1) % count;
+          uint32_t before = first + (i + count - 1) % count;
+          points.push_back(loop[i]);
+          next.push_back(reverse ? before : after);
+          prev.push_back(reverse ? after : before);
+        }
+      }
+    };
+
+    //The edges in the sweep status have the interior on their right, so they go down, and they don't cross. Left to
+    //right order is by testing the upper end of the edge that starts lower against the other edge. Comparing with
+    //a point finds the edge directly left of a vertex
+    struct StatusLess
+    {
+      using is_transparent = void;
+
+      bool operator()(uint32_t e1, uint32_t e2) const
+      {
+        const auto& a1 = loops->points[e1];
+        const auto& a2 = loops->points[e2];
+        if(Above(a2, a1))
+          return SpgMth::Orient2d(a2, loops->points[loops->next[e2]], a1) < 0.0;
+        if(Above(a1, a2))
+          return SpgMth::Orient2d(a1, loops->points[loops->next[e1]], a2) > 0.0;
+        return false;
+      }
+      bool operator()(uint32_t e, const SpgMth::Point2d& p) const
+      {
+        return SpgMth::Orient2d(loops->points[e], loops->points[loops->next[e]], p) > 0.0;
+      }
+      bool operator()(const SpgMth::Point2d& p, uint32_t e) const
+      {
+        return SpgMth::Orient2d(loops->points[e], loops->points[loops->next[e]], p) < 0.0;
+      }
+
+      const PolygonLoops* loops;
+    };
+
+    using DiagonalList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    //Diagonals that split the polygon into y-monotone pieces - MonotonePartitionAlgo::MakeMonotone() with edges and
+    //helpers by index (edge v's helper is helper[v]). False if the sweep status turns out inconsistent, which only
+    //happens if the boundaries cross or touch
+    bool MakeMonotoneDiagonals(const PolygonLoops& loops, DiagonalList& diagonals)
+    {
+      enum class Category : uint8_t { Start, End, Regular, Split, Merge };
+
+      const auto& points = loops.points;
+      const uint32_t n = (uint32_t)points.size();
+      std::vector<Category> category(n);
+      for(uint32_t v = 0; v < n; v++) {
+        const auto& p_prev = points[loops.prev[v]];
+        const auto& p_next = points[loops.next[v]];
+        const bool convex = SpgMth::Orient2d(p_prev, points[v], p_next) > 0.0;
+        if(Above(points[v], p_prev) && Above(points[v], p_next))
+          category[v] = convex ? Category::Start : Category::Split;
+        else if(Above(p_prev, points[v]) && Above(p_next, points[v]))
+          category[v] = convex ? Category::End : Category::Merge;
+        else
+          category[v] = Category::Regular;
+      }
+
+      std::vector<uint32_t> events(n);
+      std::iota(events.begin(), events.end(), 0u);
+      std::sort(events.begin(), events.end(), [&points](uint32_t a, uint32_t b) {
+        return Above(points[a], points[b]);
+      });
+
+      std::set<uint32_t, StatusLess> status(StatusLess{&loops});
+      std::vector<uint32_t> helper(n, s_null);
+
+      auto connect_merge_helper = [&](uint32_t v, uint32_t e) {
+        if(category[helper[e]] == Category::Merge)
+          diagonals.push_back({v, helper[e]});
+      };
+      auto edge_left_of = [&](uint32_t v) {
+        auto itr = status.lower_bound(points[v]);
+        return (itr == status.begin()) ? s_null : *std::prev(itr);
+      };
+      auto insert_edge = [&](uint32_t v) {
+        helper[v] = v;
+        return status.insert(v).second;
+      };
+
+      for(uint32_t v : events) {
+        const uint32_t e_prev = loops.prev[v];
+        uint32_t e_left = s_null;
+        switch(category[v]) {
+          case Category::Start:
+            if(!insert_edge(v))
+              return false;
+            break;
+          case Category::End:
+            if(status.erase(e_prev) == 0)
+              return false;
+            connect_merge_helper(v, e_prev);
+            break;
+          case Category::Split:
+            if((e_left = edge_left_of(v)) == s_null)
+              return false;
+            diagonals.push_back({v, helper[e_left]});
+            helper[e_left] = v;
+            if(!insert_edge(v))
+              return false;
+            break;
+          case Category::Merge:
+            if(status.erase(e_prev) == 0)
+              return false;
+            connect_merge_helper(v, e_prev);
+            if((e_left = edge_left_of(v)) == s_null)
+              return false;
+            connect_merge_helper(v, e_left);
+            helper[e_left] = v;
+            break;
+          case Category::Regular:
+            if(Above(points[e_prev], points[v])) { //interior on the right
+              if(status.erase(e_prev) == 0)
+                return false;
+              connect_merge_helper(v, e_prev);
+              if(!insert_edge(v))
+                return false;
+            }
+            else {
+              if((e_left = edge_left_of(v)) == s_null)
+                return false;
+              connect_merge_helper(v, e_left);
+              helper[e_left] = v;
+            }
+            break;
+        }
+      }
+      return status.empty();
+    }
+
+    struct ChainVertex
+    {
+      uint32_t vertex;
+      bool on_left; //left chain, i.e. CCW from the top vertex
+    };
+
+    inline void AddTriangle(const std::vector<SpgMth::Point2d>& points, uint32_t a, uint32_t b, uint32_t c, 
+      std::vector<uint32_t>& triangles)
+    {
+      if(SpgMth::Orient2d(points[a], points[b], points[c]) < 0.0)
+        std::swap(b, c);
+      triangles.insert(triangles.end(), {a, b, c});
+    }
+
+    //A y-monotone piece, CCW, in linear time - MonotonePartitionAlgo::TriangulateFace(), but the chains are merged
+    //rather than the vertices sorted. sorted and stack are scratch space
+    void TriangulateMonotone(const std::vector<SpgMth::Point2d>& points, const std::vector<uint32_t>& loop, 
+      std::vector<ChainVertex>& sorted, std::vector<uint32_t>& stack, std::vector<uint32_t>& triangles)
+    {
+      const uint32_t m = (uint32_t)loop.size();
+      uint32_t top = 0, bottom = 0;
+      for(uint32_t i = 1; i < m; i++) {
+        if(Above(points[loop[i]], points[loop[top]]))
+          top = i;
+        if(Above(points[loop[bottom]], points[loop[i]]))
+          bottom = i;
+      }
+
+      sorted.clear();
+      sorted.push_back({loop[top], true});
+      uint32_t i = (top + 1) % m;
+      uint32_t j = (top + m - 1) % m;
+      while(i != bottom || j != bottom) {
+        if((j == bottom) || ((i != bottom) && Above(points[loop[i]], points[loop[j]]))) {
+          sorted.push_back({loop[i], true});
+          i = (i + 1) % m;
+        }
+        else {
+          sorted.push_back({loop[j], false});
+          j = (j + m - 1) % m;
+        }
+      }
+      sorted.push_back({loop[bottom], true});
+
+      stack.clear();
+      stack.push_back(sorted[0].vertex);
+      stack.push_back(sorted[1].vertex);
+      bool stack_top_on_left = sorted[1].on_left;
+      for(uint32_t k = 2; k + 1 < m; k++) {
+        const uint32_t u = sorted[k].vertex;
+        const bool on_left = sorted[k].on_left;
+        if(on_left != stack_top_on_left) {
+          //Fan from u to everything on the stack
+          for(uint32_t s = 0; s + 1 < stack.size(); s++)
+            AddTriangle(points, u, stack[s], stack[s + 1], triangles);
+          uint32_t prev_u = stack.back();
+          stack.clear();
+          stack.push_back(prev_u);
+          stack.push_back(u);
+        }
+        else {
+          //Cut off triangles while the chain is convex at the stack top
+          uint32_t last = stack.back();
+          stack.pop_back();
+          while(!stack.empty()) {
+            const uint32_t s = stack.back();
+            const double orient = on_left ? SpgMth::Orient2d(points[s], points[last], points[u]) : 
+                                            SpgMth::Orient2d(points[u], points[last], points[s]);
+            if(orient <= 0.0)
+              break;
+            AddTriangle(points, u, last, s, triangles);
+            last = s;
+            stack.pop_back();
+          }
+          stack.push_back(last);
+          stack.push_back(u);
+        }
+        stack_top_on_left = on_left;
+      }
+      for(uint32_t s = 0; s + 1 < stack.size(); s++)
+        AddTriangle(points, sorted.back().vertex, stack[s], stack[s + 1], triangles);
+    }
+
+    //Walks the faces the diagonals make, and triangulates each. Half edge v (< n) is boundary edge v, diagonal k is
+    //half edges n + 2k (first -> second) and n + 2k + 1 (back). Only the interior side of the boundary is needed
+    void TriangulatePieces(const PolygonLoops& loops, const DiagonalList& diagonals, std::vector<uint32_t>& triangles)
+    {
+      const auto& points = loops.points;
+      const uint32_t n = (uint32_t)points.size();
+      const uint32_t num_half_edges = n + 2 * (uint32_t)diagonals.size();
+      auto origin = [&](uint32_t h) {
+        if(h < n)
+          return h;
+        const auto& d = diagonals[(h - n) / 2];
+        return ((h - n) & 1) ? d.second : d.first;
+      };
+      auto twin = [n](uint32_t h) { return n + ((h - n) ^ 1u); };
+
+      //Diagonals departing each vertex
+      std::vector<uint32_t> first_departing(n + 1, 0);
+      for(const auto& d : diagonals) {
+        first_departing[d.first + 1]++;
+        first_departing[d.second + 1]++;
+      }
+      std::partial_sum(first_departing.begin(), first_departing.end(), first_departing.begin());
+      std::vector<uint32_t> departing(first_departing[n]);
+      {
+        std::vector<uint32_t> fill(first_departing.begin(), first_departing.end() - 1);
+        for(uint32_t h = n; h < num_half_edges; h++)
+          departing[fill[origin(h)]++] = h;
+      }
+
+      //Leaving v, the next half edge after one arriving from w is the departing one just CW of v->w. CCW round v
+      //that's the boundary edge out, the diagonals (all in the interior angle), then the boundary edge in
+      std::vector<uint32_t> next(num_half_edges);
+      for(uint32_t v = 0; v < n; v++) {
+        auto begin = departing.begin() + first_departing[v];
+        auto end = departing.begin() + first_departing[v + 1];
+        if(begin == end) {
+          next[loops.prev[v]] = v;
+          continue;
+        }
+        const auto& p = points[v];
+        const auto& p_ref = points[loops.next[v]];
+        auto half = [&](uint32_t h) { return SpgMth::Orient2d(p, p_ref, points[origin(twin(h))]) > 0.0 ? 0 : 1; };
+        std::sort(begin, end, [&](uint32_t h1, uint32_t h2) {
+          int half1 = half(h1), half2 = half(h2);
+          if(half1 != half2)
+            return half1 < half2;
+          return SpgMth::Orient2d(p, points[origin(twin(h1))], points[origin(twin(h2))]) > 0.0;
+        });
+        uint32_t cw = v;
+        for(auto itr = begin; itr != end; ++itr) {
+          next[twin(*itr)] = cw;
+          cw = *itr;
+        }
+        next[loops.prev[v]] = cw;
+      }
+
+      std::vector<uint8_t> visited(num_half_edges, 0);
+      std::vector<uint32_t> loop;
+      std::vector<ChainVertex> sorted;
+      std::vector<uint32_t> stack;
+      for(uint32_t h = 0; h < num_half_edges; h++) {
+        if(visited[h])
+          continue;
+        loop.clear();
+        uint32_t e = h;
+        do {
+          visited[e] = 1;
+          loop.push_back(origin(e));
+          e = next[e];
+        } while(e != h && loop.size() <= n);
+        SPG_ASSERT(e == h && loop.size() >= 3);
+        if(e == h && loop.size() >= 3)
+          TriangulateMonotone(points, loop, sorted, stack, triangles);
+      }
+    }
+  }
+
+  bool TriangulatePolygon(std::span<const SpgMth::Point2d> outer, std::span<const std::vector<SpgMth::Point2d>> holes, 
+    std::vector<uint32_t>& triangles_out)
+  {
+    triangles_out.clear();
+    PolygonLoops loops;
+    std::size_t num_points = outer.size();
+    for(const auto& hole : holes)
+      num_points += hole.size();
+    loops.points.reserve(num_points);
+    loops.next.reserve(num_points);
+    loops.prev.reserve(num_points);
+
+    bool loops_ok = (outer.size() >= 3);
+    loops.AddLoop(outer, true);
+    for(const auto& hole : holes) {
+      loops_ok = loops_ok && (hole.size() >= 3);
+      loops.AddLoop(hole, false);
+    }
+    if(!loops_ok) {
+      SPG_ERROR("TriangulatePolygon(): boundary with fewer than 3 points");
+      return false;
+    }
+
+    DiagonalList diagonals;
+    diagonals.reserve(num_points / 4);
+    if(!MakeMonotoneDiagonals(loops, diagonals)) {
+      SPG_ERROR("TriangulatePolygon(): boundaries aren't simple, or they touch");
+      return false;
+    }
+
+    const std::size_t num_triangles = num_points + 2 * holes.size() - 2;
+    triangles_out.reserve(3 * num_triangles);
+    TriangulatePieces(loops, diagonals, triangles_out);
+    if(triangles_out.size() != 3 * num_triangles) {
+      SPG_ERROR("TriangulatePolygon(): {} triangles rather than {} - boundaries aren't simple, or they touch", triangles_out.size() / 3, num_triangles);
+      triangles_out.clear();
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<uint32_t> TriangulatePolygon(std::span<const SpgMth::Point2d> outer, 
+    std::span<const std::vector<SpgMth::Point2d>> holes)
+  {
+    std::vector<uint32_t> triangles;
+    TriangulatePolygon(outer, holes, triangles);
+    return triangles;
+  }
+}
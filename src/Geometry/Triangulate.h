@@ -1,12 +1,30 @@
 #pragma once
+#include <span>
+#include <vector>
 #include "Geometry/Polygon.h"
+#include "Geometry/SegmentGrid.h"
 
 namespace Geom
 {
 
   bool IsDiagonal(const SP::Vertex* v1, const SP::Vertex* v2, const PolygonSimple* polygon = nullptr );
 
+  //Same test, but the intersection check is only against the edges near v1-v2. edge_grid holds, for each vertex
+  //still in the polygon, its index for the edge to its next vertex (see Triangulate_EarClipping())
+  bool IsDiagonal(const SP::Vertex* v1, const SP::Vertex* v2, const PolygonSimple& polygon, const SegmentGrid2D& edge_grid);
+
   void Triangulate_EarClipping(PolygonSimple* polygon, std::vector<SP::Edge>& edge_list);
 
+  //Triangulates a polygon with holes in O(n log n): a sweep splits it into y-monotone pieces (as in
+  //MonotonePartitionAlgo), and each piece is triangulated in linear time. Works on vertex indices throughout - the
+  //output is 3 indices per triangle (CCW) into the outer boundary's points followed by each hole's in turn, so
+  //n + 2*holes - 2 triangles. Either orientation is accepted for the boundary and the holes. The boundaries must be
+  //simple and not touch each other, with no repeated points. Returns false (with triangles_out empty) if the sweep
+  //finds they aren't
+  bool TriangulatePolygon(std::span<const SpgMth::Point2d> outer, std::span<const std::vector<SpgMth::Point2d>> holes, 
+    std::vector<uint32_t>& triangles_out);
+  std::vector<uint32_t> TriangulatePolygon(std::span<const SpgMth::Point2d> outer, 
+    std::span<const std::vector<SpgMth::Point2d>> holes = {});
+
   
 }
\ No newline at end of file
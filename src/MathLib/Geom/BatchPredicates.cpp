@@ -0,0 +1,155 @@
+#include "MathLib/Geom/BatchPredicates.h"
+#include "MathLib/Geom/Predicates.h"
+#include "MathLib/Simd.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace SpgMth
+{
+  namespace
+  {
+    constexpr double s_epsilon = 0x1p-53;
+    constexpr double s_ccw_err_bound_A = (3.0 + 16.0 * s_epsilon) * s_epsilon; //same filter as Orient2d()
+
+    struct LaneSigns
+    {
+      uint32_t pos = 0; //bit per lane
+      uint32_t neg = 0;
+    };
+
+    //Orient2d(a, b, p) signs for the V::s_width points starting at pts. The double evaluation is the same as
+    //Orient2d()'s first stage, lanes where it's within the error bound of 0 get the full Orient2d()
+    template<typename V>
+    LaneSigns Orient2dLanes(const DPoint2d& a, const DPoint2d& b, const Point2d* pts)
+    {
+      V px, py;
+      Simd::LoadPoints(pts, px, py);
+      V det_left = (V::Set(a.x) - px) * (V::Set(b.y) - py);
+      V det_right = (V::Set(a.y) - py) * (V::Set(b.x) - px);
+      V det = det_left - det_right;
+      V err_bound = V::Set(s_ccw_err_bound_A) * (Simd::Abs(det_left) + Simd::Abs(det_right));
+      uint32_t certain = Simd::Bits(Simd::Ge(Simd::Abs(det), err_bound));
+      LaneSigns signs;
+      signs.pos = Simd::Bits(Simd::Gt(det, V::Set(0.0))) & certain;
+      signs.neg = Simd::Bits(Simd::Lt(det, V::Set(0.0))) & certain;
+
+      uint32_t uncertain = ~certain & ((1u << V::s_width) - 1);
+      while(uncertain) {
+        uint32_t i = std::countr_zero(uncertain);
+        uncertain &= uncertain - 1;
+        double d = Orient2d(a, b, DPoint2d(pts[i]));
+        signs.pos |= uint32_t(d > 0.0) << i;
+        signs.neg |= uint32_t(d < 0.0) << i;
+      }
+      return signs;
+    }
+
+    //Crossing number test as in PointInPolygon(), for the V::s_width points starting at pts. Bit per lane
+    template<typename V>
+    uint32_t PointInPolygonLanes(std::span<const Point2d> polygon, const Point2d* pts)
+    {
+      V px, py;
+      Simd::LoadPoints(pts, px, py);
+      typename V::Mask inside{};
+      const std::size_t num_verts = polygon.size();
+      for(std::size_t i = 0, j = num_verts - 1; i < num_verts; j = i++) {
+        double x_i = polygon[i].x, y_i = polygon[i].y;
+        double x_j = polygon[j].x, y_j = polygon[j].y;
+        auto straddles = Simd::Gt(V::Set(y_i), py) ^ Simd::Gt(V::Set(y_j), py);
+        if(Simd::Bits(straddles) == 0)
+          continue; //most edges, for most chunks
+        V x_cross = V::Set(x_j - x_i) * (py - V::Set(y_i)) / V::Set(y_j - y_i) + V::Set(x_i);
+        inside = inside ^ (straddles & Simd::Lt(px, x_cross));
+      }
+      return Simd::Bits(inside);
+    }
+
+    //Calls store(first, lanes(V(), first), width) over [0, num_pts): full width SIMD chunks, then single lanes for
+    //the tail. The widths are 1, 2 or 4, so a chunk never straddles a 64 bit bitmask word
+    template<typename TLanes, typename TStore>
+    void ForEachChunk(std::size_t num_pts, TLanes lanes, TStore store)
+    {
+      constexpr uint32_t width = Simd::DoubleV::s_width;
+      std::size_t i = 0;
+      for(; i + width <= num_pts; i += width)
+        store(i, lanes(Simd::DoubleV{}, i), width);
+      for(; i < num_pts; i++)
+        store(i, lanes(Simd::DoubleX1{}, i), 1u);
+    }
+
+    auto ByteStore(std::span<uint8_t> out)
+    {
+      return [out](std::size_t first, uint32_t bits, uint32_t width) {
+        for(uint32_t k = 0; k < width; k++)
+          out[first + k] = (bits >> k) & 1;
+      };
+    }
+
+    auto MaskStore(std::span<uint64_t> mask_out, std::size_t num_pts)
+    {
+      SPG_ASSERT(mask_out.size() >= BitmaskWords(num_pts));
+      std::fill(mask_out.begin(), mask_out.begin() + BitmaskWords(num_pts), 0);
+      return [mask_out](std::size_t first, uint32_t bits, uint32_t) {
+        mask_out[first / 64] |= uint64_t(bits) << (first % 64);
+      };
+    }
+
+    auto LeftLanes(const LineSeg2D& line_seg, std::span<const Point2d> pts)
+    {
+      return [a = DPoint2d(line_seg.start), b = DPoint2d(line_seg.end), pts](auto lanes, std::size_t first) {
+        return Orient2dLanes<decltype(lanes)>(a, b, pts.data() + first).pos;
+      };
+    }
+
+    auto PolygonLanes(std::span<const Point2d> polygon, std::span<const Point2d> pts)
+    {
+      return [polygon, pts](auto lanes, std::size_t first) {
+        return PointInPolygonLanes<decltype(lanes)>(polygon, pts.data() + first);
+      };
+    }
+  }
+
+  void Orient2dBatch(const Point2d& a, const Point2d& b, std::span<const Point2d> pts, std::span<int8_t> out)
+  {
+    SPG_ASSERT(out.size() >= pts.size());
+    DPoint2d da(a), db(b);
+    ForEachChunk(pts.size(),
+      [da, db, pts](auto lanes, std::size_t first) {
+        return Orient2dLanes<decltype(lanes)>(da, db, pts.data() + first);
+      },
+      [out](std::size_t first, LaneSigns signs, uint32_t width) {
+        for(uint32_t k = 0; k < width; k++)
+          out[first + k] = (int8_t)((signs.pos >> k) & 1) - (int8_t)((signs.neg >> k) & 1);
+      });
+  }
+
+  void LeftBatch(const LineSeg2D& line_seg, std::span<const Point2d> pts, std::span<uint8_t> out)
+  {
+    SPG_ASSERT(out.size() >= pts.size());
+    ForEachChunk(pts.size(), LeftLanes(line_seg, pts), ByteStore(out));
+  }
+
+  void LeftBatch(const LineSeg2D& line_seg, std::span<const Point2d> pts, std::span<uint64_t> mask_out)
+  {
+    ForEachChunk(pts.size(), LeftLanes(line_seg, pts), MaskStore(mask_out, pts.size()));
+  }
+
+  void PointInPolygonBatch(std::span<const Point2d> polygon, std::span<const Point2d> pts, std::span<uint8_t> out)
+  {
+    SPG_ASSERT(out.size() >= pts.size());
+    if(polygon.size() < 3) {
+      std::fill(out.begin(), out.begin() + pts.size(), 0);
+      return;
+    }
+    ForEachChunk(pts.size(), PolygonLanes(polygon, pts), ByteStore(out));
+  }
+
+  void PointInPolygonBatch(std::span<const Point2d> polygon, std::span<const Point2d> pts, std::span<uint64_t> mask_out)
+  {
+    auto store = MaskStore(mask_out, pts.size());
+    if(polygon.size() < 3)
+      return;
+    ForEachChunk(pts.size(), PolygonLanes(polygon, pts), store);
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <span>
+#include "MathLib/Geom/Geom.h"
+
+namespace SpgMth
+{
+  //Batched versions of the per point predicates, for the tight loops in hull construction, ear clipping and
+  //picking: classify a whole span of points against one segment / polygon. The points are processed a SIMD
+  //register at a time (see MathLib/Simd.h - AVX2, SSE2 or scalar depending on the build target), the results
+  //written to a byte array or a bitmask (bit i of word i/64 for point i, see BitmaskWords() / TestBit()).
+  //
+  //Each result is identical to what the scalar function gives for that point, on any target. The orientation
+  //kernels use the same error bound filter as Orient2d() and hand the rare lanes it can't decide to Orient2d(), so
+  //they're exact (the Orient2d() / LeftExact() semantics rather than the epsilon ones of Orientation2d() / Left()).
+  //
+  //The out span must be at least as long as pts (bytes), or hold BitmaskWords(pts.size()) words (bitmask). Unused
+  //bits in the last bitmask word are set to 0.
+
+  inline std::size_t BitmaskWords(std::size_t num_bits)
+  {
+    return (num_bits + 63) / 64;
+  }
+
+  inline bool TestBit(std::span<const uint64_t> mask, std::size_t i)
+  {
+    return (mask[i / 64] >> (i % 64)) & 1;
+  }
+
+  //out[i] = Orient2dSign(a, b, pts[i]), i.e. 1 if pts[i] is left of a->b, -1 if right, 0 if exactly collinear
+  void Orient2dBatch(const Point2d& a, const Point2d& b, std::span<const Point2d> pts, std::span<int8_t> out);
+
+  //LeftExact(line_seg, pts[i])
+  void LeftBatch(const LineSeg2D& line_seg, std::span<const Point2d> pts, std::span<uint8_t> out);
+  void LeftBatch(const LineSeg2D& line_seg, std::span<const Point2d> pts, std::span<uint64_t> mask_out);
+
+  //PointInPolygon(polygon, pts[i]) - the same crossing number test, evaluated in the same (double) arithmetic
+  void PointInPolygonBatch(std::span<const Point2d> polygon, std::span<const Point2d> pts, std::span<uint8_t> out);
+  void PointInPolygonBatch(std::span<const Point2d> polygon, std::span<const Point2d> pts, std::span<uint64_t> mask_out);
+}
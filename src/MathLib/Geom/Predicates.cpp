@@ -0,0 +1,416 @@
+#include "MathLib/Geom/Predicates.h"
+
+#include <cmath>
+
+namespace SpgMth
+{
+  namespace
+  {
+    //Expansion arithmetic: a value is held exactly as an 'expansion' - a sum of non-overlapping doubles in increasing
+    //order of magnitude. The building blocks below give the exact result of a +,- or * as a rounded value plus the
+    //rounding error (also a double).
+
+    constexpr double s_epsilon = 0x1p-53; //half an ulp of 1.0, i.e. the max relative rounding error
+
+    //Bounds on the rounding error of each evaluation stage, from Shewchuk's paper
+    constexpr double s_result_err_bound = (3.0 + 8.0 * s_epsilon) * s_epsilon;
+    constexpr double s_ccw_err_bound_A = (3.0 + 16.0 * s_epsilon) * s_epsilon;
+    constexpr double s_ccw_err_bound_B = (2.0 + 12.0 * s_epsilon) * s_epsilon;
+    constexpr double s_ccw_err_bound_C = (9.0 + 64.0 * s_epsilon) * s_epsilon * s_epsilon;
+    constexpr double s_icc_err_bound_A = (10.0 + 96.0 * s_epsilon) * s_epsilon;
+
+    //x + y == a + b exactly, x = fl(a + b)
+    inline void TwoSum(double a, double b, double& x, double& y)
+    {
+      x = a + b;
+      double b_virtual = x - a;
+      double a_virtual = x - b_virtual;
+      y = (a - a_virtual) + (b - b_virtual);
+    }
+
+    //As TwoSum, requires |a| >= |b|
+    inline void FastTwoSum(double a, double b, double& x, double& y)
+    {
+      x = a + b;
+      y = b - (x - a);
+    }
+
+    //x + y == a - b exactly, x = fl(a - b)
+    inline void TwoDiffTail(double a, double b, double x, double& y)
+    {
+      double b_virtual = a - x;
+      double a_virtual = x + b_virtual;
+      y = (a - a_virtual) + (b_virtual - b);
+    }
+
+    inline void TwoDiff(double a, double b, double& x, double& y)
+    {
+      x = a - b;
+      TwoDiffTail(a, b, x, y);
+    }
+
+#if defined(__FMA__) || defined(__AVX2__)
+    //x + y == a * b exactly. With hardware FMA the error term is a single fused multiply-add. (Also needed for
+    //correctness in that case - the compiler may contract Dekker's split version below into FMAs and break it)
+    inline void TwoProduct(double a, double b, double& x, double& y)
+    {
+      x = a * b;
+      y = std::fma(a, b, -x);
+    }
+#else
+    //Dekker's product: split each operand into two 26 bit halves whose products are exact
+    inline void Split(double a, double& hi, double& lo)
+    {
+      constexpr double splitter = 134217729.0; //2^27 + 1
+      double c = splitter * a;
+      double big = c - a;
+      hi = c - big;
+      lo = a - hi;
+    }
+
+    inline void TwoProduct(double a, double b, double& x, double& y)
+    {
+      x = a * b;
+      double a_hi, a_lo, b_hi, b_lo;
+      Split(a, a_hi, a_lo);
+      Split(b, b_hi, b_lo);
+      double err1 = x - (a_hi * b_hi);
+      double err2 = err1 - (a_lo * b_hi);
+      double err3 = err2 - (a_hi * b_lo);
+      y = (a_lo * b_lo) - err3;
+    }
+#endif
+
+    //(a1 + a0) - (b1 + b0) as a 4 component expansion x[0..3]
+    inline void TwoTwoDiff(double a1, double a0, double b1, double b0, double* x)
+    {
+      double i, j, k;
+      TwoDiff(a0, b0, i, x[0]);
+      TwoSum(a1, i, j, k);
+      double l;
+      TwoDiff(k, b1, l, x[1]);
+      TwoSum(j, l, x[3], x[2]);
+    }
+
+    //h = e + f, with zero components removed. Returns the length of h, which needs room for elen + flen components
+    int FastExpansionSumZeroElim(int elen, const double* e, int flen, const double* f, double* h)
+    {
+      double q, q_new, hh;
+      int e_idx = 0, f_idx = 0, h_idx = 0;
+      double e_now = e[0];
+      double f_now = f[0];
+      //Take the smaller magnitude component first
+      if((f_now > e_now) == (f_now > -e_now)) {
+        q = e_now;
+        e_idx++;
+      }
+      else {
+        q = f_now;
+        f_idx++;
+      }
+      if((e_idx < elen) && (f_idx < flen)) {
+        e_now = e[e_idx];
+        f_now = f[f_idx];
+        if((f_now > e_now) == (f_now > -e_now)) {
+          FastTwoSum(e_now, q, q_new, hh);
+          e_idx++;
+        }
+        else {
+          FastTwoSum(f_now, q, q_new, hh);
+          f_idx++;
+        }
+        q = q_new;
+        if(hh != 0.0)
+          h[h_idx++] = hh;
+        while((e_idx < elen) && (f_idx < flen)) {
+          e_now = e[e_idx];
+          f_now = f[f_idx];
+          if((f_now > e_now) == (f_now > -e_now)) {
+            TwoSum(q, e_now, q_new, hh);
+            e_idx++;
+          }
+          else {
+            TwoSum(q, f_now, q_new, hh);
+            f_idx++;
+          }
+          q = q_new;
+          if(hh != 0.0)
+            h[h_idx++] = hh;
+        }
+      }
+      for(; e_idx < elen; e_idx++) {
+        TwoSum(q, e[e_idx], q_new, hh);
+        q = q_new;
+        if(hh != 0.0)
+          h[h_idx++] = hh;
+      }
+      for(; f_idx < flen; f_idx++) {
+        TwoSum(q, f[f_idx], q_new, hh);
+        q = q_new;
+        if(hh != 0.0)
+          h[h_idx++] = hh;
+      }
+      if((q != 0.0) || (h_idx == 0))
+        h[h_idx++] = q;
+      return h_idx;
+    }
+
+    //h = e * b, with zero components removed. Returns the length of h, which needs room for 2 * elen components
+    int ScaleExpansionZeroElim(int elen, const double* e, double b, double* h)
+    {
+      double q, hh, product1, product0, sum;
+      int h_idx = 0;
+      TwoProduct(e[0], b, q, hh);
+      if(hh != 0.0)
+        h[h_idx++] = hh;
+      for(int e_idx = 1; e_idx < elen; e_idx++) {
+        TwoProduct(e[e_idx], b, product1, product0);
+        TwoSum(q, product0, sum, hh);
+        if(hh != 0.0)
+          h[h_idx++] = hh;
+        FastTwoSum(product1, sum, q, hh);
+        if(hh != 0.0)
+          h[h_idx++] = hh;
+      }
+      if((q != 0.0) || (h_idx == 0))
+        h[h_idx++] = q;
+      return h_idx;
+    }
+
+    double Estimate(int elen, const double* e)
+    {
+      double q = e[0];
+      for(int i = 1; i < elen; i++)
+        q += e[i];
+      return q;
+    }
+
+    double Orient2dAdapt(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, double det_sum)
+    {
+      double acx = a.x - c.x;
+      double bcx = b.x - c.x;
+      double acy = a.y - c.y;
+      double bcy = b.y - c.y;
+
+      //Stage B: exact determinant of the (rounded) differences
+      double det_left, det_left_tail, det_right, det_right_tail;
+      TwoProduct(acx, bcy, det_left, det_left_tail);
+      TwoProduct(acy, bcx, det_right, det_right_tail);
+      double B[4];
+      TwoTwoDiff(det_left, det_left_tail, det_right, det_right_tail, B);
+      double det = Estimate(4, B);
+      double err_bound = s_ccw_err_bound_B * det_sum;
+      if((det >= err_bound) || (-det >= err_bound))
+        return det;
+
+      //Stage C: first order correction for the rounding error in the differences
+      double acx_tail, bcx_tail, acy_tail, bcy_tail;
+      TwoDiffTail(a.x, c.x, acx, acx_tail);
+      TwoDiffTail(b.x, c.x, bcx, bcx_tail);
+      TwoDiffTail(a.y, c.y, acy, acy_tail);
+      TwoDiffTail(b.y, c.y, bcy, bcy_tail);
+      if((acx_tail == 0.0) && (acy_tail == 0.0) && (bcx_tail == 0.0) && (bcy_tail == 0.0))
+        return det; //differences were exact, so B is the exact determinant
+
+      err_bound = s_ccw_err_bound_C * det_sum + s_result_err_bound * std::abs(det);
+      det += (acx * bcy_tail + bcy * acx_tail) - (acy * bcx_tail + bcx * acy_tail);
+      if((det >= err_bound) || (-det >= err_bound))
+        return det;
+
+      //Stage D: fully exact
+      double s1, s0, t1, t0, u[4];
+      TwoProduct(acx_tail, bcy, s1, s0);
+      TwoProduct(acy_tail, bcx, t1, t0);
+      TwoTwoDiff(s1, s0, t1, t0, u);
+      double C1[8];
+      int C1_len = FastExpansionSumZeroElim(4, B, 4, u, C1);
+
+      TwoProduct(acx, bcy_tail, s1, s0);
+      TwoProduct(acy, bcx_tail, t1, t0);
+      TwoTwoDiff(s1, s0, t1, t0, u);
+      double C2[12];
+      int C2_len = FastExpansionSumZeroElim(C1_len, C1, 4, u, C2);
+
+      TwoProduct(acx_tail, bcy_tail, s1, s0);
+      TwoProduct(acy_tail, bcx_tail, t1, t0);
+      TwoTwoDiff(s1, s0, t1, t0, u);
+      double D[16];
+      int D_len = FastExpansionSumZeroElim(C2_len, C2, 4, u, D);
+      return D[D_len - 1];
+    }
+
+    //a.x * b.y - b.x * a.y as a 4 component expansion
+    inline void CrossExact(const DPoint2d& a, const DPoint2d& b, double* x)
+    {
+      double p1, p0, q1, q0;
+      TwoProduct(a.x, b.y, p1, p0);
+      TwoProduct(b.x, a.y, q1, q0);
+      TwoTwoDiff(p1, p0, q1, q0, x);
+    }
+
+    //(p.x^2 + p.y^2) * e
+    int LiftExpansion(int elen, const double* e, const DPoint2d& p, double sign, double* h)
+    {
+      double x24[24], x48[48], y24[24], y48[48];
+      int x_len = ScaleExpansionZeroElim(elen, e, p.x, x24);
+      x_len = ScaleExpansionZeroElim(x_len, x24, sign * p.x, x48);
+      int y_len = ScaleExpansionZeroElim(elen, e, p.y, y24);
+      y_len = ScaleExpansionZeroElim(y_len, y24, sign * p.y, y48);
+      return FastExpansionSumZeroElim(x_len, x48, y_len, y48, h);
+    }
+
+    //Exact incircle determinant, from the raw coordinates (no differences, so no rounding error to correct for).
+    //Slow, but only reached when the filter in InCircle() can't decide, which is rare outside of exactly
+    //cocircular points
+    double InCircleExact(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d)
+    {
+      double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+      CrossExact(a, b, ab);
+      CrossExact(b, c, bc);
+      CrossExact(c, d, cd);
+      CrossExact(d, a, da);
+      CrossExact(a, c, ac);
+      CrossExact(b, d, bd);
+
+      double temp8[8], cda[12], dab[12], abc[12], bcd[12];
+      int temp_len = FastExpansionSumZeroElim(4, cd, 4, da, temp8);
+      int cda_len = FastExpansionSumZeroElim(temp_len, temp8, 4, ac, cda);
+      temp_len = FastExpansionSumZeroElim(4, da, 4, ab, temp8);
+      int dab_len = FastExpansionSumZeroElim(temp_len, temp8, 4, bd, dab);
+      for(int i = 0; i < 4; i++) {
+        bd[i] = -bd[i];
+        ac[i] = -ac[i];
+      }
+      temp_len = FastExpansionSumZeroElim(4, ab, 4, bc, temp8);
+      int abc_len = FastExpansionSumZeroElim(temp_len, temp8, 4, ac, abc);
+      temp_len = FastExpansionSumZeroElim(4, bc, 4, cd, temp8);
+      int bcd_len = FastExpansionSumZeroElim(temp_len, temp8, 4, bd, bcd);
+
+      double a_det[96], b_det[96], c_det[96], d_det[96];
+      int a_len = LiftExpansion(bcd_len, bcd, a, 1.0, a_det);
+      int b_len = LiftExpansion(cda_len, cda, b, -1.0, b_det);
+      int c_len = LiftExpansion(dab_len, dab, c, 1.0, c_det);
+      int d_len = LiftExpansion(abc_len, abc, d, -1.0, d_det);
+
+      double ab_det[192], cd_det[192], det[384];
+      int ab_len = FastExpansionSumZeroElim(a_len, a_det, b_len, b_det, ab_det);
+      int cd_len = FastExpansionSumZeroElim(c_len, c_det, d_len, d_det, cd_det);
+      int det_len = FastExpansionSumZeroElim(ab_len, ab_det, cd_len, cd_det, det);
+      return det[det_len - 1];
+    }
+  }
+
+  double Orient2dFast(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c)
+  {
+    return (a.x - c.x) * (b.y - c.y) - (a.y - c.y) * (b.x - c.x);
+  }
+
+  double Orient2d(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c)
+  {
+    double det_left = (a.x - c.x) * (b.y - c.y);
+    double det_right = (a.y - c.y) * (b.x - c.x);
+    double det = det_left - det_right;
+
+    //Opposite signs (or a zero) => no cancellation, the sign is right
+    double det_sum;
+    if(det_left > 0.0) {
+      if(det_right <= 0.0)
+        return det;
+      det_sum = det_left + det_right;
+    }
+    else if(det_left < 0.0) {
+      if(det_right >= 0.0)
+        return det;
+      det_sum = -det_left - det_right;
+    }
+    else
+      return det;
+
+    double err_bound = s_ccw_err_bound_A * det_sum;
+    if((det >= err_bound) || (-det >= err_bound))
+      return det;
+    return Orient2dAdapt(a, b, c, det_sum);
+  }
+
+  double InCircleFast(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d)
+  {
+    DVec2 ad = a - d, bd = b - d, cd = c - d;
+    double a_lift = ad.x * ad.x + ad.y * ad.y;
+    double b_lift = bd.x * bd.x + bd.y * bd.y;
+    double c_lift = cd.x * cd.x + cd.y * cd.y;
+    return a_lift * (bd.x * cd.y - cd.x * bd.y) + b_lift * (cd.x * ad.y - ad.x * cd.y) + c_lift * (ad.x * bd.y - bd.x * ad.y);
+  }
+
+  double InCircle(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d)
+  {
+    DVec2 ad = a - d, bd = b - d, cd = c - d;
+    double bd_x_cd_y = bd.x * cd.y;
+    double cd_x_bd_y = cd.x * bd.y;
+    double a_lift = ad.x * ad.x + ad.y * ad.y;
+    double cd_x_ad_y = cd.x * ad.y;
+    double ad_x_cd_y = ad.x * cd.y;
+    double b_lift = bd.x * bd.x + bd.y * bd.y;
+    double ad_x_bd_y = ad.x * bd.y;
+    double bd_x_ad_y = bd.x * ad.y;
+    double c_lift = cd.x * cd.x + cd.y * cd.y;
+
+    double det = a_lift * (bd_x_cd_y - cd_x_bd_y) + b_lift * (cd_x_ad_y - ad_x_cd_y) + c_lift * (ad_x_bd_y - bd_x_ad_y);
+    double permanent = (std::abs(bd_x_cd_y) + std::abs(cd_x_bd_y)) * a_lift +
+                       (std::abs(cd_x_ad_y) + std::abs(ad_x_cd_y)) * b_lift +
+                       (std::abs(ad_x_bd_y) + std::abs(bd_x_ad_y)) * c_lift;
+    double err_bound = s_icc_err_bound_A * permanent;
+    if((det > err_bound) || (-det > err_bound))
+      return det;
+    return InCircleExact(a, b, c, d);
+  }
+
+  RelativePos Orientation2dExact(const Point2d& a, const Point2d& b, const Point2d& c)
+  {
+    double det = Orient2d(a, b, c);
+    if(det > 0.0)
+      return RelativePos::Left;
+    if(det < 0.0)
+      return RelativePos::Right;
+    if(a == c)
+      return RelativePos::Origin;
+    if(b == c)
+      return RelativePos::Destination;
+
+    //Collinear. Differences of floats are exact in double, so is the rest
+    DVec2 ab = DPoint2d(b) - DPoint2d(a);
+    DVec2 ac = DPoint2d(c) - DPoint2d(a);
+    if((ab.x * ac.x < 0.0) || (ab.y * ac.y < 0.0))
+      return RelativePos::Behind;
+    if(glm::dot(ab, ab) < glm::dot(ac, ac))
+      return RelativePos::Beyond;
+    return RelativePos::Between;
+  }
+
+  bool LeftExact(const LineSeg2D& line_seg, const Point2d& p)
+  {
+    return Orient2d(line_seg.start, line_seg.end, p) > 0.0;
+  }
+
+  bool IntersectionExistsExact(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d)
+  {
+    int o1 = Orient2dSign(a, b, c);
+    int o2 = Orient2dSign(a, b, d);
+    int o3 = Orient2dSign(c, d, a);
+    int o4 = Orient2dSign(c, d, b);
+    if((o1 * o2 < 0) && (o3 * o4 < 0))
+      return true; //proper crossing
+
+    //Touching: an endpoint of one seg is on the other. The point is collinear with it, so being in its bounding box
+    //is enough
+    auto in_box = [](const DPoint2d& p, const DPoint2d& q, const DPoint2d& r) {
+      return (r.x >= std::min(p.x, q.x)) && (r.x <= std::max(p.x, q.x)) && (r.y >= std::min(p.y, q.y)) && (r.y <= std::max(p.y, q.y));
+    };
+    return ((o1 == 0) && in_box(a, b, c)) || ((o2 == 0) && in_box(a, b, d)) ||
+           ((o3 == 0) && in_box(c, d, a)) || ((o4 == 0) && in_box(c, d, b));
+  }
+
+  bool IntersectionExistsExact(const LineSeg2D& line_seg1, const LineSeg2D& line_seg2)
+  {
+    return IntersectionExistsExact(DPoint2d(line_seg1.start), DPoint2d(line_seg1.end), DPoint2d(line_seg2.start), DPoint2d(line_seg2.end));
+  }
+}
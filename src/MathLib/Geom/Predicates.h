@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MathLib/Geom/Geom.h"
+
+namespace SpgMth
+{
+  //Robust geometric predicates, after Shewchuk's "Adaptive Precision Floating-Point Arithmetic and Fast Robust
+  //Geometric Predicates". The sign of the result is always correct for the given double inputs (no epsilon tests):
+  //a plain double evaluation is used if it's further from zero than its worst case rounding error, which is nearly
+  //always, and otherwise the determinant is recomputed with increasing precision (expansion arithmetic) until the
+  //sign is certain. Float points convert to double exactly, so the float overloads are exact too.
+  //
+  //The magnitude is only approximate - use these for the sign. Not valid for inputs that overflow / underflow.
+
+  //> 0 if a,b,c are in CCW order (c is left of a->b), < 0 if CW, 0 if exactly collinear. Approx 2x the signed area
+  double Orient2d(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c);
+
+  //> 0 if d is inside the circle through a,b,c (which must be in CCW order, otherwise the sign is flipped), < 0 if
+  //outside, 0 if exactly on it
+  double InCircle(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d);
+
+  //Plain double evaluation, no guarantee on the sign. For comparison / when a wrong answer is acceptable
+  double Orient2dFast(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c);
+  double InCircleFast(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d);
+
+  inline double Orient2d(const Point2d& a, const Point2d& b, const Point2d& c)
+  {
+    return Orient2d(DPoint2d(a), DPoint2d(b), DPoint2d(c));
+  }
+
+  inline double InCircle(const Point2d& a, const Point2d& b, const Point2d& c, const Point2d& d)
+  {
+    return InCircle(DPoint2d(a), DPoint2d(b), DPoint2d(c), DPoint2d(d));
+  }
+
+  //-1, 0 or 1
+  inline int Orient2dSign(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c)
+  {
+    double det = Orient2d(a, b, c);
+    return (det > 0) - (det < 0);
+  }
+
+  //Exact counterparts of Orientation2d(), Left() and IntersectionExists() in Geom.h. Those treat anything within an
+  //epsilon of collinear as collinear, these only exactly collinear, so they never contradict each other (e.g. a
+  //point left of a->b and right of b->a can't happen) and degenerate input can't make a loop cycle forever
+  RelativePos Orientation2dExact(const Point2d& a, const Point2d& b, const Point2d& c);
+
+  bool LeftExact(const LineSeg2D& line_seg, const Point2d& p);
+
+  //Touching counts (shared endpoints, T junctions, collinear overlaps)
+  bool IntersectionExistsExact(const LineSeg2D& line_seg1, const LineSeg2D& line_seg2);
+  bool IntersectionExistsExact(const DPoint2d& a, const DPoint2d& b, const DPoint2d& c, const DPoint2d& d);
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include "MathLib/MathLib.h"
+
+//Minimal portable SIMD layer for the batch kernels (Geom/BatchPredicates). Picks the widest double lane type the
+//compiler is targeting: AVX2 (4 lanes) if __AVX2__ is defined (-mavx2 / -march=native, /arch:AVX2 on MSVC), else
+//SSE2 (2 lanes, always available on x86-64), else a plain double. Define SPG_SIMD_SCALAR to force the scalar path.
+//
+//Kernels are written once as templates over the lane type, using only what's here: arithmetic operators,
+//comparisons giving a Mask (value initialised = all lanes false), Bits() to get a mask as an int (bit i = lane i)
+//and LoadPoints() to load s_width consecutive Point2d's as separate x and y lanes. DoubleX1 is always available,
+//for loop tails.
+//
+//Doubles rather than floats so that a lane gives the bit identical result to the equivalent scalar double code.
+
+#if !defined(SPG_SIMD_SCALAR)
+  #if defined(__AVX2__)
+    #define SPG_SIMD_AVX2
+  #endif
+  #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SPG_SIMD_SSE2
+  #endif
+#endif
+
+#if defined(SPG_SIMD_AVX2) || defined(SPG_SIMD_SSE2)
+  #include <immintrin.h>
+#endif
+
+namespace SpgMth::Simd
+{
+  static_assert(sizeof(Point2d) == 2 * sizeof(float), "LoadPoints() expects tightly packed Point2d's");
+
+  // ==== Scalar ==============================================================================
+
+  struct MaskX1
+  {
+    bool v;
+    MaskX1 operator & (MaskX1 o) const { return {v && o.v}; }
+    MaskX1 operator | (MaskX1 o) const { return {v || o.v}; }
+    MaskX1 operator ^ (MaskX1 o) const { return {v != o.v}; }
+  };
+
+  struct DoubleX1
+  {
+    using Mask = MaskX1;
+    static constexpr uint32_t s_width = 1;
+    double v;
+
+    static DoubleX1 Set(double d) { return {d}; }
+    DoubleX1 operator + (DoubleX1 o) const { return {v + o.v}; }
+    DoubleX1 operator - (DoubleX1 o) const { return {v - o.v}; }
+    DoubleX1 operator * (DoubleX1 o) const { return {v * o.v}; }
+    DoubleX1 operator / (DoubleX1 o) const { return {v / o.v}; }
+  };
+
+  inline DoubleX1 Abs(DoubleX1 a) { return {std::abs(a.v)}; }
+  inline MaskX1 Lt(DoubleX1 a, DoubleX1 b) { return {a.v < b.v}; }
+  inline MaskX1 Gt(DoubleX1 a, DoubleX1 b) { return {a.v > b.v}; }
+  inline MaskX1 Ge(DoubleX1 a, DoubleX1 b) { return {a.v >= b.v}; }
+  inline uint32_t Bits(MaskX1 m) { return m.v ? 1u : 0u; }
+
+  inline void LoadPoints(const Point2d* pts, DoubleX1& x, DoubleX1& y)
+  {
+    x.v = pts->x;
+    y.v = pts->y;
+  }
+
+  // ==== SSE2 ================================================================================
+
+#if defined(SPG_SIMD_SSE2)
+  struct MaskX2
+  {
+    __m128d v;
+    MaskX2 operator & (MaskX2 o) const { return {_mm_and_pd(v, o.v)}; }
+    MaskX2 operator | (MaskX2 o) const { return {_mm_or_pd(v, o.v)}; }
+    MaskX2 operator ^ (MaskX2 o) const { return {_mm_xor_pd(v, o.v)}; }
+  };
+
+  struct DoubleX2
+  {
+    using Mask = MaskX2;
+    static constexpr uint32_t s_width = 2;
+    __m128d v;
+
+    static DoubleX2 Set(double d) { return {_mm_set1_pd(d)}; }
+    DoubleX2 operator + (DoubleX2 o) const { return {_mm_add_pd(v, o.v)}; }
+    DoubleX2 operator - (DoubleX2 o) const { return {_mm_sub_pd(v, o.v)}; }
+    DoubleX2 operator * (DoubleX2 o) const { return {_mm_mul_pd(v, o.v)}; }
+    DoubleX2 operator / (DoubleX2 o) const { return {_mm_div_pd(v, o.v)}; }
+  };
+
+  inline DoubleX2 Abs(DoubleX2 a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+  inline MaskX2 Lt(DoubleX2 a, DoubleX2 b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+  inline MaskX2 Gt(DoubleX2 a, DoubleX2 b) { return {_mm_cmpgt_pd(a.v, b.v)}; }
+  inline MaskX2 Ge(DoubleX2 a, DoubleX2 b) { return {_mm_cmpge_pd(a.v, b.v)}; }
+  inline uint32_t Bits(MaskX2 m) { return (uint32_t)_mm_movemask_pd(m.v); }
+
+  inline void LoadPoints(const Point2d* pts, DoubleX2& x, DoubleX2& y)
+  {
+    //x0 y0 x1 y1 -> x0 x1 y0 y1
+    __m128 v = _mm_loadu_ps(&pts->x);
+    v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 2, 0));
+    x.v = _mm_cvtps_pd(v);
+    y.v = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+  }
+#endif
+
+  // ==== AVX2 ================================================================================
+
+#if defined(SPG_SIMD_AVX2)
+  struct MaskX4
+  {
+    __m256d v;
+    MaskX4 operator & (MaskX4 o) const { return {_mm256_and_pd(v, o.v)}; }
+    MaskX4 operator | (MaskX4 o) const { return {_mm256_or_pd(v, o.v)}; }
+    MaskX4 operator ^ (MaskX4 o) const { return {_mm256_xor_pd(v, o.v)}; }
+  };
+
+  struct DoubleX4
+  {
+    using Mask = MaskX4;
+    static constexpr uint32_t s_width = 4;
+    __m256d v;
+
+    static DoubleX4 Set(double d) { return {_mm256_set1_pd(d)}; }
+    DoubleX4 operator + (DoubleX4 o) const { return {_mm256_add_pd(v, o.v)}; }
+    DoubleX4 operator - (DoubleX4 o) const { return {_mm256_sub_pd(v, o.v)}; }
+    DoubleX4 operator * (DoubleX4 o) const { return {_mm256_mul_pd(v, o.v)}; }
+    DoubleX4 operator / (DoubleX4 o) const { return {_mm256_div_pd(v, o.v)}; }
+  };
+
+  inline DoubleX4 Abs(DoubleX4 a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+  inline MaskX4 Lt(DoubleX4 a, DoubleX4 b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+  inline MaskX4 Gt(DoubleX4 a, DoubleX4 b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+  inline MaskX4 Ge(DoubleX4 a, DoubleX4 b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)}; }
+  inline uint32_t Bits(MaskX4 m) { return (uint32_t)_mm256_movemask_pd(m.v); }
+
+  inline void LoadPoints(const Point2d* pts, DoubleX4& x, DoubleX4& y)
+  {
+    //x0 y0 x1 y1 x2 y2 x3 y3 -> x0 x1 x2 x3 | y0 y1 y2 y3
+    __m256 v = _mm256_loadu_ps(&pts->x);
+    v = _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+    x.v = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    y.v = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+  }
+#endif
+
+  //Widest available
+#if defined(SPG_SIMD_AVX2)
+  using DoubleV = DoubleX4;
+#elif defined(SPG_SIMD_SSE2)
+  using DoubleV = DoubleX2;
+#else
+  using DoubleV = DoubleX1;
+#endif
+}
@@ -3,8 +3,16 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
 
+#include <random>
+#include <set>
+#include <map>
+#include <stdexcept>
+#include <limits>
+
 #include "Geometry/Geometry.h"
 #include "MathLib/Geom/Geom.h"
+#include "MathLib/Geom/Predicates.h"
+#include "MathLib/Geom/BatchPredicates.h"
 
 namespace GeomTest 
 {
@@ -217,6 +225,159 @@ namespace GeomTest
   REQUIRE(SpgMth::IntersectionExists(L1,L2) == false); //Segments don't cross FAILS!?
 
   
+  }
+
+  TEST_CASE( "Exact predicates", "Orient2d(), InCircle(), IntersectionExistsExact()") {
+  //Orient2d: a on a 256x256 grid of ulps around (0.5,0.5), b and c further along y=x. The exact determinant is
+  //12 * (a.y - a.x) / ulp, so the sign is known. (Shewchuk's example - the plain double version gets ~1/6 wrong)
+  const double ulp = std::ldexp(1.0, -53);
+  int num_wrong = 0;
+  for(int i=0; i<256; i++) {
+    for(int j=0; j<256; j++) {
+      double det = SpgMth::Orient2d(SpgMth::DPoint2d{0.5 + i*ulp, 0.5 + j*ulp}, SpgMth::DPoint2d{12,12}, SpgMth::DPoint2d{24,24});
+      num_wrong += (((det > 0) - (det < 0)) != ((j > i) - (j < i)));
+    }
+  }
+  REQUIRE(num_wrong == 0);
+
+  //InCircle: lattice points on a circle of radius 65, scaled and offset far from the origin so the plain double
+  //version loses the sign. d exactly on the circle, then nudged out / in by the smallest step
+  const double on_circle[][2] = {{16,63},{63,16},{33,56},{-56,33},{39,-52},{-52,-39},{25,60},{-60,-25},{0,-65}};
+  num_wrong = 0;
+  std::mt19937 mt(16);
+  for(int rep=0; rep<50; rep++) {
+    double offset = 4194304.0 + (mt() % 1000);
+    double scale = 1 + (mt() % 4000);
+    auto pt = [&](double x, double y) { return SpgMth::DPoint2d{offset + x*scale, offset + y*scale}; };
+    SpgMth::DPoint2d a = pt(65,0), b = pt(0,65), c = pt(-65,0); //CCW
+    for(auto& p : on_circle) {
+      SpgMth::DPoint2d d = pt(p[0],p[1]);
+      SpgMth::DVec2 out{(p[0] > 0) - (p[0] < 0), (p[1] > 0) - (p[1] < 0)};
+      out /= 1024.0;
+      num_wrong += (SpgMth::InCircle(a,b,c,d) != 0);
+      num_wrong += !(SpgMth::InCircle(a,b,c,d + out) < 0);
+      num_wrong += !(SpgMth::InCircle(a,b,c,d - out) > 0);
+      num_wrong += !(SpgMth::InCircle(b,a,c,d - out) < 0); //CW order flips the sign
+    }
+  }
+  REQUIRE(num_wrong == 0);
+
+  SpgMth::Point2d A{0,0}, B{4,2}, C{2,1};
+  REQUIRE(SpgMth::Orientation2dExact(A,B,C) == SpgMth::RelativePos::Between);
+  REQUIRE(SpgMth::Orientation2dExact(A,C,B) == SpgMth::RelativePos::Beyond);
+  REQUIRE(SpgMth::Orientation2dExact(C,B,A) == SpgMth::RelativePos::Behind);
+  REQUIRE(SpgMth::Orientation2dExact(A,B,A) == SpgMth::RelativePos::Origin);
+  REQUIRE(SpgMth::Orientation2dExact(A,B,B) == SpgMth::RelativePos::Destination);
+  C = {2, std::nextafter(1.0f, 2.0f)}; //as near collinear as floats get
+  REQUIRE(SpgMth::Orientation2dExact(A,B,C) == SpgMth::RelativePos::Left);
+  REQUIRE(SpgMth::Orientation2dExact(B,A,C) == SpgMth::RelativePos::Right);
+  REQUIRE(SpgMth::LeftExact({A,B},C));
+
+  //Same cases as "Intersection Exists"
+  SpgMth::LineSeg2D L1{{20,30},{60,20}}, L2{{50,30},{30,20}};
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == true); //Segments cross
+  L1={{20,30},{70,31}}; L2={{50,30},{30,20}};
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == false); //L2 is below L1 all the way along
+  L1={{20,30},{70,31}}; L2={{10,27},{80,33}};
+  REQUIRE(SpgMth::IntersectionExistsExact(L2,L1) == true); //Segments cross
+  L1={{20,30},{50,20}}; L2={{50,30},{50,10}}; 
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == true); //Enpoint of L1 lies on L2
+  REQUIRE(SpgMth::IntersectionExistsExact(L2,L1) == true);
+  L1={{20,30},{50,20}}; L2={{50,20},{60,30}}; 
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == true); //Coinciding endpoints
+  L1={{0,0},{4,2}}; L2={{2,1},{6,3}}; 
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == true); //Collinear overlap
+  L2={{5,2.5f},{6,3}}; 
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == false); //Collinear, disjoint
+  L1={{10,30},{20,45}}; L2={{20,40},{60,30}}; 
+  REQUIRE(SpgMth::IntersectionExistsExact(L2,L1) == false); //Segments don't cross
+  REQUIRE(SpgMth::IntersectionExistsExact(L1,L2) == false);
+
+#if defined(RUN_BENCHMARKS)     
+  SpgMth::DPoint2d pa{-2.96,-1.48}, pb{5.044,1.43}, pc{-3.02,0.924}, pd{1.5,1.2};
+  BENCHMARK("Orient2dFast") { return SpgMth::Orient2dFast(pa,pb,pc); };
+  BENCHMARK("Orient2d") { return SpgMth::Orient2d(pa,pb,pc); };
+  BENCHMARK("Orient2d near degenerate") { return SpgMth::Orient2d(SpgMth::DPoint2d{0.5 + ulp, 0.5}, SpgMth::DPoint2d{12,12}, SpgMth::DPoint2d{24,24}); };
+  BENCHMARK("InCircleFast") { return SpgMth::InCircleFast(pa,pb,pc,pd); };
+  BENCHMARK("InCircle") { return SpgMth::InCircle(pa,pb,pc,pd); };
+#endif  
+  }
+
+  TEST_CASE( "Batch predicates", "Orient2dBatch(), LeftBatch(), PointInPolygonBatch()") {
+  //Random points mixed with points exactly on / a float step either side of the segment, an odd count so the
+  //scalar tail gets used. Every result must match the per point function
+  std::mt19937 mt(17);
+  std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+  SpgMth::LineSeg2D seg{{-50.0f, -20.0f}, {70.0f, 40.0f}};
+  std::vector<SpgMth::Point2d> pts;
+  for(int i=0; i<10007; i++) {
+    if(i % 3 == 0) {
+      float x = -50.0f + 2.0f * (i % 61); //on the segment's line
+      float y = 0.5f * x + 5.0f;
+      pts.push_back({x, (i % 2) ? y : std::nextafter(y, (i % 4 == 0) ? 1000.0f : -1000.0f)});
+    }
+    else
+      pts.push_back({dist(mt), dist(mt)});
+  }
+
+  std::vector<int8_t> signs(pts.size());
+  std::vector<uint8_t> left(pts.size());
+  std::vector<uint64_t> left_mask(SpgMth::BitmaskWords(pts.size()));
+  SpgMth::Orient2dBatch(seg.start, seg.end, pts, signs);
+  SpgMth::LeftBatch(seg, pts, left);
+  SpgMth::LeftBatch(seg, pts, left_mask);
+  int num_wrong = 0, num_collinear = 0;
+  for(std::size_t i=0; i<pts.size(); i++) {
+    num_wrong += (signs[i] != SpgMth::Orient2dSign(SpgMth::DPoint2d(seg.start), SpgMth::DPoint2d(seg.end), SpgMth::DPoint2d(pts[i])));
+    num_wrong += (left[i] != SpgMth::LeftExact(seg, pts[i]));
+    num_wrong += (SpgMth::TestBit(left_mask, i) != SpgMth::LeftExact(seg, pts[i]));
+    num_collinear += (signs[i] == 0);
+  }
+  REQUIRE(num_wrong == 0);
+  REQUIRE(num_collinear > 0);
+
+  //Star shaped polygon. Include the vertices themselves and points level with them
+  std::vector<SpgMth::Point2d> polygon;
+  for(int i=0; i<40; i++) {
+    float r = (i % 2) ? 30.0f : 90.0f;
+    float angle = i * 2.0f * 3.14159265f / 40;
+    polygon.push_back({r * std::cos(angle), r * std::sin(angle)});
+  }
+  for(auto& v : polygon) {
+    pts.push_back(v);
+    pts.push_back({v.x - 1.0f, v.y});
+  }
+  std::vector<uint8_t> inside(pts.size());
+  std::vector<uint64_t> inside_mask(SpgMth::BitmaskWords(pts.size()), ~0ull);
+  SpgMth::PointInPolygonBatch(polygon, pts, inside);
+  SpgMth::PointInPolygonBatch(polygon, pts, inside_mask);
+  num_wrong = 0;
+  int num_inside = 0;
+  for(std::size_t i=0; i<pts.size(); i++) {
+    num_wrong += (inside[i] != SpgMth::PointInPolygon(polygon, pts[i]));
+    num_wrong += (SpgMth::TestBit(inside_mask, i) != SpgMth::PointInPolygon(polygon, pts[i]));
+    num_inside += inside[i];
+  }
+  REQUIRE(num_wrong == 0);
+  REQUIRE(num_inside > 0);
+  REQUIRE((inside_mask.back() >> (pts.size() % 64)) == 0); //unused bits cleared
+
+#if defined(RUN_BENCHMARKS)
+  BENCHMARK("LeftExact, 10007 points") {
+    int count = 0;
+    for(auto& p : pts)
+      count += SpgMth::LeftExact(seg, p);
+    return count;
+  };
+  BENCHMARK("LeftBatch (bitmask), 10007 points") { SpgMth::LeftBatch(seg, pts, left_mask); return left_mask[0]; };
+  BENCHMARK("PointInPolygon, 40 vertices, 10087 points") {
+    int count = 0;
+    for(auto& p : pts)
+      count += SpgMth::PointInPolygon(polygon, p);
+    return count;
+  };
+  BENCHMARK("PointInPolygonBatch, 40 vertices, 10087 points") { SpgMth::PointInPolygonBatch(polygon, pts, inside); return inside[0]; };
+#endif
   }
 
   TEST_CASE( "Compute Angle, Subtended Angle 2d", "ComputeAngleInDegrees(), ComputeSubtendedAngleInDegrees()") 
@@ -308,6 +469,1574 @@ namespace GeomTest
 
   }
 
+  TEST_CASE( "PointSoA2D container and overloads", "PointSoA2D, Convexhull2D_ModifiedGrahams(PointSoAView2D), KDTree2D(PointSoAView2D)") 
+  {
+    std::mt19937 mt(18); 
+    std::uniform_real_distribution<float> fdist(-500.0f, 500.0f); 
+    std::vector<SpgMth::Point2d> points;
+    for(int i=0; i<20000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    for(int i=0; i<50; i++) 
+      points.push_back({points[i].x, fdist(mt)}); //equal x's
+
+    Geom::PointSoA2D soa(points);
+    REQUIRE(soa.Size() == points.size());
+    REQUIRE(((uintptr_t)soa.X() % Geom::PointSoA2D::s_alignment) == 0);
+    REQUIRE(((uintptr_t)soa.Y() % Geom::PointSoA2D::s_alignment) == 0);
+    REQUIRE(soa.ToPoints() == points);
+    Geom::PointSoAView2D sub = soa.Subview(100, 50);
+    REQUIRE(sub.Size() == 50);
+    REQUIRE(sub[0] == points[100]);
+    REQUIRE(sub.X() == soa.X() + 100); //no copy
+
+    REQUIRE(Geom::Convexhull2D_ModifiedGrahams(soa) == Geom::Convexhull2D_ModifiedGrahams(points));
+    auto sub_points = sub.ToPoints();
+    REQUIRE(Geom::Convexhull2D_ModifiedGrahams(sub) == Geom::Convexhull2D_ModifiedGrahams(sub_points));
+
+    Geom::KDTree2D tree(points, Geom::KDTree2D::Layout::Flat);
+    Geom::KDTree2D soa_tree(soa, Geom::KDTree2D::Layout::Flat);
+    Geom::KDTree2D::Range range{-100, 50, 0, 300};
+    REQUIRE(soa_tree.Size() == points.size());
+    REQUIRE(soa_tree.RangeCount(range) == tree.RangeCount(range));
+
+    Geom::PointSoA2D random;
+    Geom::GenerateRandomPoints_XY(10.0f, 1000, random);
+    REQUIRE(random.Size() == 1000);
+    int num_outside = 0;
+    for(std::size_t i=0; i<random.Size(); i++)
+      num_outside += (std::abs(random[i].x) > 10.0f) || (std::abs(random[i].y) > 10.0f);
+    REQUIRE(num_outside == 0);
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("Convexhull2D_ModifiedGrahams, std::vector<Point2d>, 20050 points") { 
+      return Geom::Convexhull2D_ModifiedGrahams(points);
+    };
+    BENCHMARK("Convexhull2D_ModifiedGrahams, PointSoA2D, 20050 points") { 
+      return Geom::Convexhull2D_ModifiedGrahams(soa);
+    };
+  #endif
+  }
+
+  TEST_CASE( "Chan and parallel convex hulls", "ConvexHull2D_Chan(), ConvexHull2D_Parallel(), AklToussaintCull()") 
+  {
+    //Strictly convex, CCW and everything inside or on it
+    auto check_hull = [](const std::vector<SpgMth::Point2d>& hull, const std::vector<SpgMth::Point2d>& points) {
+      const std::size_t n = hull.size();
+      int num_wrong = 0;
+      for(std::size_t i=0; (n >= 3) && (i<n); i++) {
+        num_wrong += !(SpgMth::Orient2d(hull[i], hull[(i+1)%n], hull[(i+2)%n]) > 0);
+        for(auto& p : points)
+          num_wrong += (SpgMth::Orient2d(hull[i], hull[(i+1)%n], p) < 0);
+      }
+      return num_wrong;
+    };
+
+    std::mt19937 mt(19); 
+    std::uniform_real_distribution<float> fdist(-1000.0f, 1000.0f); 
+    std::vector<std::vector<SpgMth::Point2d>> inputs(5);
+    for(int i=0; i<300000; i++) 
+      inputs[0].push_back({fdist(mt),fdist(mt)});
+    while(inputs[1].size() < 300000) {
+      SpgMth::Point2d p{fdist(mt),fdist(mt)};
+      if(p.x*p.x + p.y*p.y < 1000.0f*1000.0f)
+        inputs[1].push_back(p);
+    }
+    for(int i=0; i<40000; i++) //grid - lots of collinear and duplicate points
+      inputs[2].push_back({(float)(mt() % 100), (float)(mt() % 60)});
+    for(int i=0; i<1000; i++) //all collinear
+      inputs[3].push_back({(float)(mt() % 500), 7.0f});
+    inputs[4] = {{1,1},{1,1},{1,1}};
+
+    Core::ThreadPool pool(4);
+    for(auto& points : inputs) {
+      auto chan = Geom::ConvexHull2D_Chan(points);
+      auto parallel = Geom::ConvexHull2D_Parallel(points, pool);
+      auto gift_wrap = Geom::ConvexHull2D_GiftWrap(points);
+      REQUIRE(chan == parallel);
+      REQUIRE(check_hull(chan, points) == 0);
+      if(chan.size() >= 3) {
+        //Same points, gift wrapping starts at the bottom rather than the left
+        REQUIRE(gift_wrap.size() == chan.size());
+        std::rotate(gift_wrap.begin(), std::find(gift_wrap.begin(), gift_wrap.end(), chan[0]), gift_wrap.end());
+        REQUIRE(gift_wrap == chan);
+      }
+    }
+    REQUIRE(Geom::ConvexHull2D_Chan(inputs[3]).size() == 2);
+    REQUIRE(Geom::ConvexHull2D_Chan(inputs[4]).size() == 1);
+    REQUIRE(Geom::AklToussaintCull(inputs[0]).size() < inputs[0].size() / 10);
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("Convexhull2D_ModifiedGrahams, 300000 points") { 
+      return Geom::Convexhull2D_ModifiedGrahams(inputs[0]);
+    };
+    BENCHMARK("ConvexHull2D_Chan, 300000 points") { 
+      return Geom::ConvexHull2D_Chan(inputs[0]);
+    };
+    BENCHMARK("ConvexHull2D_Parallel, 300000 points") { 
+      return Geom::ConvexHull2D_Parallel(inputs[0], pool);
+    };
+  #endif
+  }
+
+  TEST_CASE( "Incremental convex hull", "IncrementalHull2D::Insert(), IncrementalHull2D::Contains()") 
+  {
+    std::mt19937 mt(29); 
+    std::normal_distribution<float> ndist(0.0f, 100.0f); 
+    std::vector<std::vector<SpgMth::Point2d>> inputs(4);
+    for(int i=0; i<20000; i++) 
+      inputs[0].push_back({ndist(mt),ndist(mt)});
+    for(int i=0; i<5000; i++) //grid - lots of collinear and duplicate points
+      inputs[1].push_back({(float)(mt() % 30), (float)(mt() % 20)});
+    for(int i=0; i<500; i++) //all collinear
+      inputs[2].push_back({(float)(mt() % 200), 3.0f});
+    for(int i=0; i<2000; i++) //spiralling outwards - every point is a new hull vertex, most knock others off
+      inputs[3].push_back({i * std::cos(i * 0.1f), i * std::sin(i * 0.1f)});
+
+    const std::size_t BATCH_SIZE = 500;
+    for(auto& points : inputs) {
+      Geom::IncrementalHull2D inc_hull;
+      REQUIRE(inc_hull.Empty());
+      REQUIRE(!inc_hull.Contains({0,0}));
+      for(std::size_t first = 0; first < points.size(); first += BATCH_SIZE) {
+        std::size_t count = std::min(BATCH_SIZE, points.size() - first);
+        inc_hull.Insert(std::span(points).subspan(first, count));
+        auto hull = inc_hull.Hull();
+        REQUIRE(hull == Geom::ConvexHull2D_Chan(std::span(points).first(first + count)));
+        REQUIRE(inc_hull.NumVertices() == hull.size());
+      }
+
+      //Contains vs the hull edges, for the points themselves (all inside or on) and points around them
+      auto hull = inc_hull.Hull();
+      auto brute_contains = [&hull](const SpgMth::Point2d& p) {
+        const std::size_t n = hull.size();
+        if(n == 1)
+          return p == hull[0];
+        for(std::size_t i=0; i<n; i++) {
+          if(SpgMth::Orient2d(hull[i], hull[(i+1)%n], p) < 0)
+            return false;
+        }
+        if(n == 2) //on the line, need to be on the segment too
+          return !(p.x < std::min(hull[0].x, hull[1].x) || p.x > std::max(hull[0].x, hull[1].x) || p.y < std::min(hull[0].y, hull[1].y) || p.y > std::max(hull[0].y, hull[1].y));
+        return true;
+      };
+      int num_wrong = 0;
+      for(auto& p : points)
+        num_wrong += !inc_hull.Contains(p);
+      for(auto& p : points) {
+        SpgMth::Point2d q = p * 1.05f + SpgMth::Point2d(0.0f, 0.5f);
+        num_wrong += (inc_hull.Contains(q) != brute_contains(q));
+      }
+      REQUIRE(num_wrong == 0);
+    }
+
+    //Single points, and Insert() reporting whether the hull changed
+    Geom::IncrementalHull2D inc_hull;
+    REQUIRE(inc_hull.Insert({1,1}));
+    REQUIRE(!inc_hull.Insert({1,1}));
+    REQUIRE(inc_hull.Hull().size() == 1);
+    REQUIRE(inc_hull.Contains({1,1}));
+    REQUIRE(!inc_hull.Contains({1,2}));
+    REQUIRE(inc_hull.Insert({3,1}));
+    REQUIRE(!inc_hull.Insert({2,1}));
+    REQUIRE(inc_hull.Insert({2,3}));
+    REQUIRE(!inc_hull.Insert({2,2}));
+    REQUIRE(inc_hull.Hull() == std::vector<SpgMth::Point2d>{{1,1},{3,1},{2,3}});
+    inc_hull.Clear();
+    REQUIRE(inc_hull.Empty());
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("IncrementalHull2D, 20000 points in batches of 500") { 
+      Geom::IncrementalHull2D hull;
+      for(std::size_t first = 0; first < inputs[0].size(); first += BATCH_SIZE) 
+        hull.Insert(std::span(inputs[0]).subspan(first, BATCH_SIZE));
+      return hull.NumVertices();
+    };
+    BENCHMARK("ConvexHull2D_Chan re-run per batch, 20000 points in batches of 500") { 
+      std::size_t num_vertices = 0;
+      for(std::size_t first = 0; first < inputs[0].size(); first += BATCH_SIZE) 
+        num_vertices = Geom::ConvexHull2D_Chan(std::span(inputs[0]).first(first + BATCH_SIZE)).size();
+      return num_vertices;
+    };
+  #endif
+  }
+
+  TEST_CASE( "KDTree2D flat layout range search", "KDTree2D::RangeSearch()") 
+  {
+    std::mt19937 mt(42); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> points;
+    for(int i=0; i<5000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    Geom::KDTree2D linked_tree(points);
+
+    //Flat layout should cope with duplicates
+    for(int i=0; i<50; i++) 
+      points.push_back(points[i]);
+    Geom::KDTree2D flat_tree(points, Geom::KDTree2D::Layout::Flat, 8);
+    Geom::KDTree2D flat_tree_1(points, Geom::KDTree2D::Layout::Flat, 1);
+
+    REQUIRE(flat_tree.CollectAllPoints().size() == points.size());
+
+    std::vector<Geom::KDTree2D::Range> ranges = { {20,80,20,80}, {0,200,0,200}, {150,151,0,200}, {-10,-5,-10,-5}, {} };
+    for(auto& range : ranges) {
+      REQUIRE(linked_tree.RangeSearch(range).size() == linked_tree.BruteForceRangeSearch(range).size());
+      auto expected = flat_tree.BruteForceRangeSearch(range).size();
+      REQUIRE(flat_tree.RangeSearch(range).size() == expected);
+      REQUIRE(flat_tree_1.RangeSearch(range).size() == expected);
+    }
+
+  #if defined(RUN_BENCHMARKS)  
+    Geom::KDTree2D::Range range{20,80,20,80};
+    BENCHMARK("KDTree2D linked range search") { 
+      return linked_tree.RangeSearch(range);
+    };
+    BENCHMARK("KDTree2D flat range search") { 
+      return flat_tree.RangeSearch(range);
+    };
+  #endif
+  }
+
+  TEST_CASE( "KDTree2D nearest neighbour queries", "KDTree2D::KNearest(), KDTree2D::RadiusSearch()") 
+  {
+    std::mt19937 mt(7); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> points, queries;
+    for(int i=0; i<2000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    for(int i=0; i<50; i++) 
+      queries.push_back({fdist(mt),fdist(mt)});
+
+    Geom::KDTree2D linked_tree(points);
+    Geom::KDTree2D flat_tree(points, Geom::KDTree2D::Layout::Flat);
+
+    const uint32_t K = 6;
+    std::vector<SpgMth::Point2d> batch_results;
+    REQUIRE(flat_tree.KNearestBatch(queries, K, batch_results) == K);
+    for(uint32_t i=0; i<queries.size(); i++) {
+      auto q = queries[i];
+      auto expected = flat_tree.BruteForceKNearest(q, K);
+      auto linked_result = linked_tree.KNearest(q, K);
+      auto flat_result = flat_tree.KNearest(q, K);
+      REQUIRE(flat_result.size() == K);
+      for(uint32_t j=0; j<K; j++) {
+        REQUIRE(glm::length2(linked_result[j]-q) == glm::length2(expected[j]-q));
+        REQUIRE(glm::length2(flat_result[j]-q) == glm::length2(expected[j]-q));
+        REQUIRE(glm::length2(batch_results[i*K+j]-q) == glm::length2(expected[j]-q));
+      }
+      REQUIRE(SpgMth::Equal(flat_tree.Nearest(q).value(), expected[0]));
+
+      size_t in_radius = 0;
+      for(auto& p : points)
+        if(glm::length2(p-q) <= 15.0f*15.0f) in_radius++;
+      REQUIRE(linked_tree.RadiusSearch(q, 15.0f).size() == in_radius);
+      REQUIRE(flat_tree.RadiusSearch(q, 15.0f).size() == in_radius);
+    }
+
+    //k larger than the number of points
+    REQUIRE(flat_tree.KNearest(queries[0], 5000).size() == points.size());
+    Geom::KDTree2D empty_tree(std::vector<SpgMth::Point2d>{}, Geom::KDTree2D::Layout::Flat);
+    REQUIRE(empty_tree.Nearest(queries[0]).has_value() == false);
+
+    //The queries are const, so one tree can be shared by pool workers - a batch per query, each into its own buffer
+    Core::ThreadPool pool(4);
+    for(const Geom::KDTree2D* shared_tree : {&linked_tree, &flat_tree}) {
+      const Geom::KDTree2D& tree = *shared_tree;
+      std::vector<std::vector<SpgMth::Point2d>> per_query(queries.size());
+      std::vector<uint8_t> radius_ok(queries.size(), 0);
+      pool.ParallelFor((uint32_t)queries.size(), 1, [&](uint32_t begin, uint32_t end) {
+        for(uint32_t i = begin; i < end; i++) {
+          tree.KNearestBatch({queries[i]}, K, per_query[i]);
+          radius_ok[i] = (tree.RadiusSearch(queries[i], 15.0f).size() == flat_tree.RadiusSearch(queries[i], 15.0f).size());
+        }
+      });
+      for(uint32_t i=0; i<queries.size(); i++) {
+        REQUIRE(per_query[i].size() == K);
+        REQUIRE(glm::length2(per_query[i][0]-queries[i]) == glm::length2(batch_results[i*K]-queries[i]));
+        REQUIRE(radius_ok[i] == 1);
+      }
+    }
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("KDTree2D flat KNearestBatch") { 
+      return flat_tree.KNearestBatch(queries, K, batch_results);
+    };
+  #endif
+  }
+
+  TEST_CASE( "KDTree2D insert and erase", "KDTree2D::Insert(), KDTree2D::Erase()") 
+  {
+    std::mt19937 mt(11); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> live;
+    for(int i=0; i<1000; i++) 
+      live.push_back({fdist(mt),fdist(mt)});
+    Geom::KDTree2D tree(live);
+
+    //Random churn, including duplicate points and skewed (sorted) inserts that force scapegoat rebuilds
+    for(int i=0; i<3000; i++) {
+      const float r = fdist(mt);
+      if(r < 100) {
+        SpgMth::Point2d p{fdist(mt),fdist(mt)};
+        tree.Insert(p);
+        live.push_back(p);
+      }
+      else if(r < 110) {
+        SpgMth::Point2d p = live[mt() % live.size()];
+        tree.Insert(p);
+        live.push_back(p);
+      }
+      else if(r < 130) {
+        SpgMth::Point2d p{(float)i/15.0f, (float)i/15.0f};
+        tree.Insert(p);
+        live.push_back(p);
+      }
+      else if(!live.empty()) {
+        const size_t idx = mt() % live.size();
+        REQUIRE(tree.Erase(live[idx]));
+        live[idx] = live.back();
+        live.pop_back();
+      }
+    }
+    REQUIRE(tree.Size() == live.size());
+    REQUIRE(tree.CollectAllPoints().size() == live.size());
+    REQUIRE_FALSE(tree.Erase({-1.0f,-1.0f}));
+
+    std::vector<Geom::KDTree2D::Range> ranges = { {20,80,20,80}, {0,200,0,200}, {150,151,0,200}, {-10,-5,-10,-5} };
+    for(int i=0; i<50; i++) {
+      float x = fdist(mt), y = fdist(mt);
+      ranges.push_back({x, x+25, y, y+25});
+    }
+    //Check against the live points directly rather than BruteForce*(), which use the tree's own points
+    for(auto& range : ranges) {
+      size_t expected = 0;
+      for(auto& p : live)
+        if(p.x >= range.x_min && p.x <= range.x_max && p.y >= range.y_min && p.y <= range.y_max) expected++;
+      REQUIRE(tree.RangeSearch(range).size() == expected);
+      REQUIRE(tree.RangeCount(range) == expected);
+    }
+    for(int i=0; i<20; i++) {
+      SpgMth::Point2d q{fdist(mt),fdist(mt)};
+      float nearest_sq = std::numeric_limits<float>::max();
+      for(auto& p : live)
+        nearest_sq = std::min(nearest_sq, glm::length2(p-q));
+      auto result = tree.KNearest(q, 4);
+      REQUIRE(result.size() == 4);
+      REQUIRE(glm::length2(result[0]-q) == nearest_sq);
+    }
+
+    //Erase everything, then re-fill an empty tree
+    for(auto& p : live)
+      REQUIRE(tree.Erase(p));
+    REQUIRE(tree.Size() == 0);
+    REQUIRE(tree.RangeSearch({0,200,0,200}).empty());
+    Geom::KDTree2D empty_tree;
+    for(int i=0; i<100; i++)
+      empty_tree.Insert({fdist(mt),fdist(mt)});
+    REQUIRE(empty_tree.RangeCount({0,200,0,200}) == 100);
+
+    //Flat trees can't be updated - refused, and left as they were
+    Geom::KDTree2D flat_tree(live, Geom::KDTree2D::Layout::Flat);
+    const uint32_t flat_size = flat_tree.Size();
+    REQUIRE(!flat_tree.Insert({1.0f, 1.0f}));
+    REQUIRE(!flat_tree.Erase(flat_tree.CollectAllPoints().front()));
+    REQUIRE(flat_tree.Size() == flat_size);
+    REQUIRE(flat_tree.RangeCount({0,200,0,200}) == flat_size);
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("KDTree2D 1000 inserts + 1000 erases") { 
+      std::vector<SpgMth::Point2d> pts;
+      for(int i=0; i<1000; i++) 
+        pts.push_back({fdist(mt),fdist(mt)});
+      for(auto& p : pts)
+        tree.Insert(p);
+      for(auto& p : pts)
+        tree.Erase(p);
+      return tree.Size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "KDTree3D range and nearest neighbour queries", "KDTree<3>::RangeSearch(), KDTree<3>::KNearest()") 
+  {
+    std::mt19937 mt(5); 
+    std::uniform_real_distribution<float> fdist(0.0f, 100.0f); 
+    std::vector<glm::vec3> points;
+    for(int i=0; i<5000; i++) 
+      points.push_back({fdist(mt),fdist(mt),fdist(mt)});
+    for(int i=0; i<20; i++) 
+      points.push_back(points[i]);
+    Geom::KDTree3D tree(points);
+    Geom::KDTree3D tree_1(points, 1);
+    REQUIRE(tree.Size() == points.size());
+
+    for(int i=0; i<50; i++) {
+      Geom::KDTree3D::Box box;
+      box.min = {fdist(mt),fdist(mt),fdist(mt)};
+      box.max = box.min + glm::vec3(25.0f);
+      size_t expected = 0;
+      for(auto& p : points)
+        if(p.x >= box.min.x && p.x < box.max.x && p.y >= box.min.y && p.y < box.max.y && p.z >= box.min.z && p.z < box.max.z) expected++;
+      REQUIRE(tree.RangeSearch(box).size() == expected);
+      REQUIRE(tree_1.RangeSearch(box).size() == expected);
+      REQUIRE(tree.RangeCount(box) == expected);
+    }
+    REQUIRE(tree.RangeCount(Geom::KDTree3D::Box{}) == points.size());
+
+    for(int i=0; i<50; i++) {
+      glm::vec3 q{fdist(mt),fdist(mt),fdist(mt)};
+      std::vector<float> dists;
+      for(auto& p : points)
+        dists.push_back(glm::length2(p-q));
+      std::sort(dists.begin(), dists.end());
+      auto result = tree.KNearest(q, 5);
+      REQUIRE(result.size() == 5);
+      for(uint32_t j=0; j<5; j++)
+        REQUIRE(glm::length2(result[j]-q) == dists[j]);
+      const size_t in_radius = std::upper_bound(dists.begin(), dists.end(), 10.0f*10.0f) - dists.begin();
+      REQUIRE(tree.RadiusSearch(q, 10.0f).size() == in_radius);
+    }
+
+    Geom::KDTree3D empty_tree;
+    REQUIRE(empty_tree.Nearest({0,0,0}).has_value() == false);
+    REQUIRE(empty_tree.RangeCount(Geom::KDTree3D::Box{}) == 0);
+
+  #if defined(RUN_BENCHMARKS)  
+    Geom::KDTree3D::Box box{glm::vec3(20.0f), glm::vec3(50.0f)};
+    BENCHMARK("KDTree3D range search") { 
+      return tree.RangeSearch(box);
+    };
+    BENCHMARK("KDTree3D 8 nearest") { 
+      return tree.KNearest(glm::vec3(50.0f), 8);
+    };
+  #endif
+  }
+
+  TEST_CASE( "Batched range queries", "KDTree2D::RangeSearchBatch(), RangeTree2D::RangeQueryBatch()") 
+  {
+    std::mt19937 mt(3); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> points;
+    for(int i=0; i<3000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+
+    std::vector<Geom::KDTree2D::Range> kd_ranges;
+    std::vector<Geom::RangeTree2D::Range> rt_ranges;
+    for(int i=0; i<500; i++) {
+      float x = fdist(mt), y = fdist(mt), w = fdist(mt)/4, h = fdist(mt)/4;
+      kd_ranges.push_back({x, x+w, y, y+h});
+      rt_ranges.push_back({x, x+w, y, y+h});
+    }
+    kd_ranges.push_back({50,40,0,200}); //empty
+    rt_ranges.push_back({50,40,0,200});
+
+    Geom::KDTree2D kd_tree(points, Geom::KDTree2D::Layout::Flat);
+    Geom::RangeTree2D range_tree(points);
+    Core::ThreadPool pool(4);
+
+    auto point_less = [](SpgMth::Point2d a, SpgMth::Point2d b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+
+    Geom::BatchQueryResult kd_result, rt_result;
+    for(int pass=0; pass<2; pass++) { //2nd pass re-uses the result buffers
+      kd_tree.RangeSearchBatch(kd_ranges, kd_result, pool);
+      range_tree.RangeQueryBatch(rt_ranges, rt_result, pool);
+      REQUIRE(kd_result.NumQueries() == kd_ranges.size());
+      REQUIRE(rt_result.NumQueries() == rt_ranges.size());
+      for(size_t i=0; i<kd_ranges.size(); i++) {
+        auto expected = kd_tree.RangeSearch(kd_ranges[i]);
+        std::vector<SpgMth::Point2d> kd_batch(kd_result[i].begin(), kd_result[i].end());
+        std::vector<SpgMth::Point2d> rt_batch(rt_result[i].begin(), rt_result[i].end());
+        std::sort(expected.begin(), expected.end(), point_less);
+        std::sort(kd_batch.begin(), kd_batch.end(), point_less);
+        std::sort(rt_batch.begin(), rt_batch.end(), point_less);
+        REQUIRE(kd_batch == expected);
+        REQUIRE(rt_batch == expected);
+      }
+    }
+
+    //Batch queries from inside pool tasks (more of them than threads) and from two threads at once - each
+    //ParallelFor only waits on its own chunks, so neither blocks
+    auto batch_matches = [&](uint32_t i) {
+      Geom::BatchQueryResult nested;
+      kd_tree.RangeSearchBatch(std::span(kd_ranges).subspan(i * 50, 50), nested, pool);
+      for(uint32_t j = 0; j < 50; j++)
+        if(nested[j].size() != kd_tree.RangeCount(kd_ranges[i * 50 + j]))
+          return false;
+      return true;
+    };
+    std::vector<uint8_t> nested_ok(10, 0);
+    pool.ParallelFor(10, 1, [&](uint32_t begin, uint32_t end) {
+      for(uint32_t i = begin; i < end; i++)
+        nested_ok[i] = batch_matches(i);
+    });
+    REQUIRE(std::count(nested_ok.begin(), nested_ok.end(), 1) == 10);
+    bool concurrent_ok[2] = {false, false};
+    std::thread other([&]() { concurrent_ok[1] = batch_matches(1); });
+    concurrent_ok[0] = batch_matches(0);
+    other.join();
+    REQUIRE((concurrent_ok[0] && concurrent_ok[1]));
+
+    //An exception in a chunk comes back out of ParallelFor() rather than leaving it waiting, and the pool still works
+    auto throw_in_chunk = [&pool]() {
+      pool.ParallelFor(1000, 1, [](uint32_t begin, uint32_t end) {
+        if((begin <= 537) && (537 < end))
+          throw std::runtime_error("chunk failed");
+      });
+    };
+    REQUIRE_THROWS_AS(throw_in_chunk(), std::runtime_error);
+    REQUIRE(batch_matches(2));
+  }
+
+  TEST_CASE( "Range count and visitor queries", "KDTree2D::RangeCount(), RangeTree2D::RangeCount()") 
+  {
+    std::mt19937 mt(11); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> points;
+    for(int i=0; i<3000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    //Repeated y values and repeated points - every copy counts
+    for(int i=0; i<300; i++) {
+      points.push_back({fdist(mt), points[i].y});
+      points.push_back(points[i+300]);
+    }
+
+    Geom::KDTree2D linked_tree(points);
+    Geom::KDTree2D flat_tree(points, Geom::KDTree2D::Layout::Flat);
+    Geom::RangeTree2D range_tree(points);
+
+    for(int i=0; i<200; i++) {
+      float x = fdist(mt), y = fdist(mt), w = fdist(mt)/2, h = fdist(mt)/2;
+      Geom::KDTree2D::Range kd_range{x, x+w, y, y+h};
+      Geom::RangeTree2D::Range rt_range{x, x+w, y, y+h};
+      uint32_t expected = (uint32_t)flat_tree.BruteForceRangeSearch(kd_range).size();
+      REQUIRE(linked_tree.RangeCount(kd_range) == expected);
+      REQUIRE(flat_tree.RangeCount(kd_range) == expected);
+      REQUIRE(range_tree.RangeCount(rt_range) == expected);
+
+      uint32_t visited = 0;
+      auto visitor = [&visited, &kd_range](const SpgMth::Point2d& p) { 
+        REQUIRE((p.x >= kd_range.x_min && p.x < kd_range.x_max && p.y >= kd_range.y_min && p.y < kd_range.y_max));
+        visited++; 
+      };
+      flat_tree.RangeSearch(kd_range, visitor);
+      linked_tree.RangeSearch(kd_range, visitor);
+      range_tree.RangeQuery(rt_range, visitor);
+      REQUIRE(visited == 3*expected);
+    }
+    REQUIRE(flat_tree.RangeCount(Geom::KDTree2D::Range{}) == points.size());
+    REQUIRE(range_tree.RangeCount(Geom::RangeTree2D::Range{}) == points.size());
+    REQUIRE(range_tree.RangeQuery(Geom::RangeTree2D::Range{}).size() == points.size());
+
+    //All on a few rows - nothing but repeated y values
+    std::vector<SpgMth::Point2d> rows;
+    for(int i=0; i<2000; i++)
+      rows.push_back({fdist(mt), (float)(i % 7)});
+    Geom::RangeTree2D rows_tree(rows);
+    for(int i=0; i<100; i++) {
+      float x = fdist(mt), w = fdist(mt)/2, y = (float)(i % 8) - 0.5f;
+      Geom::RangeTree2D::Range range{x, x+w, y, y + 2.0f};
+      uint32_t expected = (uint32_t)std::count_if(rows.begin(), rows.end(), [&](SpgMth::Point2d p) {
+        return (p.x >= range.x_min) && (p.x < range.x_max) && (p.y >= range.y_min) && (p.y < range.y_max); });
+      REQUIRE(rows_tree.RangeQuery(range).size() == expected);
+      REQUIRE(rows_tree.RangeCount(range) == expected);
+    }
+
+    //Wide in x, narrow in y - the canonical subtrees are mostly outside the range in y, so they're counted on y alone
+    for(int i=0; i<200; i++) {
+      float x = fdist(mt)/10, y = fdist(mt), w = 150 + fdist(mt)/4, h = fdist(mt)/50;
+      Geom::KDTree2D::Range kd_range{x, x+w, y, y+h};
+      uint32_t expected = (uint32_t)flat_tree.BruteForceRangeSearch(kd_range).size();
+      REQUIRE(range_tree.RangeCount(Geom::RangeTree2D::Range{x, x+w, y, y+h}) == expected);
+      REQUIRE(range_tree.RangeCount(Geom::RangeTree2D::Range{x, x+w, points[i].y, points[i].y + h}) == 
+        (uint32_t)flat_tree.BruteForceRangeSearch({x, x+w, points[i].y, points[i].y + h}).size());
+    }
+  }
+
+  TEST_CASE( "Layered range tree", "LayeredRangeTree2D::RangeQuery(), LayeredRangeTree2D::RangeCount()") 
+  {
+    std::mt19937 mt(5); 
+    std::uniform_real_distribution<float> fdist(0.0f, 200.0f); 
+    std::vector<SpgMth::Point2d> points;
+    for(int i=0; i<3000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    //duplicates and shared x / y values
+    for(int i=0; i<100; i++) {
+      points.push_back(points[i]);
+      points.push_back({points[i].x, fdist(mt)});
+      points.push_back({fdist(mt), points[i].y});
+    }
+
+    Geom::LayeredRangeTree2D tree(points);
+    REQUIRE(tree.Size() == points.size());
+
+    auto point_less = [](SpgMth::Point2d a, SpgMth::Point2d b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+    std::vector<Geom::LayeredRangeTree2D::Range> ranges = { {}, {50,40,0,200}, {0,200,10,10} };
+    for(int i=0; i<200; i++) {
+      float x = fdist(mt), y = fdist(mt), w = fdist(mt)/2, h = fdist(mt)/2;
+      ranges.push_back({x, x+w, y, y+h});
+    }
+    ranges.push_back({points[0].x, points[1].x, points[2].y, points[3].y}); //bounds on existing values
+    for(auto& range : ranges) {
+      std::vector<SpgMth::Point2d> expected;
+      for(auto& p : points)
+        if(p.x >= range.x_min && p.x < range.x_max && p.y >= range.y_min && p.y < range.y_max) 
+          expected.push_back(p);
+      auto result = tree.RangeQuery(range);
+      std::sort(expected.begin(), expected.end(), point_less);
+      std::sort(result.begin(), result.end(), point_less);
+      REQUIRE(result == expected);
+      REQUIRE(tree.RangeCount(range) == expected.size());
+    }
+
+  #if defined(RUN_BENCHMARKS)  
+    Geom::LayeredRangeTree2D::Range range{20,80,20,80};
+    BENCHMARK("LayeredRangeTree2D range query") { 
+      return tree.RangeQuery(range);
+    };
+    BENCHMARK("LayeredRangeTree2D range count") { 
+      return tree.RangeCount(range);
+    };
+  #endif
+  }
+
+  TEST_CASE( "RBTree pooled node allocator", "RBTree_V2::RBTree, RBTree with Core::NodePool") 
+  {
+    std::mt19937 mt(9); 
+    std::uniform_int_distribution<int> dist(0, 5000); 
+    Geom::RBTree_V2::RBTree<int> pooled_tree;
+    Geom::RBTree_V2::RBTree<int,std::less<int>,void,Core::HeapNodeAllocator> heap_tree;
+    Geom::RBTree<int,void> pooled_tree_v1;
+    std::set<int> expected;
+    for(int i=0; i<20000; i++) {
+      int v = dist(mt);
+      if(expected.count(v)) {
+        expected.erase(v);
+        pooled_tree.Erase(v);
+        heap_tree.Erase(v);
+        pooled_tree_v1.Erase(v);
+      }
+      else {
+        expected.insert(v);
+        pooled_tree.Insert(v);
+        heap_tree.Insert(v);
+        pooled_tree_v1.Insert(v);
+      }
+    }
+    REQUIRE(pooled_tree.Size() == expected.size());
+    REQUIRE(heap_tree.Size() == expected.size());
+    REQUIRE(pooled_tree_v1.Size() == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), pooled_tree.begin()));
+    REQUIRE(std::equal(expected.begin(), expected.end(), pooled_tree_v1.begin()));
+
+    //Nodes belong to the pool, so they have to survive moving the tree
+    auto moved_tree = std::move(pooled_tree);
+    REQUIRE(moved_tree.Size() == expected.size());
+    REQUIRE(pooled_tree.Size() == 0);
+    Geom::RBTree_V2::RBTree<int> assigned_tree;
+    assigned_tree.Insert(-1);
+    assigned_tree = std::move(moved_tree);
+    REQUIRE(std::equal(expected.begin(), expected.end(), assigned_tree.begin()));
+    pooled_tree.Insert(3);
+    REQUIRE(pooled_tree.Contains(3));
+
+    //Pools only hold about what they've been asked for - a tree (or a sentinel) costs nothing like a full slab
+    Core::NodePool<std::array<double,4>> pool;
+    REQUIRE(pool.NumReserved() == 0);
+    auto* first = pool.Create();
+    REQUIRE(pool.NumReserved() == 1);
+    std::vector<std::array<double,4>*> nodes;
+    for(int i=0; i<1000; i++)
+      nodes.push_back(pool.Create());
+    REQUIRE(pool.NumReserved() < 2 * pool.NumLive());
+    for(auto* node : nodes)
+      pool.Destroy(node);
+    pool.Reserve(1500); //only the shortfall over the free nodes is allocated
+    REQUIRE(pool.NumReserved() == 1501);
+    const std::size_t reserved = pool.NumReserved();
+    for(int i=0; i<1500; i++)
+      nodes.push_back(pool.Create());
+    REQUIRE(pool.NumReserved() == reserved);
+    REQUIRE(pool.NumLive() == 1501);
+    pool.Destroy(first);
+
+  #if defined(RUN_BENCHMARKS)  
+    std::vector<int> vals(10000);
+    for(int i=0; i<(int)vals.size(); i++) 
+      vals[i] = i;
+    std::shuffle(vals.begin(), vals.end(), mt);
+    BENCHMARK("RBTree_V2 pooled insert + erase") { 
+      Geom::RBTree_V2::RBTree<int> tree;
+      for(auto v : vals) tree.Insert(v);
+      for(auto v : vals) tree.Erase(v);
+      return tree.Size();
+    };
+    BENCHMARK("RBTree_V2 new/delete insert + erase") { 
+      Geom::RBTree_V2::RBTree<int,std::less<int>,void,Core::HeapNodeAllocator> tree;
+      for(auto v : vals) tree.Insert(v);
+      for(auto v : vals) tree.Erase(v);
+      return tree.Size();
+    };
+    BENCHMARK("std::set insert + erase") { 
+      std::set<int> tree;
+      for(auto v : vals) tree.insert(v);
+      for(auto v : vals) tree.erase(v);
+      return tree.size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "RBTree bulk build from sorted input", "RBTree::BuildFromSorted(), RangeTree1D") 
+  {
+    std::vector<int> sorted_vals;
+    for(int i=0; i<1000; i++) 
+      sorted_vals.push_back(i/2); //every key twice
+    Geom::RBTree<int,void> bulk_tree(Geom::sorted_input, sorted_vals);
+    REQUIRE(bulk_tree.Size() == 500);
+    int expected = 0;
+    for(auto v : bulk_tree)
+      REQUIRE(v == expected++);
+    REQUIRE(bulk_tree.Contains(0));
+    REQUIRE(bulk_tree.Contains(499));
+    REQUIRE_FALSE(bulk_tree.Contains(500));
+
+    //Still a valid red-black tree to insert/erase on
+    for(int i=0; i<500; i+=2)
+      REQUIRE(bulk_tree.Erase(i));
+    for(int i=500; i<700; i++)
+      bulk_tree.Insert(i);
+    REQUIRE(bulk_tree.Size() == 450);
+    REQUIRE(std::is_sorted(bulk_tree.begin(), bulk_tree.end()));
+
+    Geom::RBTreeTraversable<int,void> traversable_tree(Geom::sorted_input, std::vector<int>{1,2,3,4,5,6,7});
+    REQUIRE(*traversable_tree.Root() == 4);
+    bulk_tree.BuildFromSorted({});
+    REQUIRE(bulk_tree.Empty());
+
+    std::mt19937 mt(2); 
+    std::uniform_real_distribution<float> fdist(0.0f, 100.0f); 
+    std::vector<float> vals;
+    for(int i=0; i<2000; i++) 
+      vals.push_back(fdist(mt));
+    Geom::RangeTree1D range_tree(vals);
+    auto in_range = range_tree.RangeSearch({20.0f, 40.0f});
+    REQUIRE(in_range.size() == (size_t)std::count_if(vals.begin(), vals.end(), [](float v) { return v >= 20.0f && v <= 40.0f; }));
+
+  #if defined(RUN_BENCHMARKS)  
+    std::vector<int> bench_vals(100000);
+    for(int i=0; i<(int)bench_vals.size(); i++) 
+      bench_vals[i] = i;
+    BENCHMARK("RBTree 100k repeated inserts") { 
+      Geom::RBTree<int,void> tree;
+      for(auto v : bench_vals) tree.Insert(v);
+      return tree.Size();
+    };
+    BENCHMARK("RBTree 100k bulk build") { 
+      Geom::RBTree<int,void> tree(Geom::sorted_input, bench_vals);
+      return tree.Size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "Order statistic RBTree", "RBTree_V2::OrderStatisticRBTree::Rank(), Select(), CountRange()") 
+  {
+    std::mt19937 mt(4); 
+    std::uniform_int_distribution<int> dist(0, 20000); 
+    Geom::RBTree_V2::OrderStatisticRBTree<int> tree;
+    std::set<int> expected;
+    for(int i=0; i<30000; i++) {
+      int v = dist(mt);
+      if(expected.erase(v))
+        tree.Erase(v);
+      else {
+        expected.insert(v);
+        tree.Insert(v);
+      }
+    }
+    REQUIRE(tree.Size() == expected.size());
+    std::vector<int> sorted(expected.begin(), expected.end());
+    for(std::size_t k=0; k<sorted.size(); k++)
+      REQUIRE(*tree.Select(k) == sorted[k]);
+    REQUIRE(tree.Select(sorted.size()) == tree.end());
+
+    for(int i=0; i<500; i++) {
+      int lo = dist(mt), hi = dist(mt);
+      const std::size_t rank = std::lower_bound(sorted.begin(), sorted.end(), lo) - sorted.begin();
+      REQUIRE(tree.Rank(lo) == rank);
+      const std::size_t count = (lo <= hi) ? (std::upper_bound(sorted.begin(), sorted.end(), hi) - sorted.begin()) - rank : 0;
+      REQUIRE(tree.CountRange(lo, hi) == count);
+    }
+    REQUIRE(tree.CountRange(-1, 20001) == sorted.size());
+    REQUIRE(tree.Rank(-1) == 0);
+
+    tree.Clear();
+    REQUIRE(tree.Select(0) == tree.end());
+    REQUIRE(tree.CountRange(0, 20000) == 0);
+
+  #if defined(RUN_BENCHMARKS)  
+    for(auto v : sorted) tree.Insert(v);
+    BENCHMARK("OrderStatisticRBTree CountRange") { 
+      return tree.CountRange(5000, 15000);
+    };
+    BENCHMARK("Iterator distance (no augmentation)") { 
+      return Geom::RBTree_V2::Distance(tree.LowerBound(5000), tree.UpperBound(15000));
+    };
+  #endif
+  }
+
+  TEST_CASE( "FlatSortedSet matches std::set", "FlatSortedSet::Insert(), Erase(), LowerBound(), UpperBound(), Iterator") 
+  {
+    std::mt19937 mt(5); 
+    std::uniform_int_distribution<int> dist(0, 5000); 
+    Geom::FlatSortedSet<int, std::less<int>, 8> flat_set;
+    Geom::RBTree_V2::RBTree<int> rb_tree;
+    std::set<int> expected;
+    for(int i=0; i<20000; i++) {
+      int v = dist(mt);
+      if(expected.erase(v)) {
+        REQUIRE(flat_set.Erase(v));
+        rb_tree.Erase(v);
+      }
+      else {
+        auto itr = expected.insert(v).first;
+        //Insert returns an iterator to the new element, so its neighbours are the ones either side in the set
+        auto flat_itr = flat_set.Insert(v);
+        auto rb_itr = rb_tree.Insert(v);
+        REQUIRE(*flat_itr == v);
+        REQUIRE(*rb_itr == v);
+        auto next = std::next(itr);
+        REQUIRE(((++flat_itr == flat_set.end()) ? -1 : *flat_itr) == ((next == expected.end()) ? -1 : *next));
+        REQUIRE(((++rb_itr == rb_tree.end()) ? -1 : *rb_itr) == ((next == expected.end()) ? -1 : *next));
+      }
+    }
+    REQUIRE(flat_set.Size() == expected.size());
+    REQUIRE(flat_set.Insert(*expected.begin()) == flat_set.end());
+    REQUIRE(--flat_set.begin() == flat_set.end());
+    std::vector<int> values;
+    flat_set.InOrderTraverse(values);
+    REQUIRE(values == std::vector<int>(expected.begin(), expected.end()));
+    values.clear();
+    for(auto v : flat_set)
+      values.push_back(v);
+    REQUIRE(values == std::vector<int>(expected.begin(), expected.end()));
+
+    for(int v=-1; v<=5001; v++) {
+      auto lb = expected.lower_bound(v);
+      auto ub = expected.upper_bound(v);
+      REQUIRE(((flat_set.LowerBound(v) == flat_set.end()) ? -1 : *flat_set.LowerBound(v)) == ((lb == expected.end()) ? -1 : *lb));
+      REQUIRE(((flat_set.UpperBound(v) == flat_set.end()) ? -1 : *flat_set.UpperBound(v)) == ((ub == expected.end()) ? -1 : *ub));
+      REQUIRE(flat_set.Contains(v) == expected.contains(v));
+    }
+
+    //Erase everything through iterators, in reverse
+    while(!flat_set.Empty())
+      flat_set.Erase(--flat_set.end());
+    REQUIRE(flat_set.NumBlocks() == 0);
+    REQUIRE(flat_set.begin() == flat_set.end());
+
+  #if defined(RUN_BENCHMARKS)  
+    std::vector<int> bench_vals(2000);
+    for(int i=0; i<(int)bench_vals.size(); i++) 
+      bench_vals[i] = i;
+    std::shuffle(bench_vals.begin(), bench_vals.end(), mt);
+    BENCHMARK("FlatSortedSet 2k insert/erase") { 
+      Geom::FlatSortedSet<int> set;
+      for(auto v : bench_vals) set.Insert(v);
+      for(auto v : bench_vals) set.Erase(v);
+      return set.Size();
+    };
+    BENCHMARK("RBTree_V2 2k insert/erase") { 
+      Geom::RBTree_V2::RBTree<int> tree;
+      for(auto v : bench_vals) tree.Insert(v);
+      for(auto v : bench_vals) tree.Erase(v);
+      return tree.Size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "IntersectionSet matches brute force", "ItersectSet::IntersectionSet::Process()") 
+  {
+    using SegIndex = Geom::ItersectSet::SegIndex;
+    std::mt19937 mt(6); 
+    std::uniform_real_distribution<float> pos_dist(0.0f, 500.0f); 
+    std::uniform_real_distribution<float> len_dist(-40.0f, 40.0f); 
+    Geom::ItersectSet::SegList segs {
+      {{0,0},{10,10}}, {{0,10},{10,0}}, {{5,10},{5,0}}, //three through (5,5)
+      {{-5,5},{15,5}}, //horizontal through (5,5) too
+      {{20,0},{30,0}}, {{25,0},{25,-10}}, //T junction
+      {{40,0},{50,10}}, {{50,10},{60,0}} //shared endpoint
+    };
+    for(int i=0; i<800; i++) {
+      SpgMth::Point2d start{pos_dist(mt), pos_dist(mt)};
+      segs.emplace_back(start, start + SpgMth::Point2d{len_dist(mt), len_dist(mt)});
+    }
+
+    //Orientation of float points is exact in double
+    auto orient = [](glm::dvec2 a, glm::dvec2 b, glm::dvec2 c) {
+      double d = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      return (d > 0) - (d < 0);
+    };
+    auto in_box = [](glm::dvec2 a, glm::dvec2 b, glm::dvec2 p) {
+      return (p.x >= std::min(a.x,b.x)) && (p.x <= std::max(a.x,b.x)) && (p.y >= std::min(a.y,b.y)) && (p.y <= std::max(a.y,b.y));
+    };
+    std::set<std::pair<SegIndex,SegIndex>> expected;
+    for(SegIndex i=0; i<segs.size(); i++) {
+      glm::dvec2 a{segs[i].start}, b{segs[i].end};
+      for(SegIndex j=i+1; j<segs.size(); j++) {
+        glm::dvec2 c{segs[j].start}, d{segs[j].end};
+        int o1 = orient(a,b,c), o2 = orient(a,b,d), o3 = orient(c,d,a), o4 = orient(c,d,b);
+        bool hit = ((o1*o2 < 0) && (o3*o4 < 0)) || ((o1 == 0) && in_box(a,b,c)) || ((o2 == 0) && in_box(a,b,d)) ||
+          ((o3 == 0) && in_box(c,d,a)) || ((o4 == 0) && in_box(c,d,b));
+        if(hit)
+          expected.insert({i,j});
+      }
+    }
+
+    Geom::ItersectSet::IntersectionSet intersection_set(segs);
+    intersection_set.Process();
+    std::set<std::pair<SegIndex,SegIndex>> found;
+    for(auto& intersection : intersection_set.GetIntersections()) {
+      auto inter_segs = intersection_set.GetSegs(intersection);
+      REQUIRE(inter_segs.size() >= 2);
+      for(std::size_t i=0; i<inter_segs.size(); i++)
+        for(std::size_t j=i+1; j<inter_segs.size(); j++)
+          found.insert({std::min(inter_segs[i],inter_segs[j]), std::max(inter_segs[i],inter_segs[j])});
+    }
+    REQUIRE(found == expected);
+    auto& intersections = intersection_set.GetIntersections();
+    auto num_at_5_5 = std::count_if(intersections.begin(), intersections.end(), [](auto& intersection) {
+      return (intersection.point == SpgMth::Point2d{5,5}) && (intersection.count == 4); });
+    REQUIRE(num_at_5_5 == 1); //reported once with all 4 segs
+
+    //A zero length seg is valid input - it's just left out
+    Geom::ItersectSet::SegList with_degenerate = segs;
+    with_degenerate.push_back({{1000,1000},{1000,1000}});
+    Geom::ItersectSet::IntersectionSet degenerate_set(with_degenerate);
+    degenerate_set.Process();
+    REQUIRE(degenerate_set.GetIntersections().size() == intersections.size());
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("IntersectionSet 808 segs") { 
+      Geom::ItersectSet::IntersectionSet bench_set(segs);
+      bench_set.Process();
+      return bench_set.GetIntersections().size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "IntersectionSet ProcessParallel matches Process", "ItersectSet::IntersectionSet::ProcessParallel()") 
+  {
+    std::mt19937 mt(15); 
+    std::uniform_real_distribution<float> pos_dist(0.0f, 1000.0f); 
+    std::uniform_real_distribution<float> len_dist(-20.0f, 20.0f); 
+    Geom::ItersectSet::SegList segs;
+    //Grid of vertical and horizontal segs - strip boundaries land on the vertical ones' x, so lots of the
+    //intersections are exactly on a boundary
+    for(int i=0; i<500; i++) {
+      segs.push_back({{2.0f*i, 0.0f}, {2.0f*i, 1000.0f}});
+      segs.push_back({{0.0f, 2.0f*i + 1.0f}, {1000.0f, 2.0f*i + 1.0f}});
+    }
+    for(int i=0; i<20000; i++) {
+      SpgMth::Point2d start{pos_dist(mt), pos_dist(mt)};
+      segs.emplace_back(start, start + SpgMth::Point2d{len_dist(mt), len_dist(mt)});
+    }
+
+    Geom::ItersectSet::IntersectionSet serial_set(segs);
+    serial_set.Process();
+    auto& expected = serial_set.GetIntersections();
+    Core::ThreadPool pool(4);
+    for(uint32_t num_strips : {2u, 5u, 0u}) {
+      Geom::ItersectSet::IntersectionSet parallel_set(segs);
+      parallel_set.ProcessParallel(pool, num_strips);
+      auto& intersections = parallel_set.GetIntersections();
+      REQUIRE(intersections.size() == expected.size());
+      bool same = true;
+      for(std::size_t i=0; i<intersections.size(); i++) {
+        auto segs1 = parallel_set.GetSegs(intersections[i]);
+        auto segs2 = serial_set.GetSegs(expected[i]);
+        same = same && (intersections[i].point == expected[i].point) && std::equal(segs1.begin(), segs1.end(), segs2.begin(), segs2.end());
+      }
+      REQUIRE(same);
+    }
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("IntersectionSet Process 21000 segs") { 
+      Geom::ItersectSet::IntersectionSet bench_set(segs);
+      bench_set.Process();
+      return bench_set.GetIntersections().size();
+    };
+    BENCHMARK("IntersectionSet ProcessParallel 21000 segs") { 
+      Geom::ItersectSet::IntersectionSet bench_set(segs);
+      bench_set.ProcessParallel(pool);
+      return bench_set.GetIntersections().size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "Indexed DCEL", "dcel_v3::DCEL::GetDiagonal(), Join(), Split(), Clone()" ) 
+  {
+    using DCEL = Geom::dcel_v3::DCEL;
+    std::vector<SpgMth::Point2d> poly_points =
+    {
+      {16.42f,12.51f},  //A 0
+      {13.95,10.36},    //B 1
+      {11.2,18.4},      //C 2
+      {9.2,16.4},       //D 3
+      {6.6,17.8},       //E 4
+      {4,16},           //F 5
+      {6.62,13.16},     //G 6
+      {5.52,9.06},      //H 7
+      {3.38,11.36},     //I 8
+      {2.54,6.49},      //J 9
+      {6.04,3.49},      //K 10
+      {8.99,5.24},      //L 11
+      {12,2},           //M 12
+      {12.26,7.79},     //N 13
+      {17.04,6.99}      //O 14
+    };
+    DCEL poly(poly_points);
+    REQUIRE(poly.Validate());
+    REQUIRE(poly.NumFaces() == 2);
+    REQUIRE(poly.GetVertices(1).size() == poly_points.size());
+
+    //Same cases as the (disabled) dcel_v1 test below, 0 based
+    auto valid = [&poly](uint32_t v1, uint32_t v2) { return poly.GetDiagonal(v1, v2).is_valid; };
+    REQUIRE(!valid(4,4));   //Same vertex
+    REQUIRE(!valid(6,7));   //Neighbours
+    REQUIRE(!valid(7,6));
+    REQUIRE(!valid(0,14));
+    REQUIRE(!valid(14,0));
+    REQUIRE(!valid(8,6));   //Exterior, 1 convex, 1 reflex
+    REQUIRE(!valid(6,8));
+    REQUIRE(!valid(0,2));   //Exterior, 2 convex
+    REQUIRE(!valid(2,0));
+    REQUIRE(!valid(11,14)); //Intersection, 1 convex, 1 reflex
+    REQUIRE(!valid(14,11));
+    REQUIRE(!valid(8,4));   //Intersection, 2 convex
+    REQUIRE(!valid(4,8));
+    REQUIRE(valid(1,7));    //2 reflex
+    REQUIRE(valid(7,1));
+    REQUIRE(valid(6,3));
+    REQUIRE(valid(3,6));
+    REQUIRE(valid(9,13));   //1 convex, 1 reflex
+    REQUIRE(valid(13,9));
+    REQUIRE(valid(10,2));   //2 convex
+    REQUIRE(valid(2,10));
+    REQUIRE(valid(14,1));   //1 convex, 1 reflex
+    REQUIRE(valid(1,14));
+
+    //Clone is independent. Triangulate it by joining every valid diagonal
+    DCEL tri = poly.Clone();
+    const uint32_t n = (uint32_t)poly_points.size();
+    for(uint32_t i=0; i<n; i++)
+      for(uint32_t j=i+2; j<n; j++)
+        tri.Join(i, j);
+    REQUIRE(tri.Validate());
+    REQUIRE(tri.NumFaces() == 1 + (n-2));
+    REQUIRE(tri.NumHalfEdges() == 2*n + 2*(n-3));
+    REQUIRE(poly.NumFaces() == 2);
+    REQUIRE(poly.NumHalfEdges() == 2*n);
+    double area = 0.0;
+    for(uint32_t f=1; f<tri.NumFaces(); f++) {
+      auto verts = tri.GetVertices(f);
+      REQUIRE(verts.size() == 3);
+      area += SpgMth::Orient2d(tri.GetPoint(verts[0]), tri.GetPoint(verts[1]), tri.GetPoint(verts[2]));
+      REQUIRE(!tri.GetDiagonal(verts[0], verts[1]).is_valid);
+    }
+    double poly_area = 0.0;
+    for(uint32_t i=0; i<n; i++)
+      poly_area += SpgMth::Orient2d(SpgMth::Point2d{0,0}, poly_points[i], poly_points[(i+1)%n]);
+    REQUIRE_THAT(area, CM::WithinRel(poly_area, 1e-6));
+
+    //Split M-N, then join the new vertex to L (cuts off M)
+    DCEL::HalfEdgeId h = poly.GetDepartingEdge(12, 1); //M->N
+    REQUIRE(poly.Destination(h) == 13);
+    DCEL::VertexId v = poly.Split({12.13f, 4.9f}, h);
+    REQUIRE(poly.Validate());
+    REQUIRE(poly.NumVertices() == n+1);
+    REQUIRE(poly.GetVertices(1).size() == n+1);
+    REQUIRE(poly.Destination(h) == v);
+    REQUIRE(poly.Destination(poly.Next(h)) == 13);
+    REQUIRE(!poly.GetDiagonal(v, 10).is_valid); //crosses L-M
+    REQUIRE(poly.Join(v, 11) != DCEL::s_null);
+    REQUIRE(poly.Validate());
+    REQUIRE(poly.NumFaces() == 3);
+  }
+
+  TEST_CASE( "DCEL bulk build", "dcel_v3::DCEL::Build(), BuildFromTriangles(), Join() with holes" ) 
+  {
+    using DCEL = Geom::dcel_v3::DCEL;
+    auto num_holes = [](const DCEL& dcel, DCEL::FaceId f) {
+      uint32_t count = 0;
+      dcel.ForEachBoundaryLoop(f, [&](DCEL::HalfEdgeId) { count++; });
+      return count - (dcel.GetFace(f).outer != DCEL::s_null);
+    };
+
+    //Grid of quads, and the same grid as triangles with some given CW
+    const uint32_t NX = 40, NY = 25;
+    std::vector<SpgMth::Point2d> grid_points;
+    for(uint32_t j=0; j<=NY; j++)
+      for(uint32_t i=0; i<=NX; i++)
+        grid_points.push_back({(float)i, (float)j});
+    auto id = [NX](uint32_t i, uint32_t j) { return j*(NX+1) + i; };
+    std::vector<DCEL::FaceIndices> quads;
+    std::vector<uint32_t> triangles;
+    for(uint32_t j=0; j<NY; j++) {
+      for(uint32_t i=0; i<NX; i++) {
+        quads.push_back({{id(i,j), id(i+1,j), id(i+1,j+1), id(i,j+1)}, {}});
+        triangles.insert(triangles.end(), {id(i,j), id(i+1,j), id(i+1,j+1)});
+        if((i+j)%3 == 0)
+          triangles.insert(triangles.end(), {id(i,j), id(i,j+1), id(i+1,j+1)}); //CW
+        else
+          triangles.insert(triangles.end(), {id(i,j), id(i+1,j+1), id(i,j+1)});
+      }
+    }
+    const uint32_t num_grid_edges = NX*(NY+1) + NY*(NX+1);
+    DCEL grid;
+    REQUIRE(grid.Build(grid_points, quads));
+    REQUIRE(grid.Validate());
+    REQUIRE(grid.NumFaces() == 1 + NX*NY);
+    REQUIRE(grid.NumHalfEdges() == 2*num_grid_edges);
+    REQUIRE(num_holes(grid, DCEL::s_unbounded_face) == 1);
+    REQUIRE(grid.GetVertices(1) == std::vector<DCEL::VertexId>{id(0,0), id(1,0), id(1,1), id(0,1)});
+    REQUIRE(grid.Join(id(0,0), id(1,1)) != DCEL::s_null);
+    REQUIRE(grid.Validate());
+
+    DCEL tri;
+    REQUIRE(tri.BuildFromTriangles(grid_points, triangles));
+    REQUIRE(tri.Validate());
+    REQUIRE(tri.NumFaces() == 1 + 2*NX*NY);
+    REQUIRE(tri.NumHalfEdges() == 2*(num_grid_edges + NX*NY));
+    bool all_ccw = true;
+    for(DCEL::FaceId f=1; f<tri.NumFaces(); f++) {
+      auto verts = tri.GetVertices(f);
+      all_ccw = all_ccw && (verts.size() == 3) && (SpgMth::Orient2d(tri.GetPoint(verts[0]), tri.GetPoint(verts[1]), tri.GetPoint(verts[2])) > 0);
+    }
+    REQUIRE(all_ccw);
+
+    //Square with a square hole (given CCW - gets reversed). Unfilled, then filled by an island face
+    std::vector<SpgMth::Point2d> points = {{0,0},{10,0},{10,10},{0,10},{4,4},{6,4},{6,6},{4,6}};
+    std::vector<DCEL::FaceIndices> faces = {{{0,1,2,3}, {{4,5,6,7}}}};
+    DCEL holed;
+    REQUIRE(holed.Build(points, faces));
+    REQUIRE(holed.Validate());
+    REQUIRE(holed.NumFaces() == 2);
+    REQUIRE(num_holes(holed, 1) == 1);
+    REQUIRE(num_holes(holed, DCEL::s_unbounded_face) == 2);
+    faces.push_back({{4,5,6,7}, {}});
+    REQUIRE(holed.Build(points, faces));
+    REQUIRE(holed.Validate());
+    REQUIRE(holed.NumFaces() == 3);
+    REQUIRE(num_holes(holed, 1) == 1);
+    REQUIRE(num_holes(holed, DCEL::s_unbounded_face) == 1);
+
+    //Triangulate the ring and the island by joining every valid diagonal. The first join from the outer boundary
+    //to the hole merges the loops
+    REQUIRE(!holed.GetDiagonal(0, 6).is_valid); //through the hole
+    REQUIRE(holed.Join(0, 4) != DCEL::s_null);
+    REQUIRE(holed.Validate());
+    REQUIRE(holed.NumFaces() == 3);
+    REQUIRE(num_holes(holed, 1) == 0);
+    for(uint32_t i=0; i<8; i++)
+      for(uint32_t j=0; j<8; j++)
+        holed.Join(i, j);
+    REQUIRE(holed.Validate());
+    REQUIRE(holed.NumFaces() == 1 + 8 + 2);
+    for(DCEL::FaceId f=1; f<holed.NumFaces(); f++)
+      REQUIRE(holed.GetVertices(f).size() == 3);
+
+    //Splitting a face moves the holes on the new side to the new face
+    points = {{0,0},{10,0},{20,0},{20,10},{10,10},{0,10},{14,4},{16,4},{16,6},{14,6}};
+    DCEL split;
+    REQUIRE(split.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3,4,5}, {{6,9,8,7}}}}));
+    REQUIRE(split.Join(1, 4) != DCEL::s_null);
+    REQUIRE(split.Validate());
+    REQUIRE(split.NumFaces() == 3);
+    REQUIRE(num_holes(split, 1) == 0);
+    REQUIRE(num_holes(split, 2) == 1);
+
+    //A diagonal round the outside of a hole cuts off a pocket between it and the hole
+    points = {{0,0},{20,0},{20,20},{0,20},{5,5},{15,5},{15,15},{10,15},{10,10},{5,10}};
+    DCEL pocket;
+    REQUIRE(pocket.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3}, {{4,5,6,7,8,9}}}, {{4,5,6,7,8,9}, {}}}));
+    DCEL::HalfEdgeId h = pocket.Join(7, 9); //valid in the face round the hole, not in the L shaped island
+    REQUIRE(h != DCEL::s_null);
+    REQUIRE(pocket.Validate());
+    REQUIRE(pocket.NumFaces() == 4);
+    REQUIRE(pocket.GetVertices(pocket.IncidentFace(h)).size() == 3);
+    REQUIRE(pocket.IncidentFace(DCEL::Twin(h)) == 1);
+    REQUIRE(num_holes(pocket, 1) == 1);
+
+    //Faces touching at a corner
+    points = {{0,0},{1,0},{1,1},{0,1},{2,1},{2,2},{1,2}};
+    DCEL touching;
+    REQUIRE(touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3}, {}}, {{2,4,5,6}, {}}}));
+    REQUIRE(touching.Validate());
+    REQUIRE(num_holes(touching, DCEL::s_unbounded_face) == 1);
+    REQUIRE(touching.GetDepartingEdges(2).size() == 4);
+
+    //Departing edges come round clockwise - fan round the centre of E, N, W, S
+    points = {{0,0},{1,0},{0,1},{-1,0},{0,-1}};
+    DCEL fan;
+    REQUIRE(fan.BuildFromTriangles(points, std::vector<uint32_t>{0,1,2, 0,2,3, 0,3,4, 0,4,1}));
+    auto departing = fan.GetDepartingEdges(0);
+    REQUIRE(departing.size() == 4);
+    for(size_t i = 0; i < departing.size(); i++)
+      REQUIRE(SpgMth::Orient2d(points[0], fan.GetDestinationPoint(departing[i]), fan.GetDestinationPoint(departing[(i+1)%4])) < 0.0);
+
+    //Bad input
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3}, {}}, {{0,1,2,3}, {}}})); //overlapping
+    REQUIRE(touching.NumHalfEdges() == 0);
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,20}, {}}}));
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1}, {}}}));
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{}, {}}})); //empty outer loop
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3}, {{}}}})); //empty hole
+    REQUIRE(!touching.Build(points, std::vector<DCEL::FaceIndices>{{{0,1,2,3}, {{4,5}}}})); //2 vertex hole
+    REQUIRE(touching.NumHalfEdges() == 0);
+
+  #if defined(RUN_BENCHMARKS)  
+    BENCHMARK("DCEL::Build 1000 quads") { 
+      DCEL dcel;
+      dcel.Build(grid_points, quads);
+      return dcel.NumHalfEdges();
+    };
+    BENCHMARK("DCEL::BuildFromTriangles 2000 triangles") { 
+      DCEL dcel;
+      dcel.BuildFromTriangles(grid_points, triangles);
+      return dcel.NumHalfEdges();
+    };
+  #endif
+  }
+
+  TEST_CASE( "DCEL edge index and grid diagonal checks", "dcel_v3::DCEL::BuildEdgeIndex(), IsDiagonal(v1, v2, polygon, edge_grid), SegmentGrid2D" ) 
+  {
+    using DCEL = Geom::dcel_v3::DCEL;
+    std::mt19937 mt(37); 
+    //Star shaped, so simple, with plenty of reflex vertices
+    auto star_polygon = [&mt](uint32_t num_points) {
+      std::uniform_real_distribution<float> radius_dist(50.0f, 100.0f); 
+      std::vector<SpgMth::Point2d> points;
+      for(uint32_t i=0; i<num_points; i++) {
+        float angle = 2.0f * 3.14159265f * (float)i / (float)num_points;
+        float r = radius_dist(mt);
+        points.push_back({r * std::cos(angle), r * std::sin(angle)});
+      }
+      return points;
+    };
+
+    //SegmentGrid2D candidates include every segment that crosses the query
+    {
+      std::uniform_real_distribution<float> pos_dist(0.0f, 100.0f); 
+      std::uniform_real_distribution<float> len_dist(-5.0f, 5.0f); 
+      std::vector<SpgMth::LineSeg2D> segs;
+      SpgMth::BoundingBox bounds;
+      for(int i=0; i<2000; i++) {
+        SpgMth::Point2d start{pos_dist(mt), pos_dist(mt)};
+        segs.push_back({start, start + SpgMth::Point2d{len_dist(mt), len_dist(mt)}});
+        bounds.Update(segs.back().start);
+        bounds.Update(segs.back().end);
+      }
+      segs.push_back({{10,10},{10,20}}); //vertical and horizontal, on cell boundaries
+      segs.push_back({{10,10},{20,10}});
+      Geom::SegmentGrid2D grid(bounds, (uint32_t)segs.size());
+      for(uint32_t i=0; i<segs.size(); i++)
+        grid.Insert(i, segs[i].start, segs[i].end);
+      int num_missed = 0;
+      for(uint32_t i=0; i<segs.size(); i++) {
+        std::set<uint32_t> candidates;
+        grid.ForEachCandidate(segs[i].start, segs[i].end, [&](uint32_t id) { candidates.insert(id); return false; });
+        for(uint32_t j=0; j<segs.size(); j++)
+          num_missed += SpgMth::IntersectionExistsExact(segs[i], segs[j]) && !candidates.contains(j);
+      }
+      REQUIRE(num_missed == 0);
+    }
+
+    //DCEL with and without the index agree, as diagonals are joined and edges split
+    auto points = star_polygon(3000);
+    DCEL plain(points);
+    DCEL indexed(points);
+    indexed.BuildEdgeIndex();
+    REQUIRE(indexed.HasEdgeIndex());
+    std::uniform_int_distribution<uint32_t> vert_dist(0, (uint32_t)points.size()-1);
+    int num_different = 0;
+    int num_joined = 0;
+    for(int round=0; round<4; round++) {
+      for(int i=0; i<3000; i++) {
+        uint32_t v1 = vert_dist(mt);
+        uint32_t v2 = (round % 2) ? vert_dist(mt) : (v1 + 2) % (uint32_t)points.size(); //ears, then anything
+        bool valid = plain.GetDiagonal(v1, v2).is_valid;
+        num_different += (valid != indexed.GetDiagonal(v1, v2).is_valid);
+        if(valid) {
+          plain.Join(v1, v2);
+          indexed.Join(v1, v2);
+          num_joined++;
+        }
+      }
+      for(int i=0; i<20; i++) {
+        DCEL::HalfEdgeId h = 2 * vert_dist(mt);
+        SpgMth::Point2d mid = 0.5f * (plain.GetOriginPoint(h) + plain.GetDestinationPoint(h));
+        plain.Split(mid, h);
+        indexed.Split(mid, h);
+      }
+    }
+    DCEL::HalfEdgeId h = 0;
+    indexed.Split(indexed.GetOriginPoint(h) * 3.0f, h); //outside the grid - rebuilds it
+    plain.Split(plain.GetOriginPoint(h) * 3.0f, h);
+    for(uint32_t v=0; v<points.size(); v++)
+      num_different += (plain.GetDiagonal(v, (v+2) % (uint32_t)points.size()).is_valid != indexed.GetDiagonal(v, (v+2) % (uint32_t)points.size()).is_valid);
+    REQUIRE(num_different == 0);
+    REQUIRE(num_joined > 500);
+    REQUIRE(indexed.NumFaces() == plain.NumFaces());
+    REQUIRE(indexed.Validate());
+
+    //Ear clipping's grid based IsDiagonal() agrees with the full scan, and gives a full set of diagonals
+    points = star_polygon(400);
+    Geom::PolygonSimple polygon(points);
+    SpgMth::BoundingBox bounds;
+    for(auto& p : points)
+      bounds.Update(p);
+    Geom::SegmentGrid2D edge_grid(bounds, (uint32_t)points.size());
+    for(auto v : polygon.vertices)
+      edge_grid.Insert(v->index, v->point, v->next->point);
+    num_different = 0;
+    for(uint32_t i=0; i<points.size(); i++)
+      for(uint32_t j=i+2; j<points.size(); j+=3)
+        num_different += (Geom::IsDiagonal(polygon.vertices[i], polygon.vertices[j]) != Geom::IsDiagonal(polygon.vertices[i], polygon.vertices[j], polygon, edge_grid));
+    REQUIRE(num_different == 0);
+
+    std::vector<Geom::SP::Edge> diagonals;
+    Geom::Triangulate_EarClipping(&polygon, diagonals);
+    REQUIRE(diagonals.size() == points.size() - 3);
+    Geom::PolygonSimple original(points);
+    auto find_vertex = [&original](const SpgMth::Point2d& p) {
+      return *std::find_if(original.vertices.begin(), original.vertices.end(), [&p](auto v) { return v->point == p; });
+    };
+    int num_invalid = 0;
+    for(auto& d : diagonals)
+      num_invalid += !Geom::IsDiagonal(find_vertex(d.v1.point), find_vertex(d.v2.point));
+    REQUIRE(num_invalid == 0);
+
+  #if defined(RUN_BENCHMARKS)  
+    points = star_polygon(100000);
+    DCEL big_plain(points);
+    DCEL big_indexed(points);
+    big_indexed.BuildEdgeIndex();
+    BENCHMARK("DCEL::GetDiagonal, 100000 vertices, 100 ear diagonals, no index") { 
+      uint32_t num_valid = 0;
+      for(uint32_t i=0; i<100; i++)
+        num_valid += big_plain.GetDiagonal(i, i+2).is_valid;
+      return num_valid;
+    };
+    BENCHMARK("DCEL::GetDiagonal, 100000 vertices, 100 ear diagonals, edge index") { 
+      uint32_t num_valid = 0;
+      for(uint32_t i=0; i<100; i++)
+        num_valid += big_indexed.GetDiagonal(i, i+2).is_valid;
+      return num_valid;
+    };
+  #endif
+  }
+
+  TEST_CASE( "Monotone polygon triangulation", "TriangulatePolygon()" ) 
+  {
+    //Triangles all CCW and covering the polygon: n + 2*holes - 2 of them, areas summing to the polygon's
+    auto check_triangulation = [](const std::vector<SpgMth::Point2d>& outer, const std::vector<std::vector<SpgMth::Point2d>>& holes) {
+      std::vector<SpgMth::Point2d> points = outer;
+      double expected_area = std::abs(SpgMth::SignedArea(outer));
+      for(auto& hole : holes) {
+        points.insert(points.end(), hole.begin(), hole.end());
+        expected_area -= std::abs(SpgMth::SignedArea(hole));
+      }
+      std::vector<uint32_t> triangles;
+      bool ok = Geom::TriangulatePolygon(outer, holes, triangles);
+      int num_not_ccw = 0;
+      double area = 0.0;
+      for(size_t i = 0; i < triangles.size(); i += 3) {
+        double orient = SpgMth::Orient2d(points[triangles[i]], points[triangles[i+1]], points[triangles[i+2]]);
+        num_not_ccw += (orient <= 0.0);
+        area += 0.5 * orient;
+      }
+      return ok && (num_not_ccw == 0) && (triangles.size() == 3 * (points.size() + 2 * holes.size() - 2)) &&
+        (std::abs(area - expected_area) <= 1e-4 * expected_area);
+    };
+
+    std::vector<SpgMth::Point2d> square{{0,0},{10,0},{10,10},{0,10}};
+    std::vector<SpgMth::Point2d> square_cw{{0,0},{0,10},{10,10},{10,0}};
+    REQUIRE(check_triangulation(square, {}));
+    REQUIRE(check_triangulation(square_cw, {}));
+    REQUIRE(check_triangulation(square, {{{2,2},{4,2},{4,4},{2,4}}, {{6,6},{6,8},{8,8},{8,6}}}));
+
+    //Comb - many split and merge vertices, lots of equal y's. And a grid of square holes
+    std::vector<SpgMth::Point2d> comb{{0,0},{100,0},{100,10}};
+    for(int i = 49; i >= 0; i--) 
+      comb.insert(comb.end(), {{i*2 + 1.5f, 10}, {i*2 + 1.0f, 3}, {i*2 + 0.5f, 10}});
+    REQUIRE(check_triangulation(comb, {}));
+    std::vector<std::vector<SpgMth::Point2d>> square_holes;
+    for(int i = 0; i < 4; i++)
+      for(int j = 0; j < 4; j++)
+        square_holes.push_back({{i*2.5f + 0.5f, j*2.5f + 0.5f}, {i*2.5f + 2, j*2.5f + 0.5f}, {i*2.5f + 2, j*2.5f + 2}, {i*2.5f + 0.5f, j*2.5f + 2}});
+    REQUIRE(check_triangulation(square, square_holes));
+
+    //Random star polygons, with small star holes round the centre
+    std::mt19937 mt(41); 
+    auto star_polygon = [&mt](uint32_t num_points, SpgMth::Point2d centre, float r_min, float r_max) {
+      std::uniform_real_distribution<float> radius_dist(r_min, r_max); 
+      std::vector<SpgMth::Point2d> points;
+      for(uint32_t i=0; i<num_points; i++) {
+        float angle = 2.0f * 3.14159265f * (float)i / (float)num_points;
+        float r = radius_dist(mt);
+        points.push_back(centre + SpgMth::Point2d{r * std::cos(angle), r * std::sin(angle)});
+      }
+      return points;
+    };
+    int num_failed = 0;
+    for(int i = 0; i < 20; i++) {
+      std::vector<std::vector<SpgMth::Point2d>> holes;
+      for(int h = 0; h < i % 4; h++)
+        holes.push_back(star_polygon(50, {(h - 1.5f) * 10.0f, 0.0f}, 2.0f, 4.0f));
+      num_failed += !check_triangulation(star_polygon(2000 + 50 * i, {0,0}, 50.0f, 100.0f), holes);
+    }
+    REQUIRE(num_failed == 0);
+
+    //Self intersecting
+    std::vector<uint32_t> triangles{1,2,3};
+    REQUIRE(!Geom::TriangulatePolygon(std::vector<SpgMth::Point2d>{{0,0},{10,10},{10,0},{0,10}}, {}, triangles));
+    REQUIRE(triangles.empty());
+
+  #if defined(RUN_BENCHMARKS)  
+    //Ear clipping modifies the polygon, so building it is part of its benchmark. It's left out at 1M vertices - it
+    //takes minutes
+    auto wavy_polygon = [&mt](uint32_t num_points) {
+      std::uniform_real_distribution<float> jitter(0.0f, 0.02f); 
+      std::vector<SpgMth::Point2d> points;
+      for(uint32_t i=0; i<num_points; i++) {
+        float angle = 2.0f * 3.14159265f * (float)i / (float)num_points;
+        float r = 800.0f + 100.0f * std::sin(7.0f * angle) + jitter(mt);
+        points.push_back({r * std::cos(angle), r * std::sin(angle)});
+      }
+      return points;
+    };
+    auto points_10k = wavy_polygon(10000);
+    auto points_100k = wavy_polygon(100000);
+    auto points_1m = wavy_polygon(1000000);
+    BENCHMARK("TriangulatePolygon, 10000 vertices") { return Geom::TriangulatePolygon(points_10k); };
+    BENCHMARK("TriangulatePolygon, 100000 vertices") { return Geom::TriangulatePolygon(points_100k); };
+    BENCHMARK("TriangulatePolygon, 1000000 vertices") { return Geom::TriangulatePolygon(points_1m); };
+    BENCHMARK("Triangulate_EarClipping, 10000 vertices") { 
+      Geom::PolygonSimple polygon(points_10k);
+      std::vector<Geom::SP::Edge> diagonals;
+      Geom::Triangulate_EarClipping(&polygon, diagonals);
+      return diagonals.size();
+    };
+    BENCHMARK("Triangulate_EarClipping, 100000 vertices") { 
+      Geom::PolygonSimple polygon(points_100k);
+      std::vector<Geom::SP::Edge> diagonals;
+      Geom::Triangulate_EarClipping(&polygon, diagonals);
+      return diagonals.size();
+    };
+  #endif
+  }
+
+  TEST_CASE( "Constrained Delaunay triangulation", "DelaunayTriangulation2D::Triangulate(), IsConstrained(), BuildDCEL()" ) 
+  {
+    //All CCW, no unconstrained edge with the opposite point of its neighbour inside its circumcircle. Returns the
+    //number of failures
+    auto check_delaunay = [](const Geom::DelaunayTriangulation2D& dt, const std::vector<SpgMth::Point2d>& points) {
+      auto triangles = dt.GetTriangles();
+      std::map<std::pair<uint32_t, uint32_t>, uint32_t> opposite; //edge -> the vertex on its left
+      int num_failed = 0;
+      for(size_t i = 0; i < triangles.size(); i += 3) {
+        num_failed += (SpgMth::Orient2d(points[triangles[i]], points[triangles[i+1]], points[triangles[i+2]]) <= 0.0);
+        for(uint32_t j = 0; j < 3; j++)
+          opposite[{triangles[i+j], triangles[i+(j+1)%3]}] = triangles[i+(j+2)%3];
+      }
+      for(auto& [edge, c] : opposite) {
+        auto twin = opposite.find({edge.second, edge.first});
+        if((twin != opposite.end()) && !dt.IsConstrained(edge.first, edge.second))
+          num_failed += (SpgMth::InCircle(points[edge.first], points[edge.second], points[c], points[twin->second]) > 0.0);
+      }
+      return num_failed;
+    };
+
+    std::mt19937 mt(17); 
+    std::uniform_real_distribution<float> fdist(-100.0f, 100.0f); 
+    Geom::DelaunayTriangulation2D dt;
+    for(uint32_t n : {3u, 4u, 10u, 100u, 5000u}) {
+      std::vector<SpgMth::Point2d> points;
+      for(uint32_t i=0; i<n; i++) 
+        points.push_back({fdist(mt),fdist(mt)});
+      const size_t h = Geom::ConvexHull2D_Chan(points).size();
+      for(auto order : {Geom::DelaunayTriangulation2D::InsertionOrder::BRIO, Geom::DelaunayTriangulation2D::InsertionOrder::Input}) {
+        REQUIRE(dt.Triangulate(points, {}, order));
+        REQUIRE(dt.GetTriangles().size() == 3 * (2 * n - h - 2));
+        REQUIRE(check_delaunay(dt, points) == 0);
+      }
+    }
+
+    //Integer grid, shuffled, with repeats - lots of cocircular points. Constraints along a row and a diagonal, through
+    //grid points on the way (so split there) and to a repeat
+    std::vector<SpgMth::Point2d> grid;
+    for(int i = 0; i < 30; i++)
+      for(int j = 0; j < 30; j++)
+        grid.push_back({(float)i, (float)j});
+    std::shuffle(grid.begin(), grid.end(), mt);
+    for(uint32_t i = 0; i < 100; i++)
+      grid.push_back(grid[i]);
+    auto index_of = [&grid](SpgMth::Point2d p) { return (uint32_t)(std::find(grid.begin(), grid.end(), p) - grid.begin()); };
+    grid.push_back({29,29});
+    std::vector<uint32_t> grid_constraints{index_of({0,5}), index_of({29,5}), index_of({10,10}), (uint32_t)grid.size() - 1};
+    REQUIRE(dt.Triangulate(grid, grid_constraints));
+    REQUIRE(dt.GetTriangles().size() == 3 * (2 * 900 - 116 - 2));
+    REQUIRE(check_delaunay(dt, grid) == 0);
+    REQUIRE(dt.IsConstrained(index_of({0,5}), index_of({1,5})));
+    REQUIRE(dt.IsConstrained(index_of({28,5}), index_of({29,5})));
+    REQUIRE(dt.IsConstrained(index_of({10,10}), index_of({11,11})));
+    REQUIRE(dt.IsConstrained(index_of({28,28}), index_of({29,29})));
+    REQUIRE(!dt.IsConstrained(index_of({0,6}), index_of({1,6})));
+
+    //Random points with concentric rings of constraints
+    std::vector<SpgMth::Point2d> points;
+    for(uint32_t i=0; i<5000; i++) 
+      points.push_back({fdist(mt),fdist(mt)});
+    std::vector<uint32_t> constraints;
+    for(uint32_t ring = 1; ring <= 10; ring++) {
+      const uint32_t first = (uint32_t)points.size(), num = 10 + 6 * ring;
+      for(uint32_t i = 0; i < num; i++) {
+        float angle = 2.0f * 3.14159265f * (float)i / (float)num;
+        points.push_back({9.0f * ring * std::cos(angle), 9.0f * ring * std::sin(angle)});
+        constraints.insert(constraints.end(), {first + i, first + (i + 1) % num});
+      }
+    }
+    REQUIRE(dt.Triangulate(points, constraints));
+    int num_unconstrained = 0;
+    for(size_t i = 0; i < constraints.size(); i += 2)
+      num_unconstrained += !dt.IsConstrained(constraints[i], constraints[i+1]);
+    REQUIRE(num_unconstrained == 0);
+    REQUIRE(check_delaunay(dt, points) == 0);
+
+    Geom::dcel_v3::DCEL dcel;
+    REQUIRE(dt.BuildDCEL(dcel));
+    REQUIRE(dcel.Validate());
+    REQUIRE(dcel.NumFaces() == dt.GetTriangles().size() / 3 + 1);
+
+    //Crossing constraints - the second isn't added. All collinear - nothing to triangulate
+    std::vector<SpgMth::Point2d> square{{0,0},{10,0},{10,10},{0,10},{5,6}};
+    REQUIRE(!dt.Triangulate(square, std::vector<uint32_t>{0,2,1,3}));
+    REQUIRE(dt.IsConstrained(0, 2));
+    REQUIRE(!dt.IsEdge(1, 3));
+    REQUIRE(!dt.Triangulate(std::vector<SpgMth::Point2d>{{0,0},{1,1},{2,2},{3,3}}));
+    REQUIRE(dt.GetTriangles().empty());
+
+  #if defined(RUN_BENCHMARKS)  
+    std::vector<SpgMth::Point2d> points_100k;
+    for(uint32_t i=0; i<100000; i++) 
+      points_100k.push_back({fdist(mt),fdist(mt)});
+    BENCHMARK("Delaunay, 100000 points, BRIO order") { 
+      return dt.Triangulate(points_100k, {}, Geom::DelaunayTriangulation2D::InsertionOrder::BRIO);
+    };
+    BENCHMARK("Delaunay, 100000 points, input order") { 
+      return dt.Triangulate(points_100k, {}, Geom::DelaunayTriangulation2D::InsertionOrder::Input);
+    };
+  #endif
+  }
+
 #if 0 //Todo - debug ssertion in DCEL code
   TEST_CASE( "Diagonal test", "DCEL::DiagonalCheck(Vertex*, Vertex*)" ) {
     std::vector<SpgMth::Point2d> poly_points =